@@ -131,6 +131,7 @@ cdef extern from "kudu/client/schema.h" namespace "kudu::client" nogil:
         EncodingType_PLAIN " kudu::client::KuduColumnStorageAttributes::PLAIN_ENCODING"
         EncodingType_PREFIX " kudu::client::KuduColumnStorageAttributes::PREFIX_ENCODING"
         EncodingType_BIT_SHUFFLE " kudu::client::KuduColumnStorageAttributes::BIT_SHUFFLE"
+        EncodingType_FRAME_OF_REFERENCE " kudu::client::KuduColumnStorageAttributes::FRAME_OF_REFERENCE"
         EncodingType_RLE " kudu::client::KuduColumnStorageAttributes::RLE"
         EncodingType_DICT " kudu::client::KuduColumnStorageAttributes::DICT_ENCODING"
 
@@ -140,6 +141,7 @@ cdef extern from "kudu/client/schema.h" namespace "kudu::client" nogil:
         CompressionType_SNAPPY " kudu::client::KuduColumnStorageAttributes::SNAPPY"
         CompressionType_LZ4 " kudu::client::KuduColumnStorageAttributes::LZ4"
         CompressionType_ZLIB " kudu::client::KuduColumnStorageAttributes::ZLIB"
+        CompressionType_ZSTD " kudu::client::KuduColumnStorageAttributes::ZSTD"
 
     cdef struct KuduColumnStorageAttributes:
         KuduColumnStorageAttributes()
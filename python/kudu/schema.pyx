@@ -59,6 +59,7 @@ COMPRESSION_NONE = CompressionType_NONE
 COMPRESSION_SNAPPY = CompressionType_SNAPPY
 COMPRESSION_LZ4 = CompressionType_LZ4
 COMPRESSION_ZLIB = CompressionType_ZLIB
+COMPRESSION_ZSTD = CompressionType_ZSTD
 
 cdef dict _compression_types = {
     'default': COMPRESSION_DEFAULT,
@@ -66,6 +67,7 @@ cdef dict _compression_types = {
     'snappy': COMPRESSION_SNAPPY,
     'lz4': COMPRESSION_LZ4,
     'zlib': COMPRESSION_ZLIB,
+    'zstd': COMPRESSION_ZSTD,
 }
 
 cdef dict _compression_type_to_name = _reverse_dict(_compression_types)
@@ -76,6 +78,7 @@ ENCODING_AUTO = EncodingType_AUTO
 ENCODING_PLAIN = EncodingType_PLAIN
 ENCODING_PREFIX = EncodingType_PREFIX
 ENCODING_BIT_SHUFFLE = EncodingType_BIT_SHUFFLE
+ENCODING_FRAME_OF_REFERENCE = EncodingType_FRAME_OF_REFERENCE
 ENCODING_RLE = EncodingType_RLE
 ENCODING_DICT = EncodingType_DICT
 
@@ -84,6 +87,7 @@ cdef dict _encoding_types = {
     'plain': ENCODING_PLAIN,
     'prefix': ENCODING_PREFIX,
     'bitshuffle': ENCODING_BIT_SHUFFLE,
+    'frame_of_reference': ENCODING_FRAME_OF_REFERENCE,
     'rle': ENCODING_RLE,
     'dict': ENCODING_DICT,
 }
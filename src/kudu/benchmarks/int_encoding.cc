@@ -0,0 +1,170 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Micro benchmark comparing the encoded size and the decoding speed of the
+// integer block encodings (PLAIN, RLE, BIT_SHUFFLE and FRAME_OF_REFERENCE)
+// on INT64 columns of timestamps, sequence numbers and clustered keys.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/cfile/type_encodings.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
+
+DEFINE_int32(int_encoding_num_values, 1024 * 1024,
+             "Number of values to encode and decode for each data set");
+DEFINE_int32(int_encoding_decode_iters, 20,
+             "Number of times to decode each data set");
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+// Encodes 'values' into blocks of the given encoding, then decodes them
+// FLAGS_int_encoding_decode_iters times.
+void EncodeAndDecode(const string& data_name, EncodingType encoding,
+                     const vector<int64_t>& values) {
+  const TypeInfo* type_info = GetTypeInfo(INT64);
+  const TypeEncodingInfo* tei;
+  CHECK_OK(TypeEncodingInfo::Get(type_info, encoding, &tei));
+  WriterOptions opts;
+
+  // Encode the values, keeping a copy of each block.
+  vector<string> blocks;
+  size_t encoded_size = 0;
+  {
+    BlockBuilder* bb;
+    CHECK_OK(tei->CreateBlockBuilder(&bb, &opts));
+    unique_ptr<BlockBuilder> builder(bb);
+    size_t i = 0;
+    while (i < values.size()) {
+      const uint8_t* src = reinterpret_cast<const uint8_t*>(&values[i]);
+      int added = builder->Add(src, values.size() - i);
+      i += added;
+      if (builder->IsBlockFull() || i == values.size()) {
+        Slice s = builder->Finish(i - builder->Count());
+        blocks.push_back(s.ToString());
+        encoded_size += s.size();
+        builder->Reset();
+      }
+    }
+  }
+
+  // Decode all the blocks.
+  Arena arena(1024);
+  vector<int64_t> decoded(values.size());
+  Stopwatch sw;
+  sw.start();
+  for (int iter = 0; iter < FLAGS_int_encoding_decode_iters; iter++) {
+    ColumnBlock cb(type_info, nullptr, decoded.data(), decoded.size(), &arena);
+    ColumnDataView view(&cb);
+    for (const auto& block : blocks) {
+      BlockDecoder* bd;
+      CHECK_OK(tei->CreateBlockDecoder(&bd, Slice(block), nullptr));
+      unique_ptr<BlockDecoder> decoder(bd);
+      CHECK_OK(decoder->ParseHeader());
+      size_t n = decoder->Count();
+      CHECK_OK(decoder->CopyNextValues(&n, &view));
+      view.Advance(n);
+    }
+  }
+  sw.stop();
+  CHECK(decoded == values) << "decoded values don't match for " << EncodingType_Name(encoding);
+
+  double values_decoded = static_cast<double>(values.size()) * FLAGS_int_encoding_decode_iters;
+  LOG(INFO) << Substitute("$0 $1: $2 bytes ($3 bits/value), decoded $4 Mvalues/sec",
+                          data_name, EncodingType_Name(encoding), encoded_size,
+                          encoded_size * 8.0 / values.size(),
+                          values_decoded / sw.elapsed().wall_seconds() / 1e6);
+}
+
+void RunIntEncodingBenchmarks() {
+  const int num_values = FLAGS_int_encoding_num_values;
+  Random rng(GetRandomSeed32());
+
+  // Timestamps, in microseconds, of events a few milliseconds apart.
+  vector<int64_t> timestamps(num_values);
+  int64_t ts = 1500000000000000L;
+  for (int i = 0; i < num_values; i++) {
+    ts += rng.Uniform(5000);
+    timestamps[i] = ts;
+  }
+
+  // Sequence numbers with a few gaps.
+  vector<int64_t> sequence(num_values);
+  int64_t seq = 0;
+  for (int i = 0; i < num_values; i++) {
+    seq += rng.OneIn(100) ? 1 + rng.Uniform(10) : 1;
+    sequence[i] = seq;
+  }
+
+  // Keys of a few thousand distinct values, in runs of rows which share the
+  // same key.
+  vector<int64_t> clustered(num_values);
+  int64_t key = 0;
+  for (int i = 0; i < num_values; i++) {
+    if (rng.OneIn(20)) {
+      key = 1000000000L + rng.Uniform(4096);
+    }
+    clustered[i] = key;
+  }
+
+  for (EncodingType encoding : { PLAIN_ENCODING, RLE, BIT_SHUFFLE, FRAME_OF_REFERENCE }) {
+    EncodeAndDecode("timestamps", encoding, timestamps);
+    EncodeAndDecode("sequence", encoding, sequence);
+    EncodeAndDecode("clustered", encoding, clustered);
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
+
+int main(int argc, char **argv) {
+  FLAGS_logtostderr = 1;
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+
+  LOG_TIMING(INFO, "IntEncodings") {
+    kudu::cfile::RunIntEncodingBenchmarks();
+  }
+
+  return 0;
+}
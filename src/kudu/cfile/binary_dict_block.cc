@@ -264,10 +264,10 @@ Status BinaryDictBlockDecoder::SeekAtOrAfterValue(const void* value_void, bool*
   }
 }
 
-// TODO: implement CopyNextAndEval for more blocks. Eg. other blocks can
-// store their min/max values. CopyNextAndEval in these blocks could
-// short-circuit if the query can does not search for values within the
-// min/max range, or copy all and evaluate otherwise.
+// TODO: implement CopyNextAndEval for more blocks. Note that blocks whose
+// values can't match the predicate at all, or which all match it, are
+// already short-circuited by CFileSet::Iterator using the per-block
+// statistics of the cfile (see block_stats.h), when the cfile has them.
 Status BinaryDictBlockDecoder::CopyNextAndEval(size_t* n,
                                                ColumnMaterializationContext* ctx,
                                                SelectionVectorView* sel,
@@ -19,14 +19,18 @@
 #define KUDU_CFILE_BLOCK_ENCODINGS_H
 
 #include <algorithm>
+#include <cstring>
 #include <stdint.h>
 #include <glog/logging.h>
 
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -194,6 +198,69 @@ class BlockDecoder {
   DISALLOW_COPY_AND_ASSIGN(BlockDecoder);
 };
 
+// Evaluates the predicate of 'ctx' on the 'n' contiguous fixed-size values
+// of type 'Type' at 'src', as a decoder's CopyNextAndEval() does, clearing
+// the bits of 'sel' of the rows which don't match. Only the values of the
+// rows which remain selected are copied to 'dst'.
+//
+// Where the vectorized kernels of column_predicate_kernels.h support the
+// predicate, they are run over the values into a bitmap which is then ANDed
+// into 'sel', a run of rows at a time. Otherwise the cells are evaluated one
+// at a time, skipping the rows which were already deselected.
+template <DataType Type>
+void EvalAndCopySelectedCells(const uint8_t* src, size_t n,
+                              ColumnMaterializationContext* ctx,
+                              SelectionVectorView* sel,
+                              ColumnDataView* dst) {
+  const size_t size = TypeTraits<Type>::size;
+  const ColumnPredicate* pred = ctx->pred();
+  uint8_t* out = dst->data();
+
+  static constexpr size_t kMaxBatchRows = 1024;
+  uint8_t matches[kMaxBatchRows / 8];
+  bool use_kernels = true;
+  for (size_t start = 0; start < n; start += kMaxBatchRows) {
+    const size_t nrows = std::min(n - start, kMaxBatchRows);
+    const uint8_t* batch_src = src + start * size;
+    memset(matches, 0xff, BitmapSize(nrows));
+    if (!pred->EvaluateWithKernels(batch_src, nrows, matches)) {
+      // Whether the kernels apply only depends on the predicate, so no batch
+      // has been evaluated yet.
+      DCHECK_EQ(0, start);
+      use_kernels = false;
+      break;
+    }
+    BitmapIterator iter(matches, nrows);
+    bool selected;
+    size_t run_start = 0;
+    size_t run_len;
+    while ((run_len = iter.Next(&selected)) > 0) {
+      if (selected) {
+        // Rows of the run which were already deselected get a copy as well,
+        // which is harmless and cheaper than skipping them.
+        memcpy(out + (start + run_start) * size, batch_src + run_start * size, run_len * size);
+      } else {
+        sel->ClearBits(start + run_start, run_len);
+      }
+      run_start += run_len;
+    }
+  }
+  if (use_kernels) {
+    return;
+  }
+
+  for (size_t i = 0; i < n; i++, src += size, out += size) {
+    if (!sel->TestBit(i)) {
+      continue;
+    }
+    if (pred->EvaluateCell<TypeTraits<Type>::physical_type>(src)) {
+      memcpy(out, src, size);
+    } else {
+      sel->ClearBit(i);
+    }
+  }
+}
+
 } // namespace cfile
 } // namespace kudu
 
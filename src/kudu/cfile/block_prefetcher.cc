@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_prefetcher.h"
+
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(cfile_read_ahead_threads, 8,
+             "Maximum number of threads reading CFile data blocks ahead of scans. "
+             "Only used if --cfile_read_ahead_blocks is positive.");
+TAG_FLAG(cfile_read_ahead_threads, experimental);
+
+METRIC_DEFINE_counter(server, cfile_read_ahead_hits,
+                      "CFile Read-Ahead Hits", kudu::MetricUnit::kBlocks,
+                      "Number of data blocks needed by CFile iterators which had been "
+                      "read ahead");
+METRIC_DEFINE_counter(server, cfile_read_ahead_misses,
+                      "CFile Read-Ahead Misses", kudu::MetricUnit::kBlocks,
+                      "Number of data blocks needed by CFile iterators reading ahead which "
+                      "hadn't been read ahead, and were read synchronously. The read-ahead "
+                      "hit rate is hits / (hits + misses)");
+METRIC_DEFINE_counter(server, cfile_read_ahead_bytes,
+                      "CFile Read-Ahead Bytes", kudu::MetricUnit::kBytes,
+                      "Number of bytes of data blocks read ahead of CFile iterators, "
+                      "including the blocks found in the block cache");
+METRIC_DEFINE_counter(server, cfile_read_ahead_wasted_bytes,
+                      "CFile Read-Ahead Wasted Bytes", kudu::MetricUnit::kBytes,
+                      "Number of bytes of data blocks read ahead of CFile iterators which "
+                      "were discarded without being used, because the iterator seeked "
+                      "elsewhere or was destroyed");
+
+namespace kudu {
+namespace cfile {
+
+BlockPrefetcher::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
+    : hits(METRIC_cfile_read_ahead_hits.Instantiate(metric_entity)),
+      misses(METRIC_cfile_read_ahead_misses.Instantiate(metric_entity)),
+      bytes(METRIC_cfile_read_ahead_bytes.Instantiate(metric_entity)),
+      wasted_bytes(METRIC_cfile_read_ahead_wasted_bytes.Instantiate(metric_entity)) {
+}
+
+BlockPrefetcher::BlockPrefetcher() {
+  CHECK_OK(ThreadPoolBuilder("cfile-read-ahead")
+           .set_max_threads(FLAGS_cfile_read_ahead_threads)
+           .Build(&pool_));
+}
+
+void BlockPrefetcher::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
+  metrics_.reset(new Metrics(metric_entity));
+}
+
+Status BlockPrefetcher::Submit(boost::function<void()> task) {
+  return pool_->SubmitFunc(std::move(task));
+}
+
+void BlockPrefetcher::RecordHit() {
+  if (metrics_) {
+    metrics_->hits->Increment();
+  }
+}
+
+void BlockPrefetcher::RecordMiss() {
+  if (metrics_) {
+    metrics_->misses->Increment();
+  }
+}
+
+void BlockPrefetcher::RecordReadAhead(int64_t bytes) {
+  if (metrics_) {
+    metrics_->bytes->IncrementBy(bytes);
+  }
+}
+
+void BlockPrefetcher::RecordWasted(int64_t bytes) {
+  if (metrics_) {
+    metrics_->wasted_bytes->IncrementBy(bytes);
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
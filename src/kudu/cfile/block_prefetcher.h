@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_BLOCK_PREFETCHER_H
+#define KUDU_CFILE_BLOCK_PREFETCHER_H
+
+#include <cstdint>
+
+#include <boost/function.hpp>
+
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/singleton.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ThreadPool;
+
+namespace cfile {
+
+// Process-wide pool of threads which read CFile data blocks ahead of the
+// iterators which will scan them, along with the metrics of that read-ahead.
+//
+// See --cfile_read_ahead_blocks and CFileIterator for the read-ahead window
+// of each iterator.
+class BlockPrefetcher {
+ public:
+  static BlockPrefetcher* GetSingleton() {
+    return Singleton<BlockPrefetcher>::get();
+  }
+
+  // Pass a metric entity to start recording metrics.
+  // This should be called before any iterator starts reading ahead.
+  void StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity);
+
+  // Run 'task', which reads blocks ahead, on the pool.
+  Status Submit(boost::function<void()> task);
+
+  // Record that an iterator needed a data block which had been read ahead.
+  void RecordHit();
+
+  // Record that an iterator reading ahead needed a data block which hadn't
+  // been read ahead, and read it synchronously.
+  void RecordMiss();
+
+  // Record that a data block of 'bytes' bytes was scheduled to be read ahead.
+  void RecordReadAhead(int64_t bytes);
+
+  // Record that a data block of 'bytes' bytes which was read ahead was
+  // discarded without being used.
+  void RecordWasted(int64_t bytes);
+
+ private:
+  friend class Singleton<BlockPrefetcher>;
+  BlockPrefetcher();
+
+  struct Metrics {
+    explicit Metrics(const scoped_refptr<MetricEntity>& metric_entity);
+
+    scoped_refptr<Counter> hits;
+    scoped_refptr<Counter> misses;
+    scoped_refptr<Counter> bytes;
+    scoped_refptr<Counter> wasted_bytes;
+  };
+
+  gscoped_ptr<ThreadPool> pool_;
+  gscoped_ptr<Metrics> metrics_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockPrefetcher);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
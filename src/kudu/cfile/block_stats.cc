@@ -0,0 +1,222 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+
+using std::string;
+using std::vector;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// The maximum length of the binary min/max values kept in the statistics.
+const size_t kMaxBinaryStatsValueLength = 128;
+
+bool IsNaN(DataType physical_type, const void* cell) {
+  if (physical_type == FLOAT) {
+    return std::isnan(*reinterpret_cast<const float*>(cell));
+  }
+  DCHECK_EQ(DOUBLE, physical_type);
+  return std::isnan(*reinterpret_cast<const double*>(cell));
+}
+
+// Returns a pointer to the encoded statistics value 'encoded', suitable for
+// comparisons with 'type_info', or nullptr if the value is malformed.
+// 'scratch' is used for binary values.
+const void* DecodeStatsValue(const TypeInfo* type_info, const string& encoded, Slice* scratch) {
+  if (type_info->physical_type() == BINARY) {
+    *scratch = Slice(encoded);
+    return scratch;
+  }
+  if (PREDICT_FALSE(encoded.size() != type_info->size())) {
+    return nullptr;
+  }
+  return encoded.data();
+}
+
+} // anonymous namespace
+
+BlockStatsBuilder::BlockStatsBuilder(const TypeInfo* type_info)
+    : type_info_(type_info),
+      is_floating_point_(type_info->physical_type() == FLOAT ||
+                         type_info->physical_type() == DOUBLE),
+      has_value_(false),
+      has_nan_(false),
+      null_count_(0) {
+}
+
+const void* BlockStatsBuilder::ValuePtr(const faststring& buf, Slice* scratch) const {
+  if (type_info_->physical_type() == BINARY) {
+    *scratch = Slice(buf);
+    return scratch;
+  }
+  return buf.data();
+}
+
+void BlockStatsBuilder::CopyValue(const void* cell, faststring* buf) const {
+  if (type_info_->physical_type() == BINARY) {
+    const Slice* s = reinterpret_cast<const Slice*>(cell);
+    buf->assign_copy(s->data(), s->size());
+  } else {
+    buf->assign_copy(reinterpret_cast<const uint8_t*>(cell), type_info_->size());
+  }
+}
+
+void BlockStatsBuilder::AddValues(const void* values, size_t count) {
+  const uint8_t* cell = reinterpret_cast<const uint8_t*>(values);
+  const size_t size = type_info_->size();
+  Slice min_scratch;
+  Slice max_scratch;
+  for (size_t i = 0; i < count; i++, cell += size) {
+    if (is_floating_point_ && PREDICT_FALSE(IsNaN(type_info_->physical_type(), cell))) {
+      has_nan_ = true;
+      continue;
+    }
+    if (PREDICT_FALSE(!has_value_)) {
+      CopyValue(cell, &min_);
+      CopyValue(cell, &max_);
+      has_value_ = true;
+      continue;
+    }
+    if (type_info_->Compare(cell, ValuePtr(min_, &min_scratch)) < 0) {
+      CopyValue(cell, &min_);
+    } else if (type_info_->Compare(cell, ValuePtr(max_, &max_scratch)) > 0) {
+      CopyValue(cell, &max_);
+    }
+  }
+}
+
+void BlockStatsBuilder::FinishBlock(rowid_t first_ordinal, size_t num_values) {
+  BlockStatsPB* block = stats_.add_blocks();
+  block->set_first_ordinal(first_ordinal);
+  block->set_num_values(num_values);
+  if (null_count_ > 0) {
+    block->set_null_count(null_count_);
+  }
+  if (has_value_ && !has_nan_) {
+    // A prefix of the min still bounds the values from below, but a prefix
+    // of the max doesn't bound them from above, so it's left out instead.
+    block->set_min_value(min_.data(), std::min(min_.size(), kMaxBinaryStatsValueLength));
+    if (max_.size() <= kMaxBinaryStatsValueLength) {
+      block->set_max_value(max_.data(), max_.size());
+    }
+  }
+
+  has_value_ = false;
+  has_nan_ = false;
+  null_count_ = 0;
+  min_.clear();
+  max_.clear();
+}
+
+StatsMatch EvaluatePredicateOnBlockStats(const ColumnPredicate& pred,
+                                         const TypeInfo* type_info,
+                                         const BlockStatsPB& stats) {
+  if (pred.predicate_type() == PredicateType::None) {
+    return StatsMatch::NONE;
+  }
+
+  const bool has_nulls = stats.null_count() > 0;
+  if (stats.null_count() >= stats.num_values()) {
+    // Every value is NULL.
+    return pred.predicate_type() == PredicateType::IsNull ? StatsMatch::ALL : StatsMatch::NONE;
+  }
+  switch (pred.predicate_type()) {
+    case PredicateType::IsNull: return has_nulls ? StatsMatch::SOME : StatsMatch::NONE;
+    case PredicateType::IsNotNull: return has_nulls ? StatsMatch::SOME : StatsMatch::ALL;
+    default: break;
+  }
+
+  // Every other predicate type only matches non-NULL values, so NULLs rule
+  // out StatsMatch::ALL. An unset max is treated as unbounded.
+  Slice min_scratch;
+  Slice max_scratch;
+  const void* min = stats.has_min_value() ?
+      DecodeStatsValue(type_info, stats.min_value(), &min_scratch) : nullptr;
+  const void* max = stats.has_max_value() ?
+      DecodeStatsValue(type_info, stats.max_value(), &max_scratch) : nullptr;
+  if (min == nullptr) {
+    return StatsMatch::SOME;
+  }
+
+  switch (pred.predicate_type()) {
+    case PredicateType::Range:
+    case PredicateType::InBloomFilter: {
+      // Only the bounds of a bloom filter predicate can be checked.
+      const void* lower = pred.raw_lower();
+      const void* upper = pred.raw_upper();
+      if ((upper != nullptr && type_info->Compare(min, upper) >= 0) ||
+          (lower != nullptr && max != nullptr && type_info->Compare(max, lower) < 0)) {
+        return StatsMatch::NONE;
+      }
+      if (pred.predicate_type() == PredicateType::Range && !has_nulls &&
+          (lower == nullptr || type_info->Compare(min, lower) >= 0) &&
+          (upper == nullptr || (max != nullptr && type_info->Compare(max, upper) < 0))) {
+        return StatsMatch::ALL;
+      }
+      return StatsMatch::SOME;
+    }
+    case PredicateType::Equality: {
+      const void* value = pred.raw_lower();
+      if (type_info->Compare(value, min) < 0 ||
+          (max != nullptr && type_info->Compare(value, max) > 0)) {
+        return StatsMatch::NONE;
+      }
+      if (!has_nulls && max != nullptr &&
+          type_info->Compare(min, value) == 0 && type_info->Compare(max, value) == 0) {
+        return StatsMatch::ALL;
+      }
+      return StatsMatch::SOME;
+    }
+    case PredicateType::InList: {
+      // The values of the list are sorted, so only the first value which is
+      // not less than the min needs to be checked against the max.
+      const vector<const void*>& values = pred.raw_values();
+      auto it = std::lower_bound(values.begin(), values.end(), min,
+                                 [&] (const void* a, const void* b) {
+                                   return type_info->Compare(a, b) < 0;
+                                 });
+      if (it == values.end() || (max != nullptr && type_info->Compare(*it, max) > 0)) {
+        return StatsMatch::NONE;
+      }
+      if (!has_nulls && max != nullptr &&
+          type_info->Compare(min, max) == 0 && type_info->Compare(*it, min) == 0) {
+        return StatsMatch::ALL;
+      }
+      return StatsMatch::SOME;
+    }
+    default: break;
+  }
+  return StatsMatch::SOME;
+}
+
+} // namespace cfile
+} // namespace kudu
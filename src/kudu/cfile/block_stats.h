@@ -0,0 +1,112 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_BLOCK_STATS_H
+#define KUDU_CFILE_BLOCK_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+
+class ColumnPredicate;
+class TypeInfo;
+
+namespace cfile {
+
+// The result of checking a predicate against the statistics of a range of
+// values.
+enum class StatsMatch {
+  // No value in the range can match the predicate.
+  NONE,
+
+  // Some values in the range may match the predicate.
+  SOME,
+
+  // Every value in the range matches the predicate.
+  ALL
+};
+
+// Accumulates the min/max values and null count of each data block of a
+// cfile as its values are appended.
+class BlockStatsBuilder {
+ public:
+  explicit BlockStatsBuilder(const TypeInfo* type_info);
+
+  // Adds 'count' non-NULL values, laid out contiguously at 'values', to the
+  // current block.
+  void AddValues(const void* values, size_t count);
+
+  // Adds 'count' NULL values to the current block.
+  void AddNulls(size_t count) {
+    null_count_ += count;
+  }
+
+  // Records the statistics of the current block, which holds 'num_values'
+  // values starting at ordinal 'first_ordinal', and starts a new block.
+  void FinishBlock(rowid_t first_ordinal, size_t num_values);
+
+  // Returns the statistics of every finished block.
+  const BlockStatsListPB& stats() const {
+    return stats_;
+  }
+
+ private:
+  // Returns the value held in 'buf', as a pointer suitable for comparisons
+  // with TypeInfo. 'scratch' is used for binary values.
+  const void* ValuePtr(const faststring& buf, Slice* scratch) const;
+
+  // Copies the value 'cell' into 'buf'.
+  void CopyValue(const void* cell, faststring* buf) const;
+
+  const TypeInfo* const type_info_;
+
+  // Whether the values are floating point, and may be NaN. NaN can't be
+  // ordered against other values, so blocks containing NaN have no min/max.
+  const bool is_floating_point_;
+
+  // Whether any non-NULL value has been added to the current block.
+  bool has_value_;
+  // Whether any NaN value has been added to the current block.
+  bool has_nan_;
+  int64_t null_count_;
+
+  // The min and max values of the current block, in their ColumnPredicatePB
+  // encoding.
+  faststring min_;
+  faststring max_;
+
+  BlockStatsListPB stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockStatsBuilder);
+};
+
+// Checks 'pred' against the statistics 'stats' of a block of values of type
+// 'type_info'.
+StatsMatch EvaluatePredicateOnBlockStats(const ColumnPredicate& pred,
+                                         const TypeInfo* type_info,
+                                         const BlockStatsPB& stats);
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
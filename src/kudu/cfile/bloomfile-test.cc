@@ -20,7 +20,9 @@
 #include <memory>
 #include <ostream>
 #include <utility>
+#include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -36,7 +38,10 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(bloomfile_split_block_blooms);
+
 using std::shared_ptr;
+using std::vector;
 
 namespace kudu {
 namespace cfile {
@@ -86,6 +91,44 @@ TEST_F(BloomFileTest, TestWriteAndRead) {
   VerifyBloomFile();
 }
 
+// Test split-block bloom files, and that the batched probe agrees with
+// probing the keys one by one.
+TEST_F(BloomFileTest, TestSplitBlockBloomsAndBatchedProbe) {
+  google::FlagSaver saver;
+  FLAGS_bloomfile_split_block_blooms = true;
+  ASSERT_NO_FATAL_FAILURE(WriteTestBloomFile());
+  ASSERT_OK(OpenBloomFile());
+  VerifyBloomFile();
+
+  // Probe every key in the range of the inserted ones, half of which weren't
+  // inserted, along with a key before and after the range.
+  const uint64_t kNumProbes = (FLAGS_n_keys << kKeyShift) + 2;
+  vector<uint64_t> keys;
+  keys.reserve(kNumProbes);
+  keys.push_back(0);
+  for (uint64_t i = 0; i < kNumProbes - 2; i++) {
+    keys.push_back(BigEndian::FromHost64(i));
+  }
+  keys.push_back(~0ULL);
+  vector<BloomKeyProbe> probes;
+  probes.reserve(kNumProbes);
+  for (const auto& key : keys) {
+    probes.emplace_back(Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)));
+  }
+  vector<const BloomKeyProbe*> probe_ptrs;
+  for (const auto& probe : probes) {
+    probe_ptrs.push_back(&probe);
+  }
+
+  unique_ptr<bool[]> maybe_present(new bool[kNumProbes]);
+  ASSERT_OK(bfr_->CheckKeysPresent(probe_ptrs.data(), kNumProbes, maybe_present.get()));
+  for (uint64_t i = 0; i < kNumProbes; i++) {
+    bool present = false;
+    ASSERT_OK_FAST(bfr_->CheckKeyPresent(probes[i], &present));
+    ASSERT_EQ(present, maybe_present[i]) << "probe " << i;
+  }
+}
+
 #ifdef NDEBUG
 TEST_F(BloomFileTest, Benchmark) {
   ASSERT_NO_FATAL_FAILURE(WriteTestBloomFile());
@@ -21,7 +21,7 @@
 #include <utility>
 #include <vector>
 
-#include <gflags/gflags_declare.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/cfile/block_handle.h"
@@ -38,7 +38,10 @@
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/coding.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/logging.h"
@@ -48,6 +51,14 @@
 
 DECLARE_bool(cfile_lazy_open);
 
+DEFINE_bool(bloomfile_split_block_blooms, false,
+            "Whether to write the bloom filters of new bloom files as split-block "
+            "bloom filters, which are faster to probe than classic bloom filters "
+            "but take slightly more space for the same false positive rate. Bloom "
+            "files written this way can't be read by versions of Kudu which "
+            "predate them.");
+TAG_FLAG(bloomfile_split_block_blooms, experimental);
+
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -80,14 +91,54 @@ class BloomCacheItem {
 
   // The block pointer to the specific block we read last time we used this bloom reader.
   BlockPointer cur_block_pointer;
-  // The block handle and parsed BloomFilter corresponding to cur_block_pointer.
+  // The block handle and parsed filter corresponding to cur_block_pointer.
+  // Only one of the filters is used, depending on the format of the file.
   BlockHandle cur_block_handle;
   BloomFilter cur_bloom;
+  BlockBloomFilter cur_block_bloom;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BloomCacheItem);
 };
 using BloomCacheTLC = ThreadLocalCache<uint64_t, BloomCacheItem>;
+
+// Returns the thread-local cache entry of the bloom file with the given nonce,
+// creating it if needed.
+BloomCacheItem* GetCacheItem(uint64_t instance_nonce, CFileReader* reader) {
+  // Since we frequently will access the same BloomFile many times in a row
+  // when processing a batch of operations, we put our state in a small thread-local
+  // cache, keyed by the BloomFileReader's nonce. We use this nonce rather than
+  // the BlockID because it's possible that a BloomFile could be closed and
+  // re-opened, in which case we don't want to use our previous cache entry,
+  // which now points to a destructed CFileReader.
+  auto* tlc = BloomCacheTLC::GetInstance();
+  BloomCacheItem* bci = tlc->Lookup(instance_nonce);
+  // If we didn't hit in the cache, make a new cache entry and instantiate a reader.
+  if (!bci) {
+    bci = tlc->EmplaceNew(instance_nonce, reader);
+  }
+  DCHECK_EQ(reader, bci->index_iter.cfile_reader())
+      << "Cached index reader does not match expected instance";
+  return bci;
+}
+
+// Checks the cached bloom block of 'bci' for the given probe(s).
+bool MayContainKey(const BloomCacheItem& bci, bool split_block, const BloomKeyProbe& probe) {
+  return split_block ? bci.cur_block_bloom.MayContainKey(probe) :
+      bci.cur_bloom.MayContainKey(probe);
+}
+
+void MayContainKeys(const BloomCacheItem& bci, bool split_block,
+                    const BloomKeyProbe* const* probes, size_t n, bool* maybe_present) {
+  if (split_block) {
+    bci.cur_block_bloom.MayContainKeys(probes, n, maybe_present);
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    maybe_present[i] = bci.cur_bloom.MayContainKey(*probes[i]);
+  }
+}
+
 } // anonymous namespace
 
 ////////////////////////////////////////////////////////////
@@ -95,11 +146,16 @@ using BloomCacheTLC = ThreadLocalCache<uint64_t, BloomCacheItem>;
 ////////////////////////////////////////////////////////////
 
 BloomFileWriter::BloomFileWriter(unique_ptr<WritableBlock> block,
-                                 const BloomFilterSizing &sizing)
-  : bloom_builder_(sizing) {
+                                 const BloomFilterSizing &sizing) {
   cfile::WriterOptions opts;
   opts.write_posidx = false;
   opts.write_validx = true;
+  if (FLAGS_bloomfile_split_block_blooms) {
+    block_bloom_builder_.reset(new BlockBloomFilterBuilder(sizing));
+    opts.split_block_bloom = true;
+  } else {
+    bloom_builder_.reset(new BloomFilterBuilder(sizing));
+  }
   // Never use compression, regardless of the default settings, since
   // bloom filters are high-entropy data structures by their nature.
   opts.storage_attributes.encoding  = PLAIN_ENCODING;
@@ -122,7 +178,7 @@ Status BloomFileWriter::Finish() {
 }
 
 Status BloomFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction) {
-  if (bloom_builder_.count() > 0) {
+  if (count() > 0) {
     RETURN_NOT_OK(FinishCurrentBloomBlock());
   }
   return writer_->FinishAndReleaseBlock(transaction);
@@ -132,20 +188,37 @@ size_t BloomFileWriter::written_size() const {
   return writer_->written_size();
 }
 
+void BloomFileWriter::AddKey(const BloomKeyProbe& probe) {
+  if (block_bloom_builder_) {
+    block_bloom_builder_->AddKey(probe);
+  } else {
+    bloom_builder_->AddKey(probe);
+  }
+}
+
+size_t BloomFileWriter::count() const {
+  return block_bloom_builder_ ? block_bloom_builder_->count() : bloom_builder_->count();
+}
+
+size_t BloomFileWriter::expected_count() const {
+  return block_bloom_builder_ ? block_bloom_builder_->expected_count() :
+      bloom_builder_->expected_count();
+}
+
 Status BloomFileWriter::AppendKeys(
   const Slice *keys, size_t n_keys) {
 
   // If this is the call on a new bloom, copy the first key.
-  if (bloom_builder_.count() == 0 && n_keys > 0) {
+  if (count() == 0 && n_keys > 0) {
     first_key_.assign_copy(keys[0].data(), keys[0].size());
   }
 
   for (size_t i = 0; i < n_keys; i++) {
 
-    bloom_builder_.AddKey(BloomKeyProbe(keys[i]));
+    AddKey(BloomKeyProbe(keys[i]));
 
     // Bloom has reached optimal occupancy: flush it to the file
-    if (PREDICT_FALSE(bloom_builder_.count() >= bloom_builder_.expected_count())) {
+    if (PREDICT_FALSE(count() >= expected_count())) {
       RETURN_NOT_OK(FinishCurrentBloomBlock());
 
       // Update the last key and set the next key as the first key of the next block.
@@ -165,9 +238,11 @@ Status BloomFileWriter::FinishCurrentBloomBlock() {
   VLOG(1) << "Appending a new bloom block, first_key="
           << KUDU_REDACT(Slice(first_key_).ToDebugString());
 
-  // Encode the header.
+  // Encode the header. A split-block bloom filter always sets one bit in
+  // each word of a bucket.
   BloomBlockHeaderPB hdr;
-  hdr.set_num_hash_functions(bloom_builder_.n_hashes());
+  hdr.set_num_hash_functions(block_bloom_builder_ ? block_bloom::kBucketWords :
+                             bloom_builder_->n_hashes());
   faststring hdr_str;
   PutFixed32(&hdr_str, hdr.ByteSize());
   pb_util::AppendToString(hdr, &hdr_str);
@@ -175,14 +250,19 @@ Status BloomFileWriter::FinishCurrentBloomBlock() {
   // The data is the concatenation of the header and the bloom itself.
   vector<Slice> slices;
   slices.emplace_back(hdr_str);
-  slices.push_back(bloom_builder_.slice());
+  slices.push_back(block_bloom_builder_ ? block_bloom_builder_->slice() :
+                   bloom_builder_->slice());
 
   // Append to the file.
   Slice start_key(first_key_);
   Slice last_key(last_key_);
   RETURN_NOT_OK(writer_->AppendRawBlock(slices, 0, &start_key, last_key, "bloom block"));
 
-  bloom_builder_.Clear();
+  if (block_bloom_builder_) {
+    block_bloom_builder_->Clear();
+  } else {
+    bloom_builder_->Clear();
+  }
 
   #ifndef NDEBUG
   first_key_.assign_copy("POST_RESET");
@@ -228,6 +308,7 @@ BloomFileReader::BloomFileReader(unique_ptr<CFileReader> reader,
 
     : instance_nonce_(base::subtle::NoBarrier_AtomicIncrement(&g_next_nonce, 1)),
       reader_(std::move(reader)),
+      split_block_(false),
       mem_consumption_(std::move(options.parent_mem_tracker),
                        memory_footprint_excluding_reader()) {
 }
@@ -250,6 +331,8 @@ Status BloomFileReader::InitOnce() {
     return Status::Corruption("bloom file missing value index",
                               reader_->ToString());
   }
+  split_block_ = reader_->footer().incompatible_features() &
+      IncompatibleFeatures::SPLIT_BLOCK_BLOOM;
   return Status::OK();
 }
 
@@ -282,27 +365,36 @@ Status BloomFileReader::ParseBlockHeader(const Slice &block,
   return Status::OK();
 }
 
+Status BloomFileReader::ReadBloomBlock(const BlockPointer& ptr, BlockHandle* handle,
+                                       BloomFilter* bloom, BlockBloomFilter* block_bloom) const {
+  BlockHandle dblk_data;
+  RETURN_NOT_OK(reader_->ReadBlock(ptr, CFileReader::CACHE_BLOCK, &dblk_data));
+
+  // Parse the header in the block.
+  BloomBlockHeaderPB hdr;
+  Slice bloom_data;
+  RETURN_NOT_OK(ParseBlockHeader(dblk_data.data(), &hdr, &bloom_data));
+
+  if (split_block_) {
+    if (PREDICT_FALSE(!BlockBloomFilter::IsValidSize(bloom_data.size()))) {
+      return Status::Corruption(
+          StringPrintf("Invalid split-block bloom filter size: %ld", bloom_data.size()),
+          reader_->ToString());
+    }
+    *block_bloom = BlockBloomFilter(bloom_data);
+  } else {
+    *bloom = BloomFilter(bloom_data, hdr.num_hash_functions());
+  }
+  *handle = std::move(dblk_data);
+  return Status::OK();
+}
+
 Status BloomFileReader::CheckKeyPresent(const BloomKeyProbe &probe,
                                         bool *maybe_present) {
   DCHECK(init_once_.init_succeeded());
+  BloomCacheItem* bci = GetCacheItem(instance_nonce_, reader_.get());
 
-  // Since we frequently will access the same BloomFile many times in a row
-  // when processing a batch of operations, we put our state in a small thread-local
-  // cache, keyed by the BloomFileReader's nonce. We use this nonce rather than
-  // the BlockID because it's possible that a BloomFile could be closed and
-  // re-opened, in which case we don't want to use our previous cache entry,
-  // which now points to a destructed CFileReader.
-  auto* tlc = BloomCacheTLC::GetInstance();
-  BloomCacheItem* bci = tlc->Lookup(instance_nonce_);
-  // If we didn't hit in the cache, make a new cache entry and instantiate a reader.
-  if (!bci) {
-    bci = tlc->EmplaceNew(instance_nonce_, reader_.get());
-  }
-  DCHECK_EQ(reader_.get(), bci->index_iter.cfile_reader())
-      << "Cached index reader does not match expected instance";
-
-  IndexTreeIterator* index_iter = &bci->index_iter;
-  Status s = index_iter->SeekAtOrBefore(probe.key());
+  Status s = bci->index_iter.SeekAtOrBefore(probe.key());
   if (PREDICT_FALSE(s.IsNotFound())) {
     // Seek to before the first entry in the file.
     *maybe_present = false;
@@ -310,29 +402,61 @@ Status BloomFileReader::CheckKeyPresent(const BloomKeyProbe &probe,
   }
   RETURN_NOT_OK(s);
 
-  // Successfully found the pointer to the bloom block.
-  BlockPointer bblk_ptr = index_iter->GetCurrentBlockPointer();
-
-  // If the previous lookup from this bloom on this thread seeked to a different
-  // block in the BloomFile, we need to read the correct block and re-hydrate the
-  // BloomFilter instance.
+  // Successfully found the pointer to the bloom block: actually check the
+  // bloom filter. If the previous lookup from this bloom on this thread
+  // seeked to a different block in the BloomFile, we need to read the correct
+  // block and re-hydrate the filter instance.
+  BlockPointer bblk_ptr = bci->index_iter.GetCurrentBlockPointer();
   if (!bci->cur_block_pointer.Equals(bblk_ptr)) {
-    BlockHandle dblk_data;
-    RETURN_NOT_OK(reader_->ReadBlock(bblk_ptr, CFileReader::CACHE_BLOCK, &dblk_data));
-
-    // Parse the header in the block.
-    BloomBlockHeaderPB hdr;
-    Slice bloom_data;
-    RETURN_NOT_OK(ParseBlockHeader(dblk_data.data(), &hdr, &bloom_data));
-
-    // Save the data back into our threadlocal cache.
-    bci->cur_bloom = BloomFilter(bloom_data, hdr.num_hash_functions());
+    RETURN_NOT_OK(ReadBloomBlock(bblk_ptr, &bci->cur_block_handle,
+                                 &bci->cur_bloom, &bci->cur_block_bloom));
     bci->cur_block_pointer = bblk_ptr;
-    bci->cur_block_handle = std::move(dblk_data);
   }
+  *maybe_present = MayContainKey(*bci, split_block_, probe);
+  return Status::OK();
+}
+
+Status BloomFileReader::CheckKeysPresent(const BloomKeyProbe* const* probes, size_t n,
+                                         bool* maybe_present) {
+  DCHECK(init_once_.init_succeeded());
+  BloomCacheItem* bci = GetCacheItem(instance_nonce_, reader_.get());
+  IndexTreeIterator* index_iter = &bci->index_iter;
+
+  faststring next_block_key;
+  size_t i = 0;
+  while (i < n) {
+    DCHECK(i == 0 || probes[i - 1]->key().compare(probes[i]->key()) <= 0)
+        << "probes must be sorted";
+    Status s = index_iter->SeekAtOrBefore(probes[i]->key());
+    if (PREDICT_FALSE(s.IsNotFound())) {
+      // Seek to before the first entry in the file.
+      maybe_present[i++] = false;
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    BlockPointer bblk_ptr = index_iter->GetCurrentBlockPointer();
+    if (!bci->cur_block_pointer.Equals(bblk_ptr)) {
+      RETURN_NOT_OK(ReadBloomBlock(bblk_ptr, &bci->cur_block_handle,
+                                   &bci->cur_bloom, &bci->cur_block_bloom));
+      bci->cur_block_pointer = bblk_ptr;
+    }
 
-  // Actually check the bloom filter.
-  *maybe_present = bci->cur_bloom.MayContainKey(probe);
+    // The block covers the keys up to the first key of the next block, if
+    // any: find the probes which fall into it.
+    size_t end = i + 1;
+    if (index_iter->HasNext()) {
+      RETURN_NOT_OK(index_iter->Next());
+      Slice next_key = index_iter->GetCurrentKey();
+      next_block_key.assign_copy(next_key.data(), next_key.size());
+      while (end < n && probes[end]->key().compare(Slice(next_block_key)) < 0) {
+        end++;
+      }
+    } else {
+      end = n;
+    }
+    MayContainKeys(*bci, split_block_, probes + i, end - i, maybe_present + i);
+    i = end;
+  }
   return Status::OK();
 }
 
@@ -24,6 +24,7 @@
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/mem_tracker.h"
@@ -44,6 +45,11 @@ namespace cfile {
 class BloomBlockHeaderPB;
 struct ReaderOptions;
 
+// Writer for a bloom file.
+//
+// If --bloomfile_split_block_blooms is set, the bloom blocks are written as
+// split-block bloom filters, which are faster to probe but can't be read by
+// versions of Kudu which predate them.
 class BloomFileWriter {
  public:
   BloomFileWriter(std::unique_ptr<fs::WritableBlock> block,
@@ -67,9 +73,17 @@ class BloomFileWriter {
 
   Status FinishCurrentBloomBlock();
 
+  // Accessors which dispatch to whichever of the builders below is in use.
+  void AddKey(const BloomKeyProbe& probe);
+  size_t count() const;
+  size_t expected_count() const;
+
   std::unique_ptr<cfile::CFileWriter> writer_;
 
-  BloomFilterBuilder bloom_builder_;
+  // Exactly one of these is set, depending on whether split-block bloom
+  // filters are written.
+  std::unique_ptr<BloomFilterBuilder> bloom_builder_;
+  std::unique_ptr<BlockBloomFilterBuilder> block_bloom_builder_;
 
   // first key inserted in the current block.
   faststring first_key_;
@@ -115,6 +129,15 @@ class BloomFileReader {
   Status CheckKeyPresent(const BloomKeyProbe &probe,
                          bool* maybe_present);
 
+  // Batched version of CheckKeyPresent(): sets maybe_present[i] for the key
+  // of each of the 'n' probes, which must be sorted by key.
+  //
+  // The probes which fall into the same bloom block are checked together,
+  // which for split-block bloom filters uses the SIMD probe of
+  // BlockBloomFilter::MayContainKeys().
+  Status CheckKeysPresent(const BloomKeyProbe* const* probes, size_t n,
+                          bool* maybe_present);
+
   // Can be called before Init().
   uint64_t FileSize() const {
     return reader_->file_size();
@@ -137,6 +160,12 @@ class BloomFileReader {
   // Callback used in 'init_once_' to initialize this bloom file.
   Status InitOnce();
 
+  // Reads the bloom block at 'ptr' into 'handle', and parses its filter into
+  // 'bloom' or, for a split-block bloom file, into 'block_bloom'. The outputs
+  // are left untouched on error.
+  Status ReadBloomBlock(const BlockPointer& ptr, BlockHandle* handle,
+                        BloomFilter* bloom, BlockBloomFilter* block_bloom) const;
+
   // Returns the memory usage of this object including the object itself but
   // excluding the CFileReader, which is tracked independently.
   size_t memory_footprint_excluding_reader() const;
@@ -149,6 +178,9 @@ class BloomFileReader {
 
   std::unique_ptr<CFileReader> reader_;
 
+  // Whether the bloom blocks are split-block bloom filters. Set by Init().
+  bool split_block_;
+
   KuduOnceDynamic init_once_;
 
   ScopedTrackedConsumption mem_consumption_;
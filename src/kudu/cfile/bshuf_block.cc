@@ -163,6 +163,18 @@ Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* arra
   return Status::OK();
 }
 
+// Template specialization for UINT32, whose values may have been narrowed to
+// UINT8 or UINT16: the caller evaluates the predicate on the expanded values.
+template<>
+Status BShufBlockDecoder<UINT32>::CopyNextAndEval(size_t* n,
+                                                  ColumnMaterializationContext* ctx,
+                                                  SelectionVectorView* sel,
+                                                  ColumnDataView* dst) {
+  RETURN_NOT_OK(CopyNextValues(n, dst));
+  ctx->SetDecoderEvalNotSupported();
+  return Status::OK();
+}
+
 
 } // namespace cfile
 } // namespace kudu
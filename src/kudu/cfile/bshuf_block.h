@@ -328,6 +328,28 @@ class BShufBlockDecoder final : public BlockDecoder {
     return CopyNextValuesToArray(n, dst->data());
   }
 
+  // Evaluates the predicate straight from the unshuffled values, so that only
+  // the values of the selected rows are copied out.
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    EvalAndCopySelectedCells<Type>(&decoded_[cur_idx_ * size_of_type], max_fetch, ctx, sel, dst);
+
+    *n = max_fetch;
+    cur_idx_ += max_fetch;
+    return Status::OK();
+  }
+
   // Copy the codewords to a temporary buffer.
   // This API provides a more convenient way for the dictionary decoder to copy out
   // integer codewords and then look up the strings. If we use the CopyNextValuesToArray()
@@ -418,6 +440,11 @@ template<>
 Status BShufBlockDecoder<UINT32>::SeekAtOrAfterValue(const void* value_void, bool* exact);
 template<>
 Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* array);
+template<>
+Status BShufBlockDecoder<UINT32>::CopyNextAndEval(size_t* n,
+                                                  ColumnMaterializationContext* ctx,
+                                                  SelectionVectorView* sel,
+                                                  ColumnDataView* dst);
 
 
 } // namespace cfile
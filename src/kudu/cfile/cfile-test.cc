@@ -34,6 +34,8 @@
 #include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/block_prefetcher.h"
+#include "kudu/cfile/block_stats.h"
 #include "kudu/cfile/cfile-test-base.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_reader.h"
@@ -42,6 +44,7 @@
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
@@ -60,10 +63,12 @@
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/array_view.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/int128.h"
 #include "kudu/util/int128_util.h"
 #include "kudu/util/mem_tracker.h"
@@ -76,7 +81,11 @@
 #include "kudu/util/test_util.h"
 
 DECLARE_bool(cfile_write_checksums);
+DECLARE_bool(env_use_io_uring);
 DECLARE_bool(cfile_verify_checksums);
+DECLARE_int32(cfile_compression_dictionary_size);
+DECLARE_int32(cfile_compression_dictionary_training_bytes);
+DECLARE_int32(cfile_read_ahead_blocks);
 
 #if defined(__linux__)
 DECLARE_string(nvm_cache_path);
@@ -84,6 +93,10 @@ DECLARE_bool(nvm_cache_simulate_allocation_failure);
 #endif
 
 METRIC_DECLARE_counter(block_cache_hits_caching);
+METRIC_DECLARE_counter(cfile_read_ahead_bytes);
+METRIC_DECLARE_counter(cfile_read_ahead_hits);
+METRIC_DECLARE_counter(cfile_read_ahead_misses);
+METRIC_DECLARE_counter(cfile_read_ahead_wasted_bytes);
 
 METRIC_DECLARE_entity(server);
 
@@ -786,6 +799,258 @@ TEST_P(TestCFileBothCacheTypes, TestMetadata) {
   }
 }
 
+// Test that per-block statistics are written when requested, and that
+// predicates are evaluated against them.
+TEST_P(TestCFileBothCacheTypes, TestBlockStats) {
+  const int kNumItems = 10000;
+  for (bool write_block_stats : {false, true}) {
+    SCOPED_TRACE(write_block_stats);
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    BlockId block_id = sink->id();
+    WriterOptions opts;
+    opts.write_block_stats = write_block_stats;
+    opts.storage_attributes.encoding = PLAIN_ENCODING;
+    opts.storage_attributes.cfile_block_size = 1024;
+    CFileWriter w(opts, GetTypeInfo(INT32), false, std::move(sink));
+    ASSERT_OK(w.Start());
+    vector<int32_t> values(kNumItems);
+    for (int i = 0; i < kNumItems; i++) {
+      values[i] = i;
+    }
+    ASSERT_OK(w.AppendEntries(values.data(), kNumItems));
+    ASSERT_OK(w.Finish());
+
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    ASSERT_EQ(write_block_stats, reader->has_block_stats());
+
+    ColumnSchema col("c", INT32);
+    int32_t lower = 5000;
+    int32_t upper = 5010;
+    int32_t max = kNumItems;
+    auto range = ColumnPredicate::Range(col, &lower, &upper);
+    auto all = ColumnPredicate::Range(col, nullptr, &max);
+    auto equality = ColumnPredicate::Equality(col, &lower);
+
+    StatsMatch match;
+    ASSERT_OK(reader->EvaluatePredicateOnStats(range, 0, 100, &match));
+    ASSERT_EQ(write_block_stats ? StatsMatch::NONE : StatsMatch::SOME, match);
+    ASSERT_OK(reader->EvaluatePredicateOnStats(range, 4990, 100, &match));
+    ASSERT_EQ(StatsMatch::SOME, match);
+    ASSERT_OK(reader->EvaluatePredicateOnStats(equality, 8000, 1000, &match));
+    ASSERT_EQ(write_block_stats ? StatsMatch::NONE : StatsMatch::SOME, match);
+    ASSERT_OK(reader->EvaluatePredicateOnStats(all, 0, kNumItems, &match));
+    ASSERT_EQ(write_block_stats ? StatsMatch::ALL : StatsMatch::SOME, match);
+    ASSERT_OK(reader->EvaluatePredicateOnStats(ColumnPredicate::IsNull(col), 0, 10, &match));
+    ASSERT_EQ(write_block_stats ? StatsMatch::NONE : StatsMatch::SOME, match);
+
+    // Ranges extending past the end of the file are never conclusive.
+    ASSERT_OK(reader->EvaluatePredicateOnStats(all, kNumItems - 10, 20, &match));
+    ASSERT_EQ(StatsMatch::SOME, match);
+  }
+}
+
+TEST_P(TestCFileBothCacheTypes, TestReadAhead) {
+  const int kNumItems = 10000;
+  const int kBatchSize = 100;
+  FLAGS_cfile_read_ahead_blocks = 4;
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockPrefetcher::GetSingleton()->StartInstrumentation(entity);
+
+  // Write ~40 small blocks.
+  unique_ptr<WritableBlock> sink;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+  BlockId block_id = sink->id();
+  WriterOptions opts;
+  opts.storage_attributes.encoding = PLAIN_ENCODING;
+  opts.storage_attributes.cfile_block_size = 1024;
+  CFileWriter w(opts, GetTypeInfo(INT32), false, std::move(sink));
+  ASSERT_OK(w.Start());
+  vector<int32_t> values(kNumItems);
+  for (int i = 0; i < kNumItems; i++) {
+    values[i] = i;
+  }
+  ASSERT_OK(w.AppendEntries(values.data(), kNumItems));
+  ASSERT_OK(w.Finish());
+
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::DONT_CACHE_BLOCK));
+
+  // Scan the first half of the file, then skip ahead, discarding the blocks
+  // read ahead, and scan the last fifth.
+  ScopedColumnBlock<INT32> out(kBatchSize);
+  SelectionVector sel(kBatchSize);
+  for (int start : { 0, 8000 }) {
+    ASSERT_OK(iter->SeekToOrdinal(start));
+    int end = start == 0 ? kNumItems / 2 : kNumItems;
+    for (int row = start; row < end; ) {
+      size_t n = kBatchSize;
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&out, &sel);
+      ASSERT_OK(iter->CopyNextValues(&n, &ctx));
+      ASSERT_EQ(kBatchSize, n);
+      for (int i = 0; i < n; i++) {
+        ASSERT_EQ(row + i, out[i]);
+      }
+      row += n;
+    }
+  }
+
+  auto counter_value = [&](const CounterPrototype& proto) {
+    return down_cast<Counter*>(entity->FindOrNull(proto).get())->value();
+  };
+  int64_t hits = counter_value(METRIC_cfile_read_ahead_hits);
+  int64_t misses = counter_value(METRIC_cfile_read_ahead_misses);
+  LOG(INFO) << "Read-ahead hits: " << hits << " misses: " << misses
+            << " bytes: " << counter_value(METRIC_cfile_read_ahead_bytes)
+            << " wasted bytes: " << counter_value(METRIC_cfile_read_ahead_wasted_bytes);
+  // Only the first block read after each seek is a miss.
+  EXPECT_GT(hits, 15);
+  EXPECT_EQ(2, misses);
+  EXPECT_GT(counter_value(METRIC_cfile_read_ahead_wasted_bytes), 0);
+
+  // Destroying the iterator discards the rest of the window.
+  iter.reset();
+  EXPECT_LT(counter_value(METRIC_cfile_read_ahead_wasted_bytes),
+            counter_value(METRIC_cfile_read_ahead_bytes));
+}
+
+// Test that a batch of blocks which aren't all adjacent in the file, some of
+// them cached, is read correctly.
+TEST_P(TestCFileBothCacheTypes, TestReadBlocks) {
+  const int kNumItems = 10000;
+  FLAGS_env_use_io_uring = true;
+  FLAGS_cfile_write_checksums = true;
+  FLAGS_cfile_verify_checksums = true;
+
+  // Write ~40 small blocks.
+  unique_ptr<WritableBlock> sink;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+  BlockId block_id = sink->id();
+  WriterOptions opts;
+  opts.storage_attributes.encoding = PLAIN_ENCODING;
+  opts.storage_attributes.cfile_block_size = 1024;
+  CFileWriter w(opts, GetTypeInfo(INT32), false, std::move(sink));
+  ASSERT_OK(w.Start());
+  vector<int32_t> values(kNumItems);
+  for (int i = 0; i < kNumItems; i++) {
+    values[i] = i;
+  }
+  ASSERT_OK(w.AppendEntries(values.data(), kNumItems));
+  ASSERT_OK(w.Finish());
+
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+  ASSERT_OK(reader->Init());
+
+  // Collect the pointers to the data blocks.
+  vector<BlockPointer> ptrs;
+  unique_ptr<IndexTreeIterator> idx_iter(IndexTreeIterator::Create(
+      reader.get(), BlockPointer(reader->footer().posidx_info().root_block())));
+  ASSERT_OK(idx_iter->SeekToFirst());
+  ptrs.push_back(idx_iter->GetCurrentBlockPointer());
+  while (idx_iter->HasNext()) {
+    ASSERT_OK(idx_iter->Next());
+    ptrs.push_back(idx_iter->GetCurrentBlockPointer());
+  }
+  ASSERT_GT(ptrs.size(), 30);
+
+  // Read every third pair of blocks into the cache, then all the blocks. The
+  // blocks aren't compressed, so they must match the data of the file.
+  vector<BlockPointer> some_ptrs;
+  for (int i = 0; i < ptrs.size(); i++) {
+    if (i % 6 < 2) {
+      some_ptrs.push_back(ptrs[i]);
+    }
+  }
+  unique_ptr<ReadableBlock> raw;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &raw));
+  for (const auto* batch : { &some_ptrs, &ptrs }) {
+    vector<BlockHandle> handles(batch->size());
+    ASSERT_OK(reader->ReadBlocks(ArrayView<const BlockPointer>(*batch),
+                                 CFileReader::CACHE_BLOCK, handles.data()));
+    for (int i = 0; i < batch->size(); i++) {
+      const BlockPointer& ptr = (*batch)[i];
+      // The checksum of each block follows its data.
+      ASSERT_EQ(ptr.size() - 4, handles[i].data().size());
+      faststring expected;
+      expected.resize(handles[i].data().size());
+      ASSERT_OK(raw->Read(ptr.offset(), Slice(expected)));
+      ASSERT_EQ(Slice(expected), handles[i].data()) << "block " << ptr.ToString();
+    }
+  }
+}
+
+// Test that a ZSTD-compressed file whose blocks are compressed with a trained
+// dictionary can be read back, and is smaller than without the dictionary.
+TEST_P(TestCFileBothCacheTypes, TestCompressionDictionary) {
+  const int kNumItems = 50000;
+  FLAGS_cfile_compression_dictionary_training_bytes = 256 * 1024;
+  vector<string> values;
+  values.reserve(kNumItems);
+  for (int i = 0; i < kNumItems; i++) {
+    values.push_back(Substitute("host-$0.rack-$1.example.com:$2",
+                                i % 97, i % 13, 7000 + i % 5));
+  }
+
+  uint64_t file_sizes[2];
+  for (int dict_size : { 0, 16 * 1024 }) {
+    FLAGS_cfile_compression_dictionary_size = dict_size;
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    BlockId block_id = sink->id();
+    WriterOptions opts;
+    opts.storage_attributes.encoding = PLAIN_ENCODING;
+    opts.storage_attributes.compression = ZSTD;
+    opts.storage_attributes.cfile_block_size = 4 * 1024;
+    CFileWriter w(opts, GetTypeInfo(STRING), false, std::move(sink));
+    ASSERT_OK(w.Start());
+    for (const string& value : values) {
+      Slice slice(value);
+      ASSERT_OK(w.AppendEntries(&slice, 1));
+    }
+    ASSERT_OK(w.Finish());
+
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    ASSERT_OK(source->Size(&file_sizes[dict_size > 0]));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    ASSERT_EQ(dict_size > 0, reader->footer().has_compression_dictionary());
+    ASSERT_EQ(dict_size > 0, (reader->footer().incompatible_features() &
+                              IncompatibleFeatures::COMPRESSION_DICTIONARY) != 0);
+
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToFirst());
+    ScopedColumnBlock<STRING> out(100);
+    SelectionVector sel(100);
+    int row = 0;
+    while (iter->HasNext()) {
+      size_t n = out.nrows();
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&out, &sel);
+      ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+      for (int i = 0; i < n; i++) {
+        ASSERT_EQ(values[row + i], out[i].ToString());
+      }
+      row += n;
+    }
+    ASSERT_EQ(kNumItems, row);
+  }
+  LOG(INFO) << "File size without dictionary: " << file_sizes[0]
+            << ", with dictionary: " << file_sizes[1];
+  ASSERT_LT(file_sizes[1], file_sizes[0]);
+}
+
 TEST_P(TestCFileBothCacheTypes, TestDefaultColumnIter) {
   const int kNumItems = 64;
   uint8_t null_bitmap[BitmapSize(kNumItems)];
@@ -840,6 +1105,7 @@ TEST_P(TestCFileBothCacheTypes, TestAppendRaw) {
   TestReadWriteRawBlocks(SNAPPY, 1000);
   TestReadWriteRawBlocks(LZ4, 1000);
   TestReadWriteRawBlocks(ZLIB, 1000);
+  TestReadWriteRawBlocks(ZSTD, 1000);
 }
 
 TEST_P(TestCFileBothCacheTypes, TestChecksumFlags) {
@@ -1043,7 +1309,7 @@ class TestCFileDifferentCodecs : public TestCFile,
 };
 
 INSTANTIATE_TEST_CASE_P(Codecs, TestCFileDifferentCodecs,
-                        ::testing::Values(NO_COMPRESSION, SNAPPY, LZ4, ZLIB));
+                        ::testing::Values(NO_COMPRESSION, SNAPPY, LZ4, ZLIB, ZSTD));
 
 // Read/write a file with uncompressible data (random int32s)
 TEST_P(TestCFileDifferentCodecs, TestUncompressible) {
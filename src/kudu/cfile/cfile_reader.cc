@@ -23,6 +23,7 @@
 #include <ostream>
 #include <utility>
 
+#include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
@@ -30,6 +31,7 @@
 #include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_compression.h"
 #include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/block_prefetcher.h"
 #include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_util.h"
@@ -53,8 +55,10 @@
 #include "kudu/util/cache.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/malloc.h"
@@ -71,6 +75,13 @@ DEFINE_bool(cfile_lazy_open, true,
             "Allow lazily opening of cfiles");
 TAG_FLAG(cfile_lazy_open, hidden);
 
+DEFINE_int32(cfile_read_ahead_blocks, 0,
+             "Number of data blocks which each CFile iterator reads ahead of a "
+             "sequential scan, in the background. Adjacent blocks are read with a "
+             "single I/O. If 0, data blocks are only read when they are needed.");
+TAG_FLAG(cfile_read_ahead_blocks, experimental);
+TAG_FLAG(cfile_read_ahead_blocks, runtime);
+
 DEFINE_bool(cfile_verify_checksums, true,
             "Verify the checksum for each block on read if one exists");
 TAG_FLAG(cfile_verify_checksums, evolving);
@@ -304,6 +315,16 @@ Status CFileReader::ReadAndParseFooter() {
   if (footer_->compression() != NO_COMPRESSION) {
     RETURN_NOT_OK_PREPEND(GetCompressionCodec(footer_->compression(), &codec_),
                           "failed to load CFile compression codec");
+    if (footer_->incompatible_features() & IncompatibleFeatures::COMPRESSION_DICTIONARY) {
+      if (PREDICT_FALSE(!footer_->has_compression_dictionary())) {
+        return Status::Corruption("missing CFile compression dictionary");
+      }
+      RETURN_NOT_OK_PREPEND(NewCompressionCodecWithDictionary(
+                                footer_->compression(),
+                                footer_->compression_dictionary().dictionary(),
+                                &dictionary_codec_),
+                            "failed to load CFile compression dictionary");
+    }
   }
 
   VLOG(2) << "Read footer: " << SecureDebugString(*footer_);
@@ -311,10 +332,85 @@ Status CFileReader::ReadAndParseFooter() {
   return Status::OK();
 }
 
+const CompressionCodec* CFileReader::codec_for_block(const BlockPointer& ptr) const {
+  if (dictionary_codec_ != nullptr &&
+      ptr.offset() >= footer_->compression_dictionary().first_block_offset()) {
+    return dictionary_codec_.get();
+  }
+  return codec_;
+}
+
 bool CFileReader::has_checksums() const {
   return footer_->incompatible_features() & IncompatibleFeatures::CHECKSUM;
 }
 
+bool CFileReader::has_block_stats() const {
+  return (footer().compatible_features() & CompatibleFeatures::BLOCK_STATS) &&
+      footer().has_block_stats_ptr();
+}
+
+Status CFileReader::ReadBlockStatsOnce() {
+  // The parsed statistics are kept for the lifetime of the reader, so
+  // there's no need to also cache the raw block.
+  BlockHandle handle;
+  RETURN_NOT_OK(ReadBlock(BlockPointer(footer().block_stats_ptr()), DONT_CACHE_BLOCK, &handle));
+  gscoped_ptr<BlockStatsListPB> block_stats(new BlockStatsListPB);
+  RETURN_NOT_OK_PREPEND(pb_util::ParseFromArray(block_stats.get(),
+                                                handle.data().data(),
+                                                handle.data().size()),
+                        "failed to parse block stats");
+  block_stats_ = std::move(block_stats);
+
+  // The statistics have been allocated; memory consumption has changed.
+  mem_consumption_.Reset(memory_footprint());
+  return Status::OK();
+}
+
+Status CFileReader::EvaluatePredicateOnStats(const ColumnPredicate& pred,
+                                             rowid_t first_ordinal,
+                                             size_t nrows,
+                                             StatsMatch* match) {
+  *match = StatsMatch::SOME;
+  if (!has_block_stats() || nrows == 0) {
+    return Status::OK();
+  }
+  RETURN_NOT_OK_PREPEND(block_stats_once_.Init(&CFileReader::ReadBlockStatsOnce, this),
+                        Substitute("failed to read block stats of CFile $0",
+                                   block_id().ToString()));
+
+  // Find the last block starting at or before 'first_ordinal'.
+  const auto& blocks = block_stats_->blocks();
+  auto it = std::upper_bound(blocks.begin(), blocks.end(), first_ordinal,
+                             [] (rowid_t ordinal, const BlockStatsPB& block) {
+                               return ordinal < block.first_ordinal();
+                             });
+  if (it == blocks.begin()) {
+    return Status::OK();
+  }
+  --it;
+
+  // The result is only conclusive if every block holding the requested
+  // values is, and all of them agree.
+  const int64_t end_ordinal = static_cast<int64_t>(first_ordinal) + nrows;
+  int64_t next_ordinal = it->first_ordinal();
+  boost::optional<StatsMatch> result;
+  for (; it != blocks.end() && next_ordinal < end_ordinal; ++it) {
+    if (it->first_ordinal() != next_ordinal) {
+      return Status::OK();
+    }
+    StatsMatch block_match = EvaluatePredicateOnBlockStats(pred, type_info_, *it);
+    if (block_match == StatsMatch::SOME || (result && *result != block_match)) {
+      return Status::OK();
+    }
+    result = block_match;
+    next_ordinal += it->num_values();
+  }
+  if (result && next_ordinal >= end_ordinal) {
+    *match = *result;
+  }
+  return Status::OK();
+}
+
 Status CFileReader::VerifyChecksum(ArrayView<const Slice> data, const Slice& checksum) const {
   uint32_t expected_checksum = DecodeFixed32(checksum.data());
   uint32_t checksum_value = 0;
@@ -418,7 +514,42 @@ class ScratchMemory {
 
 Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
                               BlockHandle *ret) const {
+  return ReadBlocks(ArrayView<const BlockPointer>(&ptr, 1), cache_control, ret);
+}
+
+Status CFileReader::ReadBlocks(ArrayView<const BlockPointer> ptrs, CacheControl cache_control,
+                               BlockHandle* rets) const {
   DCHECK(init_once_.init_succeeded());
+  if (ptrs.size() == 1) {
+    if (LookupBlock(ptrs[0], cache_control, rets)) {
+      return Status::OK();
+    }
+    return ReadUncachedBlocks(ptrs, cache_control, rets);
+  }
+
+  // Look the blocks up in the cache, and read all the others at once.
+  vector<BlockPointer> uncached_ptrs;
+  vector<size_t> uncached_indexes;
+  for (size_t i = 0; i < ptrs.size(); i++) {
+    if (!LookupBlock(ptrs[i], cache_control, &rets[i])) {
+      uncached_ptrs.push_back(ptrs[i]);
+      uncached_indexes.push_back(i);
+    }
+  }
+  if (uncached_ptrs.empty()) {
+    return Status::OK();
+  }
+  vector<BlockHandle> uncached_rets(uncached_ptrs.size());
+  RETURN_NOT_OK(ReadUncachedBlocks(ArrayView<const BlockPointer>(uncached_ptrs),
+                                   cache_control, uncached_rets.data()));
+  for (size_t i = 0; i < uncached_indexes.size(); i++) {
+    rets[uncached_indexes[i]] = std::move(uncached_rets[i]);
+  }
+  return Status::OK();
+}
+
+bool CFileReader::LookupBlock(const BlockPointer& ptr, CacheControl cache_control,
+                              BlockHandle* ret) const {
   CHECK(ptr.offset() > 0 &&
         ptr.offset() + ptr.size() < file_size_) <<
     "bad offset " << ptr.ToString() << " in file of size "
@@ -432,121 +563,179 @@ Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_contro
     TRACE_COUNTER_INCREMENT("cfile_cache_hit", 1);
     TRACE_COUNTER_INCREMENT(CFILE_CACHE_HIT_BYTES_METRIC_NAME, ptr.size());
     *ret = BlockHandle::WithDataFromCache(&bc_handle);
-    // Cache hit
-    return Status::OK();
+    return true;
   }
+  return false;
+}
 
+Status CFileReader::ReadUncachedBlocks(ArrayView<const BlockPointer> ptrs,
+                                       CacheControl cache_control,
+                                       BlockHandle* rets) const {
   // Cache miss: need to read ourselves.
   // We issue trace events only in the cache miss case since we expect the
   // tracing overhead to be small compared to the IO (even if it's a memcpy
   // from the Linux cache).
-  TRACE_EVENT1("io", "CFileReader::ReadBlock(cache miss)",
-               "cfile", ToString());
-  TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
-  TRACE_COUNTER_INCREMENT(CFILE_CACHE_MISS_BYTES_METRIC_NAME, ptr.size());
-
-  uint32_t data_size = ptr.size();
-  if (has_checksums()) {
-    if (PREDICT_FALSE(kChecksumSize > data_size)) {
-      return Status::Corruption("invalid data size for block pointer",
-                                ptr.ToString());
+  TRACE_EVENT2("io", "CFileReader::ReadBlock(cache miss)",
+               "cfile", ToString(),
+               "blocks", ptrs.size());
+  BlockCache* cache = BlockCache::GetSingleton();
+  const size_t n = ptrs.size();
+  bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
+
+  // Each run of blocks which are adjacent in the file is read with a single
+  // I/O into the scratch memory of each, and the runs are read all at once.
+  // Unless the checksums are verified, the checksum of the last block of a
+  // run needn't be read, but those of the other blocks are in the way and
+  // must be read anyway.
+  unique_ptr<ScratchMemory[]> scratch(new ScratchMemory[n]);
+  unique_ptr<uint8_t[]> checksum_scratch(has_checksums() ? new uint8_t[n * kChecksumSize]
+                                                         : nullptr);
+  vector<Slice> blocks;
+  vector<Slice> checksums;
+  vector<Slice> results;
+  // The first block of each run, and the first of its entries in 'results'.
+  vector<size_t> run_starts;
+  vector<size_t> run_result_starts;
+  blocks.reserve(n);
+  checksums.reserve(n);
+  results.reserve(n * 2);
+  for (size_t i = 0; i < n; i++) {
+    const BlockPointer& ptr = ptrs[i];
+    bool starts_run = i == 0 || ptr.offset() != ptrs[i - 1].offset() + ptrs[i - 1].size();
+    bool ends_run = i + 1 == n || ptrs[i + 1].offset() != ptr.offset() + ptr.size();
+    if (starts_run) {
+      run_starts.push_back(i);
+      run_result_starts.push_back(results.size());
+    }
+    TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
+    TRACE_COUNTER_INCREMENT(CFILE_CACHE_MISS_BYTES_METRIC_NAME, ptr.size());
+
+    uint32_t data_size = ptr.size();
+    if (has_checksums()) {
+      if (PREDICT_FALSE(kChecksumSize > data_size)) {
+        return Status::Corruption("invalid data size for block pointer",
+                                  ptr.ToString());
+      }
+      data_size -= kChecksumSize;
+    }
+
+    // If we are reading uncompressed data and plan to cache the result,
+    // then we should allocate our scratch memory directly from the cache.
+    // This avoids an extra memory copy in the case of an NVM cache.
+    if (codec_ == nullptr && cache_control == CACHE_BLOCK) {
+      scratch[i].TryAllocateFromCache(cache, BlockCache::CacheKey(block_->id(), ptr.offset()),
+                                      data_size);
+    } else {
+      scratch[i].AllocateFromHeap(data_size);
+    }
+    blocks.emplace_back(scratch[i].get(), data_size);
+    results.push_back(blocks.back());
+    if (has_checksums()) {
+      checksums.emplace_back(&checksum_scratch[i * kChecksumSize], kChecksumSize);
+      if (read_checksum || !ends_run) {
+        results.push_back(checksums.back());
+      }
     }
-    data_size -= kChecksumSize;
   }
 
-  ScratchMemory scratch;
-  // If we are reading uncompressed data and plan to cache the result,
-  // then we should allocate our scratch memory directly from the cache.
-  // This avoids an extra memory copy in the case of an NVM cache.
-  if (codec_ == nullptr && cache_control == CACHE_BLOCK) {
-    scratch.TryAllocateFromCache(cache, key, data_size);
+  // Read the data and checksums if needed.
+  Status read_status;
+  if (run_starts.size() == 1) {
+    read_status = block_->ReadV(ptrs[0].offset(), ArrayView<Slice>(results));
   } else {
-    scratch.AllocateFromHeap(data_size);
+    vector<ReadRequest> requests;
+    requests.reserve(run_starts.size());
+    for (size_t r = 0; r < run_starts.size(); r++) {
+      size_t results_end = r + 1 < run_starts.size() ? run_result_starts[r + 1]
+                                                     : results.size();
+      requests.push_back({ ptrs[run_starts[r]].offset(),
+                           ArrayView<Slice>(&results[run_result_starts[r]],
+                                            results_end - run_result_starts[r]) });
+    }
+    read_status = block_->ReadBatch(requests);
   }
-  uint8_t* buf = scratch.get();
-  Slice block(buf, data_size);
-  uint8_t checksum_scratch[kChecksumSize];
-  Slice checksum(checksum_scratch, kChecksumSize);
+  RETURN_NOT_OK_PREPEND(read_status, Substitute("failed to read CFile block $0 at $1",
+                                                block_id().ToString(), ptrs[0].ToString()));
+
+  for (size_t i = 0; i < n; i++) {
+    const BlockPointer& ptr = ptrs[i];
+    BlockCache::CacheKey key(block_->id(), ptr.offset());
+    uint8_t* buf = scratch[i].get();
+    Slice block = blocks[i];
+
+    if (read_checksum) {
+      RETURN_NOT_OK_PREPEND(VerifyChecksum(ArrayView<const Slice>(&block, 1), checksums[i]),
+                            Substitute("checksum error on CFile block $0 at $1",
+                                       block_id().ToString(), ptr.ToString()));
+    }
 
-  // Read the data and checksum if needed.
-  Slice results_backing[] = { block, checksum };
-  bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
-  ArrayView<Slice> results(results_backing, read_checksum ? 2 : 1);
-  RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
-                        Substitute("failed to read CFile block $0 at $1",
-                                   block_id().ToString(), ptr.ToString()));
+    // Decompress the block
+    if (codec_ != nullptr) {
+      // Init the decompressor and get the size required for the uncompressed buffer.
+      CompressedBlockDecoder uncompressor(codec_for_block(ptr), cfile_version_, block);
+      Status s = uncompressor.Init();
+      if (!s.ok()) {
+        LOG(WARNING) << "Unable to validate compressed block " << block_id().ToString()
+                     << " at " << ptr.offset() << " of size " << block.size() << ": "
+                     << s.ToString();
+        return s;
+      }
+      int uncompressed_size = uncompressor.uncompressed_size();
 
-  if (has_checksums() && FLAGS_cfile_verify_checksums) {
-    RETURN_NOT_OK_PREPEND(VerifyChecksum(ArrayView<const Slice>(&block, 1), checksum),
-                          Substitute("checksum error on CFile block $0 at $1",
-                                     block_id().ToString(), ptr.ToString()));
-  }
+      // If we plan to put the uncompressed block in the cache, we should
+      // decompress directly into the cache's memory (to avoid a memcpy for NVM).
+      ScratchMemory decompressed_scratch;
+      if (cache_control == CACHE_BLOCK) {
+        decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size);
+      } else {
+        decompressed_scratch.AllocateFromHeap(uncompressed_size);
+      }
+      s = uncompressor.UncompressIntoBuffer(decompressed_scratch.get());
+      if (!s.ok()) {
+        LOG(WARNING) << "Unable to uncompress block " << block_id().ToString()
+                     << " at " << ptr.offset()
+                     << " of size " <<  block.size() << ": " << s.ToString();
+        return s;
+      }
 
-  // Decompress the block
-  if (codec_ != nullptr) {
-    // Init the decompressor and get the size required for the uncompressed buffer.
-    CompressedBlockDecoder uncompressor(codec_, cfile_version_, block);
-    Status s = uncompressor.Init();
-    if (!s.ok()) {
-      LOG(WARNING) << "Unable to validate compressed block " << block_id().ToString()
-                   << " at " << ptr.offset() << " of size " << block.size() << ": "
-                   << s.ToString();
-      return s;
-    }
-    int uncompressed_size = uncompressor.uncompressed_size();
+      // Now that we've decompressed, we don't need to keep holding onto the original
+      // scratch buffer. Instead, we have to start holding onto our decompression
+      // output buffer.
+      scratch[i].Swap(&decompressed_scratch);
+      buf = scratch[i].get();
 
-    // If we plan to put the uncompressed block in the cache, we should
-    // decompress directly into the cache's memory (to avoid a memcpy for NVM).
-    ScratchMemory decompressed_scratch;
-    if (cache_control == CACHE_BLOCK) {
-      decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size);
+      // Set the result block to our decompressed data.
+      block = Slice(buf, uncompressed_size);
     } else {
-      decompressed_scratch.AllocateFromHeap(uncompressed_size);
-    }
-    s = uncompressor.UncompressIntoBuffer(decompressed_scratch.get());
-    if (!s.ok()) {
-      LOG(WARNING) << "Unable to uncompress block " << block_id().ToString()
-                   << " at " << ptr.offset()
-                   << " of size " <<  block.size() << ": " << s.ToString();
-      return s;
+      // Some of the File implementations from LevelDB attempt to be tricky
+      // and just return a Slice into an mmapped region (or in-memory region).
+      // But, this is hard to program against in terms of cache management, etc,
+      // so we memcpy into our scratch buffer if necessary.
+      block.relocate(buf);
     }
 
-    // Now that we've decompressed, we don't need to keep holding onto the original
-    // scratch buffer. Instead, we have to start holding onto our decompression
-    // output buffer.
-    scratch.Swap(&decompressed_scratch);
+    // It's possible that one of the TryAllocateFromCache() calls above
+    // failed, in which case we don't insert it into the cache regardless
+    // of what the user requested. The scratch memory includes both the
+    // generated key and the data read from disk.
+    if (cache_control == CACHE_BLOCK && scratch[i].IsFromCache()) {
+      BlockCacheHandle bc_handle;
+      cache->Insert(scratch[i].mutable_pending_entry(), &bc_handle);
+      rets[i] = BlockHandle::WithDataFromCache(&bc_handle);
+    } else {
+      // We get here by either not intending to cache the block or
+      // if the entry could not be allocated from the block cache.
+      // Since we allocate memory to include the key for the cache entry
+      // we must reset the block.
+      DCHECK_EQ(block.data(), buf);
+      DCHECK(!scratch[i].IsFromCache());
+      rets[i] = BlockHandle::WithOwnedData(scratch[i].as_slice());
+    }
 
-    // Set the result block to our decompressed data.
-    block = Slice(buf, uncompressed_size);
-  } else {
-    // Some of the File implementations from LevelDB attempt to be tricky
-    // and just return a Slice into an mmapped region (or in-memory region).
-    // But, this is hard to program against in terms of cache management, etc,
-    // so we memcpy into our scratch buffer if necessary.
-    block.relocate(scratch.get());
-  }
-
-  // It's possible that one of the TryAllocateFromCache() calls above
-  // failed, in which case we don't insert it into the cache regardless
-  // of what the user requested. The scratch memory includes both the
-  // generated key and the data read from disk.
-  if (cache_control == CACHE_BLOCK && scratch.IsFromCache()) {
-    cache->Insert(scratch.mutable_pending_entry(), &bc_handle);
-    *ret = BlockHandle::WithDataFromCache(&bc_handle);
-  } else {
-    // We get here by either not intending to cache the block or
-    // if the entry could not be allocated from the block cache.
-    // Since we allocate memory to include the key for the cache entry
-    // we must reset the block.
-    DCHECK_EQ(block.data(), buf);
-    DCHECK(!scratch.IsFromCache());
-    *ret = BlockHandle::WithOwnedData(scratch.as_slice());
+    // The cache or the BlockHandle now has ownership over the memory, so release
+    // the scoped pointer.
+    ignore_result(scratch[i].release());
   }
-
-  // The cache or the BlockHandle now has ownership over the memory, so release
-  // the scoped pointer.
-  ignore_result(scratch.release());
-
   return Status::OK();
 }
 
@@ -580,6 +769,7 @@ size_t CFileReader::memory_footprint() const {
   size_t size = kudu_malloc_usable_size(this);
   size += block_->memory_footprint();
   size += init_once_.memory_footprint_excluding_this();
+  size += block_stats_once_.memory_footprint_excluding_this();
 
   // SpaceUsed() uses sizeof() instead of malloc_usable_size() to account for
   // the size of base objects (recursively too), thus not accounting for
@@ -590,6 +780,9 @@ size_t CFileReader::memory_footprint() const {
   if (footer_) {
     size += footer_->SpaceUsed();
   }
+  if (block_stats_) {
+    size += block_stats_->SpaceUsed();
+  }
   return size;
 }
 
@@ -664,7 +857,21 @@ CFileIterator::CFileIterator(CFileReader* reader,
     last_prepare_count_(-1) {
 }
 
+struct CFileIterator::ReadAheadRun {
+  ReadAheadRun() : done(1) {}
+
+  vector<BlockPointer> ptrs;
+  vector<BlockHandle> handles;
+  Status status;
+  CountDownLatch done;
+};
+
 CFileIterator::~CFileIterator() {
+  DiscardReadAhead();
+  // The runs use the reader.
+  for (const auto& run : read_ahead_runs_) {
+    run->done.Wait();
+  }
 }
 
 Status CFileIterator::SeekToOrdinal(rowid_t ord_idx) {
@@ -914,7 +1121,7 @@ Status DecodeNullInfo(Slice *data_block, uint32_t *num_rows_in_block, Slice *nul
 Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
                                            PreparedBlock *prep_block) {
   prep_block->dblk_ptr_ = idx_iter.GetCurrentBlockPointer();
-  RETURN_NOT_OK(reader_->ReadBlock(prep_block->dblk_ptr_, cache_control_, &prep_block->dblk_data_));
+  RETURN_NOT_OK(ReadDataBlock(idx_iter, &prep_block->dblk_data_));
 
   uint32_t num_rows_in_block = 0;
   Slice data_block = prep_block->dblk_data_.data();
@@ -952,6 +1159,127 @@ Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
   return Status::OK();
 }
 
+Status CFileIterator::ReadDataBlock(const IndexTreeIterator& idx_iter, BlockHandle* ret) {
+  const BlockPointer& ptr = idx_iter.GetCurrentBlockPointer();
+  // Only scans through the positional index are sequential enough to read
+  // ahead.
+  if (FLAGS_cfile_read_ahead_blocks <= 0 || &idx_iter != posidx_iter_.get()) {
+    DiscardReadAhead();
+    return reader_->ReadBlock(ptr, cache_control_, ret);
+  }
+
+  // Let go of the runs which are done. They usually complete in order.
+  while (!read_ahead_runs_.empty() && read_ahead_runs_.front()->done.count() == 0) {
+    read_ahead_runs_.pop_front();
+  }
+
+  // The blocks preceding this one in the window were seeked past.
+  BlockPrefetcher* prefetcher = BlockPrefetcher::GetSingleton();
+  while (!read_ahead_window_.empty() &&
+         read_ahead_window_.front().first->ptrs[read_ahead_window_.front().second].offset() !=
+         ptr.offset()) {
+    const auto& entry = read_ahead_window_.front();
+    prefetcher->RecordWasted(entry.first->ptrs[entry.second].size());
+    read_ahead_window_.pop_front();
+  }
+
+  bool hit = false;
+  if (!read_ahead_window_.empty()) {
+    ReadAheadRun* run = read_ahead_window_.front().first.get();
+    size_t idx = read_ahead_window_.front().second;
+    run->done.Wait();
+    // If reading ahead failed, read the block again below so that the
+    // error is returned, or the failure is retried.
+    if (run->status.ok()) {
+      *ret = std::move(run->handles[idx]);
+      hit = true;
+    }
+    read_ahead_window_.pop_front();
+  }
+  if (hit) {
+    prefetcher->RecordHit();
+  } else {
+    prefetcher->RecordMiss();
+    RETURN_NOT_OK(reader_->ReadBlock(ptr, cache_control_, ret));
+    if (read_ahead_window_.empty()) {
+      // Read ahead from this block.
+      if (!read_ahead_iter_) {
+        read_ahead_iter_.reset(IndexTreeIterator::Create(
+            reader_, BlockPointer(reader_->footer().posidx_info().root_block())));
+      }
+      Status s = read_ahead_iter_->SeekAtOrBefore(idx_iter.GetCurrentKey());
+      if (!s.ok()) {
+        // Not reading ahead doesn't prevent the scan.
+        KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to read ahead of CFile "
+                                       << reader_->block_id().ToString() << ": "
+                                       << s.ToString();
+        read_ahead_iter_.reset();
+        return Status::OK();
+      }
+    }
+  }
+  ReadAhead();
+  return Status::OK();
+}
+
+void CFileIterator::ReadAhead() {
+  size_t window_size = FLAGS_cfile_read_ahead_blocks;
+  if (!read_ahead_iter_ || read_ahead_window_.size() > window_size / 2) {
+    return;
+  }
+
+  // Read the following blocks with a single task, so that the adjacent ones
+  // are read with a single I/O.
+  auto run = std::make_shared<ReadAheadRun>();
+  while (read_ahead_window_.size() + run->ptrs.size() < window_size &&
+         read_ahead_iter_->HasNext()) {
+    Status s = read_ahead_iter_->Next();
+    if (!s.ok()) {
+      // Any error will be returned when the scan itself gets there.
+      read_ahead_iter_.reset();
+      break;
+    }
+    run->ptrs.push_back(read_ahead_iter_->GetCurrentBlockPointer());
+  }
+  if (run->ptrs.empty()) {
+    return;
+  }
+  run->handles.resize(run->ptrs.size());
+
+  const CFileReader* reader = reader_;
+  CFileReader::CacheControl cache_control = cache_control_;
+  BlockPrefetcher* prefetcher = BlockPrefetcher::GetSingleton();
+  Status s = prefetcher->Submit([reader, cache_control, run]() {
+      run->status = reader->ReadBlocks(
+          ArrayView<const BlockPointer>(run->ptrs.data(), run->ptrs.size()),
+          cache_control, run->handles.data());
+      run->done.CountDown();
+    });
+  if (!s.ok()) {
+    // The scan will read the blocks itself.
+    KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to read ahead of CFile "
+                                   << reader_->block_id().ToString() << ": " << s.ToString();
+    read_ahead_iter_.reset();
+    return;
+  }
+  for (size_t i = 0; i < run->ptrs.size(); i++) {
+    prefetcher->RecordReadAhead(run->ptrs[i].size());
+    read_ahead_window_.emplace_back(run, i);
+  }
+  read_ahead_runs_.push_back(std::move(run));
+}
+
+void CFileIterator::DiscardReadAhead() {
+  if (read_ahead_window_.empty()) {
+    return;
+  }
+  BlockPrefetcher* prefetcher = BlockPrefetcher::GetSingleton();
+  for (const auto& entry : read_ahead_window_) {
+    prefetcher->RecordWasted(entry.first->ptrs[entry.second].size());
+  }
+  read_ahead_window_.clear();
+}
+
 Status CFileIterator::QueueCurrentDataBlock(const IndexTreeIterator &idx_iter) {
   pblock_pool_scoped_ptr b = prepared_block_pool_.make_scoped_ptr(
     prepared_block_pool_.Construct());
@@ -1176,6 +1504,14 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   return Status::OK();
 }
 
+Status CFileIterator::EvaluatePredicateOnStats(const ColumnPredicate& pred,
+                                               rowid_t first_ordinal,
+                                               size_t nrows,
+                                               StatsMatch* match) {
+  RETURN_NOT_OK(reader_->Init());
+  return reader_->EvaluatePredicateOnStats(pred, first_ordinal, nrows, match);
+}
+
 Status CFileIterator::CopyNextValues(size_t* n, ColumnMaterializationContext* ctx) {
   RETURN_NOT_OK(PrepareBatch(n));
   RETURN_NOT_OK(Scan(ctx));
@@ -20,8 +20,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -29,6 +31,7 @@
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/block_stats.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/common/iterator_stats.h"
 #include "kudu/common/rowid.h"
@@ -38,6 +41,7 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/object_pool.h"
@@ -49,7 +53,7 @@
 namespace kudu {
 
 class ColumnMaterializationContext;
-class CompressionCodec;
+class ColumnPredicate;
 class EncodedKey;
 class SelectionVector;
 class TypeInfo;
@@ -109,6 +113,13 @@ class CFileReader {
   Status ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
                    BlockHandle *ret) const;
 
+  // Read the blocks at 'ptrs', which must be in file order, into the
+  // corresponding entries of 'rets', as ReadBlock() does. The uncached blocks
+  // which are adjacent in the file are read with a single I/O, and all these
+  // I/Os are issued at once.
+  Status ReadBlocks(ArrayView<const BlockPointer> ptrs, CacheControl cache_control,
+                    BlockHandle* rets) const;
+
   // Return the number of rows in this cfile.
   // This is assumed to be reasonably fast (i.e does not scan
   // the data)
@@ -180,6 +191,19 @@ class CFileReader {
   // Returns true if the file has checksums on the header, footer, and data blocks.
   bool has_checksums() const;
 
+  // Returns true if the file has statistics for each of its data blocks.
+  bool has_block_stats() const;
+
+  // Checks 'pred' against the statistics of the data blocks holding the
+  // values [first_ordinal, first_ordinal + nrows). The statistics are read
+  // on first use.
+  //
+  // Sets '*match' to StatsMatch::SOME if the file has no statistics.
+  Status EvaluatePredicateOnStats(const ColumnPredicate& pred,
+                                  rowid_t first_ordinal,
+                                  size_t nrows,
+                                  StatsMatch* match);
+
   // Can be called before Init().
   std::string ToString() const { return block_->id().ToString(); }
 
@@ -197,6 +221,22 @@ class CFileReader {
   Status ReadAndParseFooter();
   Status VerifyChecksum(ArrayView<const Slice> data, const Slice& checksum) const;
 
+  // Look up the block at 'ptr' in the block cache, setting 'ret' and
+  // returning true if found.
+  bool LookupBlock(const BlockPointer& ptr, CacheControl cache_control,
+                   BlockHandle* ret) const;
+
+  // Returns the codec the block at 'ptr' was compressed with.
+  const CompressionCodec* codec_for_block(const BlockPointer& ptr) const;
+
+  // Read the uncached blocks at 'ptrs', which must be in file order, with a
+  // batch of I/Os: one for each run of blocks which are adjacent in the file.
+  Status ReadUncachedBlocks(ArrayView<const BlockPointer> ptrs, CacheControl cache_control,
+                            BlockHandle* rets) const;
+
+  // Callback used in 'block_stats_once_' to read the block stats.
+  Status ReadBlockStatsOnce();
+
   // Returns the memory usage of the object including the object itself.
   size_t memory_footprint() const;
 
@@ -211,11 +251,19 @@ class CFileReader {
   gscoped_ptr<CFileHeaderPB> header_;
   gscoped_ptr<CFileFooterPB> footer_;
   const CompressionCodec* codec_;
+  // The codec of the blocks compressed with the dictionary of the footer, if
+  // any.
+  std::unique_ptr<CompressionCodec> dictionary_codec_;
   const TypeInfo *type_info_;
   const TypeEncodingInfo *type_encoding_info_;
 
   KuduOnceDynamic init_once_;
 
+  // The statistics of the data blocks, lazily read by
+  // EvaluatePredicateOnStats().
+  gscoped_ptr<BlockStatsListPB> block_stats_;
+  KuduOnceDynamic block_stats_once_;
+
   ScopedTrackedConsumption mem_consumption_;
 };
 
@@ -272,6 +320,19 @@ class ColumnIterator {
   // batch left off.
   virtual Status FinishBatch() = 0;
 
+  // Checks 'pred' against summary statistics of the values
+  // [first_ordinal, first_ordinal + nrows), if the underlying data has any.
+  // This neither requires nor changes the position of the iterator.
+  //
+  // Sets '*match' to StatsMatch::SOME if there are no such statistics.
+  virtual Status EvaluatePredicateOnStats(const ColumnPredicate& /* pred */,
+                                          rowid_t /* first_ordinal */,
+                                          size_t /* nrows */,
+                                          StatsMatch* match) {
+    *match = StatsMatch::SOME;
+    return Status::OK();
+  }
+
   virtual const IteratorStats& io_statistics() const = 0;
 };
 
@@ -381,6 +442,11 @@ class CFileIterator : public ColumnIterator {
   // Convenience method to prepare a batch, scan it, and finish it.
   Status CopyNextValues(size_t* n, ColumnMaterializationContext* ctx);
 
+  Status EvaluatePredicateOnStats(const ColumnPredicate& pred,
+                                  rowid_t first_ordinal,
+                                  size_t nrows,
+                                  StatsMatch* match) override;
+
   const IteratorStats &io_statistics() const OVERRIDE {
     return io_stats_;
   }
@@ -454,6 +520,17 @@ class CFileIterator : public ColumnIterator {
   // it onto the end of the prepared_blocks_ deque.
   Status QueueCurrentDataBlock(const IndexTreeIterator &idx_iter);
 
+  // Read the data block currently pointed to by 'idx_iter' into 'ret', taking
+  // it from the read-ahead window if it was read ahead.
+  Status ReadDataBlock(const IndexTreeIterator& idx_iter, BlockHandle* ret);
+
+  // Schedule reads of the data blocks following those in the read-ahead
+  // window, if it's less than half full.
+  void ReadAhead();
+
+  // Discard the blocks of the read-ahead window.
+  void DiscardReadAhead();
+
   // Fully initialize the underlying cfile reader if needed, and clear any
   // seek-related state.
   Status PrepareForNewSeek();
@@ -500,6 +577,24 @@ class CFileIterator : public ColumnIterator {
 
   // a temporary buffer for encoding
   faststring tmp_buf_;
+
+  // Read-ahead of the data blocks of sequential scans, enabled by
+  // --cfile_read_ahead_blocks. The blocks following the one being read are
+  // scheduled to be read by the BlockPrefetcher in runs, each of which is
+  // read by a single task.
+  struct ReadAheadRun;
+
+  // Positional index iterator pointing at the last block which was read
+  // ahead, or at the block being read if none was.
+  gscoped_ptr<IndexTreeIterator> read_ahead_iter_;
+
+  // The blocks which were read ahead, in order, as their run and index within
+  // it.
+  std::deque<std::pair<std::shared_ptr<ReadAheadRun>, size_t>> read_ahead_window_;
+
+  // The runs which may still be read, including those whose blocks were all
+  // discarded: they must complete before the reader may be destroyed.
+  std::deque<std::shared_ptr<ReadAheadRun>> read_ahead_runs_;
 };
 
 } // namespace cfile
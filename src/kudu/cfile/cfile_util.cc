@@ -47,6 +47,8 @@ WriterOptions::WriterOptions()
     write_posidx(false),
     write_validx(false),
     optimize_index_keys(true),
+    write_block_stats(false),
+    split_block_bloom(false),
     validx_key_encoder(boost::none) {
 }
 
@@ -45,7 +45,22 @@ enum IncompatibleFeatures {
   // Write a crc32 checksum at the end of each cfile block
   CHECKSUM = 1 << 0,
 
-  SUPPORTED = NONE | CHECKSUM
+  // Compress the blocks with a dictionary stored in
+  // CFileFooterPB::compression_dictionary
+  COMPRESSION_DICTIONARY = 1 << 1,
+
+  // The bloom blocks of a bloom file are split-block bloom filters
+  // (see BlockBloomFilter) rather than classic ones
+  SPLIT_BLOCK_BLOOM = 1 << 2,
+
+  SUPPORTED = NONE | CHECKSUM | COMPRESSION_DICTIONARY | SPLIT_BLOCK_BLOOM
+};
+
+// Used to set the CFileFooterPB bitset tracking compatible features
+enum CompatibleFeatures {
+  // Write the min/max values and null count of each data block, referenced
+  // by CFileFooterPB::block_stats_ptr.
+  BLOCK_STATS = 1 << 0
 };
 
 typedef std::function<void(const void*, faststring*)> ValidxKeyEncoder;
@@ -75,6 +90,16 @@ struct WriterOptions {
   // instead of entire keys.
   bool optimize_index_keys;
 
+  // Whether to write the min/max values and null count of each data block,
+  // so that readers may skip blocks which can't match a predicate.
+  bool write_block_stats;
+
+  // Whether the raw blocks appended to the file are split-block bloom
+  // filters. Only set by BloomFileWriter.
+  //
+  // Default: false.
+  bool split_block_bloom;
+
   // Column storage attributes.
   //
   // Default: all default values as specified in the constructor in
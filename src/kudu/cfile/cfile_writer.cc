@@ -17,6 +17,7 @@
 
 #include "kudu/cfile/cfile_writer.h"
 
+#include <algorithm>
 #include <functional>
 #include <numeric>
 #include <ostream>
@@ -29,6 +30,7 @@
 #include "kudu/cfile/block_compression.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/block_stats.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/index_btree.h"
@@ -56,10 +58,29 @@ DEFINE_string(cfile_default_compression_codec, "none",
               "Default cfile block compression codec.");
 TAG_FLAG(cfile_default_compression_codec, advanced);
 
+DEFINE_int32(cfile_compression_dictionary_size, 0,
+             "The maximum size in bytes of the dictionary trained for each ZSTD-compressed "
+             "cfile, which lets small blocks compress about as well as large ones. The "
+             "dictionary is trained on the first data blocks of the cfile, see "
+             "--cfile_compression_dictionary_training_bytes, which are compressed without "
+             "it. If 0, the cfiles aren't compressed with dictionaries.");
+TAG_FLAG(cfile_compression_dictionary_size, experimental);
+
+DEFINE_int32(cfile_compression_dictionary_training_bytes, 1024 * 1024,
+             "The number of bytes of data blocks a cfile dictionary is trained on. Cfiles "
+             "with less data aren't compressed with dictionaries.");
+TAG_FLAG(cfile_compression_dictionary_training_bytes, experimental);
+
 DEFINE_bool(cfile_write_checksums, true,
             "Write CRC32 checksums for each block");
 TAG_FLAG(cfile_write_checksums, evolving);
 
+DEFINE_bool(cfile_write_block_stats, true,
+            "Write the min/max values and null count of each data block, for the "
+            "cfiles which request them, so that scans may skip blocks which can't "
+            "match their predicates.");
+TAG_FLAG(cfile_write_block_stats, evolving);
+
 using google::protobuf::RepeatedPtrField;
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::BlockManager;
@@ -80,6 +101,11 @@ const size_t kChecksumSize = sizeof(uint32_t);
 
 static const size_t kMinBlockSize = 512;
 
+// The data blocks are split into samples of at most this size to train the
+// compression dictionary, so that a few large blocks still make enough
+// samples.
+static const size_t kDictionarySampleSize = 4096;
+
 static CompressionType GetDefaultCompressionCodec() {
   return GetCompressionCodecType(FLAGS_cfile_default_compression_codec);
 }
@@ -99,6 +125,7 @@ CFileWriter::CFileWriter(WriterOptions options,
     options_(std::move(options)),
     is_nullable_(is_nullable),
     typeinfo_(typeinfo),
+    train_dictionary_(false),
     state_(kWriterInitialized) {
   EncodingType encoding = options_.storage_attributes.encoding;
   Status s = TypeEncodingInfo::Get(typeinfo_, encoding, &type_encoding_info_);
@@ -141,6 +168,10 @@ CFileWriter::CFileWriter(WriterOptions options,
 
     validx_builder_.reset(new IndexTreeBuilder(&options_, this));
   }
+
+  if (options_.write_block_stats && FLAGS_cfile_write_block_stats) {
+    block_stats_builder_.reset(new BlockStatsBuilder(typeinfo_));
+  }
 }
 
 CFileWriter::~CFileWriter() {
@@ -155,6 +186,7 @@ Status CFileWriter::Start() {
     const CompressionCodec* codec;
     RETURN_NOT_OK(GetCompressionCodec(compression_, &codec));
     block_compressor_ .reset(new CompressedBlockBuilder(codec));
+    train_dictionary_ = compression_ == ZSTD && FLAGS_cfile_compression_dictionary_size > 0;
   }
 
   CFileHeaderPB header;
@@ -219,6 +251,13 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   if (FLAGS_cfile_write_checksums) {
     incompatible_features |= IncompatibleFeatures::CHECKSUM;
   }
+  if (dictionary_codec_ != nullptr) {
+    incompatible_features |= IncompatibleFeatures::COMPRESSION_DICTIONARY;
+  }
+  if (options_.split_block_bloom) {
+    incompatible_features |= IncompatibleFeatures::SPLIT_BLOCK_BLOOM;
+  }
+  uint32_t compatible_features = 0;
 
   // Start preparing the footer.
   CFileFooterPB footer;
@@ -228,6 +267,11 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   footer.set_num_values(value_count_);
   footer.set_compression(compression_);
   footer.set_incompatible_features(incompatible_features);
+  if (dictionary_codec_ != nullptr) {
+    CompressionDictionaryPB* dict_pb = footer.mutable_compression_dictionary();
+    dict_pb->set_dictionary(dictionary_.data(), dictionary_.size());
+    dict_pb->set_first_block_offset(dictionary_first_block_offset_);
+  }
 
   // Write out any pending positional index blocks.
   if (options_.write_posidx) {
@@ -243,6 +287,20 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
     footer.mutable_validx_info()->CopyFrom(validx_info);
   }
 
+  // Write out the statistics of the data blocks, if any were written.
+  if (block_stats_builder_ != nullptr && block_stats_builder_->stats().blocks_size() > 0) {
+    faststring stats_str;
+    pb_util::SerializeToString(block_stats_builder_->stats(), &stats_str);
+    BlockPointer stats_ptr;
+    RETURN_NOT_OK_PREPEND(AddBlock({ Slice(stats_str) }, &stats_ptr, "block stats"),
+                          "Couldn't write block stats");
+    stats_ptr.CopyToPB(footer.mutable_block_stats_ptr());
+    compatible_features |= CompatibleFeatures::BLOCK_STATS;
+  }
+  if (compatible_features != 0) {
+    footer.set_compatible_features(compatible_features);
+  }
+
   // Optionally append extra information to the end of cfile.
   // Example: dictionary block for dictionary encoding
   RETURN_NOT_OK(data_block_->AppendExtraInfo(this, &footer));
@@ -310,6 +368,9 @@ Status CFileWriter::AppendEntries(const void *entries, size_t count) {
   while (rem > 0) {
     int n = data_block_->Add(ptr, rem);
     DCHECK_GE(n, 0);
+    if (block_stats_builder_ != nullptr) {
+      block_stats_builder_->AddValues(ptr, n);
+    }
 
     ptr += typeinfo_->size() * n;
     rem -= n;
@@ -340,6 +401,9 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
       do {
         int n = data_block_->Add(ptr, rem);
         DCHECK_GE(n, 0);
+        if (block_stats_builder_ != nullptr) {
+          block_stats_builder_->AddValues(ptr, n);
+        }
 
         null_bitmap_builder_->AddRun(true, n);
         ptr += n * typeinfo_->size();
@@ -353,6 +417,9 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
       } while (rem > 0);
     } else {
       null_bitmap_builder_->AddRun(false, nblock);
+      if (block_stats_builder_ != nullptr) {
+        block_stats_builder_->AddNulls(nblock);
+      }
       ptr += nblock * typeinfo_->size();
       value_count_ += nblock;
     }
@@ -399,6 +466,9 @@ Status CFileWriter::FinishCurDataBlock() {
     v.push_back(null_bitmap);
   }
   v.push_back(data);
+  if (train_dictionary_) {
+    RETURN_NOT_OK(SampleForDictionary(v));
+  }
   Status s = AppendRawBlock(v, first_elem_ord,
                             reinterpret_cast<const void *>(key_tmp_space),
                             Slice(last_key_),
@@ -408,6 +478,10 @@ Status CFileWriter::FinishCurDataBlock() {
     null_bitmap_builder_->Reset();
   }
 
+  if (block_stats_builder_ != nullptr) {
+    block_stats_builder_->FinishBlock(first_elem_ord, num_elems_in_block);
+  }
+
   if (validx_builder_ != nullptr) {
     RETURN_NOT_OK(data_block_->GetLastKey(key_tmp_space));
     (*options_.validx_key_encoder)(key_tmp_space, &last_key_);
@@ -417,6 +491,49 @@ Status CFileWriter::FinishCurDataBlock() {
   return s;
 }
 
+Status CFileWriter::SampleForDictionary(const vector<Slice>& data_slices) {
+  for (const Slice& data : data_slices) {
+    for (size_t off = 0; off < data.size(); off += kDictionarySampleSize) {
+      size_t len = std::min(kDictionarySampleSize, data.size() - off);
+      dictionary_samples_.append(data.data() + off, len);
+      dictionary_sample_sizes_.push_back(len);
+    }
+  }
+  if (dictionary_samples_.size() <
+      static_cast<size_t>(FLAGS_cfile_compression_dictionary_training_bytes)) {
+    return Status::OK();
+  }
+
+  // Train the dictionary, and compress the following blocks with it.
+  train_dictionary_ = false;
+  vector<Slice> samples;
+  samples.reserve(dictionary_sample_sizes_.size());
+  const uint8_t* p = dictionary_samples_.data();
+  for (size_t size : dictionary_sample_sizes_) {
+    samples.emplace_back(p, size);
+    p += size;
+  }
+  Status s = TrainCompressionDictionary(compression_, samples,
+                                        FLAGS_cfile_compression_dictionary_size, &dictionary_);
+  dictionary_samples_.clear();
+  dictionary_samples_.shrink_to_fit();
+  dictionary_sample_sizes_.clear();
+  dictionary_sample_sizes_.shrink_to_fit();
+  if (!s.ok()) {
+    // The data may just not lend itself to a dictionary.
+    VLOG(1) << "Not compressing " << ToString() << " with a dictionary: " << s.ToString();
+    return Status::OK();
+  }
+  RETURN_NOT_OK_PREPEND(NewCompressionCodecWithDictionary(compression_, Slice(dictionary_),
+                                                          &dictionary_codec_),
+                        "Couldn't load the compression dictionary");
+  block_compressor_.reset(new CompressedBlockBuilder(dictionary_codec_.get()));
+  dictionary_first_block_offset_ = off_;
+  VLOG(1) << "Trained a compression dictionary of " << dictionary_.size()
+          << " bytes for " << ToString();
+  return Status::OK();
+}
+
 Status CFileWriter::AppendRawBlock(const vector<Slice>& data_slices,
                                    size_t ordinal_pos,
                                    const void *validx_curr,
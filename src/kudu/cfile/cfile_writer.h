@@ -47,6 +47,7 @@ class RepeatedPtrField; // IWYU pragma: keep
 
 namespace kudu {
 
+class CompressionCodec;
 class TypeInfo;
 template <typename Buffer>
 class KeyEncoder;
@@ -55,6 +56,7 @@ namespace cfile {
 
 class BlockBuilder;
 class BlockPointer;
+class BlockStatsBuilder;
 class CompressedBlockBuilder;
 class FileMetadataPairPB;
 class IndexTreeBuilder;
@@ -202,6 +204,11 @@ class CFileWriter {
 
   Status FinishCurDataBlock();
 
+  // Adds the data block made of 'data_slices' to the samples the compression
+  // dictionary is trained on. Once enough data is sampled, trains the
+  // dictionary and switches the compression of the following blocks to it.
+  Status SampleForDictionary(const std::vector<Slice>& data_slices);
+
   // Flush the current unflushed_metadata_ entries into the given protobuf
   // field, clearing the buffer.
   void FlushMetadataToPB(google::protobuf::RepeatedPtrField<FileMetadataPairPB> *field);
@@ -238,6 +245,20 @@ class CFileWriter {
   gscoped_ptr<IndexTreeBuilder> validx_builder_;
   gscoped_ptr<NullBitmapBuilder> null_bitmap_builder_;
   gscoped_ptr<CompressedBlockBuilder> block_compressor_;
+  // Only set if the writer is writing block stats.
+  gscoped_ptr<BlockStatsBuilder> block_stats_builder_;
+
+  // Whether the data blocks are being sampled to train a compression
+  // dictionary, and the samples, back to back.
+  bool train_dictionary_;
+  faststring dictionary_samples_;
+  std::vector<size_t> dictionary_sample_sizes_;
+
+  // The trained compression dictionary, the codec using it, and the offset of
+  // the first block it compressed. Only set once a dictionary is trained.
+  faststring dictionary_;
+  std::unique_ptr<CompressionCodec> dictionary_codec_;
+  uint64_t dictionary_first_block_offset_ = 0;
 
   enum State {
     kWriterInitialized,
@@ -29,6 +29,7 @@
 #include <string>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -37,11 +38,15 @@
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/bshuf_block.h"
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/cfile/for_block.h"
 #include "kudu/cfile/plain_bitmap_block.h"
 #include "kudu/cfile/plain_block.h"
 #include "kudu/cfile/rle_block.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -65,6 +70,8 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+DECLARE_bool(predicate_evaluation_use_simd);
+
 namespace kudu {
 namespace cfile {
 
@@ -677,6 +684,107 @@ class TestEncoding : public KuduTest {
     }
   }
 
+  // Test evaluating 'pred' within the decoder with CopyNextAndEval(), over
+  // runs of values in [0, 'cardinality') and a selection vector with some
+  // rows already deselected.
+  template <DataType Type, class BuilderType, class DecoderType>
+  void TestCopyNextAndEval(const ColumnPredicate& pred, int cardinality) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+
+    // Arrays rather than vectors, so that BOOL values aren't bit-packed.
+    const size_t size = 10000;
+    unique_ptr<CppType[]> to_insert(new CppType[size]);
+    for (size_t i = 0; i < size; ) {
+      int run_size = random() % 50 + 1;
+      CppType val = static_cast<CppType>(random() % cardinality);
+      for (int j = 0; j < run_size && i < size; j++) {
+        to_insert[i++] = val;
+      }
+    }
+
+    unique_ptr<WriterOptions> opts(NewWriterOptions());
+    BuilderType bb(opts.get());
+    bb.Add(reinterpret_cast<const uint8_t*>(to_insert.get()), size);
+    Slice s = bb.Finish(0);
+
+    DecoderType bd(s);
+    ASSERT_OK(bd.ParseHeader());
+
+    unique_ptr<CppType[]> decoded(new CppType[size]);
+    ColumnBlock dst_block(GetTypeInfo(Type), nullptr, decoded.get(), size, &arena_);
+    SelectionVector sel(size);
+    sel.SetAllTrue();
+    for (size_t i = 0; i < size; i += 7) {
+      sel.SetRowUnselected(i);
+    }
+    ColumnMaterializationContext ctx(0, &pred, &dst_block, &sel);
+    ColumnDataView view(&dst_block);
+    SelectionVectorView sel_view(&sel);
+    while (bd.HasNext()) {
+      size_t n = std::min<size_t>(random() % 100 + 1, view.nrows());
+      ASSERT_OK(bd.CopyNextAndEval(&n, &ctx, &sel_view, &view));
+      ASSERT_FALSE(ctx.DecoderEvalNotSupported());
+      view.Advance(n);
+      sel_view.Advance(n);
+    }
+    ASSERT_EQ(0, view.nrows());
+
+    for (size_t i = 0; i < size; i++) {
+      bool expected = i % 7 != 0 &&
+          pred.EvaluateCell<TypeTraits<Type>::physical_type>(&to_insert[i]);
+      ASSERT_EQ(expected, sel.IsRowSelected(i)) << "at index " << i;
+      if (expected) {
+        ASSERT_EQ(to_insert[i], decoded[i]) << "at index " << i;
+      }
+    }
+  }
+
+  // Times decoding a block of random values in [0, 'cardinality') while
+  // evaluating 'pred' with CopyNextAndEval(), with and without the vectorized
+  // predicate kernels.
+  template <DataType Type, class BuilderType, class DecoderType>
+  void BenchmarkCopyNextAndEval(const ColumnPredicate& pred, int cardinality) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+    const size_t kSize = 10000;
+    const int kNumIters = 10000;
+    unique_ptr<CppType[]> to_insert(new CppType[kSize]);
+    for (size_t i = 0; i < kSize; i++) {
+      to_insert[i] = static_cast<CppType>(random() % cardinality);
+    }
+    unique_ptr<WriterOptions> opts(NewWriterOptions());
+    BuilderType bb(opts.get());
+    bb.Add(reinterpret_cast<const uint8_t*>(to_insert.get()), kSize);
+    Slice s = bb.Finish(0);
+
+    unique_ptr<CppType[]> decoded(new CppType[kSize]);
+    ColumnBlock dst_block(GetTypeInfo(Type), nullptr, decoded.get(), kSize, &arena_);
+    SelectionVector sel(kSize);
+    ColumnMaterializationContext ctx(0, &pred, &dst_block, &sel);
+    for (bool use_simd : { false, true }) {
+      FLAGS_predicate_evaluation_use_simd = use_simd;
+      size_t num_selected = 0;
+      LOG_TIMING(INFO, strings::Substitute("Evaluating $0 in $1 block ($2)",
+                                           pred.ToString(), TypeTraits<Type>::name(),
+                                           use_simd ? "vectorized" : "scalar")) {
+        for (int iter = 0; iter < kNumIters; iter++) {
+          DecoderType bd(s);
+          ASSERT_OK(bd.ParseHeader());
+          sel.SetAllTrue();
+          ColumnDataView view(&dst_block);
+          SelectionVectorView sel_view(&sel);
+          while (bd.HasNext()) {
+            size_t n = view.nrows();
+            ASSERT_OK(bd.CopyNextAndEval(&n, &ctx, &sel_view, &view));
+            view.Advance(n);
+            sel_view.Advance(n);
+          }
+          num_selected += sel.CountSelected();
+        }
+      }
+      LOG(INFO) << "Selected " << num_selected << " rows";
+    }
+  }
+
   Arena arena_;
 };
 
@@ -775,6 +883,50 @@ TEST_F(TestEncoding, TestRleIntBlockEncoder) {
   ASSERT_EQ(14UL, s.size());
 }
 
+// Test that the frame of reference block picks the more compact of its modes
+// for sorted, clustered and constant data.
+TEST_F(TestEncoding, TestForBlockEncoder) {
+  const int kSize = 10000;
+  unique_ptr<WriterOptions> opts(NewWriterOptions());
+  opts->storage_attributes.cfile_block_size = kSize * sizeof(int64_t);
+
+  // Timestamps about one second apart, in microseconds: the deltas take
+  // about 20 bits, the offsets from the minimum over 30.
+  Random rng(SeedRandom());
+  vector<int64_t> timestamps(kSize);
+  int64_t ts = 1500000000000000L;
+  for (int i = 0; i < kSize; i++) {
+    ts += 1000000 + rng.Uniform(10000);
+    timestamps[i] = ts;
+  }
+  // Foreign keys clustered within 1000 of each other.
+  vector<int64_t> clustered(kSize);
+  for (int i = 0; i < kSize; i++) {
+    clustered[i] = -123456789 + rng.Uniform(1000);
+  }
+  vector<int64_t> constant(kSize, 42);
+
+  for (const auto* data : { &timestamps, &clustered, &constant }) {
+    ForBlockBuilder<INT64> fbb(opts.get());
+    ASSERT_EQ(kSize, fbb.Add(reinterpret_cast<const uint8_t*>(data->data()), kSize));
+    Slice s = fbb.Finish(12345);
+    LOG(INFO) << "Frame of reference encoded size for 10k int64s: " << s.size();
+    // Plain encoding takes 8 bytes per value.
+    ASSERT_LT(s.size(), kSize * sizeof(int64_t) / 2);
+
+    ForBlockDecoder<INT64> fbd(s);
+    ASSERT_OK(fbd.ParseHeader());
+    ASSERT_EQ(kSize, fbd.Count());
+    vector<int64_t> decoded(kSize);
+    ColumnBlock dst_block(GetTypeInfo(INT64), nullptr, decoded.data(), kSize, &arena_);
+    ColumnDataView view(&dst_block);
+    size_t n = kSize;
+    ASSERT_OK(fbd.CopyNextValues(&n, &view));
+    ASSERT_EQ(kSize, n);
+    ASSERT_EQ(*data, decoded);
+  }
+}
+
 TEST_F(TestEncoding, TestPlainBitMapRoundTrip) {
   TestBoolBlockRoundTrip<PlainBitMapBlockBuilder, PlainBitMapBlockDecoder>();
 }
@@ -783,6 +935,57 @@ TEST_F(TestEncoding, TestRleBitMapRoundTrip) {
   TestBoolBlockRoundTrip<RleBitMapBlockBuilder, RleBitMapBlockDecoder>();
 }
 
+TEST_F(TestEncoding, TestCopyNextAndEval) {
+  ColumnSchema int32_col("c", INT32);
+  int32_t lower32 = 3;
+  int32_t upper32 = 6;
+  ColumnPredicate range32 = ColumnPredicate::Range(int32_col, &lower32, &upper32);
+
+  ColumnSchema int64_col("c", INT64);
+  int64_t value64 = 4;
+  ColumnPredicate eq64 = ColumnPredicate::Equality(int64_col, &value64);
+
+  ColumnSchema bool_col("b", BOOL);
+  bool true_value = true;
+  ColumnPredicate eq_true = ColumnPredicate::Equality(bool_col, &true_value);
+
+  for (bool use_simd : { false, true }) {
+    SCOPED_TRACE(use_simd);
+    FLAGS_predicate_evaluation_use_simd = use_simd;
+    TestCopyNextAndEval<INT32, PlainBlockBuilder<INT32>, PlainBlockDecoder<INT32>>(range32, 10);
+    TestCopyNextAndEval<INT32, BShufBlockBuilder<INT32>, BShufBlockDecoder<INT32>>(range32, 10);
+    TestCopyNextAndEval<INT32, RleIntBlockBuilder<INT32>, RleIntBlockDecoder<INT32>>(range32, 10);
+    TestCopyNextAndEval<INT32, ForBlockBuilder<INT32>, ForBlockDecoder<INT32>>(range32, 10);
+
+    TestCopyNextAndEval<INT64, BShufBlockBuilder<INT64>, BShufBlockDecoder<INT64>>(eq64, 10);
+    TestCopyNextAndEval<INT64, RleIntBlockBuilder<INT64>, RleIntBlockDecoder<INT64>>(eq64, 10);
+    TestCopyNextAndEval<INT64, ForBlockBuilder<INT64>, ForBlockDecoder<INT64>>(eq64, 10);
+
+    TestCopyNextAndEval<BOOL, RleBitMapBlockBuilder, RleBitMapBlockDecoder>(eq_true, 2);
+  }
+}
+
+#ifdef NDEBUG
+TEST_F(TestEncoding, CopyNextAndEvalBenchmark) {
+  ColumnSchema int32_col("c", INT32);
+  int32_t lower32 = 100;
+  int32_t upper32 = 600;
+  ColumnPredicate range32 = ColumnPredicate::Range(int32_col, &lower32, &upper32);
+  BenchmarkCopyNextAndEval<INT32, PlainBlockBuilder<INT32>, PlainBlockDecoder<INT32>>(
+      range32, 1000);
+  BenchmarkCopyNextAndEval<INT32, BShufBlockBuilder<INT32>, BShufBlockDecoder<INT32>>(
+      range32, 1000);
+  BenchmarkCopyNextAndEval<INT32, ForBlockBuilder<INT32>, ForBlockDecoder<INT32>>(
+      range32, 1000);
+
+  ColumnSchema int64_col("c", INT64);
+  int64_t value64 = 4;
+  ColumnPredicate eq64 = ColumnPredicate::Equality(int64_col, &value64);
+  BenchmarkCopyNextAndEval<INT64, BShufBlockBuilder<INT64>, BShufBlockDecoder<INT64>>(eq64, 10);
+  BenchmarkCopyNextAndEval<INT64, ForBlockBuilder<INT64>, ForBlockDecoder<INT64>>(eq64, 10);
+}
+#endif
+
 // Test seeking to a value in a small block.
 // Regression test for a bug seen in development where this would
 // infinite loop when there are no 'restarts' in a given block.
@@ -859,7 +1062,16 @@ struct BitshuffleTestTraits {
     typedef BShufBlockDecoder<type> decoder_type;
   };
 };
-typedef testing::Types<RleTestTraits, BitshuffleTestTraits, PlainTestTraits> MyTestFixtures;
+
+struct ForTestTraits {
+  template<DataType type>
+  struct Classes {
+    typedef ForBlockBuilder<type> encoder_type;
+    typedef ForBlockDecoder<type> decoder_type;
+  };
+};
+typedef testing::Types<RleTestTraits, BitshuffleTestTraits, PlainTestTraits,
+                       ForTestTraits> MyTestFixtures;
 TYPED_TEST_CASE(IntEncodingTest, MyTestFixtures);
 
 template<class TestTraits>
@@ -0,0 +1,119 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/for_block.h"
+
+#include <emmintrin.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "kudu/util/coding-inl.h"
+
+namespace kudu {
+namespace cfile {
+namespace for_internal {
+
+namespace {
+
+// Unpacks 128 values of 'kWidth' bits. Each 128-bit word holds the next bits
+// of the four lanes, so that the values 4 * i to 4 * i + 3 are shifted out of
+// the same register. With the width known at compile time, the compiler can
+// unroll the loop and make all the shifts immediate.
+template<int kWidth>
+void UnpackBitsImpl(const uint8_t* in, uint32_t* out) {
+  const __m128i* src = reinterpret_cast<const __m128i*>(in);
+  __m128i* dst = reinterpret_cast<__m128i*>(out);
+  const __m128i mask = _mm_set1_epi32(kWidth == 32 ? 0xffffffff : (1U << (kWidth % 32)) - 1);
+  __m128i word = _mm_loadu_si128(src++);
+  int shift = 0;
+  for (int i = 0; i < 32; i++) {
+    __m128i v = _mm_srli_epi32(word, shift);
+    if (shift + kWidth >= 32) {
+      // The 32 values of a lane take exactly 'kWidth' words, so the last
+      // value never straddles two words.
+      if (i < 31) {
+        word = _mm_loadu_si128(src++);
+        if (shift + kWidth > 32) {
+          v = _mm_or_si128(v, _mm_slli_epi32(word, 32 - shift));
+        }
+      }
+      shift += kWidth - 32;
+    } else {
+      shift += kWidth;
+    }
+    _mm_storeu_si128(dst++, _mm_and_si128(v, mask));
+  }
+}
+
+void UnpackZeros(const uint8_t* /* in */, uint32_t* out) {
+  memset(out, 0, kMiniBlockSize * sizeof(uint32_t));
+}
+
+typedef void (*UnpackFunc)(const uint8_t* in, uint32_t* out);
+
+const UnpackFunc kUnpackFuncs[] = {
+  UnpackZeros,
+  UnpackBitsImpl<1>, UnpackBitsImpl<2>, UnpackBitsImpl<3>, UnpackBitsImpl<4>,
+  UnpackBitsImpl<5>, UnpackBitsImpl<6>, UnpackBitsImpl<7>, UnpackBitsImpl<8>,
+  UnpackBitsImpl<9>, UnpackBitsImpl<10>, UnpackBitsImpl<11>, UnpackBitsImpl<12>,
+  UnpackBitsImpl<13>, UnpackBitsImpl<14>, UnpackBitsImpl<15>, UnpackBitsImpl<16>,
+  UnpackBitsImpl<17>, UnpackBitsImpl<18>, UnpackBitsImpl<19>, UnpackBitsImpl<20>,
+  UnpackBitsImpl<21>, UnpackBitsImpl<22>, UnpackBitsImpl<23>, UnpackBitsImpl<24>,
+  UnpackBitsImpl<25>, UnpackBitsImpl<26>, UnpackBitsImpl<27>, UnpackBitsImpl<28>,
+  UnpackBitsImpl<29>, UnpackBitsImpl<30>, UnpackBitsImpl<31>, UnpackBitsImpl<32>,
+};
+
+} // anonymous namespace
+
+void PackBits(const uint32_t* in, int width, uint8_t* out) {
+  DCHECK_GE(width, 0);
+  DCHECK_LE(width, 32);
+  if (width == 0) {
+    return;
+  }
+  for (int lane = 0; lane < 4; lane++) {
+    uint64_t acc = 0;
+    int bits = 0;
+    int word = 0;
+    for (int i = 0; i < 32; i++) {
+      uint32_t value = in[i * 4 + lane];
+      DCHECK(width == 32 || value >> width == 0) << value << " doesn't fit in " << width;
+      acc |= static_cast<uint64_t>(value) << bits;
+      bits += width;
+      if (bits >= 32) {
+        InlineEncodeFixed32(out + (word * 4 + lane) * sizeof(uint32_t),
+                            static_cast<uint32_t>(acc));
+        acc >>= 32;
+        bits -= 32;
+        word++;
+      }
+    }
+    DCHECK_EQ(0, bits);
+    DCHECK_EQ(width, word);
+  }
+}
+
+void UnpackBits(const uint8_t* in, int width, uint32_t* out) {
+  DCHECK_GE(width, 0);
+  DCHECK_LE(width, 32);
+  kUnpackFuncs[width](in, out);
+}
+
+} // namespace for_internal
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,512 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Frame-of-reference and delta encoding of integer blocks, with the
+// residuals bit-packed in the layout of SIMD-BP128 so that they can be
+// unpacked with SIMD instructions.
+// Reference:
+// Lemire and Boytsov, "Decoding billions of integers per second through
+// vectorization", Software: Practice & Experience, 2015.
+#ifndef KUDU_CFILE_FOR_BLOCK_H
+#define KUDU_CFILE_FOR_BLOCK_H
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowid.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace cfile {
+
+namespace for_internal {
+
+// The number of values packed together with the same bit width.
+static const size_t kMiniBlockSize = 128;
+
+// Packs the kMiniBlockSize values of 'in', which must fit in 'width' bits,
+// into the 16 * 'width' bytes at 'out'. 'width' must be at most 32.
+//
+// The values are interleaved over four 32-bit lanes: the value i is packed in
+// the lane i % 4, right after the value i - 4, so that four values are
+// unpacked at a time by a 128-bit SIMD register.
+void PackBits(const uint32_t* in, int width, uint8_t* out);
+
+// Unpacks the kMiniBlockSize values packed by PackBits() at 'in' into 'out'.
+void UnpackBits(const uint8_t* in, int width, uint32_t* out);
+
+} // namespace for_internal
+
+// ForBlockBuilder encodes the integers of a block either as their difference
+// with the minimum value of the block (frame of reference), or as the
+// difference between each value and the previous one (delta), whichever is
+// smaller. The differences are then bit-packed by mini-blocks of 128 values,
+// each using as few bits as its largest difference needs.
+//
+// This is most effective for the columns whose values are clustered, such as
+// foreign keys, or increase steadily, such as timestamps and sequence
+// numbers: the residuals of their blocks take a handful of bits.
+//
+// The block format is as follows:
+//
+// 1. Header:
+//
+//    <first_ordinal> [32-bit]
+//      The ordinal offset of the first element in the block.
+//
+//    <num_elements> [32-bit]
+//      The number of elements encoded in the block.
+//
+//    <mode> [8-bit]
+//      kFrameOfReference or kDelta.
+//
+//    <reference> [size of the type]
+//      The minimum value of the block for kFrameOfReference, or its first
+//      value for kDelta.
+//
+//    <min_delta> [size of the type]
+//      The minimum difference between two consecutive values for kDelta,
+//      0 for kFrameOfReference.
+//
+//    <bit_widths> [8-bit for each mini-block]
+//      The number of bits of each residual of each mini-block.
+//
+//   NOTE: all on-disk ints are encoded little-endian
+//
+// 2. Residuals
+//
+//    The residuals of each mini-block, packed by for_internal::PackBits(),
+//    with the last mini-block padded with zeros. The residuals of 64-bit types
+//    are packed as two halves: their low 32 bits, then their high bits.
+//
+//    The value i is decoded as:
+//      - kFrameOfReference: reference + residual[i]
+//      - kDelta: value[i - 1] + min_delta + residual[i], where
+//                value[-1] = reference - min_delta and residual[0] = 0.
+//    with the wrap-around arithmetic of the unsigned type.
+//
+template<DataType Type>
+class ForBlockBuilder final : public BlockBuilder {
+ public:
+  explicit ForBlockBuilder(const WriterOptions* options)
+    : options_(options) {
+    Reset();
+  }
+
+  void Reset() OVERRIDE {
+    auto block_size = options_->storage_attributes.cfile_block_size;
+    count_ = 0;
+    data_.clear();
+    data_.reserve(block_size);
+    buffer_.clear();
+    finished_ = false;
+    rem_elem_capacity_ = block_size / kSize;
+  }
+
+  bool IsBlockFull() const override {
+    return rem_elem_capacity_ == 0;
+  }
+
+  int Add(const uint8_t* vals_void, size_t count) OVERRIDE {
+    DCHECK(!finished_);
+    int to_add = std::min<int>(rem_elem_capacity_, count);
+    data_.append(vals_void, to_add * kSize);
+    count_ += to_add;
+    rem_elem_capacity_ -= to_add;
+    return to_add;
+  }
+
+  size_t Count() const OVERRIDE {
+    return count_;
+  }
+
+  Status GetFirstKey(void* key) const OVERRIDE {
+    if (count_ == 0) {
+      return Status::NotFound("no keys in data block");
+    }
+    memcpy(key, &data_[0], kSize);
+    return Status::OK();
+  }
+
+  Status GetLastKey(void* key) const OVERRIDE {
+    if (count_ == 0) {
+      return Status::NotFound("no keys in data block");
+    }
+    memcpy(key, &data_[(count_ - 1) * kSize], kSize);
+    return Status::OK();
+  }
+
+  Slice Finish(rowid_t ordinal_pos) OVERRIDE {
+    using for_internal::kMiniBlockSize;
+    const size_t num_mini_blocks = (count_ + kMiniBlockSize - 1) / kMiniBlockSize;
+
+    // Pick the mode whose residuals take the fewest bits.
+    CppType min_value = count_ > 0 ? cell(0) : 0;
+    SignedType min_delta = std::numeric_limits<SignedType>::max();
+    for (uint32_t i = 0; i < count_; i++) {
+      min_value = std::min(min_value, cell(i));
+      if (i > 0) {
+        min_delta = std::min(min_delta, static_cast<SignedType>(delta(i)));
+      }
+    }
+    if (count_ <= 1) {
+      min_delta = 0;
+    }
+    UnsignedType for_base = static_cast<UnsignedType>(min_value);
+    UnsignedType delta_base = static_cast<UnsignedType>(min_delta);
+    size_t for_bits = 0;
+    size_t delta_bits = 0;
+    for_widths_.resize(num_mini_blocks);
+    delta_widths_.resize(num_mini_blocks);
+    for (size_t m = 0; m < num_mini_blocks; m++) {
+      UnsignedType for_max = 0;
+      UnsignedType delta_max = 0;
+      uint32_t end = std::min<uint32_t>(count_, (m + 1) * kMiniBlockSize);
+      for (uint32_t i = m * kMiniBlockSize; i < end; i++) {
+        for_max = std::max(for_max, Sub(cell(i), for_base));
+        if (i > 0) {
+          delta_max = std::max(delta_max, Sub(delta(i), delta_base));
+        }
+      }
+      for_widths_[m] = BitWidth(for_max);
+      delta_widths_[m] = BitWidth(delta_max);
+      for_bits += for_widths_[m];
+      delta_bits += delta_widths_[m];
+    }
+    bool use_delta = delta_bits < for_bits;
+    const faststring& widths = use_delta ? delta_widths_ : for_widths_;
+
+    // Write the header.
+    size_t packed_size = 0;
+    for (size_t m = 0; m < num_mini_blocks; m++) {
+      packed_size += 16 * widths[m];
+    }
+    buffer_.resize(kHeaderSize + num_mini_blocks + packed_size);
+    InlineEncodeFixed32(&buffer_[0], ordinal_pos);
+    InlineEncodeFixed32(&buffer_[4], count_);
+    buffer_[8] = use_delta ? kDelta : kFrameOfReference;
+    UnsignedType reference = use_delta ? static_cast<UnsignedType>(cell(0)) : for_base;
+    UnsignedType min_delta_field = use_delta ? delta_base : 0;
+    memcpy(&buffer_[9], &reference, kSize);
+    memcpy(&buffer_[9 + kSize], &min_delta_field, kSize);
+    memcpy(&buffer_[kHeaderSize], widths.data(), num_mini_blocks);
+
+    // Pack the residuals of each mini-block.
+    uint8_t* out = &buffer_[kHeaderSize + num_mini_blocks];
+    UnsignedType residuals[kMiniBlockSize];
+    for (size_t m = 0; m < num_mini_blocks; m++) {
+      uint32_t start = m * kMiniBlockSize;
+      for (uint32_t j = 0; j < kMiniBlockSize; j++) {
+        uint32_t i = start + j;
+        if (i >= count_) {
+          residuals[j] = 0;
+        } else if (use_delta) {
+          residuals[j] = i == 0 ? 0 : Sub(delta(i), delta_base);
+        } else {
+          residuals[j] = Sub(cell(i), for_base);
+        }
+      }
+      out = PackMiniBlock(residuals, widths[m], out);
+    }
+    DCHECK_EQ(out, buffer_.data() + buffer_.size());
+    finished_ = true;
+    return Slice(buffer_);
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename std::make_unsigned<CppType>::type UnsignedType;
+  typedef typename std::make_signed<CppType>::type SignedType;
+
+  static const size_t kSize = sizeof(CppType);
+  static const size_t kHeaderSize = sizeof(uint32_t) * 2 + 1 + kSize * 2;
+
+  CppType cell(uint32_t idx) const {
+    return UnalignedLoad<CppType>(&data_[idx * kSize]);
+  }
+
+  // The difference between the value 'idx' and the previous one.
+  UnsignedType delta(uint32_t idx) const {
+    return Sub(cell(idx), cell(idx - 1));
+  }
+
+  static UnsignedType Sub(UnsignedType a, UnsignedType b) {
+    return static_cast<UnsignedType>(a - b);
+  }
+
+  static uint8_t BitWidth(UnsignedType v) {
+    return v == 0 ? 0 : Bits::Log2FloorNonZero64(v) + 1;
+  }
+
+  // Packs the residuals of a mini-block with 'width' bits each, and returns
+  // the end of the packed data.
+  static uint8_t* PackMiniBlock(const UnsignedType* residuals, int width, uint8_t* out) {
+    using for_internal::kMiniBlockSize;
+    uint32_t half[kMiniBlockSize];
+    for (size_t j = 0; j < kMiniBlockSize; j++) {
+      half[j] = static_cast<uint32_t>(residuals[j]);
+    }
+    int low_width = std::min(width, 32);
+    for_internal::PackBits(half, low_width, out);
+    out += 16 * low_width;
+    if (width > 32) {
+      for (size_t j = 0; j < kMiniBlockSize; j++) {
+        half[j] = static_cast<uint32_t>(static_cast<uint64_t>(residuals[j]) >> 32);
+      }
+      for_internal::PackBits(half, width - 32, out);
+      out += 16 * (width - 32);
+    }
+    return out;
+  }
+
+  enum Mode {
+    kFrameOfReference = 0,
+    kDelta = 1
+  };
+
+  template<DataType> friend class ForBlockDecoder;
+
+  faststring data_;
+  faststring buffer_;
+  faststring for_widths_;
+  faststring delta_widths_;
+  uint32_t count_;
+  int rem_elem_capacity_;
+  bool finished_;
+  const WriterOptions* options_;
+};
+
+template<DataType Type>
+class ForBlockDecoder final : public BlockDecoder {
+ public:
+  explicit ForBlockDecoder(Slice slice)
+      : data_(slice),
+        parsed_(false),
+        ordinal_pos_base_(0),
+        num_elems_(0),
+        cur_idx_(0) {
+  }
+
+  Status ParseHeader() OVERRIDE {
+    using for_internal::kMiniBlockSize;
+    CHECK(!parsed_);
+    if (data_.size() < kHeaderSize) {
+      return Status::Corruption(
+        strings::Substitute("not enough bytes for header: frame of reference block header "
+          "size ($0) less than expected header length ($1)",
+          data_.size(), kHeaderSize));
+    }
+
+    ordinal_pos_base_ = DecodeFixed32(&data_[0]);
+    num_elems_ = DecodeFixed32(&data_[4]);
+    mode_ = data_[8];
+    if (mode_ != Builder::kFrameOfReference && mode_ != Builder::kDelta) {
+      return Status::Corruption(strings::Substitute("invalid mode: $0", mode_));
+    }
+    memcpy(&reference_, &data_[9], kSize);
+    memcpy(&min_delta_, &data_[9 + kSize], kSize);
+
+    size_t num_mini_blocks = (num_elems_ + kMiniBlockSize - 1) / kMiniBlockSize;
+    if (data_.size() < kHeaderSize + num_mini_blocks) {
+      return Status::Corruption("not enough bytes for the bit widths");
+    }
+    size_t packed_size = 0;
+    for (size_t m = 0; m < num_mini_blocks; m++) {
+      uint8_t width = data_[kHeaderSize + m];
+      if (width > kSize * 8) {
+        return Status::Corruption(strings::Substitute("invalid bit width: $0", width));
+      }
+      packed_size += 16 * width;
+    }
+    if (data_.size() != kHeaderSize + num_mini_blocks + packed_size) {
+      return Status::Corruption("Size Information unmatched");
+    }
+
+    Expand(num_mini_blocks);
+
+    parsed_ = true;
+    return Status::OK();
+  }
+
+  void SeekToPositionInBlock(uint pos) OVERRIDE {
+    CHECK(parsed_) << "Must call ParseHeader()";
+    if (PREDICT_FALSE(num_elems_ == 0)) {
+      DCHECK_EQ(0, pos);
+      return;
+    }
+
+    DCHECK_LE(pos, num_elems_);
+    cur_idx_ = pos;
+  }
+
+  Status SeekAtOrAfterValue(const void* value_void, bool* exact) OVERRIDE {
+    CppType target = UnalignedLoad<CppType>(value_void);
+    const CppType* values = decoded();
+    uint32_t idx = std::lower_bound(values, values + num_elems_, target) - values;
+    cur_idx_ = idx;
+    if (idx == num_elems_) {
+      *exact = false;
+      return Status::NotFound("after last key in block");
+    }
+    *exact = values[idx] == target;
+    return Status::OK();
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    memcpy(dst->data(), decoded() + cur_idx_, max_fetch * kSize);
+
+    *n = max_fetch;
+    cur_idx_ += max_fetch;
+    return Status::OK();
+  }
+
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    EvalAndCopySelectedCells<Type>(reinterpret_cast<const uint8_t*>(decoded() + cur_idx_),
+                                   max_fetch, ctx, sel, dst);
+
+    *n = max_fetch;
+    cur_idx_ += max_fetch;
+    return Status::OK();
+  }
+
+  size_t GetCurrentIndex() const OVERRIDE {
+    DCHECK(parsed_) << "must parse header first";
+    return cur_idx_;
+  }
+
+  virtual rowid_t GetFirstRowId() const OVERRIDE {
+    return ordinal_pos_base_;
+  }
+
+  size_t Count() const OVERRIDE {
+    return num_elems_;
+  }
+
+  bool HasNext() const OVERRIDE {
+    return (num_elems_ - cur_idx_) > 0;
+  }
+
+ private:
+  typedef ForBlockBuilder<Type> Builder;
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename Builder::UnsignedType UnsignedType;
+
+  static const size_t kSize = Builder::kSize;
+  static const size_t kHeaderSize = Builder::kHeaderSize;
+
+  const CppType* decoded() const {
+    return reinterpret_cast<const CppType*>(decoded_.data());
+  }
+
+  // Decodes all the values of the block into 'decoded_'.
+  void Expand(size_t num_mini_blocks) {
+    using for_internal::kMiniBlockSize;
+    decoded_.resize(num_mini_blocks * kMiniBlockSize * kSize);
+    CppType* out = reinterpret_cast<CppType*>(decoded_.data());
+    const uint8_t* in = &data_[kHeaderSize + num_mini_blocks];
+    uint32_t low[kMiniBlockSize];
+    uint32_t high[kMiniBlockSize];
+    UnsignedType prev = static_cast<UnsignedType>(reference_ - min_delta_);
+    for (size_t m = 0; m < num_mini_blocks; m++) {
+      int width = data_[kHeaderSize + m];
+      int low_width = std::min(width, 32);
+      for_internal::UnpackBits(in, low_width, low);
+      in += 16 * low_width;
+      if (width > 32) {
+        for_internal::UnpackBits(in, width - 32, high);
+        in += 16 * (width - 32);
+      }
+      if (mode_ == Builder::kFrameOfReference) {
+        if (width > 32) {
+          for (size_t j = 0; j < kMiniBlockSize; j++) {
+            out[j] = static_cast<CppType>(
+                reference_ + (static_cast<uint64_t>(high[j]) << 32 | low[j]));
+          }
+        } else {
+          for (size_t j = 0; j < kMiniBlockSize; j++) {
+            out[j] = static_cast<CppType>(reference_ + low[j]);
+          }
+        }
+      } else {
+        for (size_t j = 0; j < kMiniBlockSize; j++) {
+          UnsignedType residual = width > 32 ?
+              static_cast<UnsignedType>(static_cast<uint64_t>(high[j]) << 32 | low[j]) :
+              static_cast<UnsignedType>(low[j]);
+          prev = static_cast<UnsignedType>(prev + min_delta_ + residual);
+          out[j] = static_cast<CppType>(prev);
+        }
+      }
+      out += kMiniBlockSize;
+    }
+  }
+
+  Slice data_;
+  bool parsed_;
+
+  rowid_t ordinal_pos_base_;
+  uint32_t num_elems_;
+  uint8_t mode_;
+  UnsignedType reference_;
+  UnsignedType min_delta_;
+
+  size_t cur_idx_;
+  faststring decoded_;
+};
+
+} // namespace cfile
+} // namespace kudu
+#endif
@@ -24,7 +24,12 @@
 #include "kudu/gutil/port.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/coding-inl.h"
 #include "kudu/util/hexdump.h"
@@ -42,6 +47,37 @@ enum {
   kRleBitmapBlockHeaderSize = 8
 };
 
+// Reads the next 'n' values from 'decoder' a run at a time, evaluating the
+// predicate of 'ctx' once per run. The rows of the runs which don't match are
+// cleared from 'sel' as a whole, and the value of those which do is copied
+// to 'dst'.
+template <DataType Type>
+Status EvalRuns(RleDecoder<typename TypeTraits<Type>::cpp_type>* decoder,
+                size_t n,
+                ColumnMaterializationContext* ctx,
+                SelectionVectorView* sel,
+                ColumnDataView* dst) {
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  const ColumnPredicate* pred = ctx->pred();
+  CppType* out = reinterpret_cast<CppType*>(dst->data());
+  size_t row = 0;
+  while (row < n) {
+    CppType val;
+    size_t run_length = decoder->GetNextRun(&val, n - row);
+    if (PREDICT_FALSE(run_length == 0)) {
+      return Status::Corruption(strings::Substitute(
+          "unexpected end of RLE data: expected $0 more values", n - row));
+    }
+    if (pred->EvaluateCell<TypeTraits<Type>::physical_type>(&val)) {
+      std::fill(out + row, out + row + run_length, val);
+    } else {
+      sel->ClearBits(row, run_length);
+    }
+    row += run_length;
+  }
+  return Status::OK();
+}
+
 //
 // RLE encoder for the BOOL datatype: uses an RLE-encoded bitmap to
 // represent a bool column.
@@ -192,6 +228,29 @@ class RleBitMapBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // Evaluates the predicate once per run of the same value, without decoding
+  // the values of the runs which don't match.
+  virtual Status CopyNextAndEval(size_t* n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(bool));
+    ctx->SetDecoderEvalSupported();
+
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t bits_to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    RETURN_NOT_OK(EvalRuns<BOOL>(&rle_decoder_, bits_to_fetch, ctx, sel, dst));
+    cur_idx_ += bits_to_fetch;
+    *n = bits_to_fetch;
+    return Status::OK();
+  }
+
   virtual Status SeekAtOrAfterValue(const void *value,
                                     bool *exact_match) OVERRIDE {
     return Status::NotSupported("BOOL keys are not supported!");
@@ -423,6 +482,29 @@ class RleIntBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // Evaluates the predicate once per run of the same value, without decoding
+  // the values of the runs which don't match.
+  virtual Status CopyNextAndEval(size_t* n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    RETURN_NOT_OK(EvalRuns<IntType>(&rle_decoder_, to_fetch, ctx, sel, dst));
+    cur_idx_ += to_fetch;
+    *n = to_fetch;
+    return Status::OK();
+  }
+
   virtual bool HasNext() const OVERRIDE {
     return cur_idx_ < num_elems_;
   }
@@ -95,6 +95,7 @@
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/async_util.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"  // IWYU pragma: keep
 #include "kudu/util/metrics.h"
@@ -1143,6 +1144,54 @@ TEST_F(ClientTest, TestScanEmptyProjection) {
   }
 }
 
+// Test scanning with the COLUMNAR_LAYOUT row format flag, and that the
+// returned column buffers match the inserted rows.
+TEST_F(ClientTest, TestColumnarScan) {
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(),
+                                         FLAGS_test_scan_num_rows));
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetProjectedColumnNames({ "key", "string_val" }));
+  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  ASSERT_OK(scanner.Open());
+
+  // Row-wise batches can't be fetched from a columnar scanner.
+  KuduScanBatch row_batch;
+  Status s = scanner.NextBatch(&row_batch);
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+
+  KuduColumnarScanBatch batch;
+  int64_t count = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    if (batch.NumRows() == 0) continue;
+    count += batch.NumRows();
+
+    Slice keys;
+    ASSERT_OK(batch.GetFixedLengthColumn(0, &keys));
+    ASSERT_EQ(batch.NumRows() * sizeof(int32_t), keys.size());
+    Slice non_null;
+    ASSERT_OK(batch.GetNonNullBitmapForColumn(0, &non_null));
+    ASSERT_EQ(0, non_null.size());
+
+    Slice offsets, strings;
+    ASSERT_OK(batch.GetVariableLengthColumn(1, &offsets, &strings));
+    ASSERT_EQ((batch.NumRows() + 1) * sizeof(uint32_t), offsets.size());
+    ASSERT_OK(batch.GetNonNullBitmapForColumn(1, &non_null));
+    ASSERT_EQ(BitmapSize(batch.NumRows()), non_null.size());
+    Slice unused;
+    ASSERT_TRUE(batch.GetFixedLengthColumn(1, &unused).IsInvalidArgument());
+
+    const int32_t* key_data = reinterpret_cast<const int32_t*>(keys.data());
+    const uint32_t* offset_data = reinterpret_cast<const uint32_t*>(offsets.data());
+    for (int i = 0; i < batch.NumRows(); i++) {
+      ASSERT_TRUE(BitmapTest(non_null.data(), i));
+      Slice val(strings.data() + offset_data[i], offset_data[i + 1] - offset_data[i]);
+      ASSERT_EQ(StringPrintf("hello %d", key_data[i]), val.ToString());
+    }
+  }
+  ASSERT_EQ(FLAGS_test_scan_num_rows, count);
+}
+
 TEST_F(ClientTest, TestProjectInvalidColumn) {
   KuduScanner scanner(client_table_.get());
   Status s = scanner.SetProjectedColumns({ "column-doesnt-exist" });
@@ -70,6 +70,7 @@ Status AlterKuduTableOnly(client::KuduClient* kudu_client,
 
 namespace client {
 
+class KuduColumnarScanBatch;
 class KuduDelete;
 class KuduInsert;
 class KuduLoggingCallback;
@@ -97,6 +98,7 @@ class MetaCache;
 class RemoteTablet;
 class RemoteTabletServer;
 class ReplicaController;
+class ScanBatchDataInterface;
 class WriteRpc;
 } // namespace internal
 
@@ -1989,6 +1991,19 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status NextBatch(KuduScanBatch* batch);
 
+  /// Fetch the next batch of results for this scanner in columnar layout.
+  ///
+  /// This variant may only be used when the scanner was configured with the
+  /// COLUMNAR_LAYOUT row format flag.
+  ///
+  /// A call to NextBatch() invalidates all previously fetched results
+  /// which might now be pointing to garbage memory.
+  ///
+  /// @param [out] batch
+  ///   Placeholder for the result.
+  /// @return Operation result status.
+  Status NextBatch(KuduColumnarScanBatch* batch);
+
   /// Get the KuduTabletServer that is currently handling the scan.
   ///
   /// More concretely, this is the server that handled the most recent
@@ -2096,6 +2111,12 @@ class KUDU_EXPORT KuduScanner {
   ///   data for further decoding. Using KuduScanBatch::Row() might yield incorrect/corrupt
   ///   results and might even cause the client to crash.
   static const uint64_t PAD_UNIXTIME_MICROS_TO_16_BYTES = 1 << 0;
+  /// Makes the server return the results in columnar layout: one set of buffers
+  /// per projected column rather than one buffer of rows.
+  /// @note Scanners with this flag enabled must fetch their results with
+  ///   NextBatch(KuduColumnarScanBatch*). The flag may not be combined with
+  ///   other row format flags.
+  static const uint64_t COLUMNAR_LAYOUT = 1 << 1;
   /// Optionally set row format modifier flags.
   ///
   /// If flags is RowFormatFlags::NO_FLAGS, then no modifications will be made to the row
@@ -2139,6 +2160,9 @@ class KUDU_EXPORT KuduScanner {
  private:
   class KUDU_NO_EXPORT Data;
 
+  // Fetch the next batch of results into either kind of scan batch.
+  Status NextBatch(internal::ScanBatchDataInterface* batch);
+
   friend class KuduScanToken;
   FRIEND_TEST(ClientTest, TestScanCloseProxy);
   FRIEND_TEST(ClientTest, TestScanFaultTolerance);
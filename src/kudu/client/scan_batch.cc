@@ -69,6 +69,34 @@ Slice KuduScanBatch::indirect_data() const {
   return data_->indirect_data_;
 }
 
+////////////////////////////////////////////////////////////
+// KuduColumnarScanBatch
+////////////////////////////////////////////////////////////
+
+KuduColumnarScanBatch::KuduColumnarScanBatch() : data_(new Data()) {}
+
+KuduColumnarScanBatch::~KuduColumnarScanBatch() {
+  delete data_;
+}
+
+int KuduColumnarScanBatch::NumRows() const {
+  return data_->num_rows();
+}
+
+Status KuduColumnarScanBatch::GetFixedLengthColumn(int idx, Slice* data) const {
+  return data_->GetFixedLengthColumn(idx, data);
+}
+
+Status KuduColumnarScanBatch::GetVariableLengthColumn(int idx,
+                                                      Slice* offsets,
+                                                      Slice* data) const {
+  return data_->GetVariableLengthColumn(idx, offsets, data);
+}
+
+Status KuduColumnarScanBatch::GetNonNullBitmapForColumn(int idx, Slice* data) const {
+  return data_->GetNonNullBitmapForColumn(idx, data);
+}
+
 ////////////////////////////////////////////////////////////
 // KuduScanBatch::RowPtr
 ////////////////////////////////////////////////////////////
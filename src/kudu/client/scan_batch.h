@@ -382,6 +382,76 @@ inline KuduScanBatch::const_iterator KuduScanBatch::end() const {
   return const_iterator(this, NumRows());
 }
 
+/// @brief A batch of zero or more rows returned by a scan in columnar layout.
+///
+/// Every call to KuduScanner::NextBatch(KuduColumnarScanBatch*) on a scanner
+/// configured with the KuduScanner::COLUMNAR_LAYOUT row format flag returns
+/// a batch of zero or more rows. Rather than one buffer of rows, the batch
+/// holds a set of buffers for each projected column, in projection order:
+///
+/// @li For fixed-width types, a buffer of NumRows() cells in the same
+///   in-memory format used by KuduScanBatch::direct_data(). Cells for
+///   @c NULL values have undefined contents.
+/// @li For STRING and BINARY types, a buffer of <tt>NumRows() + 1</tt>
+///   uint32_t offsets and a buffer of variable-length data. The value of
+///   row @c i spans <tt>[offsets[i], offsets[i + 1])</tt> in the latter.
+/// @li For nullable columns, a bitmap with a set bit for each non-null cell.
+///
+/// @note The Slices returned by this class are only valid for the lifetime
+///   of the KuduColumnarScanBatch, or until it is used for a new
+///   NextBatch() call.
+///
+/// @note This is an Advanced/Unstable API: there are no guarantees on the
+///   stability of the format returned by these methods.
+class KUDU_EXPORT KuduColumnarScanBatch {
+ public:
+  KuduColumnarScanBatch();
+  ~KuduColumnarScanBatch();
+
+  /// @return The number of rows in this batch.
+  int NumRows() const;
+
+  /// Get the raw data of a fixed-width column.
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] data
+  ///   The dense cell data of the column.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range or the column is of a variable-length type.
+  Status GetFixedLengthColumn(int idx, Slice* data) const;
+
+  /// Get the raw data of a variable-length (STRING or BINARY) column.
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] offsets
+  ///   <tt>NumRows() + 1</tt> uint32_t offsets into @c data.
+  /// @param [out] data
+  ///   The variable-length cell data of the column.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range or the column is of a fixed-width type.
+  Status GetVariableLengthColumn(int idx, Slice* offsets, Slice* data) const;
+
+  /// Get the non-null bitmap of a column.
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] data
+  ///   A bitmap with a set bit for each non-null cell of the column. If the
+  ///   column is not nullable, the returned Slice is empty.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range.
+  Status GetNonNullBitmapForColumn(int idx, Slice* data) const;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+  friend class KuduScanner;
+
+  Data* data_;
+  DISALLOW_COPY_AND_ASSIGN(KuduColumnarScanBatch);
+};
+
 } // namespace client
 } // namespace kudu
 
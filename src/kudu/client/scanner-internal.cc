@@ -35,6 +35,7 @@
 #include "kudu/common/partition.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/types.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -303,6 +304,9 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
   if (configuration().row_format_flags() & KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES) {
     controller_.RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
   }
+  if (configuration().row_format_flags() & KuduScanner::COLUMNAR_LAYOUT) {
+    controller_.RequireServerFeature(TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE);
+  }
   ScanRpcStatus scan_status = AnalyzeResponse(
       proxy_->Scan(next_req_,
                    &last_response_,
@@ -591,22 +595,22 @@ Status KuduScanBatch::Data::Reset(RpcController* controller,
                                   const Schema* projection,
                                   const KuduSchema* client_projection,
                                   uint64_t row_format_flags,
-                                  unique_ptr<RowwiseRowBlockPB> resp_data) {
+                                  tserver::ScanResponsePB* response) {
   CHECK(controller->finished());
   controller_.Swap(controller);
   projection_ = projection;
   projected_row_size_ = CalculateProjectedRowSize(*projection_);
   client_projection_ = client_projection;
   row_format_flags_ = row_format_flags;
-  if (!resp_data) {
+  if (!response->has_data()) {
     // No new data; just clear out the old stuff.
     resp_data_.Clear();
     return Status::OK();
   }
 
   // There's new data. Swap it in and process it.
-  resp_data_.Swap(resp_data.get());
-  resp_data.reset(); // no longer valid.
+  resp_data_.Swap(response->mutable_data());
+  response->clear_data();
 
   // First, rewrite the relative addresses into absolute ones.
   if (PREDICT_FALSE(!resp_data_.has_rows_sidecar())) {
@@ -669,5 +673,150 @@ void KuduScanBatch::Data::Clear() {
   controller_.Reset();
 }
 
+////////////////////////////////////////////////////////////
+// KuduColumnarScanBatch
+////////////////////////////////////////////////////////////
+
+KuduColumnarScanBatch::Data::Data() : projection_(nullptr) {}
+
+KuduColumnarScanBatch::Data::~Data() {}
+
+Status KuduColumnarScanBatch::Data::Reset(RpcController* controller,
+                                          const Schema* projection,
+                                          const KuduSchema* /* client_projection */,
+                                          uint64_t /* row_format_flags */,
+                                          tserver::ScanResponsePB* response) {
+  CHECK(controller->finished());
+  controller_.Swap(controller);
+  projection_ = projection;
+  columns_.clear();
+  if (!response->has_columnar_data()) {
+    // No new data; just clear out the old stuff.
+    resp_data_.Clear();
+    columns_.resize(projection_->num_columns());
+    return Status::OK();
+  }
+
+  // There's new data. Swap it in and resolve the sidecars of each column.
+  resp_data_.Swap(response->mutable_columnar_data());
+  response->clear_columnar_data();
+
+  // The server doesn't set up any columns if none of its row blocks had
+  // selected rows.
+  if (resp_data_.num_rows() == 0 && resp_data_.columns_size() == 0) {
+    columns_.resize(projection_->num_columns());
+    return Status::OK();
+  }
+
+  if (PREDICT_FALSE(resp_data_.columns_size() != projection_->num_columns())) {
+    return Status::Corruption(Substitute(
+        "Server sent invalid response: expected $0 columns but got $1",
+        projection_->num_columns(), resp_data_.columns_size()));
+  }
+
+  const int64_t num_rows = resp_data_.num_rows();
+  columns_.resize(resp_data_.columns_size());
+  for (int i = 0; i < resp_data_.columns_size(); i++) {
+    const ColumnarRowBlockPB::Column& col_pb = resp_data_.columns(i);
+    const ColumnSchema& col = projection_->column(i);
+    Column* col_data = &columns_[i];
+
+    if (PREDICT_FALSE(!col_pb.has_data_sidecar())) {
+      return Status::Corruption(Substitute(
+          "Server sent invalid response: no data for column $0", col.name()));
+    }
+    Status s = controller_.GetInboundSidecar(col_pb.data_sidecar(), &col_data->data);
+    if (!s.ok()) {
+      return Status::Corruption("Server sent invalid response: "
+          "column data sidecar index corrupt", s.ToString());
+    }
+
+    size_t expected_data_size;
+    if (col.type_info()->physical_type() == BINARY) {
+      if (PREDICT_FALSE(!col_pb.has_varlen_data_sidecar())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: no varlen data for column $0", col.name()));
+      }
+      s = controller_.GetInboundSidecar(col_pb.varlen_data_sidecar(), &col_data->varlen_data);
+      if (!s.ok()) {
+        return Status::Corruption("Server sent invalid response: "
+            "column varlen data sidecar index corrupt", s.ToString());
+      }
+      expected_data_size = (num_rows + 1) * sizeof(uint32_t);
+    } else {
+      expected_data_size = num_rows * col.type_info()->size();
+    }
+    if (PREDICT_FALSE(col_data->data.size() != expected_data_size)) {
+      return Status::Corruption(Substitute(
+          "Server sent invalid response: column $0 has $1 bytes of data, expected $2",
+          col.name(), col_data->data.size(), expected_data_size));
+    }
+
+    if (col.is_nullable()) {
+      if (PREDICT_FALSE(!col_pb.has_non_null_bitmap_sidecar())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: no non-null bitmap for column $0", col.name()));
+      }
+      s = controller_.GetInboundSidecar(col_pb.non_null_bitmap_sidecar(),
+                                        &col_data->non_null_bitmap);
+      if (!s.ok()) {
+        return Status::Corruption("Server sent invalid response: "
+            "column non-null bitmap sidecar index corrupt", s.ToString());
+      }
+      if (PREDICT_FALSE(col_data->non_null_bitmap.size() != BitmapSize(num_rows))) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: column $0 has a non-null bitmap of $1 bytes, "
+            "expected $2", col.name(), col_data->non_null_bitmap.size(), BitmapSize(num_rows)));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+void KuduColumnarScanBatch::Data::Clear() {
+  resp_data_.Clear();
+  columns_.clear();
+  controller_.Reset();
+}
+
+Status KuduColumnarScanBatch::Data::CheckColumnIndex(int idx) const {
+  if (PREDICT_FALSE(idx < 0 || idx >= static_cast<int>(columns_.size()))) {
+    return Status::InvalidArgument(Substitute("bad column index $0 ($1 columns present)",
+                                              idx, columns_.size()));
+  }
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::GetFixedLengthColumn(int idx, Slice* data) const {
+  RETURN_NOT_OK(CheckColumnIndex(idx));
+  const ColumnSchema& col = projection_->column(idx);
+  if (PREDICT_FALSE(col.type_info()->physical_type() == BINARY)) {
+    return Status::InvalidArgument(Substitute(
+        "column $0 is of variable-length type $1", col.name(), col.type_info()->name()));
+  }
+  *data = columns_[idx].data;
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::GetVariableLengthColumn(int idx,
+                                                            Slice* offsets,
+                                                            Slice* data) const {
+  RETURN_NOT_OK(CheckColumnIndex(idx));
+  const ColumnSchema& col = projection_->column(idx);
+  if (PREDICT_FALSE(col.type_info()->physical_type() != BINARY)) {
+    return Status::InvalidArgument(Substitute(
+        "column $0 is of fixed-width type $1", col.name(), col.type_info()->name()));
+  }
+  *offsets = columns_[idx].data;
+  *data = columns_[idx].varlen_data;
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::GetNonNullBitmapForColumn(int idx, Slice* data) const {
+  RETURN_NOT_OK(CheckColumnIndex(idx));
+  *data = columns_[idx].non_null_bitmap;
+  return Status::OK();
+}
+
 } // namespace client
 } // namespace kudu
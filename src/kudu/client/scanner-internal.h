@@ -59,6 +59,24 @@ namespace client {
 namespace internal {
 class RemoteTablet;
 class RemoteTabletServer;
+
+// The interface shared by the internal data of KuduScanBatch and
+// KuduColumnarScanBatch, through which KuduScanner fills either kind of
+// batch from a scan response.
+class ScanBatchDataInterface {
+ public:
+  virtual ~ScanBatchDataInterface() = default;
+
+  // Swaps in the RPC controller and the row data of 'response', which are
+  // then owned by the batch.
+  virtual Status Reset(rpc::RpcController* controller,
+                       const Schema* projection,
+                       const KuduSchema* client_projection,
+                       uint64_t row_format_flags,
+                       tserver::ScanResponsePB* response) = 0;
+
+  virtual void Clear() = 0;
+};
 } // namespace internal
 
 // The result of KuduScanner::Data::AnalyzeResponse.
@@ -289,7 +307,7 @@ class KuduScanner::Data {
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
 
-class KuduScanBatch::Data {
+class KuduScanBatch::Data : public internal::ScanBatchDataInterface {
  public:
   Data();
   ~Data();
@@ -298,7 +316,7 @@ class KuduScanBatch::Data {
                const Schema* projection,
                const KuduSchema* client_projection,
                uint64_t row_format_flags,
-               std::unique_ptr<RowwiseRowBlockPB> resp_data);
+               tserver::ScanResponsePB* response) override;
 
   int num_rows() const {
     return resp_data_.num_rows();
@@ -316,7 +334,7 @@ class KuduScanBatch::Data {
 
   void ExtractRows(std::vector<KuduScanBatch::RowPtr>* rows);
 
-  void Clear();
+  void Clear() override;
 
   // Returns the size of a row for the given projection 'proj'.
   static size_t CalculateProjectedRowSize(const Schema& proj);
@@ -346,6 +364,53 @@ class KuduScanBatch::Data {
   size_t projected_row_size_;
 };
 
+class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
+ public:
+  Data();
+  ~Data();
+
+  Status Reset(rpc::RpcController* controller,
+               const Schema* projection,
+               const KuduSchema* client_projection,
+               uint64_t row_format_flags,
+               tserver::ScanResponsePB* response) override;
+
+  void Clear() override;
+
+  int num_rows() const {
+    return resp_data_.num_rows();
+  }
+
+  Status GetFixedLengthColumn(int idx, Slice* data) const;
+  Status GetVariableLengthColumn(int idx, Slice* offsets, Slice* data) const;
+  Status GetNonNullBitmapForColumn(int idx, Slice* data) const;
+
+ private:
+  Status CheckColumnIndex(int idx) const;
+
+  // The RPC controller for the RPC which returned this batch.
+  // Holding on to the controller ensures we hold on to the sidecars
+  // which contain the column data.
+  rpc::RpcController controller_;
+
+  // The PB which describes the sidecars of each column.
+  ColumnarRowBlockPB resp_data_;
+
+  // The projection being scanned.
+  const Schema* projection_;
+
+  // Slices into the sidecars of each column, whose lifetime is ensured by
+  // 'controller_'. An absent buffer is represented by an empty slice.
+  struct Column {
+    Slice data;
+    Slice varlen_data;
+    Slice non_null_bitmap;
+  };
+  std::vector<Column> columns_;
+
+  DISALLOW_COPY_AND_ASSIGN(Data);
+};
+
 } // namespace client
 } // namespace kudu
 
@@ -0,0 +1,128 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Microbenchmark of ColumnPredicate::Evaluate(), comparing the vectorized
+// kernels of column_predicate_kernels.h with the scalar evaluation.
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/column_predicate_kernels.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_util.h"
+
+DEFINE_int32(num_rows, 1024, "The number of rows in each evaluated block");
+DEFINE_int32(num_iters, 20000, "The number of times to evaluate each predicate");
+
+DECLARE_bool(predicate_evaluation_use_simd);
+
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class ColumnPredicateBench : public KuduTest {
+ protected:
+  // Evaluates each predicate over a block of random values, which are NULL
+  // one time in ten, with both the scalar path and the vectorized kernels.
+  template <DataType Type>
+  void RunBench() {
+    typedef typename TypeTraits<Type>::cpp_type T;
+    Random rng(SeedRandom());
+    ScopedColumnBlock<Type> block(FLAGS_num_rows);
+    for (int i = 0; i < FLAGS_num_rows; i++) {
+      block[i] = static_cast<T>(rng.Uniform(100));
+      block.SetCellIsNull(i, rng.OneIn(10));
+    }
+
+    ColumnSchema column("c", Type, true);
+    // Each predicate selects about 10% of the values.
+    T lower = 10;
+    T upper = 20;
+    vector<T> list = { 1, 10, 20, 30, 40, 50, 60, 70, 80, 90 };
+    vector<const void*> list_values;
+    for (const T& v : list) {
+      list_values.push_back(&v);
+    }
+    vector<ColumnPredicate> predicates = {
+      ColumnPredicate::Range(column, &lower, &upper),
+      ColumnPredicate::Range(column, nullptr, &lower),
+      ColumnPredicate::Equality(column, &lower),
+      ColumnPredicate::InList(column, &list_values),
+      ColumnPredicate::IsNotNull(column),
+    };
+
+    SelectionVector sel(FLAGS_num_rows);
+    for (const auto& pred : predicates) {
+      double scalar_secs = 0;
+      double vectorized_secs = 0;
+      for (bool use_simd : { false, true }) {
+        FLAGS_predicate_evaluation_use_simd = use_simd;
+        Stopwatch sw;
+        sw.start();
+        for (int i = 0; i < FLAGS_num_iters; i++) {
+          sel.SetAllTrue();
+          pred.Evaluate(block, &sel);
+        }
+        sw.stop();
+        (use_simd ? vectorized_secs : scalar_secs) = sw.elapsed().wall_seconds();
+      }
+      double rows = static_cast<double>(FLAGS_num_rows) * FLAGS_num_iters;
+      LOG(INFO) << Substitute("$0 ($1): scalar $2 Mrows/sec, $3 $4 Mrows/sec ($5x)",
+                              pred.ToString(), GetTypeInfo(Type)->name(),
+                              StringPrintf("%.1f", rows / scalar_secs / 1e6),
+                              predicate_kernels::InstructionSet(),
+                              StringPrintf("%.1f", rows / vectorized_secs / 1e6),
+                              StringPrintf("%.2f", scalar_secs / vectorized_secs));
+    }
+  }
+};
+
+TEST_F(ColumnPredicateBench, Int8) {
+  RunBench<INT8>();
+}
+
+TEST_F(ColumnPredicateBench, Int32) {
+  RunBench<INT32>();
+}
+
+TEST_F(ColumnPredicateBench, Int64) {
+  RunBench<INT64>();
+}
+
+TEST_F(ColumnPredicateBench, UnixtimeMicros) {
+  RunBench<UNIXTIME_MICROS>();
+}
+
+TEST_F(ColumnPredicateBench, Double) {
+  RunBench<DOUBLE>();
+}
+
+} // namespace kudu
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -26,15 +27,21 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/int128.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/random.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(predicate_evaluation_use_simd);
+
 using std::vector;
 
 namespace kudu {
@@ -1154,6 +1161,185 @@ TEST_F(TestColumnPredicate, TestSelectivity) {
             0);
 }
 
+// Test the simplification, merging and evaluation of bloom filter predicates.
+TEST_F(TestColumnPredicate, TestInBloomFilter) {
+  ColumnSchema column("c", INT32, true);
+
+  // Build a filter containing the even values in [0, 100).
+  BloomFilterBuilder builder(BloomFilterSizing::ByCountAndFPRate(50, 0.000001));
+  for (int32_t i = 0; i < 100; i += 2) {
+    builder.AddKey(BloomKeyProbe(Slice(reinterpret_cast<const uint8_t*>(&i), sizeof(i))));
+  }
+  BloomFilter bloom_filter(builder.slice(), builder.n_hashes());
+
+  int32_t zero = 0;
+  int32_t one = 1;
+  int32_t two = 2;
+  int32_t three = 3;
+  int32_t four = 4;
+  int32_t ten = 10;
+  int32_t fifty = 50;
+  vector<BloomFilter> bloom_filters;
+
+  auto in_bloom_filter = [&] (const void* lower, const void* upper) {
+    bloom_filters = { bloom_filter };
+    return ColumnPredicate::InBloomFilter(column, &bloom_filters, lower, upper);
+  };
+
+  ASSERT_EQ(PredicateType::InBloomFilter,
+            in_bloom_filter(nullptr, nullptr).predicate_type());
+  ASSERT_EQ(PredicateType::InBloomFilter,
+            in_bloom_filter(&zero, &ten).predicate_type());
+
+  // Empty and single-value ranges are simplified.
+  ASSERT_EQ(PredicateType::None, in_bloom_filter(&ten, &zero).predicate_type());
+  ASSERT_EQ(PredicateType::None, in_bloom_filter(&one, &two).predicate_type());
+  ASSERT_EQ(ColumnPredicate::Equality(column, &two), in_bloom_filter(&two, &three));
+
+  // Merging with a range narrows the range of the bloom filter predicate.
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            ColumnPredicate::Range(column, &two, &ten),
+            in_bloom_filter(&two, &ten),
+            PredicateType::InBloomFilter);
+
+  // Merging with an equality checks the value against the filter.
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            ColumnPredicate::Equality(column, &four),
+            ColumnPredicate::Equality(column, &four),
+            PredicateType::Equality);
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            ColumnPredicate::Equality(column, &one),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+
+  // Merging with an IN list keeps the values which pass the filter.
+  vector<const void*> values = { &one, &two, &four, &fifty };
+  ColumnPredicate in_list = ColumnPredicate::InList(column, &values);
+  values = { &two, &four };
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            in_list,
+            ColumnPredicate::InList(column, &values),
+            PredicateType::InList);
+
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            ColumnPredicate::IsNotNull(column),
+            in_bloom_filter(&zero, &fifty),
+            PredicateType::InBloomFilter);
+  TestMerge(in_bloom_filter(&zero, &fifty),
+            ColumnPredicate::IsNull(column),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+
+  // Merging two bloom filter predicates checks the filters of both.
+  {
+    ColumnPredicate merged = in_bloom_filter(&zero, &fifty);
+    merged.Merge(in_bloom_filter(&two, nullptr));
+    ASSERT_EQ(PredicateType::InBloomFilter, merged.predicate_type());
+    ASSERT_EQ(2, merged.bloom_filters().size());
+    ASSERT_EQ(two, *reinterpret_cast<const int32_t*>(merged.raw_lower()));
+    ASSERT_EQ(fifty, *reinterpret_cast<const int32_t*>(merged.raw_upper()));
+  }
+
+  // Evaluate the predicate over a block of values.
+  const int kNumRows = 100;
+  ScopedColumnBlock<INT32> block(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    block[i] = i;
+    block.SetCellIsNull(i, i == 20);
+  }
+  SelectionVector sel(kNumRows);
+  sel.SetAllTrue();
+  in_bloom_filter(&ten, &fifty).Evaluate(block, &sel);
+  for (int i = 0; i < kNumRows; i++) {
+    bool expected = i >= 10 && i < 50 && i % 2 == 0 && i != 20;
+    ASSERT_EQ(expected, sel.IsRowSelected(i)) << i;
+  }
+  ASSERT_TRUE(in_bloom_filter(nullptr, nullptr).EvaluateCell<INT32>(&fifty));
+  ASSERT_FALSE(in_bloom_filter(nullptr, &ten).EvaluateCell<INT32>(&fifty));
+}
+
+// Checks that the vectorized kernels select the same rows as the scalar
+// evaluation, for every predicate type they support.
+template <DataType Type>
+void TestVectorizedEvaluation(Random* rng) {
+  typedef typename TypeTraits<Type>::cpp_type T;
+  SCOPED_TRACE(GetTypeInfo(Type)->name());
+  // Not a multiple of 64, to also cover the rows past the last full word.
+  const int kNumRows = 1000;
+  ScopedColumnBlock<Type> block(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    block[i] = static_cast<T>(static_cast<int>(rng->Uniform(100)) - 50);
+    block.SetCellIsNull(i, rng->OneIn(10));
+  }
+  if (std::numeric_limits<T>::has_quiet_NaN) {
+    block[7] = std::numeric_limits<T>::quiet_NaN();
+    block.SetCellIsNull(7, false);
+  }
+  // Deselect a few whole words of rows, to cover the skipping of words.
+  vector<bool> initially_selected(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    initially_selected[i] = !rng->OneIn(4) && (i < 128 || i >= 256);
+  }
+  auto evaluate = [&] (const ColumnPredicate& pred, SelectionVector* sel) {
+    sel->SetAllTrue();
+    for (int i = 0; i < kNumRows; i++) {
+      if (!initially_selected[i]) sel->SetRowUnselected(i);
+    }
+    pred.Evaluate(block, sel);
+  };
+
+  ColumnSchema column("c", Type, true);
+  T lower = -10;
+  T upper = 20;
+  vector<T> short_list = { -40, -3, 0, 7, 33 };
+  vector<T> long_list;
+  for (int i = -50; i < 50; i += 3) {
+    long_list.push_back(i);
+  }
+  auto in_list = [&] (const vector<T>& list) {
+    vector<const void*> values;
+    for (const T& v : list) {
+      values.push_back(&v);
+    }
+    return ColumnPredicate::InList(column, &values);
+  };
+  vector<ColumnPredicate> predicates = {
+    ColumnPredicate::Range(column, &lower, &upper),
+    ColumnPredicate::Range(column, &lower, nullptr),
+    ColumnPredicate::Range(column, nullptr, &upper),
+    ColumnPredicate::Equality(column, &lower),
+    in_list(short_list),
+    in_list(long_list),
+    ColumnPredicate::IsNotNull(column),
+    ColumnPredicate::IsNull(column),
+  };
+  for (const auto& pred : predicates) {
+    SCOPED_TRACE(pred.ToString());
+    SelectionVector scalar_sel(kNumRows);
+    FLAGS_predicate_evaluation_use_simd = false;
+    evaluate(pred, &scalar_sel);
+    SelectionVector vectorized_sel(kNumRows);
+    FLAGS_predicate_evaluation_use_simd = true;
+    evaluate(pred, &vectorized_sel);
+    for (int i = 0; i < kNumRows; i++) {
+      ASSERT_EQ(scalar_sel.IsRowSelected(i), vectorized_sel.IsRowSelected(i)) << i;
+    }
+  }
+}
+
+TEST_F(TestColumnPredicate, TestVectorizedEvaluation) {
+  Random rng(SeedRandom());
+  TestVectorizedEvaluation<INT8>(&rng);
+  TestVectorizedEvaluation<INT16>(&rng);
+  TestVectorizedEvaluation<INT32>(&rng);
+  TestVectorizedEvaluation<INT64>(&rng);
+  TestVectorizedEvaluation<UNIXTIME_MICROS>(&rng);
+  TestVectorizedEvaluation<DECIMAL32>(&rng);
+  TestVectorizedEvaluation<DECIMAL64>(&rng);
+  TestVectorizedEvaluation<FLOAT>(&rng);
+  TestVectorizedEvaluation<DOUBLE>(&rng);
+}
+
 TEST_F(TestColumnPredicate, TestRedaction) {
   ASSERT_NE("", gflags::SetCommandLineOption("redact", "log"));
   ColumnSchema column_i32("a", INT32, true);
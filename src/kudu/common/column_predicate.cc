@@ -18,21 +18,33 @@
 #include "kudu/common/column_predicate.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
 
+#include "kudu/common/column_predicate_kernels.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/key_util.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/memory/arena.h"
 
+DEFINE_bool(predicate_evaluation_use_simd, true,
+            "Whether to evaluate predicates on fixed-width columns with the vectorized "
+            "kernels of column_predicate_kernels.h rather than a cell at a time.");
+TAG_FLAG(predicate_evaluation_use_simd, hidden);
+TAG_FLAG(predicate_evaluation_use_simd, runtime);
+
 using std::move;
 using std::string;
 using std::vector;
@@ -59,6 +71,18 @@ ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
   values_.swap(*values);
 }
 
+ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
+                                 ColumnSchema column,
+                                 vector<BloomFilter>* bloom_filters,
+                                 const void* lower,
+                                 const void* upper)
+    : predicate_type_(predicate_type),
+      column_(move(column)),
+      lower_(lower),
+      upper_(upper) {
+  bloom_filters_.swap(*bloom_filters);
+}
+
 ColumnPredicate ColumnPredicate::Equality(ColumnSchema column, const void* value) {
   CHECK(value != nullptr);
   return ColumnPredicate(PredicateType::Equality, move(column), value, nullptr);
@@ -93,6 +117,17 @@ ColumnPredicate ColumnPredicate::InList(ColumnSchema column,
   return pred;
 }
 
+ColumnPredicate ColumnPredicate::InBloomFilter(ColumnSchema column,
+                                               vector<BloomFilter>* bloom_filters,
+                                               const void* lower,
+                                               const void* upper) {
+  CHECK(bloom_filters != nullptr);
+  CHECK(!bloom_filters->empty());
+  ColumnPredicate pred(PredicateType::InBloomFilter, move(column), bloom_filters, lower, upper);
+  pred.Simplify();
+  return pred;
+}
+
 boost::optional<ColumnPredicate> ColumnPredicate::InclusiveRange(ColumnSchema column,
                                                                  const void* lower,
                                                                  const void* upper,
@@ -165,6 +200,7 @@ void ColumnPredicate::SetToNone() {
   predicate_type_ = PredicateType::None;
   lower_ = nullptr;
   upper_ = nullptr;
+  bloom_filters_.clear();
 }
 
 // TODO: For decimal columns, use column_.type_attributes().precision
@@ -229,6 +265,29 @@ void ColumnPredicate::Simplify() {
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      DCHECK(!bloom_filters_.empty());
+      if (lower_ != nullptr && upper_ != nullptr) {
+        if (type_info->Compare(lower_, upper_) >= 0) {
+          // If the range bounds are empty then no results can be returned.
+          SetToNone();
+        } else if (type_info->AreConsecutive(lower_, upper_)) {
+          // If the values are consecutive, then only the lower bound may
+          // match, so the filters can be checked up front.
+          if (CheckValueInBloomFilter(lower_)) {
+            predicate_type_ = PredicateType::Equality;
+            upper_ = nullptr;
+            bloom_filters_.clear();
+          } else {
+            SetToNone();
+          }
+        }
+      } else if (upper_ != nullptr && type_info->IsMinValue(upper_)) {
+        // VALUE < MIN
+        SetToNone();
+      }
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -257,10 +316,28 @@ void ColumnPredicate::Merge(const ColumnPredicate& other) {
       MergeIntoInList(other);
       return;
     };
+    case PredicateType::InBloomFilter: {
+      MergeIntoBloomFilter(other);
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
 
+void ColumnPredicate::MergeBounds(const ColumnPredicate& other) {
+  // Set the lower bound to the larger of the two.
+  if (other.lower_ != nullptr &&
+      (lower_ == nullptr || column_.type_info()->Compare(lower_, other.lower_) < 0)) {
+    lower_ = other.lower_;
+  }
+
+  // Set the upper bound to the smaller of the two.
+  if (other.upper_ != nullptr &&
+      (upper_ == nullptr || column_.type_info()->Compare(upper_, other.upper_) > 0)) {
+    upper_ = other.upper_;
+  }
+}
+
 void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
   CHECK(predicate_type_ == PredicateType::Range);
 
@@ -271,18 +348,7 @@ void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
     };
 
     case PredicateType::Range: {
-      // Set the lower bound to the larger of the two.
-      if (other.lower_ != nullptr &&
-          (lower_ == nullptr || column_.type_info()->Compare(lower_, other.lower_) < 0)) {
-        lower_ = other.lower_;
-      }
-
-      // Set the upper bound to the smaller of the two.
-      if (other.upper_ != nullptr &&
-          (upper_ == nullptr || column_.type_info()->Compare(upper_, other.upper_) > 0)) {
-        upper_ = other.upper_;
-      }
-
+      MergeBounds(other);
       Simplify();
       return;
     };
@@ -323,6 +389,15 @@ void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
       Simplify();
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // The range is narrowed to the bounds of the other predicate, and the
+      // bloom filters of the other predicate are checked as well.
+      MergeBounds(other);
+      bloom_filters_ = other.bloom_filters_;
+      predicate_type_ = PredicateType::InBloomFilter;
+      Simplify();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -360,6 +435,13 @@ void ColumnPredicate::MergeIntoEquality(const ColumnPredicate& other) {
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // The equality value needs to pass the bloom filters and their range.
+      if (!other.CheckValueInBloomFilter(lower_)) {
+        SetToNone();
+      }
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -378,6 +460,7 @@ void ColumnPredicate::MergeIntoIsNotNull(const ColumnPredicate &other) {
       lower_ = other.lower_;
       upper_ = other.upper_;
       values_ = other.values_;
+      bloom_filters_ = other.bloom_filters_;
       return;
     }
   }
@@ -499,6 +582,75 @@ void ColumnPredicate::MergeIntoInList(const ColumnPredicate &other) {
       Simplify();
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // Only values which pass the bloom filters should be retained.
+      values_.erase(std::remove_if(values_.begin(), values_.end(),
+                                   [&other] (const void* v) {
+                                     return !other.CheckValueInBloomFilter(v);
+                                   }), values_.end());
+      Simplify();
+      return;
+    };
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+void ColumnPredicate::MergeIntoBloomFilter(const ColumnPredicate& other) {
+  CHECK(predicate_type_ == PredicateType::InBloomFilter);
+  DCHECK(!bloom_filters_.empty());
+
+  switch (other.predicate_type()) {
+    case PredicateType::None: {
+      SetToNone();
+      return;
+    };
+    case PredicateType::Range: {
+      MergeBounds(other);
+      Simplify();
+      return;
+    };
+    case PredicateType::Equality: {
+      if (CheckValueInBloomFilter(other.lower_)) {
+        // The value passes the filters, so change to Equality predicate.
+        predicate_type_ = PredicateType::Equality;
+        lower_ = other.lower_;
+        upper_ = nullptr;
+        bloom_filters_.clear();
+      } else {
+        SetToNone();
+      }
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
+    case PredicateType::InList: {
+      // An InList is more selective, so only its values which pass the
+      // filters and their range are retained.
+      vector<const void*> values;
+      for (const void* v : other.values_) {
+        if (CheckValueInBloomFilter(v)) {
+          values.push_back(v);
+        }
+      }
+      predicate_type_ = PredicateType::InList;
+      lower_ = nullptr;
+      upper_ = nullptr;
+      bloom_filters_.clear();
+      values_.swap(values);
+      Simplify();
+      return;
+    };
+    case PredicateType::InBloomFilter: {
+      // A value must pass the filters of both predicates.
+      MergeBounds(other);
+      bloom_filters_.insert(bloom_filters_.end(),
+                            other.bloom_filters_.begin(), other.bloom_filters_.end());
+      Simplify();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -524,11 +676,97 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
     }
   }
 }
+
+// The physical types supported by the kernels of column_predicate_kernels.h.
+template <DataType PhysicalType>
+struct HasPredicateKernels : public std::false_type {};
+template <> struct HasPredicateKernels<INT8> : public std::true_type {};
+template <> struct HasPredicateKernels<INT16> : public std::true_type {};
+template <> struct HasPredicateKernels<INT32> : public std::true_type {};
+template <> struct HasPredicateKernels<INT64> : public std::true_type {};
+template <> struct HasPredicateKernels<FLOAT> : public std::true_type {};
+template <> struct HasPredicateKernels<DOUBLE> : public std::true_type {};
+
+// Evaluates 'pred' on the 'nrows' values at 'data' with the vectorized
+// kernels, clearing the bits of 'sel_bitmap' of the rows which don't match.
+// If 'null_bitmap' is non-null, the NULL rows are cleared as well. Returns
+// false, leaving 'sel_bitmap' untouched, if the kernels don't support the
+// predicate.
+template <DataType PhysicalType>
+bool SelectWithKernels(const ColumnPredicate& pred, const void* data,
+                       const uint8_t* null_bitmap, size_t nrows, uint8_t* sel_bitmap,
+                       std::true_type /* has_kernels */) {
+  typedef typename DataTypeTraits<PhysicalType>::cpp_type T;
+  switch (pred.predicate_type()) {
+    case PredicateType::Range:
+    case PredicateType::Equality:
+      break;
+    case PredicateType::InList:
+      // The kernel compares each value with every value of the list, which
+      // only beats a binary search for short lists. It also doesn't order NaN
+      // like the binary search does, so it's only used for integers.
+      if (!std::is_integral<T>::value ||
+          pred.raw_values().size() > predicate_kernels::kMaxInListSize) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+
+  const T* values = reinterpret_cast<const T*>(data);
+  if (null_bitmap != nullptr) {
+    predicate_kernels::SelectNonNull(null_bitmap, nrows, sel_bitmap);
+  }
+  switch (pred.predicate_type()) {
+    case PredicateType::Range: {
+      T lower;
+      T upper;
+      if (pred.raw_lower() != nullptr) lower = UnalignedLoad<T>(pred.raw_lower());
+      if (pred.raw_upper() != nullptr) upper = UnalignedLoad<T>(pred.raw_upper());
+      predicate_kernels::SelectRange(values, nrows,
+                                     pred.raw_lower() != nullptr ? &lower : nullptr,
+                                     pred.raw_upper() != nullptr ? &upper : nullptr,
+                                     sel_bitmap);
+      break;
+    }
+    case PredicateType::Equality:
+      predicate_kernels::SelectEqual(values, nrows, UnalignedLoad<T>(pred.raw_lower()),
+                                     sel_bitmap);
+      break;
+    case PredicateType::InList: {
+      T list[predicate_kernels::kMaxInListSize];
+      const auto& raw_values = pred.raw_values();
+      for (size_t i = 0; i < raw_values.size(); i++) {
+        list[i] = UnalignedLoad<T>(raw_values[i]);
+      }
+      predicate_kernels::SelectInList(values, nrows, list, raw_values.size(), sel_bitmap);
+      break;
+    }
+    default:
+      LOG(FATAL) << "unexpected predicate type";
+  }
+  return true;
+}
+
+template <DataType PhysicalType>
+bool SelectWithKernels(const ColumnPredicate& /* pred */, const void* /* data */,
+                       const uint8_t* /* null_bitmap */, size_t /* nrows */,
+                       uint8_t* /* sel_bitmap */, std::false_type /* has_kernels */) {
+  return false;
+}
 } // anonymous namespace
 
 template <DataType PhysicalType>
 void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
                                               SelectionVector* sel) const {
+  if (FLAGS_predicate_evaluation_use_simd &&
+      SelectWithKernels<PhysicalType>(*this, block.data(),
+                                      block.is_nullable() ? block.null_bitmap() : nullptr,
+                                      block.nrows(), sel->mutable_bitmap(),
+                                      HasPredicateKernels<PhysicalType>())) {
+    return;
+  }
   switch (predicate_type()) {
     case PredicateType::Range: {
       if (lower_ == nullptr) {
@@ -555,8 +793,11 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
     };
     case PredicateType::IsNotNull: {
       if (!block.is_nullable()) return;
-      // TODO: make this more efficient by using bitwise operations on the
-      // null and selection vectors.
+      if (FLAGS_predicate_evaluation_use_simd) {
+        predicate_kernels::SelectNonNull(block.null_bitmap(), block.nrows(),
+                                         sel->mutable_bitmap());
+        return;
+      }
       for (size_t i = 0; i < block.nrows(); i++) {
         if (sel->IsRowSelected(i) && block.is_null(i)) {
           BitmapClear(sel->mutable_bitmap(), i);
@@ -569,8 +810,11 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
         BitmapChangeBits(sel->mutable_bitmap(), 0, block.nrows(), false);
         return;
       }
-      // TODO(wdberkeley): make this more efficient by using bitwise operations on the
-      // null and selection vectors.
+      if (FLAGS_predicate_evaluation_use_simd) {
+        predicate_kernels::SelectNull(block.null_bitmap(), block.nrows(),
+                                      sel->mutable_bitmap());
+        return;
+      }
       for (size_t i = 0; i < block.nrows(); i++) {
         if (sel->IsRowSelected(i) && !block.is_null(i)) {
           BitmapClear(sel->mutable_bitmap(), i);
@@ -587,6 +831,12 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
       });
       return;
     };
+    case PredicateType::InBloomFilter: {
+      ApplyPredicate(block, sel, [this] (const void* cell) {
+        return this->EvaluateBloomFilterCell<PhysicalType>(cell);
+      });
+      return;
+    };
     case PredicateType::None: LOG(FATAL) << "NONE predicate evaluation";
   }
   LOG(FATAL) << "unknown predicate type";
@@ -611,6 +861,35 @@ bool ColumnPredicate::EvaluateCell(DataType type, const void* cell) const {
   }
 }
 
+bool ColumnPredicate::EvaluateWithKernels(const void* values, size_t nrows,
+                                          uint8_t* sel_bitmap) const {
+  if (!FLAGS_predicate_evaluation_use_simd) {
+    return false;
+  }
+  switch (column_.type_info()->physical_type()) {
+    case INT8:
+      return SelectWithKernels<INT8>(*this, values, nullptr, nrows, sel_bitmap,
+                                     HasPredicateKernels<INT8>());
+    case INT16:
+      return SelectWithKernels<INT16>(*this, values, nullptr, nrows, sel_bitmap,
+                                      HasPredicateKernels<INT16>());
+    case INT32:
+      return SelectWithKernels<INT32>(*this, values, nullptr, nrows, sel_bitmap,
+                                      HasPredicateKernels<INT32>());
+    case INT64:
+      return SelectWithKernels<INT64>(*this, values, nullptr, nrows, sel_bitmap,
+                                      HasPredicateKernels<INT64>());
+    case FLOAT:
+      return SelectWithKernels<FLOAT>(*this, values, nullptr, nrows, sel_bitmap,
+                                      HasPredicateKernels<FLOAT>());
+    case DOUBLE:
+      return SelectWithKernels<DOUBLE>(*this, values, nullptr, nrows, sel_bitmap,
+                                       HasPredicateKernels<DOUBLE>());
+    default:
+      return false;
+  }
+}
+
 void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector* sel) const {
   DCHECK(sel);
   switch (block.type_info()->physical_type()) {
@@ -666,6 +945,17 @@ string ColumnPredicate::ToString() const {
       ss.append(")");
       return ss;
     };
+    case PredicateType::InBloomFilter: {
+      string ss = strings::Substitute("$0 IN $1 BLOOM FILTER(S)",
+                                      column_.name(), bloom_filters_.size());
+      if (lower_ != nullptr) {
+        ss.append(strings::Substitute(" AND $0 >= $1", column_.name(), column_.Stringify(lower_)));
+      }
+      if (upper_ != nullptr) {
+        ss.append(strings::Substitute(" AND $0 < $1", column_.name(), column_.Stringify(upper_)));
+      }
+      return ss;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -677,7 +967,16 @@ bool ColumnPredicate::operator==(const ColumnPredicate& other) const {
   }
   switch (predicate_type_) {
     case PredicateType::Equality: return column_.type_info()->Compare(lower_, other.lower_) == 0;
-    case PredicateType::Range: {
+    case PredicateType::Range:
+    case PredicateType::InBloomFilter: {
+      // Range predicates have no bloom filters.
+      if (bloom_filters_.size() != other.bloom_filters_.size()) return false;
+      for (int i = 0; i < bloom_filters_.size(); i++) {
+        if (bloom_filters_[i].n_hashes() != other.bloom_filters_[i].n_hashes() ||
+            bloom_filters_[i].slice() != other.bloom_filters_[i].slice()) {
+          return false;
+        }
+      }
       return (lower_ == other.lower_ ||
               (lower_ != nullptr && other.lower_ != nullptr &&
                column_.type_info()->Compare(lower_, other.lower_) == 0)) &&
@@ -705,6 +1004,11 @@ bool ColumnPredicate::CheckValueInRange(const void* value) const {
           (upper_ == nullptr || column_.type_info()->Compare(upper_, value) > 0));
 }
 
+bool ColumnPredicate::CheckValueInBloomFilter(const void* value) const {
+  CHECK(predicate_type_ == PredicateType::InBloomFilter);
+  return EvaluateCell(column_.type_info()->physical_type(), value);
+}
+
 bool ColumnPredicate::CheckValueInList(const void* value) const {
   return std::binary_search(values_.begin(), values_.end(), value,
                             [this](const void* lhs, const void* rhs) {
@@ -720,8 +1024,9 @@ int SelectivityRank(const ColumnPredicate& predicate) {
     case PredicateType::IsNull: rank = 1; break;
     case PredicateType::Equality: rank = 2; break;
     case PredicateType::InList: rank = 3; break;
-    case PredicateType::Range: rank = 4; break;
-    case PredicateType::IsNotNull: rank = 5; break;
+    case PredicateType::InBloomFilter: rank = 4; break;
+    case PredicateType::Range: rank = 5; break;
+    case PredicateType::IsNotNull: rank = 6; break;
     default: LOG(FATAL) << "unknown predicate type";
   }
   return rank * (kLargestTypeSize + 1) + predicate.column().type_info()->size();
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -28,6 +30,8 @@
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/util/bloom_filter.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 
@@ -56,6 +60,10 @@ enum class PredicateType {
   // A predicate which evaluates to true if the column value is present in
   // a value list.
   InList,
+
+  // A predicate which evaluates to true if the column value may be present in
+  // every one of a set of bloom filters, and falls within an optional range.
+  InBloomFilter,
 };
 
 // A predicate which can be evaluated over a block of column values.
@@ -130,6 +138,21 @@ class ColumnPredicate {
   // The InList will be simplified into an Equality, Range or None if possible.
   static ColumnPredicate InList(ColumnSchema column, std::vector<const void*>* values);
 
+  // Creates a new IN <BLOOM FILTER> predicate for the column.
+  //
+  // A value matches if every bloom filter may contain it, and if it falls
+  // within the inclusive lower bound and exclusive upper bound. Either or
+  // both of the bounds may be a nullptr to indicate an unbounded range on
+  // that end. The keys of the bloom filters must be the column values in
+  // their ColumnPredicatePB encoding.
+  //
+  // Neither the bloom filter data nor the bounds are copied, and they must
+  // outlive the returned predicate.
+  static ColumnPredicate InBloomFilter(ColumnSchema column,
+                                       std::vector<BloomFilter>* bloom_filters,
+                                       const void* lower,
+                                       const void* upper);
+
   // Creates a new predicate which matches no values.
   static ColumnPredicate None(ColumnSchema column);
 
@@ -164,6 +187,15 @@ class ColumnPredicate {
   // same vector as block->selection_vector().
   void Evaluate(const ColumnBlock& block, SelectionVector* sel) const;
 
+  // Evaluate the predicate on 'nrows' contiguous, non-null values of the
+  // column's physical type with the vectorized kernels of
+  // column_predicate_kernels.h, as an 'AND' with the bits of 'sel_bitmap'.
+  //
+  // Returns false, leaving 'sel_bitmap' untouched, if the kernels don't
+  // support this predicate or type, in which case the caller must evaluate
+  // the cells itself.
+  bool EvaluateWithKernels(const void* values, size_t nrows, uint8_t* sel_bitmap) const;
+
   // Evaluate the predicate on a single cell.
   template <DataType PhysicalType>
   bool EvaluateCell(const void* cell) const {
@@ -196,6 +228,9 @@ class ColumnPredicate {
                                     return DataTypeTraits<PhysicalType>::Compare(lhs, rhs) < 0;
                                   });
       };
+      case PredicateType::InBloomFilter: {
+        return EvaluateBloomFilterCell<PhysicalType>(cell);
+      };
     }
     LOG(FATAL) << "unknown predicate type";
   }
@@ -212,13 +247,13 @@ class ColumnPredicate {
   // Predicates over different columns are not equal.
   bool operator==(const ColumnPredicate& other) const;
 
-  // Returns the raw lower bound value if this is a range predicate, or the
-  // equality value if this is an equality predicate.
+  // Returns the raw lower bound value if this is a range or bloom filter
+  // predicate, or the equality value if this is an equality predicate.
   const void* raw_lower() const {
     return lower_;
   }
 
-  // Returns the raw upper bound if this is a range predicate.
+  // Returns the raw upper bound if this is a range or bloom filter predicate.
   const void* raw_upper() const {
     return upper_;
   }
@@ -234,6 +269,11 @@ class ColumnPredicate {
     return values_;
   }
 
+  // Returns the bloom filters if this is a bloom filter predicate.
+  const std::vector<BloomFilter>& bloom_filters() const {
+    return bloom_filters_;
+  }
+
  private:
 
   friend class TestColumnPredicate;
@@ -249,6 +289,13 @@ class ColumnPredicate {
                   ColumnSchema column,
                   std::vector<const void*>* values);
 
+  // Creates a new InBloomFilter column predicate.
+  ColumnPredicate(PredicateType predicate_type,
+                  ColumnSchema column,
+                  std::vector<BloomFilter>* bloom_filters,
+                  const void* lower,
+                  const void* upper);
+
   // Transition to a None predicate type.
   void SetToNone();
 
@@ -276,6 +323,13 @@ class ColumnPredicate {
   // Merge another predicate into this InList predicate.
   void MergeIntoInList(const ColumnPredicate& other);
 
+  // Merge another predicate into this InBloomFilter predicate.
+  void MergeIntoBloomFilter(const ColumnPredicate& other);
+
+  // Narrows the bounds of this Range or InBloomFilter predicate to their
+  // intersection with the bounds of another Range or InBloomFilter predicate.
+  void MergeBounds(const ColumnPredicate& other);
+
   // For a Range type predicate, this helper function checks
   // whether a given value is in the range.
   bool CheckValueInRange(const void* value) const;
@@ -284,21 +338,55 @@ class ColumnPredicate {
   // whether a given value is in the list.
   bool CheckValueInList(const void* value) const;
 
+  // For an InBloomFilter type predicate, this helper function checks
+  // whether a given value falls in the range and may be in every filter.
+  bool CheckValueInBloomFilter(const void* value) const;
+
+  // Evaluates this InBloomFilter predicate on a single cell. The bounds are
+  // checked first, so that only the values within them are hashed. The hash
+  // of a value is calculated once and shared by the probes of every filter.
+  template <DataType PhysicalType>
+  bool EvaluateBloomFilterCell(const void* cell) const {
+    if ((lower_ != nullptr && DataTypeTraits<PhysicalType>::Compare(cell, lower_) < 0) ||
+        (upper_ != nullptr && DataTypeTraits<PhysicalType>::Compare(cell, upper_) >= 0)) {
+      return false;
+    }
+    Slice key;
+    if (PhysicalType == BINARY) {
+      key = *reinterpret_cast<const Slice*>(cell);
+    } else {
+      key = Slice(reinterpret_cast<const uint8_t*>(cell),
+                  sizeof(typename DataTypeTraits<PhysicalType>::cpp_type));
+    }
+    BloomKeyProbe probe(key);
+    for (const BloomFilter& bloom_filter : bloom_filters_) {
+      if (!bloom_filter.MayContainKey(probe)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   // The type of this predicate.
   PredicateType predicate_type_;
 
   // The data type of the column. TypeInfo instances have a static lifetime.
   ColumnSchema column_;
 
-  // The inclusive lower bound value if this is a Range predicate, or the
-  // equality value if this is an Equality predicate.
+  // The inclusive lower bound value if this is a Range or InBloomFilter
+  // predicate, or the equality value if this is an Equality predicate.
   const void* lower_;
 
-  // The exclusive upper bound value if this is a Range predicate.
+  // The exclusive upper bound value if this is a Range or InBloomFilter
+  // predicate.
   const void* upper_;
 
   // The list of values to check column against if this is an InList predicate.
   std::vector<const void*> values_;
+
+  // The bloom filters to check column against if this is an InBloomFilter
+  // predicate.
+  std::vector<BloomFilter> bloom_filters_;
 };
 
 // Compares predicates according to selectivity. Predicates that match fewer
@@ -0,0 +1,276 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_COMMON_COLUMN_PREDICATE_KERNELS_INL_H
+#define KUDU_COMMON_COLUMN_PREDICATE_KERNELS_INL_H
+
+// The implementation of the kernels of column_predicate_kernels.h, shared by
+// the translation unit of each instruction set.
+//
+// Everything here is templated on the 'Ops' of an instruction set, which
+// wraps its intrinsics:
+//
+//   typedef ... T;           // the type of the values
+//   typedef ... Vec;         // a vector of kLanes values
+//   typedef ... Mask;        // the result of a comparison of two Vecs
+//   static constexpr int kLanes;
+//   static constexpr uint32_t kLaneMask;  // the low kLanes bits set
+//   static Vec Load(const T* values);  // unaligned
+//   static Vec Broadcast(T value);
+//   static Mask Lt(Vec a, Vec b);      // a < b
+//   static Mask Eq(Vec a, Vec b);      // !(a < b) && !(b < a)
+//   static Mask Or(Mask a, Mask b);
+//   static Mask AndNot(Mask a, Mask b);  // ~a & b
+//   static uint32_t MoveMask(Mask m);    // one bit per lane
+//
+// Since the translation units are compiled with different instruction sets,
+// this code must not call any non-template inline function shared with
+// other translation units (e.g. those of util/bitmap.h): the linker could
+// pick the copy compiled for AVX2 for every caller.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "kudu/common/column_predicate_kernels.h"
+
+namespace kudu {
+namespace predicate_kernels {
+namespace internal {
+
+// Evaluates 'pred' on 'nrows' values, clearing the bits of the rows which
+// don't match from 'sel'.
+//
+// 'pred' maps a vector of values to a bitmask of those which match, and
+// 'pred.Matches()' evaluates a single value, for the rows past the last full
+// word of 'sel'.
+template <class Ops, class Pred>
+inline void SelectWords(const typename Ops::T* values, size_t nrows, const Pred& pred,
+                        uint8_t* sel) {
+  static_assert(64 % Ops::kLanes == 0, "a word must hold a whole number of vectors");
+  size_t i = 0;
+  for (; i + 64 <= nrows; i += 64) {
+    uint8_t* sel_word_ptr = sel + i / 8;
+    uint64_t sel_word;
+    memcpy(&sel_word, sel_word_ptr, sizeof(sel_word));
+    if (sel_word == 0) continue;
+    uint64_t matches = 0;
+    for (int j = 0; j < 64; j += Ops::kLanes) {
+      matches |= static_cast<uint64_t>(pred(Ops::Load(values + i + j))) << j;
+    }
+    sel_word &= matches;
+    memcpy(sel_word_ptr, &sel_word, sizeof(sel_word));
+  }
+  for (; i < nrows; i++) {
+    uint8_t bit = 1 << (i & 7);
+    if ((sel[i >> 3] & bit) && !pred.Matches(values[i])) {
+      sel[i >> 3] &= ~bit;
+    }
+  }
+}
+
+// Matches values >= 'lower'. NaN compares as equal to everything in
+// DataTypeTraits::Compare(), so it's tested as !(v < lower).
+template <class Ops>
+class LowerBoundPred {
+ public:
+  typedef typename Ops::T T;
+  explicit LowerBoundPred(T lower)
+      : lower_(lower),
+        lower_vec_(Ops::Broadcast(lower)) {
+  }
+  uint32_t operator()(typename Ops::Vec v) const {
+    return ~Ops::MoveMask(Ops::Lt(v, lower_vec_)) & Ops::kLaneMask;
+  }
+  bool Matches(T v) const {
+    return !(v < lower_);
+  }
+ private:
+  const T lower_;
+  const typename Ops::Vec lower_vec_;
+};
+
+// Matches values < 'upper'.
+template <class Ops>
+class UpperBoundPred {
+ public:
+  typedef typename Ops::T T;
+  explicit UpperBoundPred(T upper)
+      : upper_(upper),
+        upper_vec_(Ops::Broadcast(upper)) {
+  }
+  uint32_t operator()(typename Ops::Vec v) const {
+    return Ops::MoveMask(Ops::Lt(v, upper_vec_));
+  }
+  bool Matches(T v) const {
+    return v < upper_;
+  }
+ private:
+  const T upper_;
+  const typename Ops::Vec upper_vec_;
+};
+
+// Matches values in ['lower', 'upper').
+template <class Ops>
+class RangePred {
+ public:
+  typedef typename Ops::T T;
+  RangePred(T lower, T upper)
+      : lower_(lower),
+        upper_(upper),
+        lower_vec_(Ops::Broadcast(lower)),
+        upper_vec_(Ops::Broadcast(upper)) {
+  }
+  uint32_t operator()(typename Ops::Vec v) const {
+    return Ops::MoveMask(Ops::AndNot(Ops::Lt(v, lower_vec_), Ops::Lt(v, upper_vec_)));
+  }
+  bool Matches(T v) const {
+    return !(v < lower_) && v < upper_;
+  }
+ private:
+  const T lower_;
+  const T upper_;
+  const typename Ops::Vec lower_vec_;
+  const typename Ops::Vec upper_vec_;
+};
+
+// Matches values equal to 'value'.
+template <class Ops>
+class EqualPred {
+ public:
+  typedef typename Ops::T T;
+  explicit EqualPred(T value)
+      : value_(value),
+        value_vec_(Ops::Broadcast(value)) {
+  }
+  uint32_t operator()(typename Ops::Vec v) const {
+    return Ops::MoveMask(Ops::Eq(v, value_vec_));
+  }
+  bool Matches(T v) const {
+    return !(v < value_) && !(value_ < v);
+  }
+ private:
+  const T value_;
+  const typename Ops::Vec value_vec_;
+};
+
+// Matches values equal to any of a short list of values.
+template <class Ops, size_t kMaxSize>
+class InListPred {
+ public:
+  typedef typename Ops::T T;
+  InListPred(const T* list, size_t list_size)
+      : list_(list),
+        list_size_(list_size) {
+    for (size_t i = 0; i < list_size; i++) {
+      list_vecs_[i] = Ops::Broadcast(list[i]);
+    }
+  }
+  uint32_t operator()(typename Ops::Vec v) const {
+    typename Ops::Mask m = Ops::Eq(v, list_vecs_[0]);
+    for (size_t i = 1; i < list_size_; i++) {
+      m = Ops::Or(m, Ops::Eq(v, list_vecs_[i]));
+    }
+    return Ops::MoveMask(m);
+  }
+  bool Matches(T v) const {
+    for (size_t i = 0; i < list_size_; i++) {
+      if (!(v < list_[i]) && !(list_[i] < v)) return true;
+    }
+    return false;
+  }
+ private:
+  const T* const list_;
+  const size_t list_size_;
+  typename Ops::Vec list_vecs_[kMaxSize];
+};
+
+template <class Ops>
+void SelectRangeImpl(const typename Ops::T* values, size_t nrows,
+                     const typename Ops::T* lower, const typename Ops::T* upper,
+                     uint8_t* sel) {
+  if (lower != nullptr && upper != nullptr) {
+    SelectWords<Ops>(values, nrows, RangePred<Ops>(*lower, *upper), sel);
+  } else if (lower != nullptr) {
+    SelectWords<Ops>(values, nrows, LowerBoundPred<Ops>(*lower), sel);
+  } else if (upper != nullptr) {
+    SelectWords<Ops>(values, nrows, UpperBoundPred<Ops>(*upper), sel);
+  }
+}
+
+template <class Ops>
+void SelectEqualImpl(const typename Ops::T* values, size_t nrows, typename Ops::T value,
+                     uint8_t* sel) {
+  SelectWords<Ops>(values, nrows, EqualPred<Ops>(value), sel);
+}
+
+template <class Ops, size_t kMaxSize>
+void SelectInListImpl(const typename Ops::T* values, size_t nrows,
+                      const typename Ops::T* list, size_t list_size, uint8_t* sel) {
+  if (list_size == 0) {
+    memset(sel, 0, (nrows + 7) / 8);
+    return;
+  }
+  SelectWords<Ops>(values, nrows, InListPred<Ops, kMaxSize>(list, list_size), sel);
+}
+
+// The kernels of each instruction set, wrapping the templates above.
+#define DECLARE_PREDICATE_KERNELS_FOR_ISA(isa)                                  \
+  namespace isa {                                                               \
+  template <typename T>                                                         \
+  void SelectRange(const T* values, size_t nrows, const T* lower, const T* upper, \
+                   uint8_t* sel);                                               \
+  template <typename T>                                                         \
+  void SelectEqual(const T* values, size_t nrows, T value, uint8_t* sel);       \
+  template <typename T>                                                         \
+  void SelectInList(const T* values, size_t nrows, const T* list, size_t list_size, \
+                    uint8_t* sel);                                              \
+  } // namespace isa
+
+DECLARE_PREDICATE_KERNELS_FOR_ISA(sse42)
+DECLARE_PREDICATE_KERNELS_FOR_ISA(avx2)
+
+#undef DECLARE_PREDICATE_KERNELS_FOR_ISA
+
+// Defines the kernels of an instruction set, in the current namespace, given
+// the template of its Ops.
+#define DEFINE_PREDICATE_KERNELS(ops)                                           \
+  template <typename T>                                                         \
+  void SelectRange(const T* values, size_t nrows, const T* lower, const T* upper, \
+                   uint8_t* sel) {                                              \
+    SelectRangeImpl<ops<T>>(values, nrows, lower, upper, sel);                  \
+  }                                                                             \
+  template <typename T>                                                         \
+  void SelectEqual(const T* values, size_t nrows, T value, uint8_t* sel) {      \
+    SelectEqualImpl<ops<T>>(values, nrows, value, sel);                         \
+  }                                                                             \
+  template <typename T>                                                         \
+  void SelectInList(const T* values, size_t nrows, const T* list, size_t list_size, \
+                    uint8_t* sel) {                                             \
+    SelectInListImpl<ops<T>, kMaxInListSize>(values, nrows, list, list_size, sel); \
+  }
+
+// Instantiates the kernels defined by DEFINE_PREDICATE_KERNELS for 'type'.
+#define INSTANTIATE_PREDICATE_KERNELS(type)                                     \
+  template void SelectRange<type>(const type*, size_t, const type*, const type*, uint8_t*); \
+  template void SelectEqual<type>(const type*, size_t, type, uint8_t*);         \
+  template void SelectInList<type>(const type*, size_t, const type*, size_t, uint8_t*)
+
+} // namespace internal
+} // namespace predicate_kernels
+} // namespace kudu
+
+#endif // KUDU_COMMON_COLUMN_PREDICATE_KERNELS_INL_H
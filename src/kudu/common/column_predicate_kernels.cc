@@ -0,0 +1,272 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/column_predicate_kernels.h"
+
+#include <nmmintrin.h>
+
+#include <cstring>
+
+#include "kudu/common/column_predicate_kernels-inl.h"
+#include "kudu/gutil/cpu.h"
+
+using base::CPU;
+
+namespace kudu {
+namespace predicate_kernels {
+
+namespace internal {
+namespace sse42 {
+
+// The SSE4.2 Ops of column_predicate_kernels-inl.h. SSE4.2 is required to
+// build Kudu, so these need no runtime check.
+template <typename T>
+struct Sse42Ops;
+
+struct Sse42IntOps {
+  typedef __m128i Vec;
+  typedef __m128i Mask;
+  static Vec Load(const void* values) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+  }
+  static Mask Or(Mask a, Mask b) { return _mm_or_si128(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm_andnot_si128(a, b); }
+};
+
+template <>
+struct Sse42Ops<int8_t> : public Sse42IntOps {
+  typedef int8_t T;
+  static constexpr int kLanes = 16;
+  static constexpr uint32_t kLaneMask = 0xffff;
+  static Vec Broadcast(T value) { return _mm_set1_epi8(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmpgt_epi8(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm_movemask_epi8(m); }
+};
+
+template <>
+struct Sse42Ops<int16_t> : public Sse42IntOps {
+  typedef int16_t T;
+  static constexpr int kLanes = 8;
+  static constexpr uint32_t kLaneMask = 0xff;
+  static Vec Broadcast(T value) { return _mm_set1_epi16(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmpgt_epi16(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+  static uint32_t MoveMask(Mask m) {
+    // Narrow each lane to a byte to get a single bit per lane.
+    return _mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128()));
+  }
+};
+
+template <>
+struct Sse42Ops<int32_t> : public Sse42IntOps {
+  typedef int32_t T;
+  static constexpr int kLanes = 4;
+  static constexpr uint32_t kLaneMask = 0xf;
+  static Vec Broadcast(T value) { return _mm_set1_epi32(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmpgt_epi32(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm_movemask_ps(_mm_castsi128_ps(m)); }
+};
+
+template <>
+struct Sse42Ops<int64_t> : public Sse42IntOps {
+  typedef int64_t T;
+  static constexpr int kLanes = 2;
+  static constexpr uint32_t kLaneMask = 0x3;
+  static Vec Broadcast(T value) { return _mm_set1_epi64x(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmpgt_epi64(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm_cmpeq_epi64(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm_movemask_pd(_mm_castsi128_pd(m)); }
+};
+
+// For floating point types, Eq() also matches NaN, which compares as equal
+// to everything in DataTypeTraits::Compare().
+template <>
+struct Sse42Ops<float> {
+  typedef float T;
+  typedef __m128 Vec;
+  typedef __m128 Mask;
+  static constexpr int kLanes = 4;
+  static constexpr uint32_t kLaneMask = 0xf;
+  static Vec Load(const T* values) { return _mm_loadu_ps(values); }
+  static Vec Broadcast(T value) { return _mm_set1_ps(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+  static Mask Eq(Vec a, Vec b) { return _mm_or_ps(_mm_cmpeq_ps(a, b), _mm_cmpunord_ps(a, b)); }
+  static Mask Or(Mask a, Mask b) { return _mm_or_ps(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm_andnot_ps(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm_movemask_ps(m); }
+};
+
+template <>
+struct Sse42Ops<double> {
+  typedef double T;
+  typedef __m128d Vec;
+  typedef __m128d Mask;
+  static constexpr int kLanes = 2;
+  static constexpr uint32_t kLaneMask = 0x3;
+  static Vec Load(const T* values) { return _mm_loadu_pd(values); }
+  static Vec Broadcast(T value) { return _mm_set1_pd(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm_cmplt_pd(a, b); }
+  static Mask Eq(Vec a, Vec b) { return _mm_or_pd(_mm_cmpeq_pd(a, b), _mm_cmpunord_pd(a, b)); }
+  static Mask Or(Mask a, Mask b) { return _mm_or_pd(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm_andnot_pd(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm_movemask_pd(m); }
+};
+
+DEFINE_PREDICATE_KERNELS(Sse42Ops)
+
+INSTANTIATE_PREDICATE_KERNELS(int8_t);
+INSTANTIATE_PREDICATE_KERNELS(int16_t);
+INSTANTIATE_PREDICATE_KERNELS(int32_t);
+INSTANTIATE_PREDICATE_KERNELS(int64_t);
+INSTANTIATE_PREDICATE_KERNELS(float);
+INSTANTIATE_PREDICATE_KERNELS(double);
+
+} // namespace sse42
+} // namespace internal
+
+// Function pointers which will be assigned the correct implementation
+// for the runtime architecture.
+namespace {
+
+template <typename T>
+struct Kernels {
+  decltype(&internal::sse42::SelectRange<T>) select_range;
+  decltype(&internal::sse42::SelectEqual<T>) select_equal;
+  decltype(&internal::sse42::SelectInList<T>) select_in_list;
+
+  void Select(bool use_avx2) {
+    if (use_avx2) {
+      select_range = internal::avx2::SelectRange<T>;
+      select_equal = internal::avx2::SelectEqual<T>;
+      select_in_list = internal::avx2::SelectInList<T>;
+    } else {
+      select_range = internal::sse42::SelectRange<T>;
+      select_equal = internal::sse42::SelectEqual<T>;
+      select_in_list = internal::sse42::SelectInList<T>;
+    }
+  }
+};
+
+struct AllKernels {
+  Kernels<int8_t> int8;
+  Kernels<int16_t> int16;
+  Kernels<int32_t> int32;
+  Kernels<int64_t> int64;
+  Kernels<float> float32;
+  Kernels<double> float64;
+  bool use_avx2;
+} g_kernels;
+
+template <typename T>
+const Kernels<T>& GetKernels();
+template <>
+const Kernels<int8_t>& GetKernels() { return g_kernels.int8; }
+template <>
+const Kernels<int16_t>& GetKernels() { return g_kernels.int16; }
+template <>
+const Kernels<int32_t>& GetKernels() { return g_kernels.int32; }
+template <>
+const Kernels<int64_t>& GetKernels() { return g_kernels.int64; }
+template <>
+const Kernels<float>& GetKernels() { return g_kernels.float32; }
+template <>
+const Kernels<double>& GetKernels() { return g_kernels.float64; }
+
+} // anonymous namespace
+
+// When this translation unit is initialized, figure out the current CPU and
+// assign the correct functions for this architecture.
+//
+// This avoids an expensive 'cpuid' call in the hot path, and also avoids
+// the cost of a 'std::once' call.
+__attribute__((constructor))
+void SelectPredicateKernels() {
+  g_kernels.use_avx2 = CPU().has_avx2();
+  g_kernels.int8.Select(g_kernels.use_avx2);
+  g_kernels.int16.Select(g_kernels.use_avx2);
+  g_kernels.int32.Select(g_kernels.use_avx2);
+  g_kernels.int64.Select(g_kernels.use_avx2);
+  g_kernels.float32.Select(g_kernels.use_avx2);
+  g_kernels.float64.Select(g_kernels.use_avx2);
+}
+
+template <typename T>
+void SelectRange(const T* values, size_t nrows, const T* lower, const T* upper, uint8_t* sel) {
+  GetKernels<T>().select_range(values, nrows, lower, upper, sel);
+}
+
+template <typename T>
+void SelectEqual(const T* values, size_t nrows, T value, uint8_t* sel) {
+  GetKernels<T>().select_equal(values, nrows, value, sel);
+}
+
+template <typename T>
+void SelectInList(const T* values, size_t nrows, const T* list, size_t list_size, uint8_t* sel) {
+  GetKernels<T>().select_in_list(values, nrows, list, list_size, sel);
+}
+
+INSTANTIATE_PREDICATE_KERNELS(int8_t);
+INSTANTIATE_PREDICATE_KERNELS(int16_t);
+INSTANTIATE_PREDICATE_KERNELS(int32_t);
+INSTANTIATE_PREDICATE_KERNELS(int64_t);
+INSTANTIATE_PREDICATE_KERNELS(float);
+INSTANTIATE_PREDICATE_KERNELS(double);
+
+void SelectNonNull(const uint8_t* non_null_bitmap, size_t nrows, uint8_t* sel) {
+  size_t i = 0;
+  for (; i + 64 <= nrows; i += 64) {
+    uint64_t sel_word;
+    uint64_t non_null_word;
+    memcpy(&sel_word, sel + i / 8, sizeof(sel_word));
+    memcpy(&non_null_word, non_null_bitmap + i / 8, sizeof(non_null_word));
+    sel_word &= non_null_word;
+    memcpy(sel + i / 8, &sel_word, sizeof(sel_word));
+  }
+  for (; i < nrows; i++) {
+    uint8_t bit = 1 << (i & 7);
+    if (!(non_null_bitmap[i >> 3] & bit)) {
+      sel[i >> 3] &= ~bit;
+    }
+  }
+}
+
+void SelectNull(const uint8_t* non_null_bitmap, size_t nrows, uint8_t* sel) {
+  size_t i = 0;
+  for (; i + 64 <= nrows; i += 64) {
+    uint64_t sel_word;
+    uint64_t non_null_word;
+    memcpy(&sel_word, sel + i / 8, sizeof(sel_word));
+    memcpy(&non_null_word, non_null_bitmap + i / 8, sizeof(non_null_word));
+    sel_word &= ~non_null_word;
+    memcpy(sel + i / 8, &sel_word, sizeof(sel_word));
+  }
+  for (; i < nrows; i++) {
+    uint8_t bit = 1 << (i & 7);
+    if (non_null_bitmap[i >> 3] & bit) {
+      sel[i >> 3] &= ~bit;
+    }
+  }
+}
+
+const char* InstructionSet() {
+  return g_kernels.use_avx2 ? "avx2" : "sse4.2";
+}
+
+} // namespace predicate_kernels
+} // namespace kudu
@@ -0,0 +1,75 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_COMMON_COLUMN_PREDICATE_KERNELS_H
+#define KUDU_COMMON_COLUMN_PREDICATE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized kernels evaluating column predicates over blocks of fixed-width
+// values. They do runtime dispatch to either AVX2 or SSE4.2 implementations
+// based on the available CPU.
+//
+// Each kernel clears the bits of the selection bitmap 'sel', which covers
+// 'nrows' rows, for the rows whose value doesn't match. Bits which are
+// already clear are left alone, and rows are processed 64 at a time so that
+// 'sel' is read and written a word at a time; groups of rows with no
+// selected row are skipped entirely.
+//
+// The kernels ignore NULLs: for a nullable column, the caller must first
+// clear the NULL rows with SelectNonNull(), after which the values of those
+// rows don't matter.
+//
+// The value kernels are instantiated for int8_t, int16_t, int32_t, int64_t,
+// float and double. Values are compared like DataTypeTraits::Compare() does,
+// so that the results are the same as those of the scalar path, including
+// for NaN.
+namespace kudu {
+namespace predicate_kernels {
+
+// The largest IN list evaluated by SelectInList(). Larger lists are better
+// served by a binary search.
+static constexpr size_t kMaxInListSize = 16;
+
+// Keeps the rows whose value is in [*lower, *upper). Either bound may be
+// null, in which case the range is unbounded on that side.
+template <typename T>
+void SelectRange(const T* values, size_t nrows, const T* lower, const T* upper, uint8_t* sel);
+
+// Keeps the rows whose value is equal to 'value'.
+template <typename T>
+void SelectEqual(const T* values, size_t nrows, T value, uint8_t* sel);
+
+// Keeps the rows whose value is one of the 'list_size' values of 'list'.
+// 'list_size' must be at most kMaxInListSize.
+template <typename T>
+void SelectInList(const T* values, size_t nrows, const T* list, size_t list_size, uint8_t* sel);
+
+// Keeps the rows which are set in 'non_null_bitmap', as found in a
+// ColumnBlock.
+void SelectNonNull(const uint8_t* non_null_bitmap, size_t nrows, uint8_t* sel);
+
+// Keeps the rows which are clear in 'non_null_bitmap'.
+void SelectNull(const uint8_t* non_null_bitmap, size_t nrows, uint8_t* sel);
+
+// Returns the name of the instruction set used by the kernels.
+const char* InstructionSet();
+
+} // namespace predicate_kernels
+} // namespace kudu
+
+#endif // KUDU_COMMON_COLUMN_PREDICATE_KERNELS_H
@@ -0,0 +1,141 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// The AVX2 kernels of column_predicate_kernels.h. This file is compiled with
+// -mavx2, and its kernels are only called after checking that the CPU
+// supports AVX2: see column_predicate_kernels.cc.
+
+#include <immintrin.h>
+
+#include <cstdint>
+
+#include "kudu/common/column_predicate_kernels-inl.h"
+
+namespace kudu {
+namespace predicate_kernels {
+namespace internal {
+namespace avx2 {
+
+template <typename T>
+struct Avx2Ops;
+
+struct Avx2IntOps {
+  typedef __m256i Vec;
+  typedef __m256i Mask;
+  static Vec Load(const void* values) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+  }
+  static Mask Or(Mask a, Mask b) { return _mm256_or_si256(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm256_andnot_si256(a, b); }
+};
+
+template <>
+struct Avx2Ops<int8_t> : public Avx2IntOps {
+  typedef int8_t T;
+  static constexpr int kLanes = 32;
+  static constexpr uint32_t kLaneMask = 0xffffffff;
+  static Vec Broadcast(T value) { return _mm256_set1_epi8(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmpgt_epi8(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm256_movemask_epi8(m); }
+};
+
+template <>
+struct Avx2Ops<int16_t> : public Avx2IntOps {
+  typedef int16_t T;
+  static constexpr int kLanes = 16;
+  static constexpr uint32_t kLaneMask = 0xffff;
+  static Vec Broadcast(T value) { return _mm256_set1_epi16(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmpgt_epi16(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmpeq_epi16(a, b); }
+  static uint32_t MoveMask(Mask m) {
+    // Narrow each lane to a byte. The packing works within each 128-bit half,
+    // so the two halves of the lanes are then moved next to each other.
+    __m256i packed = _mm256_packs_epi16(m, _mm256_setzero_si256());
+    return _mm256_movemask_epi8(_mm256_permute4x64_epi64(packed, 0xd8)) & kLaneMask;
+  }
+};
+
+template <>
+struct Avx2Ops<int32_t> : public Avx2IntOps {
+  typedef int32_t T;
+  static constexpr int kLanes = 8;
+  static constexpr uint32_t kLaneMask = 0xff;
+  static Vec Broadcast(T value) { return _mm256_set1_epi32(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmpgt_epi32(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmpeq_epi32(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+};
+
+template <>
+struct Avx2Ops<int64_t> : public Avx2IntOps {
+  typedef int64_t T;
+  static constexpr int kLanes = 4;
+  static constexpr uint32_t kLaneMask = 0xf;
+  static Vec Broadcast(T value) { return _mm256_set1_epi64x(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmpgt_epi64(b, a); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmpeq_epi64(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm256_movemask_pd(_mm256_castsi256_pd(m)); }
+};
+
+// For floating point types, Eq() also matches NaN, which compares as equal
+// to everything in DataTypeTraits::Compare().
+template <>
+struct Avx2Ops<float> {
+  typedef float T;
+  typedef __m256 Vec;
+  typedef __m256 Mask;
+  static constexpr int kLanes = 8;
+  static constexpr uint32_t kLaneMask = 0xff;
+  static Vec Load(const T* values) { return _mm256_loadu_ps(values); }
+  static Vec Broadcast(T value) { return _mm256_set1_ps(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_UQ); }
+  static Mask Or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm256_andnot_ps(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm256_movemask_ps(m); }
+};
+
+template <>
+struct Avx2Ops<double> {
+  typedef double T;
+  typedef __m256d Vec;
+  typedef __m256d Mask;
+  static constexpr int kLanes = 4;
+  static constexpr uint32_t kLaneMask = 0xf;
+  static Vec Load(const T* values) { return _mm256_loadu_pd(values); }
+  static Vec Broadcast(T value) { return _mm256_set1_pd(value); }
+  static Mask Lt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static Mask Eq(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_EQ_UQ); }
+  static Mask Or(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+  static Mask AndNot(Mask a, Mask b) { return _mm256_andnot_pd(a, b); }
+  static uint32_t MoveMask(Mask m) { return _mm256_movemask_pd(m); }
+};
+
+DEFINE_PREDICATE_KERNELS(Avx2Ops)
+
+INSTANTIATE_PREDICATE_KERNELS(int8_t);
+INSTANTIATE_PREDICATE_KERNELS(int16_t);
+INSTANTIATE_PREDICATE_KERNELS(int32_t);
+INSTANTIATE_PREDICATE_KERNELS(int64_t);
+INSTANTIATE_PREDICATE_KERNELS(float);
+INSTANTIATE_PREDICATE_KERNELS(double);
+
+} // namespace avx2
+} // namespace internal
+} // namespace predicate_kernels
+} // namespace kudu
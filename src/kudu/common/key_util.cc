@@ -232,6 +232,9 @@ int PushUpperBoundKeyPredicates(ColIdxIter first,
         pushed_predicates++;
         break;
       case PredicateType::Range:
+      case PredicateType::InBloomFilter:
+        // Values of an InBloomFilter predicate fall within its range, so its
+        // bounds can be pushed like those of a Range predicate.
         if (predicate->raw_upper() != nullptr) {
           memcpy(row->mutable_cell_ptr(*col_idx_it), predicate->raw_upper(), size);
           pushed_predicates++;
@@ -298,6 +301,7 @@ int PushLowerBoundKeyPredicates(ColIdxIter first,
 
     switch (predicate->predicate_type()) {
       case PredicateType::Range:
+      case PredicateType::InBloomFilter:
         if (predicate->raw_lower() == nullptr) {
           break_loop = true;
           break;
@@ -160,6 +160,10 @@ class SelectionVectorView {
     DCHECK_LE(nrows, sel_vec_->nrows() - row_offset_);
     BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_, nrows, false);
   }
+  void ClearBits(size_t row_idx, size_t nrows) {
+    DCHECK_LE(row_idx + nrows, sel_vec_->nrows() - row_offset_);
+    BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_ + row_idx, nrows, false);
+  }
  private:
   SelectionVector* sel_vec_;
   size_t row_offset_;
@@ -193,6 +193,10 @@ void ScanSpec::PushPredicatesIntoPrimaryKeyBounds(const Schema& schema,
         // InList predicates should not be removed as the full constraints imposed by an InList
         // cannot be translated into only a single set of lower and upper bound primary keys
         break;
+      } else if (type == PredicateType::InBloomFilter) {
+        // Likewise, only the range of an InBloomFilter predicate is captured
+        // by the primary key bounds.
+        break;
       } else {
         LOG(FATAL) << "Can not remove unknown predicate type";
       }
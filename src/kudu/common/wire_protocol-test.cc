@@ -32,6 +32,7 @@
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/memory/arena.h"
@@ -332,6 +333,103 @@ TEST_F(WireProtocolTest, TestColumnarRowBlockToPBWithPadding) {
   }
 }
 
+// Serialize row blocks in columnar layout and ensure that only the selected
+// rows of the projected columns are copied, across multiple blocks.
+TEST_F(WireProtocolTest, TestRowBlockToColumnarLayout) {
+  const int kNumRows = 10;
+  Arena arena(1024);
+  Schema tablet_schema({ ColumnSchema("key", INT64),
+                         ColumnSchema("col1", STRING, true /* nullable */),
+                         ColumnSchema("col2", INT32, true /* nullable */),
+                         ColumnSchema("col3", INT32) }, 1);
+  RowBlock block(tablet_schema, kNumRows, &arena);
+  block.selection_vector()->SetAllTrue();
+  for (int i = 0; i < block.nrows(); i++) {
+    RowBlockRow row = block.row(i);
+    *reinterpret_cast<int64_t*>(row.mutable_cell_ptr(0)) = i;
+    Slice col1;
+    CHECK(test_data_arena_.RelocateSlice(Slice(string(i, 'x')), &col1));
+    *reinterpret_cast<Slice*>(row.mutable_cell_ptr(1)) = col1;
+    row.cell(1).set_null(i % 3 == 0);
+    *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(2)) = i * 10;
+    row.cell(2).set_null(i % 2 == 0);
+    *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(3)) = i * 100;
+  }
+  // Deselect the odd rows.
+  for (int i = 1; i < kNumRows; i += 2) {
+    block.selection_vector()->SetRowUnselected(i);
+  }
+
+  // Project a subset of the columns, in a different order.
+  Schema proj_schema({ ColumnSchema("col2", INT32, true /* nullable */),
+                       ColumnSchema("key", INT64),
+                       ColumnSchema("col1", STRING, true /* nullable */) }, 0);
+
+  // Serialize the same block twice to exercise appending.
+  ColumnarSerializedBatch batch;
+  SerializeRowBlockColumnar(block, &proj_schema, &batch);
+  SerializeRowBlockColumnar(block, &proj_schema, &batch);
+  const int kNumSelected = kNumRows / 2;
+  ASSERT_EQ(2 * kNumSelected, batch.num_rows);
+  ASSERT_EQ(3, batch.columns.size());
+
+  // 'col2': every selected (even) row is NULL.
+  const auto& col2 = batch.columns[0];
+  ASSERT_EQ(2 * kNumSelected * sizeof(int32_t), col2.data->size());
+  ASSERT_FALSE(col2.varlen_data);
+  ASSERT_TRUE(col2.non_null_bitmap);
+  ASSERT_EQ(BitmapSize(2 * kNumSelected), col2.non_null_bitmap->size());
+  for (int i = 0; i < 2 * kNumSelected; i++) {
+    EXPECT_FALSE(BitmapTest(col2.non_null_bitmap->data(), i));
+    EXPECT_EQ(0, reinterpret_cast<const int32_t*>(col2.data->data())[i]);
+  }
+
+  // 'key': the selected keys, non-nullable.
+  const auto& key = batch.columns[1];
+  ASSERT_EQ(2 * kNumSelected * sizeof(int64_t), key.data->size());
+  ASSERT_FALSE(key.varlen_data);
+  ASSERT_FALSE(key.non_null_bitmap);
+  for (int i = 0; i < 2 * kNumSelected; i++) {
+    EXPECT_EQ((i % kNumSelected) * 2, reinterpret_cast<const int64_t*>(key.data->data())[i]);
+  }
+
+  // 'col1': offsets into the varlen data.
+  const auto& col1 = batch.columns[2];
+  ASSERT_TRUE(col1.varlen_data);
+  ASSERT_TRUE(col1.non_null_bitmap);
+  ASSERT_EQ((2 * kNumSelected + 1) * sizeof(uint32_t), col1.data->size());
+  const uint32_t* offsets = reinterpret_cast<const uint32_t*>(col1.data->data());
+  EXPECT_EQ(0, offsets[0]);
+  for (int i = 0; i < 2 * kNumSelected; i++) {
+    int src_row = (i % kNumSelected) * 2;
+    bool is_null = src_row % 3 == 0;
+    EXPECT_EQ(!is_null, BitmapTest(col1.non_null_bitmap->data(), i));
+    Slice val(col1.varlen_data->data() + offsets[i], offsets[i + 1] - offsets[i]);
+    EXPECT_EQ(is_null ? "" : string(src_row, 'x'), val.ToString());
+  }
+}
+
+// An empty batch still carries the projection's columns.
+TEST_F(WireProtocolTest, TestEmptyColumnarBatch) {
+  Schema proj_schema({ ColumnSchema("key", INT64),
+                       ColumnSchema("col1", STRING, true /* nullable */) }, 1);
+  ColumnarSerializedBatch batch;
+  InitColumnarSerializedBatch(proj_schema, &batch);
+  ASSERT_EQ(0, batch.num_rows);
+  ASSERT_EQ(2, batch.columns.size());
+
+  const auto& key = batch.columns[0];
+  ASSERT_EQ(0, key.data->size());
+  ASSERT_FALSE(key.varlen_data);
+  ASSERT_FALSE(key.non_null_bitmap);
+
+  // A BINARY column holds the single leading offset.
+  const auto& col1 = batch.columns[1];
+  ASSERT_EQ(sizeof(uint32_t), col1.data->size());
+  ASSERT_EQ(0, col1.varlen_data->size());
+  ASSERT_EQ(0, col1.non_null_bitmap->size());
+}
+
 #ifdef NDEBUG
 TEST_F(WireProtocolTest, TestColumnarRowBlockToPBBenchmark) {
   Arena arena(1024);
@@ -499,4 +597,59 @@ TEST_F(WireProtocolTest, TestColumnPredicateInList) {
     ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
   }
 }
+
+TEST_F(WireProtocolTest, TestColumnPredicateInBloomFilter) {
+  ColumnSchema col1("col1", INT32);
+  vector<ColumnSchema> cols = { col1 };
+  Schema schema(cols, 1);
+  Arena arena(1024);
+  boost::optional<ColumnPredicate> predicate;
+
+  BloomFilterBuilder builder(BloomFilterSizing::ByCountAndFPRate(10, 0.01));
+  for (int32_t i = 0; i < 10; i++) {
+    builder.AddKey(BloomKeyProbe(Slice(reinterpret_cast<const uint8_t*>(&i), sizeof(i))));
+  }
+
+  { // col1 IN BLOOM FILTER AND col1 >= 5
+    int five = 5;
+    vector<BloomFilter> bloom_filters = { BloomFilter(builder.slice(), builder.n_hashes()) };
+    ColumnPredicate cp = ColumnPredicate::InBloomFilter(col1, &bloom_filters, &five, nullptr);
+    ColumnPredicatePB pb;
+    ASSERT_NO_FATAL_FAILURE(ColumnPredicateToPB(cp, &pb));
+    ASSERT_EQ(1, pb.in_bloom_filter().bloom_filters_size());
+    ASSERT_FALSE(pb.in_bloom_filter().has_upper());
+
+    ASSERT_OK(ColumnPredicateFromPB(schema, &arena, pb, &predicate));
+    ASSERT_EQ(PredicateType::InBloomFilter, predicate->predicate_type());
+    ASSERT_EQ(cp, *predicate);
+    // The bloom filter data must have been copied out of the protobuf.
+    ASSERT_NE(pb.in_bloom_filter().bloom_filters(0).data().data(),
+              reinterpret_cast<const char*>(predicate->bloom_filters()[0].slice().data()));
+  }
+
+  { // No bloom filters.
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    pb.mutable_in_bloom_filter();
+    ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
+  }
+
+  { // Empty bloom filter.
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    pb.mutable_in_bloom_filter()->add_bloom_filters()->set_n_hashes(2);
+    ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
+  }
+
+  { // Too many hashes.
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    auto* bloom_filter_pb = pb.mutable_in_bloom_filter()->add_bloom_filters();
+    bloom_filter_pb->set_data(builder.slice().ToString());
+    bloom_filter_pb->set_n_hashes(1000000);
+    Status s = ColumnPredicateFromPB(schema, &arena, pb, &predicate);
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "hashes");
+  }
+}
 } // namespace kudu
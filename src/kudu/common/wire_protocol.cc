@@ -40,6 +40,7 @@
 #include "kudu/gutil/strings/fastmem.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/memory/arena.h"
@@ -409,6 +410,15 @@ void CopyPredicateBoundToPB(const ColumnSchema& col, const void* bound_src, stri
   bound_dst->assign(reinterpret_cast<const char*>(src), size);
 }
 
+// The maximum number of hashes of a bloom filter predicate. Optimally-sized
+// filters use far fewer (7 for a 1% false positive rate), and every hash is
+// computed for every cell evaluated against the filter.
+const int kMaxBloomFilterHashes = 32;
+
+// The maximum size of a bloom filter predicate's bitmap. BloomFilter picks
+// bits with 32-bit hashes, so larger bitmaps could never be fully probed.
+const size_t kMaxBloomFilterBytes = (1ULL << 32) / 8;
+
 // Extract a void* pointer suitable for use in a ColumnRangePredicate from the
 // string protobuf bound. This validates that the pb_value has the correct
 // length, copies the data into 'arena', and sets *result to point to it.
@@ -480,6 +490,25 @@ void ColumnPredicateToPB(const ColumnPredicate& predicate,
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      auto* bloom_filter_pred = pb->mutable_in_bloom_filter();
+      for (const BloomFilter& bloom_filter : predicate.bloom_filters()) {
+        auto* bloom_filter_pb = bloom_filter_pred->add_bloom_filters();
+        bloom_filter_pb->set_data(bloom_filter.slice().ToString());
+        bloom_filter_pb->set_n_hashes(bloom_filter.n_hashes());
+      }
+      if (predicate.raw_lower() != nullptr) {
+        CopyPredicateBoundToPB(predicate.column(),
+                               predicate.raw_lower(),
+                               bloom_filter_pred->mutable_lower());
+      }
+      if (predicate.raw_upper() != nullptr) {
+        CopyPredicateBoundToPB(predicate.column(),
+                               predicate.raw_upper(),
+                               bloom_filter_pred->mutable_upper());
+      }
+      return;
+    };
     case PredicateType::None: LOG(FATAL) << "None predicate may not be converted to protobuf";
   }
   LOG(FATAL) << "unknown predicate type";
@@ -541,6 +570,49 @@ Status ColumnPredicateFromPB(const Schema& schema,
       *predicate = ColumnPredicate::InList(col, &values);
       break;
     };
+    case ColumnPredicatePB::kInBloomFilter: {
+      const auto& in_bloom_filter = pb.in_bloom_filter();
+      if (in_bloom_filter.bloom_filters_size() == 0) {
+        return Status::InvalidArgument("Invalid bloom filter predicate on column: no bloom filters",
+                                       col.name());
+      }
+      vector<BloomFilter> bloom_filters;
+      for (const auto& bloom_filter_pb : in_bloom_filter.bloom_filters()) {
+        const string& data = bloom_filter_pb.data();
+        if (data.empty() || bloom_filter_pb.n_hashes() <= 0) {
+          return Status::InvalidArgument("Invalid bloom filter predicate on column: empty filter",
+                                         col.name());
+        }
+        if (bloom_filter_pb.n_hashes() > kMaxBloomFilterHashes) {
+          return Status::InvalidArgument(
+              strings::Substitute("Invalid bloom filter predicate on column: $0 hashes, "
+                                  "at most $1 are allowed",
+                                  bloom_filter_pb.n_hashes(), kMaxBloomFilterHashes),
+              col.name());
+        }
+        if (data.size() > kMaxBloomFilterBytes) {
+          return Status::InvalidArgument(
+              strings::Substitute("Invalid bloom filter predicate on column: $0 byte filter, "
+                                  "at most $1 bytes are allowed",
+                                  data.size(), kMaxBloomFilterBytes),
+              col.name());
+        }
+        // Copy the bitmap into the arena, since the predicate does not own it.
+        uint8_t* data_copy = static_cast<uint8_t*>(arena->AllocateBytes(data.size()));
+        memcpy(data_copy, data.data(), data.size());
+        bloom_filters.emplace_back(Slice(data_copy, data.size()), bloom_filter_pb.n_hashes());
+      }
+      const void* lower = nullptr;
+      const void* upper = nullptr;
+      if (in_bloom_filter.has_lower()) {
+        RETURN_NOT_OK(CopyPredicateBoundFromPB(col, in_bloom_filter.lower(), arena, &lower));
+      }
+      if (in_bloom_filter.has_upper()) {
+        RETURN_NOT_OK(CopyPredicateBoundFromPB(col, in_bloom_filter.upper(), arena, &upper));
+      }
+      *predicate = ColumnPredicate::InBloomFilter(col, &bloom_filters, lower, upper);
+      break;
+    };
     case ColumnPredicatePB::kIsNotNull: {
       *predicate = ColumnPredicate::IsNotNull(col);
       break;
@@ -873,4 +945,124 @@ void SerializeRowBlock(const RowBlock& block,
   rowblock_pb->set_num_rows(rowblock_pb->num_rows() + num_rows);
 }
 
+// Copy the selected cells of a column from the given RowBlock into the
+// columnar output 'dst', appending them after the 'dst_row_offset' rows
+// which are already present.
+//
+// IS_NULLABLE and IS_VARLEN have the same meaning as for CopyColumn().
+template<bool IS_NULLABLE, bool IS_VARLEN>
+static void CopyColumnColumnar(const RowBlock& block, int col_idx, int64_t dst_row_offset,
+                               ColumnarSerializedBatch::Column* dst) {
+  ColumnBlock column_block = block.column_block(col_idx);
+  size_t cell_size = column_block.stride();
+
+  BitmapIterator selected_row_iter(block.selection_vector()->bitmap(), block.nrows());
+  int run_size;
+  bool selected;
+  int row_idx = 0;
+  int64_t dst_row_idx = dst_row_offset;
+  while ((run_size = selected_row_iter.Next(&selected))) {
+    if (!selected) {
+      row_idx += run_size;
+      continue;
+    }
+    size_t run_start_offset = dst->data->size();
+    if (!IS_VARLEN) {
+      // Fixed-width cells are stored densely in both the ColumnBlock and the
+      // output, so a whole run of selected cells can be copied at once.
+      dst->data->append(column_block.cell_ptr(row_idx), run_size * cell_size);
+    }
+    for (int i = 0; i < run_size; i++) {
+      bool is_null = IS_NULLABLE && column_block.is_null(row_idx);
+      if (IS_NULLABLE) {
+        BitmapChange(dst->non_null_bitmap->data(), dst_row_idx, !is_null);
+      }
+      if (IS_VARLEN) {
+        if (!is_null) {
+          const Slice* slice = reinterpret_cast<const Slice*>(column_block.cell_ptr(row_idx));
+          dst->varlen_data->append(slice->data(), slice->size());
+        }
+        uint32_t end_offset = dst->varlen_data->size();
+        dst->data->append(&end_offset, sizeof(end_offset));
+      } else if (is_null) {
+        // Don't leak whatever the ColumnBlock held for NULL cells to the client.
+        memset(dst->data->data() + run_start_offset + i * cell_size, 0, cell_size);
+      }
+      row_idx++;
+      dst_row_idx++;
+    }
+  }
+}
+
+void InitColumnarSerializedBatch(const Schema& projection_schema,
+                                 ColumnarSerializedBatch* batch) {
+  if (!batch->columns.empty()) {
+    DCHECK_EQ(batch->columns.size(), projection_schema.num_columns());
+    return;
+  }
+  batch->columns.resize(projection_schema.num_columns());
+  for (int i = 0; i < projection_schema.num_columns(); i++) {
+    const ColumnSchema& col = projection_schema.column(i);
+    ColumnarSerializedBatch::Column* dst = &batch->columns[i];
+    dst->data.reset(new faststring());
+    if (col.type_info()->physical_type() == BINARY) {
+      dst->varlen_data.reset(new faststring());
+      uint32_t start_offset = 0;
+      dst->data->append(&start_offset, sizeof(start_offset));
+    }
+    if (col.is_nullable()) {
+      dst->non_null_bitmap.reset(new faststring());
+    }
+  }
+}
+
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* projection_schema,
+                               ColumnarSerializedBatch* batch) {
+  DCHECK_GT(block.nrows(), 0);
+  const Schema& tablet_schema = block.schema();
+
+  if (projection_schema == nullptr) {
+    projection_schema = &tablet_schema;
+  }
+
+  // Set up the output buffers the first time a block is serialized.
+  InitColumnarSerializedBatch(*projection_schema, batch);
+  DCHECK_EQ(batch->columns.size(), projection_schema->num_columns());
+
+  size_t num_rows = block.selection_vector()->CountSelected();
+  int64_t old_num_rows = batch->num_rows;
+  size_t old_bitmap_size = BitmapSize(old_num_rows);
+  size_t new_bitmap_size = BitmapSize(old_num_rows + num_rows);
+
+  for (int p_schema_idx = 0; p_schema_idx < projection_schema->num_columns(); p_schema_idx++) {
+    const ColumnSchema& col = projection_schema->column(p_schema_idx);
+    int t_schema_idx = tablet_schema.find_column(col.name());
+    DCHECK_NE(t_schema_idx, -1);
+    ColumnarSerializedBatch::Column* dst = &batch->columns[p_schema_idx];
+
+    if (col.is_nullable()) {
+      // Zero the newly added bitmap bytes so that the trailing bits of the
+      // last byte are deterministic.
+      dst->non_null_bitmap->resize(new_bitmap_size);
+      if (new_bitmap_size > old_bitmap_size) {
+        memset(dst->non_null_bitmap->data() + old_bitmap_size, 0,
+               new_bitmap_size - old_bitmap_size);
+      }
+    }
+
+    bool is_varlen = col.type_info()->physical_type() == BINARY;
+    if (col.is_nullable() && is_varlen) {
+      CopyColumnColumnar<true, true>(block, t_schema_idx, old_num_rows, dst);
+    } else if (col.is_nullable() && !is_varlen) {
+      CopyColumnColumnar<true, false>(block, t_schema_idx, old_num_rows, dst);
+    } else if (!col.is_nullable() && is_varlen) {
+      CopyColumnColumnar<false, true>(block, t_schema_idx, old_num_rows, dst);
+    } else {
+      CopyColumnColumnar<false, false>(block, t_schema_idx, old_num_rows, dst);
+    }
+  }
+  batch->num_rows += num_rows;
+}
+
 } // namespace kudu
@@ -20,8 +20,10 @@
 #define KUDU_COMMON_WIRE_PROTOCOL_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "kudu/util/faststring.h"
 #include "kudu/util/status.h"
 
 namespace boost {
@@ -40,7 +42,6 @@ namespace kudu {
 class Arena;
 class ColumnPredicate;
 class ColumnSchema;
-class faststring;
 class HostPort;
 class RowBlock;
 class Schema;
@@ -154,6 +155,49 @@ void SerializeRowBlock(const RowBlock& block, RowwiseRowBlockPB* rowblock_pb,
                        faststring* data_buf, faststring* indirect_data,
                        bool pad_unixtime_micros_to_16_bytes = false);
 
+// Scan results serialized in columnar layout, accumulated over one or more
+// calls to SerializeRowBlockColumnar(). See ColumnarRowBlockPB for the format
+// of each buffer.
+struct ColumnarSerializedBatch {
+  struct Column {
+    // Dense cell data, or uint32 offsets into 'varlen_data' for BINARY columns.
+    std::unique_ptr<faststring> data;
+
+    // Variable-length cell data. Only set for BINARY columns.
+    std::unique_ptr<faststring> varlen_data;
+
+    // Bitmap with a set bit for each non-null cell. Only set for nullable columns.
+    std::unique_ptr<faststring> non_null_bitmap;
+  };
+
+  // One entry per column of the projection schema.
+  std::vector<Column> columns;
+
+  // The total number of rows serialized so far.
+  int64_t num_rows = 0;
+};
+
+// Set up one empty column in 'batch' for each column of 'projection_schema',
+// so that a response carries the projection's columns even if no rows are
+// serialized into it. Does nothing if 'batch' already has its columns.
+void InitColumnarSerializedBatch(const Schema& projection_schema,
+                                 ColumnarSerializedBatch* batch);
+
+// Encode the given row block into 'batch' in columnar layout.
+//
+// As with SerializeRowBlock(), only the rows whose selection vector entry is
+// true are copied, and only the columns of 'projection_schema' (or of the
+// block's schema, if NULL) are copied. Fixed-width cells are copied straight
+// out of the block's ColumnBlocks, a selected run at a time.
+//
+// The cells are appended to any data already present in 'batch', so a single
+// batch may be built from several row blocks.
+//
+// Requires that block.nrows() > 0
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* projection_schema,
+                               ColumnarSerializedBatch* batch);
+
 // Rewrites the data pointed-to by row data slice 'row_data_slice' by replacing
 // relative indirect data pointers with absolute ones in 'indirect_data_slice'.
 // At the time of this writing, this rewriting is only done for STRING types.
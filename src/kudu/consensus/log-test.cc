@@ -24,6 +24,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -41,6 +42,7 @@
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/log_index.h"
 #include "kudu/consensus/log_reader.h"
+#include "kudu/consensus/log_syncer.h"
 #include "kudu/consensus/log_util.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
@@ -68,6 +70,9 @@ DECLARE_double(log_inject_io_error_on_preallocate_fraction);
 DECLARE_int64(fs_wal_dir_reserved_bytes);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
 DECLARE_string(log_compression_codec);
+DECLARE_bool(log_group_commit_across_tablets);
+DECLARE_double(env_inject_eio);
+DECLARE_string(env_inject_eio_globs);
 
 namespace kudu {
 namespace log {
@@ -1140,6 +1145,105 @@ TEST_F(LogTest, TestAutoStopIdleAppendThread) {
     });
 }
 
+TEST_F(LogTest, TestSyncReportsWritebackErrors) {
+  ASSERT_FALSE(LogSyncer::SyncReportsWritebackErrors("2.6.32-754.el6.x86_64"));
+  ASSERT_FALSE(LogSyncer::SyncReportsWritebackErrors("4.18.0-348.el8.x86_64"));
+  ASSERT_FALSE(LogSyncer::SyncReportsWritebackErrors("5.4.0-1045-aws"));
+  ASSERT_TRUE(LogSyncer::SyncReportsWritebackErrors("5.8.0"));
+  ASSERT_TRUE(LogSyncer::SyncReportsWritebackErrors("5.10.0-21-amd64"));
+  ASSERT_TRUE(LogSyncer::SyncReportsWritebackErrors("6.1.0"));
+}
+
+// Test that, with --log_group_commit_across_tablets, the logs of different
+// tablets are synced together through the syncer of their WAL root.
+TEST_F(LogTest, TestGroupCommitAcrossTablets) {
+#if defined(__APPLE__)
+  LOG(INFO) << "Filesystem syncs are not supported on macOS; skipping";
+  return;
+#endif
+  if (!LogSyncer::SyncReportsWritebackErrors(env_->GetKernelRelease())) {
+    LOG(INFO) << "Filesystem syncs don't report writeback errors on this kernel; skipping";
+    return;
+  }
+  FLAGS_log_group_commit_across_tablets = true;
+  options_.force_fsync_all = true;
+  ASSERT_OK(BuildLog());
+  scoped_refptr<Log> other_log;
+  ASSERT_OK(Log::Open(options_,
+                      fs_manager_.get(),
+                      "other-tablet",
+                      SchemaBuilder(schema_).Build(),
+                      0, // schema_version
+                      metric_entity_.get(),
+                      &other_log));
+  shared_ptr<LogSyncer> syncer = log_->syncer_for_tests();
+  ASSERT_TRUE(syncer);
+  ASSERT_EQ(syncer.get(), other_log->syncer_for_tests().get());
+  shared_ptr<LogSyncer> root_syncer;
+  ASSERT_OK(LogSyncer::Get(env_, fs_manager_->GetWalsRootDir(), &root_syncer));
+  ASSERT_EQ(syncer.get(), root_syncer.get());
+
+  // Append to both logs at once. Each group commit of either log needs a
+  // sync, but some of them may share one.
+  const int kNumOps = 100;
+  int64_t syncs_before = syncer->num_syncs();
+  vector<std::thread> threads;
+  for (Log* log : { log_.get(), other_log.get() }) {
+    threads.emplace_back([&, log]() {
+        OpId opid = MakeOpId(1, 1);
+        for (int i = 0; i < kNumOps; i++) {
+          CHECK_OK(AppendNoOpToLogSync(clock_, log, &opid));
+        }
+      });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  int64_t num_syncs = syncer->num_syncs() - syncs_before;
+  LOG(INFO) << "Synced " << 2 * kNumOps << " appends with " << num_syncs << " syncs";
+  ASSERT_GT(num_syncs, 0);
+  ASSERT_LE(num_syncs, 2 * kNumOps);
+
+  // Both logs can be read back as usual.
+  ASSERT_OK(log_->Close());
+  ASSERT_OK(other_log->Close());
+  SegmentSequence segments;
+  ASSERT_OK(other_log->reader()->GetSegmentsSnapshot(&segments));
+  ASSERT_EQ(1, segments.size());
+  LogEntries entries;
+  ASSERT_OK(segments[0]->ReadEntries(&entries));
+  ASSERT_EQ(kNumOps, entries.size());
+}
+
+// Test that, with --log_group_commit_across_tablets, a batch whose segment
+// fails to be written back between its append and its sync is not reported
+// as durable.
+TEST_F(LogTest, TestGroupCommitReportsWritebackFailure) {
+#if defined(__APPLE__)
+  LOG(INFO) << "Filesystem syncs are not supported on macOS; skipping";
+  return;
+#endif
+  if (!LogSyncer::SyncReportsWritebackErrors(env_->GetKernelRelease())) {
+    LOG(INFO) << "Filesystem syncs don't report writeback errors on this kernel; skipping";
+    return;
+  }
+  FLAGS_log_group_commit_across_tablets = true;
+  options_.force_fsync_all = true;
+  ASSERT_OK(BuildLog());
+  ASSERT_TRUE(log_->syncer_for_tests());
+  OpId opid = MakeOpId(1, 1);
+  ASSERT_OK(AppendNoOpToLogSync(clock_, log_.get(), &opid));
+
+  // A failed write-back of a segment makes the next sync of the filesystem
+  // of the WAL root fail with EIO. Inject just that: the writes to the
+  // segment itself go through.
+  FLAGS_env_inject_eio_globs = fs_manager_->GetWalsRootDir();
+  FLAGS_env_inject_eio = 1.0;
+  Status s = AppendNoOpToLogSync(clock_, log_.get(), &opid);
+  FLAGS_env_inject_eio = 0;
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+}
+
 // Test that Log::TotalSize() captures creation, addition, and deletion of log segments.
 TEST_P(LogTestOptionalCompression, TestTotalSize) {
   // Build a log. There is an active segment, so on-disk size should be positive.
@@ -31,6 +31,7 @@
 #include "kudu/consensus/log_index.h"
 #include "kudu/consensus/log_metrics.h"
 #include "kudu/consensus/log_reader.h"
+#include "kudu/consensus/log_syncer.h"
 #include "kudu/consensus/log_util.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/atomicops.h"
@@ -93,6 +94,18 @@ TAG_FLAG(log_thread_idle_threshold_ms, hidden);
 
 // Compression configuration.
 // -----------------------------
+DEFINE_bool(log_group_commit_across_tablets, false,
+            "Whether the WALs of all the tablets of a server should be made durable "
+            "together, with a single sync of the filesystem of the WAL root, rather than "
+            "with an fsync of each tablet's active segment. This greatly reduces the "
+            "number of flushes of the WAL disk when many tablets do small writes and "
+            "--log_force_fsync_all is set, but also writes back any other data of the "
+            "filesystem, so it should only be used when the WAL root is on a filesystem "
+            "of its own. Only takes effect on Linux 5.8 or later: the filesystem syncs of "
+            "earlier kernels don't report errors writing back the data of files, so the "
+            "WAL segments are fsynced one by one there.");
+TAG_FLAG(log_group_commit_across_tablets, experimental);
+
 DEFINE_string(log_compression_codec, "LZ4",
               "Codec to use for compressing WAL segments.");
 TAG_FLAG(log_compression_codec, experimental);
@@ -519,6 +532,27 @@ Status Log::Init() {
     active_segment_sequence_number_ = segments.back()->header().sequence_number();
   }
 
+  if (force_sync_all_ && FLAGS_log_group_commit_across_tablets) {
+    Env* env = fs_manager_->env();
+    const string kernel_release = env->GetKernelRelease();
+    if (!LogSyncer::SyncReportsWritebackErrors(kernel_release)) {
+      KLOG_FIRST_N(WARNING, 1) << LogPrefix() << "Cannot sync the WALs of all tablets together: "
+                               << "filesystem syncs don't report writeback errors on kernel "
+                               << kernel_release;
+    } else {
+      // The syncer must be held before the first segment is written to, so
+      // that its syncs report the failures to write the segment back.
+      Status s = LogSyncer::Get(env, fs_manager_->GetWalsRootDir(), &syncer_);
+      if (s.IsNotSupported()) {
+        KLOG_FIRST_N(WARNING, 1) << LogPrefix()
+                                 << "Cannot sync the WALs of all tablets together: "
+                                 << s.ToString();
+      } else {
+        RETURN_NOT_OK_PREPEND(s, "could not open the filesystem of the WAL root");
+      }
+    }
+  }
+
   if (force_sync_all_) {
     KLOG_FIRST_N(INFO, 1) << LogPrefix() << "Log is configured to fsync() on all Append() calls";
   } else {
@@ -746,7 +780,11 @@ Status Log::Sync() {
 
   if (force_sync_all_ && !sync_disabled_) {
     LOG_SLOW_EXECUTION(WARNING, 50, Substitute("$0Fsync log took a long time", LogPrefix())) {
-      RETURN_NOT_OK(active_segment_->Sync());
+      if (syncer_) {
+        RETURN_NOT_OK(syncer_->Sync());
+      } else {
+        RETURN_NOT_OK(active_segment_->Sync());
+      }
 
       if (log_hooks_) {
         RETURN_NOT_OK_PREPEND(log_hooks_->PostSyncIfFsyncEnabled(),
@@ -66,6 +66,7 @@ struct RetentionIndexes;
 class LogEntryBatch;
 class LogIndex;
 class LogReader;
+class LogSyncer;
 
 typedef BlockingQueue<LogEntryBatch*, LogEntryBatchLogicalSize> LogEntryBatchQueue;
 
@@ -232,6 +233,12 @@ class Log : public RefCountedThreadSafe<Log> {
   // Returns this Log's FsManager.
   FsManager* GetFsManager();
 
+  // Returns the syncer shared with the other logs of the WAL root, or null if
+  // this Log syncs its own segments.
+  const std::shared_ptr<LogSyncer>& syncer_for_tests() const {
+    return syncer_;
+  }
+
   void SetLogFaultHooksForTests(const std::shared_ptr<LogFaultHooks> &hooks) {
     log_hooks_ = hooks;
   }
@@ -398,6 +405,11 @@ class Log : public RefCountedThreadSafe<Log> {
   // This is used to disable fsync during bootstrap.
   bool sync_disabled_;
 
+  // If set, Sync() makes the active segment durable through this syncer,
+  // together with the segments of the other logs of the WAL root, rather
+  // than with an fsync of its own. See --log_group_commit_across_tablets.
+  std::shared_ptr<LogSyncer> syncer_;
+
   // The status of the most recent log-allocation action.
   Promise<Status> allocation_status_;
 
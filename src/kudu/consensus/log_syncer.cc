@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/log_syncer.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/util/debug/trace_event.h"
+#include "kudu/util/env.h"
+#include "kudu/util/locks.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::weak_ptr;
+
+namespace kudu {
+namespace log {
+
+Status LogSyncer::Get(Env* env, const string& wal_root, shared_ptr<LogSyncer>* syncer) {
+  // The syncers are only kept alive by their logs, so that a WAL root which
+  // is no longer in use doesn't keep its syncer around.
+  static simple_spinlock lock;
+  static auto* syncers = new unordered_map<string, weak_ptr<LogSyncer>>();
+
+  std::lock_guard<simple_spinlock> l(lock);
+  weak_ptr<LogSyncer>* weak_syncer = &LookupOrInsert(syncers, wal_root, weak_ptr<LogSyncer>());
+  shared_ptr<LogSyncer> s = weak_syncer->lock();
+  if (!s) {
+    unique_ptr<FileSystemHandle> wal_fs;
+    RETURN_NOT_OK(env->OpenFileSystem(wal_root, &wal_fs));
+    s = std::make_shared<LogSyncer>(std::move(wal_fs));
+    *weak_syncer = s;
+  }
+  *syncer = std::move(s);
+  return Status::OK();
+}
+
+LogSyncer::LogSyncer(unique_ptr<FileSystemHandle> wal_fs)
+    : wal_fs_(std::move(wal_fs)),
+      round_finished_(&lock_),
+      rounds_started_(0),
+      rounds_finished_(0) {
+}
+
+LogSyncer::~LogSyncer() {
+}
+
+Status LogSyncer::Sync() {
+  TRACE_EVENT0("log", "LogSyncer::Sync");
+  MutexLock l(lock_);
+
+  // The round in flight, if any, may have started before our caller's
+  // writes, so only the next one is sure to cover them.
+  const int64_t round = rounds_started_ + 1;
+  while (rounds_finished_ < round) {
+    if (rounds_started_ == rounds_finished_) {
+      // No round is in flight: lead one, on behalf of ourselves and of all
+      // the callers which queue up behind us while it runs.
+      rounds_started_++;
+      l.Unlock();
+      Status s = wal_fs_->Sync();
+      l.Lock();
+      last_status_ = s;
+      rounds_finished_++;
+      round_finished_.Broadcast();
+    } else {
+      round_finished_.Wait();
+    }
+  }
+  return last_status_;
+}
+
+bool LogSyncer::SyncReportsWritebackErrors(const string& kernel_release) {
+  // See commit 735e4ae5ba28 ("vfs: track per-sb writeback errors and report
+  // them to syncfs") in Linux.
+  autodigit_less lt;
+  return !lt(kernel_release, "5.8");
+}
+
+int64_t LogSyncer::num_syncs() const {
+  MutexLock l(lock_);
+  return rounds_finished_;
+}
+
+}  // namespace log
+}  // namespace kudu
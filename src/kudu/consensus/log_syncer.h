@@ -0,0 +1,108 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CONSENSUS_LOG_SYNCER_H
+#define KUDU_CONSENSUS_LOG_SYNCER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Env;
+class FileSystemHandle;
+
+namespace log {
+
+// Makes the writes of all the logs of a WAL root durable together.
+//
+// Each Log has its own appender thread, which group-commits the batches of
+// its own tablet with an fsync of its active segment. When a server hosts
+// many tablets each doing small writes, the WAL disk ends up serving as many
+// independent fsyncs. Instead, logs sharing a LogSyncer sync their segments
+// with a single sync of the filesystem of the WAL root: all the logs which
+// ask for a sync while one is in flight are made durable by the next one, so
+// that the number of flushes of the WAL disk no longer grows with the number
+// of tablets.
+//
+// The filesystem is synced through a handle opened when the syncer is
+// created, rather than one per sync: a sync only reports the failures to
+// write back data which happened since its handle was opened, so the logs
+// must only write to their segments once they hold the syncer.
+//
+// The filesystem sync also writes back any other dirty data of the
+// filesystem, so this is only worthwhile when the WAL root is on its own
+// filesystem. It is only used on kernels whose filesystem syncs report
+// writeback errors; see SyncReportsWritebackErrors().
+//
+// This class is thread-safe.
+class LogSyncer {
+ public:
+  // Sets 'syncer' to the syncer shared by all the logs under 'wal_root',
+  // creating it if needed.
+  //
+  // Returns NotSupported if the filesystem of the WAL root can't be synced
+  // as a whole on this platform.
+  static Status Get(Env* env, const std::string& wal_root,
+                    std::shared_ptr<LogSyncer>* syncer);
+
+  explicit LogSyncer(std::unique_ptr<FileSystemHandle> wal_fs);
+  ~LogSyncer();
+
+  // Returns whether a filesystem sync on a kernel of the given release
+  // reports the errors of writing back the data of the filesystem's files.
+  // Before Linux 5.8, syncfs() only reported errors syncing the filesystem
+  // itself, so a failed writeback of a WAL segment would go unnoticed.
+  static bool SyncReportsWritebackErrors(const std::string& kernel_release);
+
+  // Blocks until all the data written to the files of the WAL root before
+  // the call is durable.
+  //
+  // If the sync fails, returns the error to all the callers which were
+  // waiting on it.
+  Status Sync();
+
+  // Returns the number of filesystem syncs issued so far.
+  int64_t num_syncs() const;
+
+ private:
+  // The handle on the filesystem of the WAL root.
+  const std::unique_ptr<FileSystemHandle> wal_fs_;
+
+  mutable Mutex lock_;
+  ConditionVariable round_finished_;
+
+  // The number of sync rounds started and finished so far. At most one
+  // round is in flight at any time.
+  int64_t rounds_started_;
+  int64_t rounds_finished_;
+
+  // The result of the last finished round.
+  Status last_status_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogSyncer);
+};
+
+}  // namespace log
+}  // namespace kudu
+
+#endif // KUDU_CONSENSUS_LOG_SYNCER_H
@@ -33,6 +33,7 @@ class BlockId;
 class Env;
 class MemTracker;
 class Slice;
+struct ReadRequest;
 
 template <typename T>
 class ArrayView;
@@ -162,6 +163,12 @@ class ReadableBlock : public Block {
   // If an error was encountered, returns a non-OK status.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs all the reads of 'requests', whose offsets are relative to the
+  // beginning of the block, as ReadV() does. The reads may be issued
+  // concurrently, so that a single thread can have many I/Os in flight.
+  // If an error was encountered, returns a non-OK status.
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const = 0;
+
   // Returns the memory usage of this object including the object itself.
   virtual size_t memory_footprint() const = 0;
 };
@@ -447,6 +447,8 @@ class FileReadableBlock : public ReadableBlock {
 
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const OVERRIDE;
 
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
   void HandleError(const Status& s) const;
@@ -536,6 +538,26 @@ Status FileReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
   return Status::OK();
 }
 
+Status FileReadableBlock::ReadBatch(ArrayView<const ReadRequest> requests) const {
+  DCHECK(!closed_.Load());
+
+  RETURN_NOT_OK_HANDLE_ERROR(reader_->ReadBatch(requests));
+
+  if (block_manager_->metrics_) {
+    size_t bytes_read = 0;
+    for (const auto& request : requests) {
+      bytes_read += accumulate(request.results.begin(), request.results.end(),
+                               static_cast<size_t>(0),
+                               [&](size_t sum, const Slice& curr) {
+                                 return sum + curr.size();
+                               });
+    }
+    block_manager_->metrics_->total_bytes_read->IncrementBy(bytes_read);
+  }
+
+  return Status::OK();
+}
+
 size_t FileReadableBlock::memory_footprint() const {
   DCHECK(reader_);
   return kudu_malloc_usable_size(this) + reader_->memory_footprint();
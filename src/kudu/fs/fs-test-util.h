@@ -25,6 +25,7 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/util/array_view.h"
+#include "kudu/util/env.h"
 #include "kudu/util/malloc.h"
 #include "kudu/util/slice.h"
 
@@ -81,6 +82,16 @@ class CountingReadableBlock : public ReadableBlock {
     return Status::OK();
   }
 
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const OVERRIDE {
+    RETURN_NOT_OK(block_->ReadBatch(requests));
+    for (const auto& request : requests) {
+      for (const auto& result : request.results) {
+        *bytes_read_ += result.size();
+      }
+    }
+    return Status::OK();
+  }
+
   virtual size_t memory_footprint() const OVERRIDE {
     return block_->memory_footprint();
   }
@@ -16,6 +16,7 @@
 // under the License.
 #include "kudu/fs/fs_report.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -27,6 +28,7 @@
 #include "kudu/fs/fs.pb.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/pb_util.h"
 
 namespace kudu {
@@ -262,6 +264,10 @@ void FsReport::Stats::MergeFrom(const FsReport::Stats& other) {
   live_block_bytes_aligned += other.live_block_bytes_aligned;
   lbm_container_count += other.lbm_container_count;
   lbm_full_container_count += other.lbm_full_container_count;
+  lbm_container_open_us += other.lbm_container_open_us;
+  lbm_metadata_replay_us += other.lbm_metadata_replay_us;
+  lbm_repair_us += other.lbm_repair_us;
+  lbm_max_data_dir_open_us = std::max(lbm_max_data_dir_open_us, other.lbm_max_data_dir_open_us);
 }
 
 string FsReport::Stats::ToString() const {
@@ -269,9 +275,17 @@ string FsReport::Stats::ToString() const {
       "Total live blocks: $0\n"
       "Total live bytes: $1\n"
       "Total live bytes (after alignment): $2\n"
-      "Total number of LBM containers: $3 ($4 full)\n",
+      "Total number of LBM containers: $3 ($4 full)\n"
+      "Time spent opening LBM containers: $5\n"
+      "Time spent replaying LBM metadata: $6\n"
+      "Time spent repairing LBM inconsistencies: $7\n"
+      "Time spent opening the slowest data directory: $8\n",
       live_block_count, live_block_bytes, live_block_bytes_aligned,
-      lbm_container_count, lbm_full_container_count);
+      lbm_container_count, lbm_full_container_count,
+      MonoDelta::FromMicroseconds(lbm_container_open_us).ToString(),
+      MonoDelta::FromMicroseconds(lbm_metadata_replay_us).ToString(),
+      MonoDelta::FromMicroseconds(lbm_repair_us).ToString(),
+      MonoDelta::FromMicroseconds(lbm_max_data_dir_open_us).ToString());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -247,6 +247,16 @@ struct FsReport {
 
     // Total number of full LBM containers.
     int64_t lbm_full_container_count = 0;
+
+    // Time spent opening LBM containers, replaying their metadata files and
+    // repairing inconsistencies, summed over all data directories.
+    int64_t lbm_container_open_us = 0;
+    int64_t lbm_metadata_replay_us = 0;
+    int64_t lbm_repair_us = 0;
+
+    // Time spent opening the slowest data directory, i.e. the time it took to
+    // open them all, since they're opened in parallel.
+    int64_t lbm_max_data_dir_open_us = 0;
   };
   Stats stats;
 
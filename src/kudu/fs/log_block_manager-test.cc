@@ -55,6 +55,7 @@
 #include "kudu/util/atomic.h"
 #include "kudu/util/env.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
@@ -76,6 +77,7 @@ using strings::Substitute;
 
 DECLARE_bool(cache_force_single_shard);
 DECLARE_bool(crash_on_eio);
+DECLARE_bool(log_container_compact_metadata_at_runtime);
 DECLARE_double(env_inject_eio);
 DECLARE_double(log_container_excess_space_before_cleanup_fraction);
 DECLARE_double(log_container_live_metadata_before_compact_ratio);
@@ -1546,6 +1548,143 @@ TEST_F(LogBlockManagerTest, TestCompactFullContainerMetadataAtStartup) {
   ASSERT_EQ(last_live_aligned_bytes, report.stats.live_block_bytes_aligned);
 }
 
+TEST_F(LogBlockManagerTest, TestCompactFullContainerMetadataAtRuntime) {
+  FLAGS_log_container_compact_metadata_at_runtime = true;
+  FLAGS_log_container_live_metadata_before_compact_ratio = 0.50;
+  FLAGS_log_container_max_blocks = 10;
+  ASSERT_OK(ReopenBlockManager());
+
+  // Create one full container.
+  vector<BlockId> block_ids;
+  for (int i = 0; i < FLAGS_log_container_max_blocks; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append("a"));
+    ASSERT_OK(block->Close());
+    block_ids.emplace_back(block->id());
+  }
+  string metadata_file_name;
+  NO_FATALS(GetOnlyContainerMetadataFile(&metadata_file_name));
+  uint64_t pre_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &pre_compaction_file_size));
+
+  // Delete half of the blocks. The metadata file should get compacted in the
+  // background, without a restart.
+  const int kNumToDelete = FLAGS_log_container_max_blocks / 2;
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    for (int i = 0; i < kNumToDelete; i++) {
+      deletion_transaction->AddDeletedBlock(block_ids[i]);
+    }
+    vector<BlockId> deleted;
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+  ASSERT_EVENTUALLY([&]() {
+    uint64_t file_size;
+    ASSERT_OK(env_->GetFileSize(metadata_file_name, &file_size));
+    ASSERT_LT(file_size, pre_compaction_file_size);
+  });
+
+  // The remaining blocks are still readable, and deletions are recorded in
+  // the compacted file.
+  for (int i = kNumToDelete; i < block_ids.size(); i++) {
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(bm_->OpenBlock(block_ids[i], &block));
+  }
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    deletion_transaction->AddDeletedBlock(block_ids[kNumToDelete]);
+    vector<BlockId> deleted;
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+
+  // On restart, the compacted file is replayed without inconsistencies.
+  FsReport report;
+  ASSERT_OK(ReopenBlockManager(nullptr, &report));
+  ASSERT_FALSE(report.HasFatalErrors());
+  ASSERT_TRUE(report.malformed_record_check->entries.empty());
+  ASSERT_TRUE(report.partial_record_check->entries.empty());
+  ASSERT_EQ(FLAGS_log_container_max_blocks - kNumToDelete - 1, report.stats.live_block_count);
+  ASSERT_GT(report.stats.lbm_max_data_dir_open_us, 0);
+}
+
+// Test that a runtime compaction of the metadata of a container keeps the
+// records of the deleted blocks whose holes aren't punched yet, so that they
+// are repunched at startup if the server crashes before the punch.
+TEST_F(LogBlockManagerTest, TestRuntimeCompactionWaitsForPendingPunches) {
+  FLAGS_log_container_compact_metadata_at_runtime = true;
+  FLAGS_log_container_live_metadata_before_compact_ratio = 0.50;
+  FLAGS_log_container_max_blocks = 10;
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(&registry, "test");
+  ASSERT_OK(ReopenBlockManager(entity));
+
+  // Create one full container.
+  vector<BlockId> block_ids;
+  for (int i = 0; i < FLAGS_log_container_max_blocks; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append("a"));
+    ASSERT_OK(block->Close());
+    block_ids.emplace_back(block->id());
+  }
+  string metadata_file_name;
+  NO_FATALS(GetOnlyContainerMetadataFile(&metadata_file_name));
+  uint64_t pre_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &pre_compaction_file_size));
+
+  // Delete the first block while it's still open: its hole is only punched
+  // once it's closed.
+  unique_ptr<ReadableBlock> open_block;
+  ASSERT_OK(bm_->OpenBlock(block_ids[0], &open_block));
+  vector<BlockId> deleted;
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    deletion_transaction->AddDeletedBlock(block_ids[0]);
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+
+  // Delete enough other blocks to warrant a compaction, and wait for their
+  // holes to be punched.
+  const int kNumToDelete = FLAGS_log_container_max_blocks / 2 + 1;
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    for (int i = 1; i < kNumToDelete; i++) {
+      deletion_transaction->AddDeletedBlock(block_ids[i]);
+    }
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+  Counter* holes_punched = down_cast<Counter*>(
+      entity->FindOrNull(METRIC_log_block_manager_holes_punched).get());
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_GT(holes_punched->value(), 0);
+  });
+
+  // The first block is still pending a punch, so the metadata file must not
+  // have been compacted.
+  SleepFor(MonoDelta::FromMilliseconds(100));
+  uint64_t file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &file_size));
+  ASSERT_GE(file_size, pre_compaction_file_size);
+
+  // Once the first block is closed and its hole punched, the compaction
+  // goes ahead.
+  open_block.reset();
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_OK(env_->GetFileSize(metadata_file_name, &file_size));
+    ASSERT_LT(file_size, pre_compaction_file_size);
+  });
+
+  FsReport report;
+  ASSERT_OK(ReopenBlockManager(nullptr, &report));
+  ASSERT_FALSE(report.HasFatalErrors());
+  ASSERT_EQ(FLAGS_log_container_max_blocks - kNumToDelete, report.stats.live_block_count);
+}
+
 // Regression test for a bug in which, after a metadata file was compacted,
 // we would not properly handle appending to the new (post-compaction) metadata.
 //
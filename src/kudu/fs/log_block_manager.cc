@@ -69,6 +69,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
+#include "kudu/util/rw_mutex.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/sorted_disjoint_interval_list.h"
@@ -107,6 +108,15 @@ DEFINE_double(log_container_live_metadata_before_compact_ratio, 0.50,
               "the container's metadata file will be compacted at startup.");
 TAG_FLAG(log_container_live_metadata_before_compact_ratio, experimental);
 
+DEFINE_bool(log_container_compact_metadata_at_runtime, false,
+            "Whether the metadata files of full log containers should also be "
+            "compacted while the server runs, in the background, as soon as their "
+            "live to total block ratio dips below "
+            "--log_container_live_metadata_before_compact_ratio. This keeps the "
+            "metadata files short, and thus the block manager's startup fast, on "
+            "servers which create and delete many blocks between restarts.");
+TAG_FLAG(log_container_compact_metadata_at_runtime, experimental);
+
 DEFINE_bool(log_block_manager_test_hole_punching, true,
             "Ensure hole punching is supported by the underlying filesystem");
 TAG_FLAG(log_block_manager_test_hole_punching, advanced);
@@ -160,6 +170,20 @@ using strings::Substitute;
 
 namespace internal {
 
+// Orders the records of a metadata file the way they were appended to it.
+bool BlockRecordsInFileOrder(const BlockRecordPB& a, const BlockRecordPB& b) {
+  // Sort by timestamp.
+  if (a.timestamp_us() != b.timestamp_us()) {
+    return a.timestamp_us() < b.timestamp_us();
+  }
+
+  // If the timestamps match, sort by offset.
+  //
+  // If the offsets also match (i.e. both blocks are of zero length),
+  // it doesn't matter which of the two records comes first.
+  return a.offset() < b.offset();
+}
+
 ////////////////////////////////////////////////////////////
 // LogBlockManagerMetrics
 ////////////////////////////////////////////////////////////
@@ -373,8 +397,21 @@ class LogBlockContainer {
   // The on-disk effects of this call are made durable only after SyncData().
   Status PunchHole(int64_t offset, int64_t length);
 
-  // Executes a hole punching operation at 'offset' with the given 'length'.
-  void ContainerDeletionAsync(int64_t offset, int64_t length);
+  // Executes a hole punching operation at 'offset' with the given 'length',
+  // which frees the space of 'num_blocks' deleted blocks. Once no other
+  // block is pending a punch, schedules a metadata compaction if needed. If
+  // the punch fails, the blocks stay pending.
+  void ContainerDeletionAsync(int64_t offset, int64_t length, int64_t num_blocks);
+
+  // Rewrites the metadata file with the records of the live blocks only.
+  // Appends to the metadata file wait for the rewrite to finish.
+  Status CompactMetadata();
+
+  // Executes CompactMetadata(), logging any failure.
+  void CompactMetadataAsync();
+
+  // Like ReopenMetadataWriter(), with 'metadata_lock_' held in exclusive mode.
+  Status ReopenMetadataWriterUnlocked();
 
   // Preallocate enough space to ensure that an append of 'next_append_length'
   // can be satisfied by this container. The offset of the beginning of this
@@ -397,6 +434,9 @@ class LogBlockContainer {
   // See RWFile::ReadV().
   Status ReadVData(int64_t offset, ArrayView<Slice> results) const;
 
+  // See RWFile::ReadBatch().
+  Status ReadBatchData(ArrayView<const ReadRequest> requests) const;
+
   // Appends 'pb' to this container's metadata file.
   //
   // The on-disk effects of this call are made durable only after SyncMetadata().
@@ -431,6 +471,24 @@ class LogBlockContainer {
   // file was changed.
   Status ReopenMetadataWriter();
 
+  // Records that the metadata file was rewritten at startup without the
+  // records of 'num_blocks' dead blocks.
+  void MetadataCompacted(int64_t num_blocks) {
+    compacted_dead_blocks_.IncrementBy(num_blocks);
+  }
+
+  // Adds 'num_blocks' (which may be negative) to the number of deleted blocks
+  // whose holes are not punched yet. Must be called before the DELETE record
+  // of a block is appended.
+  void AddBlocksPendingPunch(int64_t num_blocks) {
+    blocks_pending_punch_.IncrementBy(num_blocks);
+  }
+
+  // If runtime metadata compaction is enabled and this container is full and
+  // has few enough live blocks and no block pending a punch, schedules the
+  // compaction of its metadata file on its data directory's thread pool.
+  void ScheduleMetadataCompactionIfNeeded();
+
   // Truncates this container's data file to 'next_block_offset_' if it is
   // full. This effectively removes any preallocated but unused space.
   //
@@ -565,6 +623,10 @@ class LogBlockContainer {
 
   // Opened file handles to the container's files.
   unique_ptr<WritablePBContainerFile> metadata_file_;
+
+  // Protects 'metadata_file_' from being replaced while in use. Taken in
+  // shared mode to use the file, and in exclusive mode to rewrite it.
+  RWMutex metadata_lock_;
   shared_ptr<RWFile> data_file_;
 
   // The offset of the next block to be written to the container.
@@ -586,6 +648,20 @@ class LogBlockContainer {
   // The number of not-yet-deleted blocks in the container.
   AtomicInt<int64_t> live_blocks_;
 
+  // The number of deleted blocks whose records were dropped from the metadata
+  // file by compactions. The others still have a CREATE record, and likely a
+  // DELETE record, in the file.
+  AtomicInt<int64_t> compacted_dead_blocks_;
+
+  // The number of deleted blocks whose holes are not punched yet, or failed
+  // to be. Their records must outlive metadata compactions, so that the
+  // holes are repunched at startup; until then, the metadata file isn't
+  // compacted at runtime.
+  AtomicInt<int64_t> blocks_pending_punch_;
+
+  // Whether a compaction of the metadata file is scheduled or running.
+  AtomicBool metadata_compaction_scheduled_;
+
   // The metrics. Not owned by the log container; it has the same lifespan
   // as the block manager.
   const LogBlockManagerMetrics* metrics_;
@@ -616,6 +692,9 @@ LogBlockContainer::LogBlockContainer(
       live_bytes_(0),
       live_bytes_aligned_(0),
       live_blocks_(0),
+      compacted_dead_blocks_(0),
+      blocks_pending_punch_(0),
+      metadata_compaction_scheduled_(false),
       metrics_(block_manager->metrics()) {
 }
 
@@ -993,7 +1072,13 @@ Status LogBlockContainer::ReadVData(int64_t offset, ArrayView<Slice> results) co
   return Status::OK();
 }
 
+Status LogBlockContainer::ReadBatchData(ArrayView<const ReadRequest> requests) const {
+  RETURN_NOT_OK_HANDLE_ERROR(data_file_->ReadBatch(requests));
+  return Status::OK();
+}
+
 Status LogBlockContainer::AppendMetadata(const BlockRecordPB& pb) {
+  shared_lock<RWMutex> l(metadata_lock_);
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   // Note: We don't check for sufficient disk space for metadata writes in
   // order to allow for block deletion on full disks.
@@ -1010,6 +1095,7 @@ Status LogBlockContainer::FlushData(int64_t offset, int64_t length) {
 }
 
 Status LogBlockContainer::FlushMetadata() {
+  shared_lock<RWMutex> l(metadata_lock_);
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   RETURN_NOT_OK_HANDLE_ERROR(metadata_file_->Flush());
   return Status::OK();
@@ -1025,6 +1111,7 @@ Status LogBlockContainer::SyncData() {
 }
 
 Status LogBlockContainer::SyncMetadata() {
+  shared_lock<RWMutex> l(metadata_lock_);
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   if (FLAGS_enable_data_block_fsync) {
     if (metrics_) metrics_->generic_metrics.total_disk_sync->Increment();
@@ -1034,6 +1121,11 @@ Status LogBlockContainer::SyncMetadata() {
 }
 
 Status LogBlockContainer::ReopenMetadataWriter() {
+  std::lock_guard<RWMutex> l(metadata_lock_);
+  return ReopenMetadataWriterUnlocked();
+}
+
+Status LogBlockContainer::ReopenMetadataWriterUnlocked() {
   shared_ptr<RWFile> f;
   RETURN_NOT_OK_HANDLE_ERROR(block_manager_->file_cache_.OpenExistingFile(
       metadata_file_->filename(), &f));
@@ -1154,12 +1246,117 @@ void LogBlockContainer::SetReadOnly(const Status& error) {
   read_only_status_ = error;
 }
 
-void LogBlockContainer::ContainerDeletionAsync(int64_t offset, int64_t length) {
+void LogBlockContainer::ScheduleMetadataCompactionIfNeeded() {
+  if (!FLAGS_log_container_compact_metadata_at_runtime || !full() ||
+      blocks_pending_punch_.Load() > 0) {
+    return;
+  }
+  // A container without live blocks will be deleted outright at startup.
+  int64_t live = live_blocks();
+  int64_t dead = total_blocks() - live - compacted_dead_blocks_.Load();
+  if (live == 0 || dead <= 0 ||
+      static_cast<double>(live) / (live + dead) >
+          FLAGS_log_container_live_metadata_before_compact_ratio) {
+    return;
+  }
+  if (metadata_compaction_scheduled_.CompareAndSet(false, true)) {
+    ExecClosure(Bind(&LogBlockContainer::CompactMetadataAsync, Unretained(this)));
+  }
+}
+
+Status LogBlockContainer::CompactMetadata() {
+  std::lock_guard<RWMutex> l(metadata_lock_);
+  RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
+
+  // A block was deleted since the compaction was scheduled. Its hole may not
+  // be punched yet, so leave the file alone: the punch schedules another
+  // compaction once it is done.
+  if (blocks_pending_punch_.Load() > 0) {
+    return Status::OK();
+  }
+
+  // Read back the records of the live blocks. Nothing can be appended to the
+  // file in the meantime.
+  string metadata_path = metadata_file_->filename();
+  unique_ptr<RandomAccessFile> metadata_reader;
+  RETURN_NOT_OK_HANDLE_ERROR(block_manager()->env()->NewRandomAccessFile(
+      metadata_path, &metadata_reader));
+  ReadablePBContainerFile pb_reader(std::move(metadata_reader));
+  RETURN_NOT_OK_HANDLE_ERROR(pb_reader.Open());
+  LogBlockManager::BlockRecordMap live_block_records;
+  int64_t num_created = 0;
+  while (true) {
+    BlockRecordPB record;
+    Status s = pb_reader.ReadNextPB(&record);
+    if (s.IsEndOfFile()) {
+      break;
+    }
+    RETURN_NOT_OK_HANDLE_ERROR(s);
+    const BlockId block_id(BlockId::FromPB(record.block_id()));
+    switch (record.op_type()) {
+      case CREATE:
+        num_created++;
+        live_block_records[block_id].Swap(&record);
+        break;
+      case DELETE:
+        live_block_records.erase(block_id);
+        break;
+      default:
+        return Status::Corruption(Substitute("Found unknown block record in metadata file $0: $1",
+                                             metadata_path,
+                                             pb_util::SecureDebugString(record)));
+    }
+  }
+  vector<BlockRecordPB> records;
+  records.reserve(live_block_records.size());
+  for (auto& e : live_block_records) {
+    records.emplace_back();
+    records.back().Swap(&e.second);
+  }
+  std::sort(records.begin(), records.end(), BlockRecordsInFileOrder);
+
+  int64_t file_bytes_delta;
+  RETURN_NOT_OK(block_manager_->RewriteMetadataFile(*this, records, &file_bytes_delta));
+
+  // The old file is gone: if the writer can't be pointed at the new one, or
+  // if the new one can't be made durable, the records appended from now on
+  // could be lost, so stop using the container.
+  Status s = ReopenMetadataWriterUnlocked();
+  if (s.ok()) {
+    s = block_manager()->env()->SyncDir(data_dir_->dir());
+    HandleError(s);
+  }
+  if (!s.ok()) {
+    SetReadOnly(s);
+    return s.CloneAndPrepend("could not switch to the compacted metadata file");
+  }
+  compacted_dead_blocks_.IncrementBy(num_created - records.size());
+  VLOG(1) << "Compacted metadata file " << metadata_path
+          << " (saved " << file_bytes_delta << " bytes)";
+  return Status::OK();
+}
+
+void LogBlockContainer::CompactMetadataAsync() {
+  WARN_NOT_OK(CompactMetadata(), Substitute("could not compact metadata of container $0",
+                                            ToString()));
+  metadata_compaction_scheduled_.Store(false);
+}
+
+void LogBlockContainer::ContainerDeletionAsync(int64_t offset, int64_t length,
+                                               int64_t num_blocks) {
   VLOG(3) << "Freeing space belonging to container " << ToString();
   Status s = PunchHole(offset, length);
-  if (s.ok() && metrics_) metrics_->holes_punched->Increment();
-  WARN_NOT_OK(s, Substitute("could not delete blocks in container $0",
-                            data_dir()->dir()));
+  if (!s.ok()) {
+    // The blocks stay pending, so that their records outlive any compaction
+    // and their holes are repunched at startup.
+    WARN_NOT_OK(s, Substitute("could not delete blocks in container $0",
+                              data_dir()->dir()));
+    return;
+  }
+  if (metrics_) metrics_->holes_punched->Increment();
+  if (blocks_pending_punch_.IncrementBy(-num_blocks) == 0) {
+    ScheduleMetadataCompactionIfNeeded();
+  }
 }
 
 ///////////////////////////////////////////////////////////
@@ -1259,15 +1456,26 @@ void LogBlockDeletionTransaction::AddDeletedBlock(BlockId block) {
 LogBlockDeletionTransaction::~LogBlockDeletionTransaction() {
   for (auto& entry : deleted_interval_map_) {
     LogBlockContainer* container = entry.first;
+    vector<BlockInterval> block_intervals = entry.second;
+    std::sort(block_intervals.begin(), block_intervals.end());
     CHECK_OK_PREPEND(CoalesceIntervals<int64_t>(&entry.second),
                      Substitute("could not coalesce hole punching for container: $0",
                                 container->ToString()));
 
+    // Each coalesced interval covers a run of the sorted block intervals.
+    auto block_interval = block_intervals.begin();
     for (const auto& interval : entry.second) {
+      int64_t num_blocks = 0;
+      while (block_interval != block_intervals.end() &&
+             block_interval->first <= interval.second) {
+        num_blocks++;
+        block_interval++;
+      }
       container->ExecClosure(Bind(&LogBlockContainer::ContainerDeletionAsync,
                                   Unretained(container),
                                   interval.first,
-                                  interval.second - interval.first));
+                                  interval.second - interval.first,
+                                  num_blocks));
     }
   }
 }
@@ -1563,9 +1771,18 @@ class LogReadableBlock : public ReadableBlock {
 
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const OVERRIDE;
 
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
  private:
+  // Returns an error if the 'length' bytes at 'offset' of this block aren't
+  // all within it.
+  Status CheckReadBounds(uint64_t offset, size_t length) const;
+
+  // Records a read of 'length' bytes which took 'dur' microseconds.
+  void RecordRead(size_t length, int64_t dur) const;
+
   // The owning container. Must outlive this block.
   LogBlockContainer* container_;
 
@@ -1629,30 +1846,64 @@ Status LogReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
                                     return sum + curr.size();
                                   });
 
-  uint64_t read_offset = log_block_->offset() + offset;
-  if (log_block_->length() < offset + read_length) {
+  RETURN_NOT_OK(CheckReadBounds(offset, read_length));
+
+  MicrosecondsInt64 start_time = GetMonoTimeMicros();
+  RETURN_NOT_OK(container_->ReadVData(log_block_->offset() + offset, results));
+  MicrosecondsInt64 end_time = GetMonoTimeMicros();
+
+  RecordRead(read_length, end_time - start_time);
+  return Status::OK();
+}
+
+Status LogReadableBlock::ReadBatch(ArrayView<const ReadRequest> requests) const {
+  DCHECK(!closed_.Load());
+
+  // Translate the requests into reads of the container's data file.
+  vector<ReadRequest> container_requests;
+  container_requests.reserve(requests.size());
+  size_t read_length = 0;
+  for (const auto& request : requests) {
+    size_t length = accumulate(request.results.begin(), request.results.end(),
+                               static_cast<size_t>(0),
+                               [&](size_t sum, const Slice& curr) {
+                                 return sum + curr.size();
+                               });
+    RETURN_NOT_OK(CheckReadBounds(request.offset, length));
+    container_requests.push_back({ log_block_->offset() + request.offset, request.results });
+    read_length += length;
+  }
+
+  MicrosecondsInt64 start_time = GetMonoTimeMicros();
+  RETURN_NOT_OK(container_->ReadBatchData(container_requests));
+  MicrosecondsInt64 end_time = GetMonoTimeMicros();
+
+  RecordRead(read_length, end_time - start_time);
+  return Status::OK();
+}
+
+Status LogReadableBlock::CheckReadBounds(uint64_t offset, size_t length) const {
+  if (log_block_->length() < offset + length) {
+    uint64_t read_offset = log_block_->offset() + offset;
     return Status::IOError("Out-of-bounds read",
                            Substitute("read of [$0-$1) in block [$2-$3)",
                                       read_offset,
-                                      read_offset + read_length,
+                                      read_offset + length,
                                       log_block_->offset(),
                                       log_block_->offset() + log_block_->length()));
   }
+  return Status::OK();
+}
 
-  MicrosecondsInt64 start_time = GetMonoTimeMicros();
-  RETURN_NOT_OK(container_->ReadVData(read_offset, results));
-  MicrosecondsInt64 end_time = GetMonoTimeMicros();
-
-  int64_t dur = end_time - start_time;
+void LogReadableBlock::RecordRead(size_t length, int64_t dur) const {
   TRACE_COUNTER_INCREMENT("lbm_read_time_us", dur);
 
   const char* counter = BUCKETED_COUNTER_NAME("lbm_reads", dur);
   TRACE_COUNTER_INCREMENT(counter, 1);
 
   if (container_->metrics()) {
-    container_->metrics()->generic_metrics.total_bytes_read->IncrementBy(read_length);
+    container_->metrics()->generic_metrics.total_bytes_read->IncrementBy(length);
   }
-  return Status::OK();
 }
 
 size_t LogReadableBlock::memory_footprint() const {
@@ -2088,9 +2339,11 @@ Status LogBlockManager::RemoveLogBlocks(vector<BlockId> block_ids,
     VLOG(3) << "Deleting block " << lb->block_id();
     lb->container()->BlockDeleted(lb);
 
-    // Record the on-disk deletion.
+    // Record the on-disk deletion. The block is pending a punch from then on,
+    // so that a metadata compaction doesn't drop its records meanwhile.
     //
     // TODO(unknown): what if this fails? Should we restore the in-memory block?
+    lb->container()->AddBlocksPendingPunch(1);
     BlockRecordPB record;
     lb->block_id().CopyToPB(record.mutable_block_id());
     record.set_op_type(DELETE);
@@ -2105,6 +2358,7 @@ Status LogBlockManager::RemoveLogBlocks(vector<BlockId> block_ids,
     // TODO(KUDU-829): Implement GC of orphaned blocks.
 
     if (!s.ok()) {
+      lb->container()->AddBlocksPendingPunch(-1);
       if (first_failure.ok()) {
         first_failure = s.CloneAndPrepend(
             "Unable to append deletion record to block metadata");
@@ -2151,6 +2405,7 @@ Status LogBlockManager::RemoveLogBlockUnlocked(const BlockId& block_id,
 void LogBlockManager::OpenDataDir(DataDir* dir,
                                   FsReport* report,
                                   Status* result_status) {
+  const MonoTime start_time = MonoTime::Now();
   FsReport local_report;
   local_report.data_dirs.push_back(dir->dir());
 
@@ -2200,8 +2455,11 @@ void LogBlockManager::OpenDataDir(DataDir* dir,
     }
 
     unique_ptr<LogBlockContainer> container;
+    MonoTime phase_start = MonoTime::Now();
     s = LogBlockContainer::Open(
         this, dir, &local_report, container_name, &container);
+    local_report.stats.lbm_container_open_us +=
+        (MonoTime::Now() - phase_start).ToMicroseconds();
     if (s.IsAborted()) {
       // Skip the container. Open() added a record of it to 'local_report' for us.
       continue;
@@ -2230,11 +2488,14 @@ void LogBlockManager::OpenDataDir(DataDir* dir,
     BlockRecordMap live_block_records;
     vector<scoped_refptr<internal::LogBlock>> dead_blocks;
     uint64_t max_block_id = 0;
+    phase_start = MonoTime::Now();
     s = container->ProcessRecords(&local_report,
                                   &live_blocks,
                                   &live_block_records,
                                   &dead_blocks,
                                   &max_block_id);
+    local_report.stats.lbm_metadata_replay_us +=
+        (MonoTime::Now() - phase_start).ToMicroseconds();
     if (!s.ok()) {
       *result_status = s.CloneAndPrepend(Substitute(
           "Could not process records in container $0", container->ToString()));
@@ -2287,19 +2548,7 @@ void LogBlockManager::OpenDataDir(DataDir* dir,
         // container (such as std::map) because while records are temporarily
         // retained for every container, only some containers will actually
         // undergo metadata compaction.
-        std::sort(records.begin(), records.end(),
-                  [](const BlockRecordPB& a, const BlockRecordPB& b) {
-          // Sort by timestamp.
-          if (a.timestamp_us() != b.timestamp_us()) {
-            return a.timestamp_us() < b.timestamp_us();
-          }
-
-          // If the timestamps match, sort by offset.
-          //
-          // If the offsets also match (i.e. both blocks are of zero length),
-          // it doesn't matter which of the two records comes first.
-          return a.offset() < b.offset();
-        });
+        std::sort(records.begin(), records.end(), internal::BlockRecordsInFileOrder);
 
         low_live_block_containers[container->ToString()] = std::move(records);
       }
@@ -2398,11 +2647,13 @@ void LogBlockManager::OpenDataDir(DataDir* dir,
 
   // Like the rest of Open(), repairs are performed per data directory to take
   // advantage of parallelism.
+  MonoTime repair_start = MonoTime::Now();
   s = Repair(dir,
              &local_report,
              std::move(need_repunching),
              std::move(dead_containers),
              std::move(low_live_block_containers));
+  local_report.stats.lbm_repair_us = (MonoTime::Now() - repair_start).ToMicroseconds();
   if (!s.ok()) {
     *result_status = s.CloneAndPrepend(Substitute(
         "fatal error while repairing inconsistencies in data directory $0",
@@ -2410,6 +2661,7 @@ void LogBlockManager::OpenDataDir(DataDir* dir,
     return;
   }
 
+  local_report.stats.lbm_max_data_dir_open_us = (MonoTime::Now() - start_time).ToMicroseconds();
   *report = std::move(local_report);
   *result_status = Status::OK();
 }
@@ -2607,6 +2859,7 @@ Status LogBlockManager::Repair(
   shared_ptr<LogBlockDeletionTransaction> transaction =
       std::make_shared<LogBlockDeletionTransaction>(this);
   for (const auto& b : need_repunching) {
+    b->container()->AddBlocksPendingPunch(1);
     b->RegisterDeletion(transaction);
     transaction->AddBlock(b);
   }
@@ -2639,6 +2892,7 @@ Status LogBlockManager::Repair(
     // However, we're hosed if we can't open the new metadata file.
     RETURN_NOT_OK_PREPEND(container->ReopenMetadataWriter(),
                           "could not reopen new metadata file");
+    container->MetadataCompacted(container->total_blocks() - container->live_blocks());
 
     metadata_files_compacted++;
     metadata_bytes_delta += file_bytes_delta;
@@ -93,8 +93,10 @@ DECLARE_int32(num_replicas);
 DECLARE_int32(num_tablet_servers);
 DECLARE_int32(rpc_timeout);
 
+METRIC_DECLARE_entity(server);
 METRIC_DECLARE_entity(tablet);
 METRIC_DECLARE_counter(transaction_memory_pressure_rejections);
+METRIC_DECLARE_histogram(op_apply_run_time);
 METRIC_DECLARE_gauge_int64(time_since_last_leader_heartbeat);
 METRIC_DECLARE_gauge_int64(failed_elections_since_stable_leader);
 
@@ -2995,5 +2997,90 @@ TEST_P(RaftConsensusParamReplicationModesITest, TestRestartWithDifferentUUID) {
     ASSERT_FALSE(files_in_wal_dir.empty());
   });
 }
+
+class RaftConsensusApplyThreadsITest :
+    public RaftConsensusITest,
+    public ::testing::WithParamInterface<int> {
+};
+INSTANTIATE_TEST_CASE_P(ApplyThreads, RaftConsensusApplyThreadsITest,
+                        ::testing::Values(1, 4, 16));
+
+// Measures how fast a follower applies a backlog of write operations with
+// the given number of apply threads. The follower is paused while the leader
+// and the other follower accept writes, then resumed; the time it takes to
+// apply as many operations as the other follower is reported.
+TEST_P(RaftConsensusApplyThreadsITest, FollowerApplyBenchmark) {
+  if (!AllowSlowTests()) {
+    LOG(WARNING) << "test is skipped; set KUDU_ALLOW_SLOW_TESTS=1 to run";
+    return;
+  }
+  const int kApplyThreads = GetParam();
+  const int kNumRowsToWrite = 200000;
+  const MonoDelta kTimeout = MonoDelta::FromSeconds(300);
+  const vector<string> kTsFlags = {
+    Substitute("--tablet_apply_pool_max_threads=$0", kApplyThreads),
+  };
+  NO_FATALS(BuildAndStart(kTsFlags));
+
+  TServerDetails* leader;
+  vector<TServerDetails*> followers;
+  ASSERT_OK(GetTabletLeaderAndFollowers(tablet_id_, &leader, &followers));
+  ASSERT_EQ(2, followers.size());
+  ExternalTabletServer* lagging_follower =
+      cluster_->tablet_server_by_uuid(followers[0]->uuid());
+  ExternalTabletServer* other_follower =
+      cluster_->tablet_server_by_uuid(followers[1]->uuid());
+
+  // The apply pool is server-wide, and this server only hosts the tablet
+  // under test, so the server's count of applied operations is the tablet's.
+  const auto get_applied_ops = [](ExternalTabletServer* ts, int64_t* applied_ops) {
+    return GetInt64Metric(ts->bound_http_hostport(),
+                          &METRIC_ENTITY_server,
+                          "kudu.tabletserver",
+                          &METRIC_op_apply_run_time,
+                          "total_count",
+                          applied_ops);
+  };
+  int64_t initial_ops;
+  ASSERT_OK(get_applied_ops(lagging_follower, &initial_ops));
+
+  ASSERT_OK(lagging_follower->Pause());
+  TestWorkload workload(cluster_.get());
+  workload.set_table_name(kTableId);
+  workload.set_num_write_threads(16);
+  workload.set_write_batch_size(10);
+  workload.Setup();
+  workload.Start();
+  while (workload.rows_inserted() < kNumRowsToWrite) {
+    SleepFor(MonoDelta::FromMilliseconds(100));
+  }
+  workload.StopAndJoin();
+
+  // Every batch is a write operation, which the other follower applies once
+  // the leader has told it about the commit.
+  int64_t target_ops;
+  ASSERT_EVENTUALLY([&] {
+    ASSERT_OK(get_applied_ops(other_follower, &target_ops));
+    ASSERT_GE(target_ops, initial_ops + workload.batches_completed());
+  });
+
+  ASSERT_OK(lagging_follower->Resume());
+  const MonoTime start = MonoTime::Now();
+  const MonoTime deadline = start + kTimeout;
+  int64_t applied_ops = 0;
+  while (applied_ops < target_ops) {
+    ASSERT_OK(get_applied_ops(lagging_follower, &applied_ops));
+    ASSERT_LT(MonoTime::Now(), deadline) << "follower has only applied "
+                                         << applied_ops << "/" << target_ops << " ops";
+    SleepFor(MonoDelta::FromMilliseconds(10));
+  }
+  const MonoDelta elapsed = MonoTime::Now() - start;
+  LOG(INFO) << Substitute("Follower with $0 apply threads applied $1 write ops in $2: "
+                          "$3 ops/s",
+                          kApplyThreads, target_ops - initial_ops, elapsed.ToString(),
+                          (target_ops - initial_ops) / elapsed.ToSeconds());
+  NO_FATALS(AssertAllReplicasAgree(workload.rows_inserted()));
+}
+
 }  // namespace tserver
 }  // namespace kudu
@@ -55,6 +55,15 @@ static bool ValidateThreadPoolThreadLimit(const char* /*flagname*/, int32_t valu
 }
 DEFINE_validator(server_thread_pool_max_thread_count, &ValidateThreadPoolThreadLimit);
 
+DEFINE_int32(tablet_apply_pool_max_threads, -1,
+             "Maximum number of threads applying committed write operations to the "
+             "tablets hosted by this server. Operations whose rows don't conflict are "
+             "applied concurrently, even if they belong to the same tablet. If -1, "
+             "one thread per CPU is used. It is an error to use a value of 0.");
+TAG_FLAG(tablet_apply_pool_max_threads, advanced);
+TAG_FLAG(tablet_apply_pool_max_threads, experimental);
+DEFINE_validator(tablet_apply_pool_max_threads, &ValidateThreadPoolThreadLimit);
+
 using std::string;
 using strings::Substitute;
 
@@ -140,7 +149,11 @@ Status KuduServer::Init() {
       METRIC_op_apply_queue_time.Instantiate(metric_entity_),
       METRIC_op_apply_run_time.Instantiate(metric_entity_)
   };
-  RETURN_NOT_OK(ThreadPoolBuilder("apply")
+  ThreadPoolBuilder apply_pool_builder("apply");
+  if (FLAGS_tablet_apply_pool_max_threads != -1) {
+    apply_pool_builder.set_max_threads(FLAGS_tablet_apply_pool_max_threads);
+  }
+  RETURN_NOT_OK(apply_pool_builder
                 .set_metrics(std::move(metrics))
                 .Build(&tablet_apply_pool_));
 
@@ -347,6 +347,56 @@ TEST_F(TestCBTree, TestInsertAndVerifyRandom) {
   }
 }
 
+// Test inserting with the leaf of the previous insert as a hint, with runs
+// of increasing keys interleaved with keys which belong elsewhere in the tree.
+TEST_F(TestCBTree, TestInsertWithHint) {
+  CBTree<SmallFanoutTraits> t;
+  char kbuf[64];
+  char vbuf[64];
+
+  int n_keys = 10000;
+  LeafNode<SmallFanoutTraits>* hint = nullptr;
+  for (int i = 0; i < n_keys; i++) {
+    // Every tenth key goes to the start of the tree.
+    int key = (i % 10 == 9) ? -i : i;
+    snprintf(kbuf, sizeof(kbuf), "key_%c%08d", key < 0 ? 'a' : 'b', abs(key));
+    snprintf(vbuf, sizeof(vbuf), "val_%d", key);
+    Slice k(kbuf);
+    PreparedMutation<SmallFanoutTraits> mutation(k);
+    mutation.PrepareWithHint(&t, hint);
+    ASSERT_FALSE(mutation.exists());
+    ASSERT_TRUE(mutation.Insert(Slice(vbuf)));
+    hint = mutation.leaf();
+
+    // Inserting the same key again with the hint must find it.
+    PreparedMutation<SmallFanoutTraits> dup(k);
+    dup.PrepareWithHint(&t, hint);
+    ASSERT_TRUE(dup.exists());
+    ASSERT_FALSE(dup.Insert(Slice(vbuf)));
+  }
+
+  for (int i = 0; i < n_keys; i++) {
+    int key = (i % 10 == 9) ? -i : i;
+    snprintf(kbuf, sizeof(kbuf), "key_%c%08d", key < 0 ? 'a' : 'b', abs(key));
+    snprintf(vbuf, sizeof(vbuf), "val_%d", key);
+    VerifyGet(t, Slice(kbuf), Slice(vbuf));
+  }
+
+  // The keys must be iterated in order.
+  gscoped_ptr<CBTreeIterator<SmallFanoutTraits> > iter(t.NewIterator());
+  ASSERT_TRUE(iter->SeekToStart());
+  string prev;
+  int count = 0;
+  while (iter->IsValid()) {
+    string k = iter->GetCurrentKey().ToString();
+    ASSERT_LT(prev, k);
+    prev = k;
+    count++;
+    iter->Next();
+  }
+  ASSERT_EQ(n_keys, count);
+}
+
 // Thread which cycles through doing the following:
 // - lock the node
 // - either mark it splitting or inserting (alternatingly)
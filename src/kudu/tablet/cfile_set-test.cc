@@ -46,6 +46,7 @@
 #include "kudu/gutil/strings/stringpiece.h"
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/diskrowset.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/util/auto_release_pool.h"
 #include "kudu/util/bloom_filter.h"
@@ -54,10 +55,13 @@
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(bloomfile_split_block_blooms);
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(scan_late_materialization_min_skipped_rows);
 
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 
 namespace kudu {
@@ -139,6 +143,7 @@ class TestCFileSet : public KuduRowSetTest {
                            size_t col_idx,
                            ColumnBlock *cb) {
     SelectionVector sel(cb->nrows());
+    sel.SetAllTrue();
     ColumnMaterializationContext ctx(col_idx, nullptr, cb, &sel);
     return iter->MaterializeColumn(&ctx);
   }
@@ -322,6 +327,120 @@ TEST_F(TestCFileSet, TestRangeScan) {
   EXPECT_EQ(1, stats[2].blocks_read);
 }
 
+// Check the presence of a batch of rows, some of which are in the rowset, and
+// ensure that the results match checking them one by one.
+TEST_F(TestCFileSet, TestCheckRowsPresent) {
+  FLAGS_bloomfile_split_block_blooms = true;
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), &fileset));
+
+  // The keys of the rowset are the even numbers in [0, kNumRows * 2).
+  Schema key_schema = schema_.CreateKeyProjection();
+  vector<unique_ptr<RowBuilder>> rows;
+  vector<unique_ptr<RowSetKeyProbe>> probes;
+  for (int32_t key = -1; key <= kNumRows * 2; key++) {
+    rows.emplace_back(new RowBuilder(key_schema));
+    rows.back()->AddInt32(key);
+    probes.emplace_back(new RowSetKeyProbe(rows.back()->row()));
+  }
+  const size_t n = probes.size();
+  vector<const RowSetKeyProbe*> probe_ptrs;
+  vector<ProbeStats> stats(n);
+  vector<ProbeStats*> stats_ptrs;
+  for (size_t i = 0; i < n; i++) {
+    probe_ptrs.push_back(probes[i].get());
+    stats_ptrs.push_back(&stats[i]);
+  }
+
+  unique_ptr<bool[]> present(new bool[n]);
+  unique_ptr<rowid_t[]> rowids(new rowid_t[n]);
+  ASSERT_OK(fileset->CheckRowsPresent(probe_ptrs.data(), n, present.get(), rowids.get(),
+                                      stats_ptrs.data()));
+  int num_present = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t key = static_cast<int32_t>(i) - 1;
+    bool expected_present = key >= 0 && key < kNumRows * 2 && key % 2 == 0;
+    ASSERT_EQ(expected_present, present[i]) << "key " << key;
+    ASSERT_EQ(1, stats[i].blooms_consulted);
+
+    ProbeStats single_stats;
+    bool single_present;
+    rowid_t single_rowid;
+    ASSERT_OK(fileset->CheckRowPresent(*probes[i], &single_present, &single_rowid,
+                                       &single_stats));
+    ASSERT_EQ(single_present, present[i]) << "key " << key;
+    ASSERT_EQ(single_stats.keys_consulted, stats[i].keys_consulted) << "key " << key;
+    if (present[i]) {
+      ASSERT_EQ(key / 2, rowids[i]);
+      num_present++;
+    }
+  }
+  ASSERT_EQ(kNumRows, num_present);
+}
+
+// Scan with a selective predicate on a non-key column, in a single batch,
+// and ensure that the other columns are only read around the selected rows.
+TEST_F(TestCFileSet, TestLateMaterialization) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), &fileset));
+
+  for (int32_t min_skipped_rows : { 0, 128 }) {
+    SCOPED_TRACE(min_skipped_rows);
+    FLAGS_scan_late_materialization_min_skipped_rows = min_skipped_rows;
+
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+
+    // Select rows [5000, 5010) through the second column, which is i * 10.
+    ScanSpec spec;
+    int32_t lower = 50000;
+    int32_t upper = 50100;
+    auto pred = ColumnPredicate::Range(schema_.column(1), &lower, &upper);
+    spec.AddPredicate(pred);
+    ASSERT_OK(iter->Init(&spec));
+
+    Arena arena(1024);
+    RowBlock block(schema_, kNumRows, &arena);
+    ASSERT_OK(iter->NextBlock(&block));
+    ASSERT_FALSE(iter->HasNext());
+    ASSERT_EQ(kNumRows, block.nrows());
+    ASSERT_EQ(10, block.selection_vector()->CountSelected());
+    for (int i = 0; i < kNumRows; i++) {
+      if (block.selection_vector()->IsRowSelected(i)) {
+        RowBlockRow row = block.row(i);
+        ASSERT_GE(i, 5000);
+        ASSERT_LT(i, 5010);
+        EXPECT_EQ(i * 2, *schema_.ExtractColumnFromRow<INT32>(row, 0));
+        EXPECT_EQ(i * 10, *schema_.ExtractColumnFromRow<INT32>(row, 1));
+        EXPECT_EQ(i * 100, *schema_.ExtractColumnFromRow<INT32>(row, 2));
+      }
+    }
+
+    vector<IteratorStats> stats;
+    iter->GetIteratorStats(&stats);
+    ASSERT_EQ(3, stats.size());
+    for (int i = 0; i < 3; i++) {
+      LOG(INFO) << "Col " << i << " stats: " << stats[i].ToString();
+    }
+    if (min_skipped_rows == 0) {
+      // The whole batch was decoded.
+      EXPECT_GT(stats[0].blocks_read, 10);
+      EXPECT_GT(stats[2].blocks_read, 10);
+    } else {
+      // Only the blocks around the selected rows were read.
+      EXPECT_LE(stats[0].blocks_read, 2);
+      EXPECT_LE(stats[2].blocks_read, 2);
+      EXPECT_LT(stats[2].cells_read, kNumRows / 10);
+    }
+  }
+}
+
 // Several other black-box tests for range scans. These are similar to
 // TestRangeScan above, except don't inspect internal state.
 TEST_F(TestCFileSet, TestRangePredicates2) {
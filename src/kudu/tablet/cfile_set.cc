@@ -30,6 +30,7 @@
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 
+#include "kudu/cfile/block_stats.h"
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_util.h"
@@ -54,6 +55,8 @@
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/slice.h"
@@ -62,6 +65,15 @@
 DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence checks");
 TAG_FLAG(consult_bloom_filters, hidden);
 
+DEFINE_int32(scan_late_materialization_min_skipped_rows, 128,
+             "When materializing a column without a predicate, only the row ranges "
+             "of the batch which contain selected rows are decoded, provided that "
+             "at least this many consecutive deselected rows can be skipped. "
+             "Blocks holding only skipped rows aren't read at all. If 0, the whole "
+             "batch is always decoded.");
+TAG_FLAG(scan_late_materialization_min_skipped_rows, advanced);
+TAG_FLAG(scan_late_materialization_min_skipped_rows, runtime);
+
 DECLARE_bool(rowset_metadata_store_keys);
 
 namespace kudu {
@@ -76,7 +88,9 @@ using cfile::CFileReader;
 using cfile::ColumnIterator;
 using cfile::ReaderOptions;
 using cfile::DefaultColumnValueIterator;
+using cfile::StatsMatch;
 using fs::ReadableBlock;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -87,6 +101,23 @@ using strings::Substitute;
 // Utilities
 ////////////////////////////////////////////////////////////
 
+// Seeks 'key_iter' to the key of 'probe', setting *idx to the index of the
+// row or to boost::none if the row is not found.
+static Status SeekToKey(CFileIterator* key_iter,
+                        const RowSetKeyProbe& probe,
+                        boost::optional<rowid_t>* idx) {
+  bool exact;
+  Status s = key_iter->SeekAtOrAfter(probe.encoded_key(), &exact);
+  if (s.IsNotFound() || (s.ok() && !exact)) {
+    *idx = boost::none;
+    return Status::OK();
+  }
+  RETURN_NOT_OK(s);
+
+  *idx = key_iter->GetCurrentOrdinal();
+  return Status::OK();
+}
+
 static Status OpenReader(FsManager* fs,
                          shared_ptr<MemTracker> parent_mem_tracker,
                          const BlockId& block_id,
@@ -288,16 +319,7 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe,
 
   unique_ptr<CFileIterator> key_iter_scoped(key_iter); // free on return
 
-  bool exact;
-  Status s = key_iter->SeekAtOrAfter(probe.encoded_key(), &exact);
-  if (s.IsNotFound() || (s.ok() && !exact)) {
-    *idx = boost::none;
-    return Status::OK();
-  }
-  RETURN_NOT_OK(s);
-
-  *idx = key_iter->GetCurrentOrdinal();
-  return Status::OK();
+  return SeekToKey(key_iter, probe, idx);
 }
 
 Status CFileSet::CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
@@ -311,6 +333,52 @@ Status CFileSet::CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
   return Status::OK();
 }
 
+Status CFileSet::CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                                  bool* present, rowid_t* rowids,
+                                  ProbeStats* const* stats) const {
+  // Every row may be present until the bloom filters say otherwise.
+  std::fill(present, present + n, true);
+  if (FLAGS_consult_bloom_filters) {
+    RETURN_NOT_OK(bloom_reader_->Init());
+
+    vector<const BloomKeyProbe*> bloom_probes(n);
+    for (size_t i = 0; i < n; i++) {
+      bloom_probes[i] = &probes[i]->bloom_probe();
+      stats[i]->blooms_consulted++;
+    }
+    Status s = bloom_reader_->CheckKeysPresent(bloom_probes.data(), n, present);
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute("Unable to query bloom in $0: $1",
+          rowset_metadata_->bloom_block().ToString(), s.ToString());
+      if (PREDICT_FALSE(s.IsDiskFailure())) {
+        // If the bloom lookup failed because of a disk failure, return early
+        // since I/O to the tablet should be stopped.
+        return s;
+      }
+      // Continue with the slow path
+      std::fill(present, present + n, true);
+    }
+  }
+
+  unique_ptr<CFileIterator> key_iter;
+  for (size_t i = 0; i < n; i++) {
+    if (!present[i]) continue;
+    if (!key_iter) {
+      CFileIterator* iter = nullptr;
+      RETURN_NOT_OK(NewKeyIterator(&iter));
+      key_iter.reset(iter);
+    }
+    stats[i]->keys_consulted++;
+    boost::optional<rowid_t> idx;
+    RETURN_NOT_OK(SeekToKey(key_iter.get(), *probes[i], &idx));
+    present[i] = idx != boost::none;
+    if (present[i]) {
+      rowids[i] = *idx;
+    }
+  }
+  return Status::OK();
+}
+
 Status CFileSet::NewKeyIterator(CFileIterator **key_iter) const {
   RETURN_NOT_OK(key_index_reader()->Init());
   return key_index_reader()->NewIterator(key_iter, CFileReader::CACHE_BLOCK);
@@ -508,13 +576,114 @@ Status CFileSet::Iterator::InitializeSelectionVector(SelectionVector *sel_vec) {
   return Status::OK();
 }
 
+namespace {
+
+// Computes the [start, end) ranges of the first 'nrows' rows of 'sel' which
+// contain selected rows, merging the ranges separated by fewer than
+// 'min_skipped_rows' deselected rows, including from the ends of the batch.
+// The ranges are aligned to multiples of 8 rows, so that they start on a byte
+// of the column block's null bitmap.
+void GetSelectedRanges(const SelectionVector& sel, size_t nrows, size_t min_skipped_rows,
+                       vector<pair<size_t, size_t>>* ranges) {
+  const uint8_t* bitmap = sel.bitmap();
+  size_t row = 0;
+  size_t start;
+  while (row < nrows && BitmapFindFirstSet(bitmap, row, nrows, &start)) {
+    size_t end;
+    if (!BitmapFindFirstZero(bitmap, start, nrows, &end)) {
+      end = nrows;
+    }
+    start &= ~static_cast<size_t>(7);
+    end = std::min(nrows, (end + 7) & ~static_cast<size_t>(7));
+    if (ranges->empty()) {
+      ranges->emplace_back(start < min_skipped_rows ? 0 : start, end);
+    } else if (start < ranges->back().second + min_skipped_rows) {
+      ranges->back().second = end;
+    } else {
+      ranges->emplace_back(start, end);
+    }
+    row = end;
+  }
+  if (!ranges->empty() && nrows - ranges->back().second < min_skipped_rows) {
+    ranges->back().second = nrows;
+  }
+}
+
+} // anonymous namespace
+
+Status CFileSet::Iterator::MaterializeColumnRanges(ColumnMaterializationContext *ctx,
+                                                   const vector<pair<size_t, size_t>>& ranges) {
+  DCHECK(!cols_prepared_[ctx->col_idx()]);
+  ColumnIterator* iter = col_iters_[ctx->col_idx()].get();
+  ColumnBlock* dst = ctx->block();
+  for (const auto& range : ranges) {
+    rowid_t start_idx = cur_idx_ + range.first;
+    if (!iter->seeked() || iter->GetCurrentOrdinal() != start_idx) {
+      RETURN_NOT_OK(iter->SeekToOrdinal(start_idx));
+    }
+    size_t n = range.second - range.first;
+    RETURN_NOT_OK(iter->PrepareBatch(&n));
+    if (n != range.second - range.first) {
+      return Status::Corruption(
+          Substitute("Column $0 ($1) didn't yield enough rows at offset $2: expected $3 "
+                     "but only got $4", ctx->col_idx(),
+                     projection_->column(ctx->col_idx()).ToString(),
+                     start_idx, range.second - range.first, n));
+    }
+
+    DCHECK_EQ(0, range.first % 8);
+    ColumnBlock range_dst(dst->type_info(),
+                          dst->is_nullable() ? dst->null_bitmap() + range.first / 8 : nullptr,
+                          dst->data() + range.first * dst->stride(),
+                          n,
+                          dst->arena());
+    ColumnMaterializationContext range_ctx(ctx->col_idx(), nullptr, &range_dst, ctx->sel());
+    RETURN_NOT_OK(iter->Scan(&range_ctx));
+    RETURN_NOT_OK(iter->FinishBatch());
+  }
+  return Status::OK();
+}
+
 Status CFileSet::Iterator::MaterializeColumn(ColumnMaterializationContext *ctx) {
   CHECK_EQ(prepared_count_, ctx->block()->nrows());
   DCHECK_LT(ctx->col_idx(), col_iters_.size());
-
-  RETURN_NOT_OK(PrepareColumn(ctx));
   ColumnIterator* iter = col_iters_[ctx->col_idx()].get();
 
+  // A column without a predicate only needs the values of the selected rows:
+  // if the predicates on other columns (or deletions) left long runs of
+  // deselected rows, skip over them rather than decoding the whole batch.
+  int32_t min_skipped_rows = FLAGS_scan_late_materialization_min_skipped_rows;
+  if (ctx->pred() == nullptr && min_skipped_rows > 0 && !cols_prepared_[ctx->col_idx()]) {
+    vector<pair<size_t, size_t>> ranges;
+    GetSelectedRanges(*ctx->sel(), prepared_count_, min_skipped_rows, &ranges);
+    if (ranges.size() != 1 || ranges[0].second - ranges[0].first != prepared_count_) {
+      return MaterializeColumnRanges(ctx, ranges);
+    }
+  }
+
+  // If the predicate may be evaluated here rather than by the caller, first
+  // check it against the statistics of the blocks covering the batch: the
+  // column needn't be read at all if no value can match, nor evaluated if
+  // every value does.
+  if (ctx->DecoderEvalNotDisabled()) {
+    StatsMatch match;
+    RETURN_NOT_OK(iter->EvaluatePredicateOnStats(*ctx->pred(), cur_idx_, prepared_count_,
+                                                 &match));
+    if (match == StatsMatch::NONE) {
+      ctx->sel()->SetAllFalse();
+      ctx->SetDecoderEvalSupported();
+      return Status::OK();
+    }
+    if (match == StatsMatch::ALL) {
+      ColumnMaterializationContext copy_ctx(ctx->col_idx(), nullptr, ctx->block(), ctx->sel());
+      RETURN_NOT_OK(PrepareColumn(&copy_ctx));
+      RETURN_NOT_OK(iter->Scan(&copy_ctx));
+      ctx->SetDecoderEvalSupported();
+      return Status::OK();
+    }
+  }
+
+  RETURN_NOT_OK(PrepareColumn(ctx));
   RETURN_NOT_OK(iter->Scan(ctx));
 
   return Status::OK();
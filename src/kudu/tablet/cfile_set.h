@@ -111,6 +111,16 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
   Status CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                          rowid_t *rowid, ProbeStats* stats) const;
 
+  // Batched version of CheckRowPresent() for 'n' probes sorted by key: sets
+  // present[i], and rowids[i] if the row is present, for each probe, and
+  // updates stats[i].
+  //
+  // The bloom filters are checked for all the probes at once, and the keys
+  // which may be present are then looked up with a single key iterator.
+  Status CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                          bool* present, rowid_t* rowids,
+                          ProbeStats* const* stats) const;
+
   // Return true if there exists a CFile for the given column ID.
   bool has_data_for_column_id(ColumnId col_id) const {
     return ContainsKey(readers_by_col_id_, col_id);
@@ -230,6 +240,15 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Prepare the given column if not already prepared.
   Status PrepareColumn(ColumnMaterializationContext *ctx);
 
+  // Materialize the column of 'ctx' only for the given [start, end) row
+  // ranges of the batch, seeking the column iterator past the rows in between
+  // so that the blocks holding only those rows are never read.
+  //
+  // Each range is prepared, scanned and finished as a batch of its own, so
+  // the column is left unprepared for the rest of the batch.
+  Status MaterializeColumnRanges(ColumnMaterializationContext *ctx,
+                                 const std::vector<std::pair<size_t, size_t>>& ranges);
+
   const std::shared_ptr<CFileSet const> base_data_;
   const Schema* projection_;
 
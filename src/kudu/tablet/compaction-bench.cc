@@ -0,0 +1,189 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmark of the flush of a MemRowSet and of the compaction of the
+// resulting rowset, comparing the throughput of the writers with different
+// numbers of column writer threads.
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/clock/logical_clock.h"
+#include "kudu/common/row.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/timestamp.h"
+#include "kudu/consensus/log_anchor_registry.h"
+#include "kudu/consensus/opid.pb.h"
+#include "kudu/consensus/opid_util.h"
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/compaction.h"
+#include "kudu/tablet/diskrowset.h"
+#include "kudu/tablet/memrowset.h"
+#include "kudu/tablet/mvcc.h"
+#include "kudu/tablet/rowset_metadata.h"
+#include "kudu/tablet/tablet-test-util.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_mem_trackers.h"
+#include "kudu/util/random.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(num_rows, 200000, "The number of rows of the flushed MemRowSet");
+DEFINE_int32(num_int_columns, 8, "The number of INT64 value columns");
+DEFINE_int32(num_string_columns, 8, "The number of STRING value columns");
+DEFINE_int32(string_length, 32, "The length of the values of the STRING columns");
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+class CompactionBench : public KuduRowSetTest {
+ public:
+  CompactionBench()
+      : KuduRowSetTest(CreateSchema()),
+        clock_(clock::LogicalClock::CreateStartingAt(Timestamp::kInitialTimestamp)),
+        log_anchor_registry_(new log::LogAnchorRegistry()) {
+  }
+
+  // A wide schema, LZ4-compressed, so that most of the time of a flush is
+  // spent encoding and compressing the columns.
+  static Schema CreateSchema() {
+    SchemaBuilder builder;
+    CHECK_OK(builder.AddKeyColumn("key", INT64));
+    const ColumnStorageAttributes attrs(AUTO_ENCODING, LZ4);
+    for (int i = 0; i < FLAGS_num_int_columns; i++) {
+      CHECK_OK(builder.AddColumn(ColumnSchema(Substitute("i$0", i), INT64, false,
+                                              nullptr, nullptr, attrs), false));
+    }
+    for (int i = 0; i < FLAGS_num_string_columns; i++) {
+      CHECK_OK(builder.AddColumn(ColumnSchema(Substitute("s$0", i), STRING, true,
+                                              nullptr, nullptr, attrs), false));
+    }
+    return builder.BuildWithoutIds();
+  }
+
+ protected:
+  void FillMemRowSet(MemRowSet* mrs) {
+    Random rng(SeedRandom());
+    RowBuilder rb(schema_);
+    string str;
+    for (int64_t key = 0; key < FLAGS_num_rows; key++) {
+      rb.Reset();
+      rb.AddInt64(key);
+      for (int i = 0; i < FLAGS_num_int_columns; i++) {
+        rb.AddInt64(key * (i + 1) + rng.Uniform(1000));
+      }
+      for (int i = 0; i < FLAGS_num_string_columns; i++) {
+        if (rng.OneIn(10)) {
+          rb.AddNull();
+          continue;
+        }
+        str = StringPrintf("%0*u", FLAGS_string_length, rng.Next());
+        rb.AddString(Slice(str));
+      }
+      ScopedTransaction tx(&mvcc_, clock_->Now());
+      tx.StartApplying();
+      ASSERT_OK_FAST(mrs->Insert(tx.timestamp(), rb.row(), consensus::MaximumOpId()));
+      tx.Commit();
+    }
+  }
+
+  // Write 'input' with 'num_threads' column writer threads, and log the
+  // throughput of the writer.
+  void WriteInput(const string& op_name, CompactionInput* input, int num_threads,
+                  const MvccSnapshot& snap, vector<shared_ptr<DiskRowSet>>* rowsets) {
+    gscoped_ptr<ThreadPool> pool;
+    if (num_threads > 1) {
+      ASSERT_OK(ThreadPoolBuilder("rowset-writer")
+                .set_max_threads(num_threads)
+                .Build(&pool));
+    }
+    RollingDiskRowSetWriter writer(tablet()->metadata(), schema_,
+                                   Tablet::DefaultBloomSizing(),
+                                   64 * 1024 * 1024,
+                                   pool.get());
+    ASSERT_OK(writer.Open());
+    Stopwatch sw;
+    sw.start();
+    ASSERT_OK(FlushCompactionInput(input, snap, HistoryGcOpts::Disabled(), &writer));
+    ASSERT_OK(writer.Finish());
+    sw.stop();
+    ASSERT_EQ(FLAGS_num_rows, writer.written_count());
+    LOG(INFO) << Substitute("$0 with $1 column writer thread(s): $2 rows/sec ($3)",
+                            op_name, num_threads,
+                            static_cast<int64_t>(FLAGS_num_rows / sw.elapsed().wall_seconds()),
+                            sw.elapsed().ToString());
+
+    RowSetMetadataVector metas;
+    writer.GetWrittenRowSetMetadata(&metas);
+    for (const auto& meta : metas) {
+      shared_ptr<DiskRowSet> rs;
+      ASSERT_OK(DiskRowSet::Open(meta, log_anchor_registry_.get(), mem_trackers_, &rs));
+      rowsets->push_back(std::move(rs));
+    }
+  }
+
+  scoped_refptr<clock::LogicalClock> clock_;
+  MvccManager mvcc_;
+  scoped_refptr<log::LogAnchorRegistry> log_anchor_registry_;
+  TabletMemTrackers mem_trackers_;
+};
+
+TEST_F(CompactionBench, FlushAndCompact) {
+  shared_ptr<MemRowSet> mrs;
+  ASSERT_OK(MemRowSet::Create(0, schema_, log_anchor_registry_.get(),
+                              mem_trackers_.tablet_tracker, &mrs));
+  NO_FATALS(FillMemRowSet(mrs.get()));
+
+  for (int num_threads : { 1, 4, 16 }) {
+    MvccSnapshot snap(mvcc_);
+    gscoped_ptr<CompactionInput> flush_input(CompactionInput::Create(*mrs, &schema_, snap));
+    vector<shared_ptr<DiskRowSet>> flushed;
+    NO_FATALS(WriteInput("Flush", flush_input.get(), num_threads, snap, &flushed));
+
+    vector<shared_ptr<CompactionInput>> inputs;
+    for (const auto& rs : flushed) {
+      gscoped_ptr<CompactionInput> input;
+      ASSERT_OK(CompactionInput::Create(*rs, &schema_, snap, &input));
+      inputs.emplace_back(input.release());
+    }
+    gscoped_ptr<CompactionInput> merge(CompactionInput::Merge(inputs, &schema_));
+    vector<shared_ptr<DiskRowSet>> compacted;
+    NO_FATALS(WriteInput("Compaction", merge.get(), num_threads, snap, &compacted));
+  }
+}
+
+} // namespace tablet
+} // namespace kudu
@@ -75,6 +75,7 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_string(merge_benchmark_input_dir, "",
               "Directory to benchmark merge. The benchmark will merge "
@@ -281,7 +282,8 @@ class TestCompaction : public KuduRowSetTest {
     // This simplifies the test so we always need to reopen only a single rowset.
     RollingDiskRowSetWriter rsw(tablet()->metadata(), projection,
                                 Tablet::DefaultBloomSizing(),
-                                roll_threshold);
+                                roll_threshold,
+                                column_writer_pool_.get());
     ASSERT_OK(rsw.Open());
     ASSERT_OK(FlushCompactionInput(input, snap, HistoryGcOpts::Disabled(), &rsw));
     ASSERT_OK(rsw.Finish());
@@ -483,6 +485,9 @@ class TestCompaction : public KuduRowSetTest {
   scoped_refptr<LogAnchorRegistry> log_anchor_registry_;
 
   TabletMemTrackers mem_trackers_;
+
+  // If set, the columns of the flushed rowsets are written by this pool.
+  gscoped_ptr<ThreadPool> column_writer_pool_;
 };
 
 TEST_F(TestCompaction, TestMemRowSetInput) {
@@ -540,6 +545,58 @@ TEST_F(TestCompaction, TestFlushMRSWithRolling) {
             rows[1]);
 }
 
+// Test that flushing and compacting with a column writer pool produces the
+// same rowsets as doing it serially.
+TEST_F(TestCompaction, TestFlushAndCompactWithColumnWriterPool) {
+  const int kNumRows = 5000;
+  shared_ptr<MemRowSet> mrs;
+  ASSERT_OK(MemRowSet::Create(0, schema_, log_anchor_registry_.get(),
+                              mem_trackers_.tablet_tracker, &mrs));
+  InsertRows(mrs.get(), kNumRows, 0);
+  UpdateRows(mrs.get(), kNumRows / 2, 0, 1);
+  DeleteRows(mrs.get(), kNumRows / 10);
+
+  shared_ptr<DiskRowSet> serial_rs;
+  NO_FATALS(FlushMRSAndReopenNoRoll(*mrs, schema_, &serial_rs));
+  vector<string> serial_rows;
+  ASSERT_OK(serial_rs->DebugDump(&serial_rows));
+  vector<string> serial_compacted_rows;
+  {
+    shared_ptr<DiskRowSet> rs;
+    NO_FATALS(CompactAndReopenNoRoll({ serial_rs }, schema_, &rs));
+    ASSERT_OK(rs->DebugDump(&serial_compacted_rows));
+  }
+
+  ASSERT_OK(ThreadPoolBuilder("rowset-writer")
+            .set_max_threads(4)
+            .Build(&column_writer_pool_));
+  shared_ptr<DiskRowSet> parallel_rs;
+  NO_FATALS(FlushMRSAndReopenNoRoll(*mrs, schema_, &parallel_rs));
+  vector<string> parallel_rows;
+  ASSERT_OK(parallel_rs->DebugDump(&parallel_rows));
+  ASSERT_EQ(serial_rows, parallel_rows);
+  {
+    shared_ptr<DiskRowSet> rs;
+    NO_FATALS(CompactAndReopenNoRoll({ parallel_rs }, schema_, &rs));
+    vector<string> rows;
+    ASSERT_OK(rs->DebugDump(&rows));
+    ASSERT_EQ(serial_compacted_rows, rows);
+  }
+
+  // Rolling only happens between output blocks, and the parallel output
+  // blocks are larger, so only check that no row is lost.
+  vector<shared_ptr<DiskRowSet>> rowsets;
+  NO_FATALS(FlushMRSAndReopen(*mrs, schema_, kSmallRollThreshold, &rowsets));
+  ASSERT_GT(rowsets.size(), 1);
+  size_t num_rows = 0;
+  for (const auto& rs : rowsets) {
+    rowid_t count;
+    ASSERT_OK(rs->CountRows(&count));
+    num_rows += count;
+  }
+  ASSERT_EQ(kNumRows, num_rows);
+}
+
 TEST_F(TestCompaction, TestRowSetInput) {
   // Create a memrowset with a bunch of rows, flush and reopen.
   shared_ptr<DiskRowSet> rs;
@@ -75,6 +75,11 @@ namespace {
 // compaction.
 const int kCompactionOutputBlockNumRows = 100;
 
+// The number of rows we output at a time when the columns are encoded in
+// parallel. The blocks are larger so that the cost of handing off each
+// column to the pool is amortized over enough rows.
+const int kParallelCompactionOutputBlockNumRows = 1024;
+
 // Advances to the last mutation in a mutation list.
 void AdvanceToLastInList(const Mutation** m) {
   if (*m == nullptr) return;
@@ -119,18 +124,22 @@ class MemRowSetCompactionInput : public CompactionInput {
     }
 
     arena_.Reset();
+
+    // TODO(todd): A copy is performed to make all CompactionInputRow have the same schema
+    // Copy the whole leaf at once, which lets a memrowset with the columnar
+    // layout copy a column at a time.
+    RETURN_NOT_OK(iter_->ProjectRowsInLeaf(num_in_block, row_block_.get(), 0,
+                                           static_cast<Arena*>(nullptr)));
+
     RowChangeListEncoder undo_encoder(&buffer_);
     int next_row_index = 0;
     for (int i = 0; i < num_in_block; ++i) {
-      // TODO(todd): A copy is performed to make all CompactionInputRow have the same schema
       CompactionInputRow& input_row = block->at(next_row_index);
-      input_row.row.Reset(row_block_.get(), next_row_index);
+      input_row.row.Reset(row_block_.get(), i);
       Timestamp insertion_timestamp;
-      RETURN_NOT_OK(iter_->GetCurrentRow(&input_row.row,
-                                         static_cast<Arena*>(nullptr),
-                                         &input_row.redo_head,
-                                         &arena_,
-                                         &insertion_timestamp));
+      RETURN_NOT_OK(iter_->GetCurrentRowMutations(&input_row.redo_head,
+                                                  &arena_,
+                                                  &insertion_timestamp));
 
       // Handle the rare case where a row was inserted and deleted in the same operation.
       // This row can never be observed and should not be compacted/flushed. This saves
@@ -1101,12 +1110,19 @@ Status FlushCompactionInput(CompactionInput* input,
 
   DCHECK(out->schema().has_column_ids());
 
-  RowBlock block(out->schema(), kCompactionOutputBlockNumRows, nullptr);
+  // When the columns are encoded in parallel, the output block accumulates
+  // rows across input blocks, so their indirect data must be copied out of
+  // the input's arenas, which are reset by FinishBlock().
+  const bool accumulate = out->has_column_writer_pool();
+  Arena block_arena(32 * 1024);
+  RowBlock block(out->schema(),
+                 accumulate ? kParallelCompactionOutputBlockNumRows : kCompactionOutputBlockNumRows,
+                 accumulate ? &block_arena : nullptr);
 
+  int n = 0;
   while (input->HasMoreBlocks()) {
     RETURN_NOT_OK(input->PrepareBlock(&rows));
 
-    int n = 0;
     for (int i = 0; i < rows.size(); i++) {
       CompactionInputRow* input_row = &rows[i];
       RETURN_NOT_OK(out->RollIfNecessary());
@@ -1165,21 +1181,32 @@ Status FlushCompactionInput(CompactionInput* input,
       DVLOG(4) << "Output Row: " << dst_row.schema()->DebugRow(dst_row)
                << "; RowId: " << index_in_current_drs;
 
+      if (accumulate) {
+        RETURN_NOT_OK(RelocateIndirectDataToArena(&dst_row, &block_arena));
+      }
+
       n++;
       if (n == block.nrows()) {
         RETURN_NOT_OK(out->AppendBlock(block));
+        block_arena.Reset();
         n = 0;
       }
     }
 
-    if (n > 0) {
+    if (n > 0 && !accumulate) {
       block.Resize(n);
       RETURN_NOT_OK(out->AppendBlock(block));
       block.Resize(block.row_capacity());
+      n = 0;
     }
 
     RETURN_NOT_OK(input->FinishBlock());
   }
+
+  if (n > 0) {
+    block.Resize(n);
+    RETURN_NOT_OK(out->AppendBlock(block));
+  }
   return Status::OK();
 }
 
@@ -22,6 +22,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <glog/stl_logging.h>
 #include <gtest/gtest.h>
@@ -42,6 +43,9 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_double(workload_compaction_read_weight);
+
+using std::shared_ptr;
 using std::unordered_set;
 using std::string;
 using std::vector;
@@ -210,5 +214,61 @@ TEST_F(TestCompactionPolicy, KUDU2251) {
   ASSERT_GE(quality, 1.0);
 }
 
+// Test that the workload-aware policy prefers compacting the rowsets which
+// are read over the ones which aren't, even when compacting the latter would
+// reduce the overlap of the rowsets more.
+TEST_F(TestCompactionPolicy, TestWorkloadAwareSelection) {
+  // Three fully overlapping rowsets which are never read.
+  vector<shared_ptr<MockDiskRowSet>> cold = {
+    std::make_shared<MockDiskRowSet>("A", "B"),
+    std::make_shared<MockDiskRowSet>("A", "B"),
+    std::make_shared<MockDiskRowSet>("A", "B")
+  };
+  // Three partially overlapping rowsets which are probed by every write.
+  vector<shared_ptr<MockDiskRowSet>> hot = {
+    std::make_shared<MockDiskRowSet>("X0", "X6"),
+    std::make_shared<MockDiskRowSet>("X3", "X9"),
+    std::make_shared<MockDiskRowSet>("X5", "X8")
+  };
+  RowSetReadStats read_stats;
+  read_stats.bloom_probes = 10000;
+  read_stats.key_lookups = 10;
+  RowSetVector vec;
+  unordered_set<RowSet*> cold_set, hot_set;
+  for (const auto& rs : cold) {
+    vec.push_back(rs);
+    cold_set.insert(rs.get());
+  }
+  for (const auto& rs : hot) {
+    rs->set_read_stats(read_stats);
+    vec.push_back(rs);
+    hot_set.insert(rs.get());
+  }
+  RowSetTree tree;
+  ASSERT_OK(tree.Reset(vec));
+
+  // The budget only allows for one of the two groups to be compacted.
+  const int kBudgetMb = 3;
+  unordered_set<RowSet*> picked;
+  double quality = 0;
+  BudgetedCompactionPolicy budgeted(kBudgetMb);
+  ASSERT_OK(budgeted.PickRowSets(tree, &picked, &quality, nullptr));
+  ASSERT_EQ(cold_set, picked);
+
+  picked.clear();
+  WorkloadAwareCompactionPolicy workload_aware(kBudgetMb);
+  ASSERT_OK(workload_aware.PickRowSets(tree, &picked, &quality, nullptr));
+  ASSERT_EQ(hot_set, picked);
+  ASSERT_GT(quality, 0);
+
+  // Without any weight given to the reads, the policy behaves like the
+  // budgeted policy.
+  google::FlagSaver saver;
+  FLAGS_workload_compaction_read_weight = 0;
+  picked.clear();
+  ASSERT_OK(workload_aware.PickRowSets(tree, &picked, &quality, nullptr));
+  ASSERT_EQ(cold_set, picked);
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -18,9 +18,12 @@
 #include "kudu/tablet/compaction_policy.h"
 
 #include <algorithm>
+#include <cmath>
 #include <ostream>
+#include <memory>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -30,10 +33,13 @@
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/mathlimits.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_info.h"
+#include "kudu/tablet/rowset_tree.h"
 #include "kudu/tablet/svg_dump.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/knapsack_solver.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 using std::vector;
@@ -55,6 +61,22 @@ DEFINE_double(compaction_minimum_improvement, 0.01f,
               "improve the average height of DiskRowSets by at least this amount, the "
               "compaction will be considered ineligible.");
 
+DEFINE_int32(workload_compaction_read_rate_half_life_secs, 300,
+             "Half-life of the moving averages of the read rates of the rowsets, "
+             "when the workload-aware compaction policy is used. Reads older than "
+             "this count half as much towards the weight of a rowset.");
+TAG_FLAG(workload_compaction_read_rate_half_life_secs, experimental);
+
+DEFINE_double(workload_compaction_read_weight, 0.9,
+              "How much the weight of a rowset depends on its read rate, when the "
+              "workload-aware compaction policy is used. 0 makes the policy behave "
+              "like the budgeted compaction policy, and values close to 1 leave the "
+              "rowsets which are rarely read uncompacted.");
+TAG_FLAG(workload_compaction_read_weight, experimental);
+DEFINE_validator(workload_compaction_read_weight, [](const char* /*n*/, double v) {
+  return v >= 0 && v <= 1;
+});
+
 namespace kudu {
 namespace tablet {
 
@@ -77,6 +99,18 @@ namespace tablet {
 // here.
 static const double kSupportAdjust = 1.01;
 
+// The relative cost of the reads served by a rowset, used to compute its read
+// rate in the workload-aware policy. A bloom probe is usually answered from
+// the block cache, a key lookup seeks into the key index, and a scan seeks
+// into each projected column.
+static const double kBloomProbeCost = 1;
+static const double kKeyLookupCost = 10;
+static const double kScanCost = 50;
+
+// The lowest weight given to a rowset by the workload-aware policy, so that
+// tablets which hardly see any reads still have a well-defined cdf.
+static const double kMinRowSetWeight = 0.01;
+
 ////////////////////////////////////////////////////////////
 // BudgetedCompactionPolicy
 ////////////////////////////////////////////////////////////
@@ -95,7 +129,9 @@ uint64_t BudgetedCompactionPolicy::target_rowset_size() const {
 void BudgetedCompactionPolicy::SetupKnapsackInput(const RowSetTree &tree,
                                                   vector<RowSetInfo>* min_key,
                                                   vector<RowSetInfo>* max_key) {
-  RowSetInfo::CollectOrdered(tree, min_key, max_key);
+  std::unordered_map<RowSet*, double> weights;
+  ComputeRowSetWeights(tree, &weights);
+  RowSetInfo::CollectOrdered(tree, min_key, max_key, weights.empty() ? nullptr : &weights);
 
   if (min_key->size() < 2) {
     // require at least 2 rowsets to compact
@@ -476,5 +512,62 @@ Status BudgetedCompactionPolicy::PickRowSets(const RowSetTree &tree,
   return Status::OK();
 }
 
+////////////////////////////////////////////////////////////
+// WorkloadAwareCompactionPolicy
+////////////////////////////////////////////////////////////
+
+WorkloadAwareCompactionPolicy::WorkloadAwareCompactionPolicy(int size_budget_mb)
+  : BudgetedCompactionPolicy(size_budget_mb),
+    last_sample_time_(MonoTime::Now()) {
+}
+
+void WorkloadAwareCompactionPolicy::ComputeRowSetWeights(
+    const RowSetTree& tree,
+    std::unordered_map<RowSet*, double>* weights) {
+  const MonoTime now = MonoTime::Now();
+  const double elapsed_secs = std::max((now - last_sample_time_).ToSeconds(), 1e-3);
+  last_sample_time_ = now;
+  // The fraction of the previous moving average which is kept.
+  const double decay = std::exp2(-elapsed_secs /
+                                 std::max(FLAGS_workload_compaction_read_rate_half_life_secs, 1));
+
+  std::unordered_map<RowSet*, ReadRate> read_rates;
+  read_rates.reserve(tree.all_rowsets().size());
+  double total_rate = 0;
+  for (const auto& rs : tree.all_rowsets()) {
+    const RowSetReadStats stats = rs->GetReadStats();
+    ReadRate rate;
+    rate.rowset = rs;
+    rate.cost = stats.bloom_probes * kBloomProbeCost +
+                stats.key_lookups * kKeyLookupCost +
+                stats.scans * kScanCost;
+    const ReadRate* prev = FindOrNull(read_rates_, rs.get());
+    if (prev && prev->rowset.lock() == rs) {
+      double sample = std::max(rate.cost - prev->cost, 0.0) / elapsed_secs;
+      rate.rate = prev->rate * decay + sample * (1 - decay);
+    } else {
+      // There is no history for rowsets which weren't in the tree on the
+      // last call, e.g. because they were just flushed or compacted; take the
+      // reads they served since then at face value.
+      rate.rate = rate.cost / elapsed_secs;
+    }
+    total_rate += rate.rate;
+    read_rates.emplace(rs.get(), std::move(rate));
+  }
+  read_rates_.swap(read_rates);
+
+  if (total_rate <= 0) {
+    // Without reads, weigh the rowsets by size only, like the budgeted policy.
+    return;
+  }
+  // A rowset with the average read rate of the tablet has weight 1.
+  const double mean_rate = total_rate / read_rates_.size();
+  const double read_weight = FLAGS_workload_compaction_read_weight;
+  for (const auto& e : read_rates_) {
+    double weight = (1 - read_weight) + read_weight * e.second.rate / mean_rate;
+    InsertOrDie(weights, e.first, std::max(weight, kMinRowSetWeight));
+  }
+}
+
 } // namespace tablet
 } // namespace kudu
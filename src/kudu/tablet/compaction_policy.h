@@ -19,12 +19,15 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -86,6 +89,14 @@ class BudgetedCompactionPolicy : public CompactionPolicy {
 
   virtual uint64_t target_rowset_size() const OVERRIDE;
 
+ protected:
+  // Fills in 'weights' with the weight of the data of each rowset of 'tree'
+  // in the knapsack input. See RowSetInfo::CollectOrdered(). Rowsets which
+  // are left out have weight 1, which is the case of all rowsets unless a
+  // subclass overrides this.
+  virtual void ComputeRowSetWeights(const RowSetTree& tree,
+                                    std::unordered_map<RowSet*, double>* weights) {}
+
  private:
   struct SolutionAndValue {
     std::unordered_set<RowSet*> rowsets;
@@ -127,6 +138,45 @@ class BudgetedCompactionPolicy : public CompactionPolicy {
   size_t size_budget_mb_;
 };
 
+// Budgeted compaction policy which also takes into account how the rowsets
+// are read. Each rowset is weighted by the rate of scans, bloom filter probes
+// and key lookups it has recently served, relative to the other rowsets of
+// the tablet, so that compacting the key ranges which are read the most is
+// worth more than compacting the same amount of overlap in key ranges which
+// are rarely read.
+//
+// The read rates are exponentially-weighted moving averages which are
+// updated on each call to PickRowSets(). Callers of PickRowSets() must
+// already synchronize it, so that state is not otherwise protected.
+class WorkloadAwareCompactionPolicy : public BudgetedCompactionPolicy {
+ public:
+  explicit WorkloadAwareCompactionPolicy(int size_budget_mb);
+
+ protected:
+  virtual void ComputeRowSetWeights(const RowSetTree& tree,
+                                    std::unordered_map<RowSet*, double>* weights) OVERRIDE;
+
+ private:
+  struct ReadRate {
+    // Used to tell whether the RowSet this entry was created for is still
+    // alive, since the address of a destroyed RowSet may be reused.
+    std::weak_ptr<RowSet> rowset;
+
+    // The cost of the reads served by the rowset as of the last sample.
+    double cost = 0;
+
+    // The moving average of the cost of the reads served per second.
+    double rate = 0;
+  };
+
+  // The read rates of the rowsets of the tree passed to the last call
+  // of PickRowSets().
+  std::unordered_map<RowSet*, ReadRate> read_rates_;
+
+  // The time at which 'read_rates_' was last sampled.
+  MonoTime last_sample_time_;
+};
+
 } // namespace tablet
 } // namespace kudu
 #endif
@@ -767,6 +767,24 @@ class LeafNode : public NodeBase<Traits> {
     *v = vals_[idx];
   }
 
+  // Return true if the given key can only belong in this leaf node: either
+  // it falls between the first and last keys of the node, or it is after
+  // the last key and this is the rightmost leaf of the tree.
+  //
+  // Since leaf nodes are never merged or removed from the tree, this is
+  // valid as long as the caller holds the lock.
+  bool CoversKey(const Slice &key) {
+    DCHECK(this->IsLocked());
+    if (num_entries_ == 0) {
+      // Only the root of an empty tree has no entries.
+      return next_ == NULL;
+    }
+    if (key.compare(GetKey(0)) < 0) {
+      return false;
+    }
+    return next_ == NULL || key.compare(GetKey(num_entries_ - 1)) <= 0;
+  }
+
   // Truncates the node, removing entries from the right to reduce
   // to the new size.
   // Caller must hold the node's lock with the SPLITTING flag set.
@@ -864,6 +882,21 @@ class PreparedMutation {
     needs_unlock_ = true;
   }
 
+  // Same as Prepare(), but first tries the leaf node 'hint', typically
+  // the leaf() of the mutation which inserted the previous key. If the key
+  // belongs in that leaf, as when inserting keys in increasing order, this
+  // skips the traversal from the root. 'hint' may be NULL.
+  //
+  // After Insert(), leaf() returns the leaf where the key was inserted.
+  void PrepareWithHint(CBTree<Traits> *tree, LeafNode<Traits> *hint) {
+    debug::ScopedTSANIgnoreReadsAndWrites ignore_tsan;
+    CHECK(!prepared());
+    this->tree_ = tree;
+    this->arena_ = tree->arena_.get();
+    tree->PrepareMutationWithHint(this, hint);
+    needs_unlock_ = true;
+  }
+
   bool Insert(const Slice &val) {
     CHECK(prepared());
     return tree_->Insert(this, val);
@@ -1288,6 +1321,20 @@ class CBTree {
     }
   }
 
+  void PrepareMutationWithHint(PreparedMutation<Traits> *mutation,
+                               LeafNode<Traits> *hint) {
+    DCHECK_EQ(mutation->tree(), this);
+    if (hint != NULL) {
+      hint->Lock();
+      if (hint->CoversKey(mutation->key())) {
+        hint->PrepareMutation(mutation);
+        return;
+      }
+      hint->Unlock();
+    }
+    PrepareMutation(mutation);
+  }
+
   // Inserts the given key/value into the prepared leaf node.
   // If the leaf node is already full, handles splitting it and
   // propagating splits up the tree.
@@ -1693,7 +1740,9 @@ class CBTreeIterator {
   void GetEntryInLeaf(size_t idx, Slice *key, Slice *val) {
     DCHECK(seeked_);
     DCHECK_LT(idx, leaf_to_scan_->num_entries());
-    leaf_to_scan_->Get(idx, key, val);
+    ValueSlice val_slice;
+    leaf_to_scan_->Get(idx, key, &val_slice);
+    *val = val_slice.as_slice();
   }
 
  private:
@@ -44,6 +44,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/tablet/delta_stats.h"
 #include "kudu/tablet/delta_store.h"
@@ -53,6 +54,7 @@
 #include "kudu/util/faststring.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
@@ -67,6 +69,7 @@ using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace tablet {
@@ -417,5 +420,151 @@ TEST_F(TestDeltaFile, TestEmptyFileIsAborted) {
   ASSERT_TRUE(s.IsNotFound()) << s.ToString();
 }
 
+// Check that deletes, reinserts and updates of the same rows are applied with
+// the last mutation of each row winning, including across batch boundaries
+// that don't line up with whole bytes of the selection vector.
+TEST_F(TestDeltaFile, TestApplyDeletesAndReinserts) {
+  const int kNumRows = 1000;
+  unique_ptr<WritableBlock> block;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &block));
+  test_block_ = block->id();
+  {
+    DeltaFileWriter dfw(std::move(block));
+    ASSERT_OK(dfw.Start());
+    faststring buf;
+    DeltaStats stats;
+    auto append = [&](rowid_t row, int64_t timestamp) {
+      DeltaKey key(row, Timestamp(timestamp));
+      RowChangeList rcl(buf);
+      ASSERT_OK_FAST(dfw.AppendDelta<REDO>(key, rcl));
+      ASSERT_OK_FAST(stats.UpdateStats(key.timestamp(), rcl));
+    };
+    for (rowid_t row = 0; row < kNumRows; row++) {
+      if (row % 4 == 1) {
+        // Delete every fourth row, and reinsert every other deleted row.
+        buf.clear();
+        RowChangeListEncoder(&buf).SetToDelete();
+        NO_FATALS(append(row, 1));
+        if (row % 8 == 1) {
+          buf.clear();
+          RowChangeListEncoder reinsert(&buf);
+          reinsert.SetToReinsert();
+          uint32_t new_val = row + 1;
+          reinsert.AddColumnUpdate(schema_.column(0), schema_.column_id(0), &new_val);
+          NO_FATALS(append(row, 2));
+        }
+      } else if (row % 4 == 2) {
+        buf.clear();
+        RowChangeListEncoder update(&buf);
+        uint32_t new_val = row;
+        update.AddColumnUpdate(schema_.column(0), schema_.column_id(0), &new_val);
+        NO_FATALS(append(row, 1));
+      }
+    }
+    dfw.WriteDeltaStats(stats);
+    ASSERT_OK(dfw.Finish());
+  }
+
+  gscoped_ptr<DeltaIterator> it;
+  ASSERT_OK(OpenDeltaFileIterator(test_block_, &it));
+  ASSERT_OK(it->Init(nullptr));
+  ASSERT_OK(it->SeekToOrdinal(0));
+
+  const int kBatchSize = 77;
+  RowBlock row_block(schema_, kBatchSize, &arena_);
+  for (rowid_t start_row = 0; start_row < kNumRows; start_row += kBatchSize) {
+    int nrows = std::min<int>(kBatchSize, kNumRows - start_row);
+    row_block.Resize(nrows);
+    row_block.ZeroMemory();
+    row_block.selection_vector()->SetAllTrue();
+    ASSERT_OK_FAST(it->PrepareBatch(nrows, DeltaIterator::PREPARE_FOR_APPLY));
+    ColumnBlock dst_col = row_block.column_block(0);
+    ASSERT_OK_FAST(it->ApplyUpdates(0, &dst_col));
+    ASSERT_OK_FAST(it->ApplyDeletes(row_block.selection_vector()));
+
+    for (int i = 0; i < nrows; i++) {
+      rowid_t row = start_row + i;
+      bool should_be_selected = row % 4 != 1 || row % 8 == 1;
+      ASSERT_EQ(should_be_selected, row_block.selection_vector()->IsRowSelected(i))
+          << "row " << row;
+      uint32_t expected_val = 0;
+      if (row % 8 == 1) {
+        expected_val = row + 1;
+      } else if (row % 4 == 2) {
+        expected_val = row;
+      }
+      ASSERT_EQ(expected_val, *schema_.ExtractColumnFromRow<UINT32>(row_block.row(i), 0))
+          << "row " << row;
+    }
+  }
+}
+
+// Benchmark of the application of a delta file to a column and a selection
+// vector, parameterized by the fraction of rows that are updated. A tenth as
+// many rows are deleted.
+class TestDeltaFileApplyDensity : public TestDeltaFile,
+                                  public ::testing::WithParamInterface<double> {
+};
+
+INSTANTIATE_TEST_CASE_P(Densities, TestDeltaFileApplyDensity,
+                        ::testing::Values(0.001, 0.01, 0.1, 0.5, 1.0));
+
+TEST_P(TestDeltaFileApplyDensity, BenchmarkApply) {
+  const double density = GetParam();
+  const int kNumRows = AllowSlowTests() ? 10000000 : 100000;
+  const int update_every = std::max<int>(1, 1 / density);
+  const int delete_every = update_every * 10;
+
+  unique_ptr<WritableBlock> block;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &block));
+  test_block_ = block->id();
+  {
+    DeltaFileWriter dfw(std::move(block));
+    ASSERT_OK(dfw.Start());
+    faststring buf;
+    DeltaStats stats;
+    for (rowid_t row = 0; row < kNumRows; row++) {
+      buf.clear();
+      RowChangeListEncoder enc(&buf);
+      if (row % delete_every == 0) {
+        enc.SetToDelete();
+      } else if (row % update_every == 0) {
+        uint32_t new_val = row;
+        enc.AddColumnUpdate(schema_.column(0), schema_.column_id(0), &new_val);
+      } else {
+        continue;
+      }
+      DeltaKey key(row, Timestamp(0));
+      RowChangeList rcl(buf);
+      ASSERT_OK_FAST(dfw.AppendDelta<REDO>(key, rcl));
+      ASSERT_OK_FAST(stats.UpdateStats(key.timestamp(), rcl));
+    }
+    dfw.WriteDeltaStats(stats);
+    ASSERT_OK(dfw.Finish());
+  }
+
+  gscoped_ptr<DeltaIterator> it;
+  ASSERT_OK(OpenDeltaFileIterator(test_block_, &it));
+  ASSERT_OK(it->Init(nullptr));
+  RowBlock row_block(schema_, 1000, &arena_);
+  size_t num_selected = 0;
+  LOG_TIMING(INFO, Substitute("Applying deltas to $0 rows with density $1",
+                              kNumRows, density)) {
+    for (int i = 0; i < FLAGS_n_verify; i++) {
+      ASSERT_OK(it->SeekToOrdinal(0));
+      num_selected = 0;
+      for (rowid_t start_row = 0; start_row < kNumRows; start_row += row_block.nrows()) {
+        row_block.selection_vector()->SetAllTrue();
+        ASSERT_OK_FAST(it->PrepareBatch(row_block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
+        ColumnBlock dst_col = row_block.column_block(0);
+        ASSERT_OK_FAST(it->ApplyUpdates(0, &dst_col));
+        ASSERT_OK_FAST(it->ApplyDeletes(row_block.selection_vector()));
+        num_selected += row_block.selection_vector()->CountSelected();
+      }
+    }
+  }
+  ASSERT_EQ(kNumRows - (kNumRows + delete_every - 1) / delete_every, num_selected);
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/deltafile.h"
 
+#include <cstring>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -49,6 +50,7 @@
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/tablet.pb.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
@@ -408,6 +410,8 @@ DeltaFileIterator::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
       prepared_(false),
       exhausted_(false),
       initted_(false),
+      deltas_decoded_(false),
+      has_liveness_changes_(false),
       delta_type_(delta_type),
       cache_blocks_(CFileReader::CACHE_BLOCK) {}
 
@@ -463,6 +467,7 @@ Status DeltaFileIterator::SeekToOrdinal(rowid_t idx) {
   prepared_idx_ = idx;
   prepared_count_ = 0;
   prepared_ = false;
+  deltas_decoded_ = false;
   delta_blocks_.clear();
   exhausted_ = false;
   return Status::OK();
@@ -583,6 +588,7 @@ Status DeltaFileIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   prepared_idx_ = start_row;
   prepared_count_ = nrows;
   prepared_ = true;
+  deltas_decoded_ = false;
   return Status::OK();
 }
 
@@ -680,140 +686,175 @@ inline bool IsUndoRelevant(const MvccSnapshot& snap,
   return true;
 }
 
+// Visitor which decodes the relevant mutations of the prepared row range into
+// the per-column updates and the liveness bitmaps of the iterator.
 template<DeltaType Type>
-struct ApplyingVisitor {
+struct DecodingVisitor {
 
   Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
 
-  inline Status ApplyMutation(const DeltaKey &key, const Slice &deltas) {
+  inline Status DecodeMutation(const DeltaKey &key, const Slice &deltas) {
     int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
     DCHECK_GE(rel_idx, 0);
 
-    // TODO(todd): this code looks eerily similar to DMSIterator::ApplyUpdates!
-    // I bet it can be combined.
-
-    const Schema* schema = dfi->opts_.projection;
     RowChangeListDecoder decoder((RowChangeList(deltas)));
     RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update() || decoder.is_reinsert()) {
-      return decoder.ApplyToOneColumn(rel_idx, dst, *schema, col_to_apply, dst->arena());
+    if (decoder.is_delete()) {
+      BitmapSet(dfi->deleted_rows_.data(), rel_idx);
+      BitmapClear(dfi->reinserted_rows_.data(), rel_idx);
+      dfi->has_liveness_changes_ = true;
+      return Status::OK();
+    }
+    if (decoder.is_reinsert()) {
+      BitmapClear(dfi->deleted_rows_.data(), rel_idx);
+      BitmapSet(dfi->reinserted_rows_.data(), rel_idx);
+      dfi->has_liveness_changes_ = true;
     }
 
-    DCHECK(decoder.is_delete());
-    // If it's a DELETE, then it will be processed by LivenessVisitor.
+    const Schema* schema = dfi->opts_.projection;
+    while (decoder.HasNext()) {
+      RowChangeListDecoder::DecodedUpdate dec;
+      RETURN_NOT_OK(decoder.DecodeNext(&dec));
+      int col_idx;
+      const void* unused;
+      RETURN_NOT_OK(dec.Validate(*schema, &col_idx, &unused));
+      if (col_idx == Schema::kColumnNotFound) {
+        continue;
+      }
+      dfi->decoded_updates_[col_idx].push_back({ static_cast<rowid_t>(rel_idx),
+                                                 dec.null, dec.raw_value });
+    }
     return Status::OK();
   }
 
   DeltaFileIterator *dfi;
-  size_t col_to_apply;
-  ColumnBlock *dst;
 };
 
 template<>
-inline Status ApplyingVisitor<REDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<REDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsRedoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied redo delta";
-    return ApplyMutation(key, deltas);
+    return DecodeMutation(key, deltas);
   }
   DVLOG(3) << "Redo delta uncommitted, skipped applying.";
   return Status::OK();
 }
 
 template<>
-inline Status ApplyingVisitor<UNDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<UNDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsUndoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied undo delta";
-    return ApplyMutation(key, deltas);
+    return DecodeMutation(key, deltas);
   }
   DVLOG(3) << "Undo delta committed, skipped applying.";
   return Status::OK();
 }
 
-Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
-  DCHECK_LE(prepared_count_, dst->nrows());
+Status DeltaFileIterator::DecodeDeltasIfNecessary() {
+  DCHECK(prepared_) << "must Prepare";
+  if (deltas_decoded_) {
+    return Status::OK();
+  }
+
+  const Schema* schema = opts_.projection;
+  decoded_updates_.resize(schema->num_columns());
+  for (auto& updates : decoded_updates_) {
+    updates.clear();
+  }
+  size_t bitmap_size = BitmapSize(prepared_count_);
+  deleted_rows_.resize(bitmap_size);
+  reinserted_rows_.resize(bitmap_size);
+  memset(deleted_rows_.data(), 0, bitmap_size);
+  memset(reinserted_rows_.data(), 0, bitmap_size);
+  has_liveness_changes_ = false;
 
   if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO mutations to " << col_to_apply;
-    ApplyingVisitor<REDO> visitor = {this, col_to_apply, dst};
-    return VisitMutations(&visitor);
+    DecodingVisitor<REDO> visitor = { this };
+    RETURN_NOT_OK(VisitMutations(&visitor));
+  } else {
+    DecodingVisitor<UNDO> visitor = { this };
+    RETURN_NOT_OK(VisitMutations(&visitor));
   }
-  DVLOG(3) << "Applying UNDO mutations to " << col_to_apply;
-  ApplyingVisitor<UNDO> visitor = {this, col_to_apply, dst};
-  return VisitMutations(&visitor);
+  deltas_decoded_ = true;
+  return Status::OK();
 }
 
-// Visitor which establishes the liveness of a row by applying deletes and reinserts.
-template<DeltaType Type>
-struct LivenessVisitor {
-
-  Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
-
-  inline Status ApplyDelete(const DeltaKey &key, const Slice &deltas) {
-    int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
-    DCHECK_GE(rel_idx, 0);
-
-    RowChangeListDecoder decoder((RowChangeList(deltas)));
-    RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update()) {
-      DVLOG(3) << "Didn't delete row (update)";
-      // If this is an update the row must be selected.
-      DCHECK(sel_vec->IsRowSelected(rel_idx));
-      return Status::OK();
-    }
-
-    if (decoder.is_delete()) {
-      DVLOG(3) << "Row deleted";
-      sel_vec->SetRowUnselected(rel_idx);
-      return Status::OK();
-    }
+Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
+  DCHECK_LE(prepared_count_, dst->nrows());
+  DVLOG(3) << "Applying " << DeltaType_Name(delta_type_) << " mutations to " << col_to_apply;
+  RETURN_NOT_OK(DecodeDeltasIfNecessary());
 
-    DCHECK(decoder.is_reinsert());
-    DVLOG(3) << "Re-selected the row (reinsert)";
-    // If this is a reinsert the row must be unselected.
-    DCHECK(!sel_vec->IsRowSelected(rel_idx));
-    sel_vec->SetRowSelected(rel_idx);
+  const vector<DecodedCellUpdate>& updates = decoded_updates_[col_to_apply];
+  if (updates.empty()) {
     return Status::OK();
   }
+  const ColumnSchema& col_schema = opts_.projection->column(col_to_apply);
+  const bool nullable = dst->is_nullable();
 
-  DeltaFileIterator *dfi;
-  SelectionVector *sel_vec;
-};
-
-template<>
-inline Status LivenessVisitor<REDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas,
-                                           bool* continue_visit) {
-  if (IsRedoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
+  if (col_schema.type_info()->physical_type() == BINARY) {
+    Arena* arena = dst->arena();
+    for (const DecodedCellUpdate& u : updates) {
+      if (nullable) {
+        dst->SetCellIsNull(u.rel_idx, u.is_null);
+      }
+      if (u.is_null) {
+        continue;
+      }
+      Slice copy;
+      if (PREDICT_FALSE(!arena->RelocateSlice(u.value, &copy))) {
+        return Status::IOError("out of memory copying slice", u.value.ToString());
+      }
+      dst->SetCellValue(u.rel_idx, &copy);
+    }
+    return Status::OK();
   }
-  return Status::OK();
-}
 
-template<>
-inline Status LivenessVisitor<UNDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas, bool*
-                                           continue_visit) {
-  if (IsUndoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
+  // Fixed-size cells are copied straight from the delta blocks.
+  if (nullable) {
+    for (const DecodedCellUpdate& u : updates) {
+      dst->SetCellIsNull(u.rel_idx, u.is_null);
+      if (!u.is_null) {
+        dst->SetCellValue(u.rel_idx, u.value.data());
+      }
+    }
+  } else {
+    for (const DecodedCellUpdate& u : updates) {
+      dst->SetCellValue(u.rel_idx, u.value.data());
+    }
   }
   return Status::OK();
 }
 
-
 Status DeltaFileIterator::ApplyDeletes(SelectionVector *sel_vec) {
   DCHECK_LE(prepared_count_, sel_vec->nrows());
-  if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO deletes";
-    LivenessVisitor<REDO> visitor = { this, sel_vec };
-    return VisitMutations(&visitor);
+  DVLOG(3) << "Applying " << DeltaType_Name(delta_type_) << " deletes";
+  RETURN_NOT_OK(DecodeDeltasIfNecessary());
+  if (!has_liveness_changes_) {
+    return Status::OK();
   }
-  DVLOG(3) << "Applying UNDO deletes";
-  LivenessVisitor<UNDO> visitor = { this, sel_vec };
-  return VisitMutations(&visitor);
+
+  // A row ends up selected if its last liveness change is a REINSERT, and
+  // unselected if it's a DELETE. The bits past 'prepared_count_' are clear
+  // in both bitmaps, so whole words can be used.
+  uint8_t* sel = sel_vec->mutable_bitmap();
+  const uint8_t* deleted = deleted_rows_.data();
+  const uint8_t* reinserted = reinserted_rows_.data();
+  size_t nbytes = deleted_rows_.size();
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+    uint64_t s, d, r;
+    memcpy(&s, sel + i, sizeof(s));
+    memcpy(&d, deleted + i, sizeof(d));
+    memcpy(&r, reinserted + i, sizeof(r));
+    s = (s & ~d) | r;
+    memcpy(sel + i, &s, sizeof(s));
+  }
+  for (; i < nbytes; i++) {
+    sel[i] = (sel[i] & ~deleted[i]) | reinserted[i];
+  }
+  return Status::OK();
 }
 
 // Visitor which, for each mutation, adds it into a ColumnBlock of
@@ -76,11 +76,9 @@ namespace tablet {
 
 class Mutation;
 template<DeltaType Type>
-struct ApplyingVisitor;
-template<DeltaType Type>
 struct CollectingVisitor;
 template<DeltaType Type>
-struct LivenessVisitor;
+struct DecodingVisitor;
 
 class DeltaFileWriter {
  public:
@@ -243,12 +241,10 @@ class DeltaFileIterator : public DeltaIterator {
 
  private:
   friend class DeltaFileReader;
-  friend struct ApplyingVisitor<REDO>;
-  friend struct ApplyingVisitor<UNDO>;
   friend struct CollectingVisitor<REDO>;
   friend struct CollectingVisitor<UNDO>;
-  friend struct LivenessVisitor<REDO>;
-  friend struct LivenessVisitor<UNDO>;
+  friend struct DecodingVisitor<REDO>;
+  friend struct DecodingVisitor<UNDO>;
   friend struct FilterAndAppendVisitor;
 
   DISALLOW_COPY_AND_ASSIGN(DeltaFileIterator);
@@ -312,6 +308,11 @@ class DeltaFileIterator : public DeltaIterator {
   template<class Visitor>
   Status VisitMutations(Visitor *visitor);
 
+  // Decode the relevant deltas of the prepared row range into
+  // 'decoded_updates_' and the liveness bitmaps, unless this was already done
+  // since the last PrepareBatch().
+  Status DecodeDeltasIfNecessary();
+
   // Log a FATAL error message about a bad delta.
   void FatalUnexpectedDelta(const DeltaKey &key, const Slice &deltas,
                             const std::string &msg);
@@ -333,6 +334,37 @@ class DeltaFileIterator : public DeltaIterator {
   // which correspond to prepared_block_.
   std::deque<std::unique_ptr<PreparedDeltaBlock>> delta_blocks_;
 
+  // An update of a cell of a prepared row, decoded from a RowChangeList.
+  struct DecodedCellUpdate {
+    // The index of the row, relative to prepared_idx_.
+    rowid_t rel_idx;
+
+    // Whether the cell is set to NULL.
+    bool is_null;
+
+    // The new value of the cell, as in RowChangeListDecoder::DecodedUpdate:
+    // the cell itself for fixed-size types, or the string for BINARY ones.
+    // Points into the delta blocks, so is only valid until the next
+    // PrepareBatch().
+    Slice value;
+  };
+
+  // Whether the deltas of the prepared row range have been decoded.
+  bool deltas_decoded_;
+
+  // The relevant updates of the prepared row range, for each column of the
+  // projection, in the order they must be applied. Decoding the deltas once
+  // per batch, rather than once per column, lets ApplyUpdates() copy the
+  // cells of a column with a tight loop.
+  std::vector<std::vector<DecodedCellUpdate>> decoded_updates_;
+
+  // Bitmaps with a bit per prepared row, set for the rows whose last
+  // relevant DELETE or REINSERT was, respectively, a DELETE or a REINSERT.
+  // ApplyDeletes() applies them a word at a time.
+  faststring deleted_rows_;
+  faststring reinserted_rows_;
+  bool has_liveness_changes_;
+
   // Temporary buffer used in seeking.
   faststring tmp_buf_;
 
@@ -50,6 +50,7 @@
 #include "kudu/tablet/diskrowset-test-base.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_key_ranges.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/tablet.h"
@@ -65,6 +66,7 @@ DEFINE_double(update_fraction, 0.1f, "fraction of rows to update");
 DECLARE_bool(cfile_lazy_open);
 DECLARE_bool(crash_on_eio);
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(rowset_max_key_ranges);
 DECLARE_double(env_inject_eio);
 DECLARE_double(tablet_delta_store_major_compact_min_ratio);
 DECLARE_int32(tablet_delta_store_minor_compact_max);
@@ -82,6 +84,35 @@ namespace tablet {
 // TODO: add test which calls CopyNextRows on an iterator with no more
 // rows - i think it segfaults!
 
+// Test that the key ranges of a rowset are stored in its metadata by default,
+// and returned by GetKeyRanges().
+TEST_F(TestRowSet, TestKeyRangesStoredByDefault) {
+  WriteTestRowSet(1000);
+  vector<EncodedKeyRange> stored_ranges = rowset_meta_->key_ranges();
+  ASSERT_FALSE(stored_ranges.empty());
+  ASSERT_LE(stored_ranges.size(), static_cast<size_t>(FLAGS_rowset_max_key_ranges));
+
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  vector<EncodedKeyRange> ranges;
+  ASSERT_OK(rs->GetKeyRanges(&ranges));
+  ASSERT_EQ(stored_ranges, ranges);
+}
+
+// Test that no key ranges are stored with --rowset_max_key_ranges=0, in which
+// case the bounds of the rowset are its only range.
+TEST_F(TestRowSet, TestKeyRangesDisabled) {
+  FLAGS_rowset_max_key_ranges = 0;
+  WriteTestRowSet(1000);
+  ASSERT_TRUE(rowset_meta_->key_ranges().empty());
+
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  vector<EncodedKeyRange> ranges;
+  ASSERT_OK(rs->GetKeyRanges(&ranges));
+  ASSERT_EQ(1, ranges.size());
+}
+
 // Test round-trip writing and reading back a rowset with
 // multiple columns. Does not test any modifications.
 TEST_F(TestRowSet, TestRowSetRoundTrip) {
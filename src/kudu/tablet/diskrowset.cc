@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <map>
 #include <ostream>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -76,10 +77,18 @@ DEFINE_int32(default_composite_key_index_block_size_bytes, 4096,
 TAG_FLAG(default_composite_key_index_block_size_bytes, experimental);
 
 DEFINE_bool(rowset_metadata_store_keys, false,
-            "Whether to store the min/max encoded keys in the rowset "
-            "metadata. If false, keys will be read from the data blocks.");
+            "Whether to store the min/max encoded keys in the rowset metadata. "
+            "If false, keys will be read from the data blocks.");
 TAG_FLAG(rowset_metadata_store_keys, experimental);
 
+DEFINE_int32(rowset_max_key_ranges, 16,
+             "The maximum number of disjoint key ranges by which the keys of a "
+             "flushed or compacted rowset are summarized in its metadata. Point "
+             "lookups skip the rowsets which have no range holding their key. "
+             "If 0, no ranges are stored and only the min and max keys of rowsets "
+             "are used.");
+TAG_FLAG(rowset_max_key_ranges, advanced);
+
 namespace kudu {
 
 class Mutex;
@@ -96,6 +105,7 @@ using fs::BlockCreationTransaction;
 using fs::CreateBlockOptions;
 using fs::WritableBlock;
 using log::LogAnchorRegistry;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -106,12 +116,15 @@ const char *DiskRowSet::kMaxKeyMetaEntryName = "max_key";
 
 DiskRowSetWriter::DiskRowSetWriter(RowSetMetadata* rowset_metadata,
                                    const Schema* schema,
-                                   BloomFilterSizing bloom_sizing)
+                                   BloomFilterSizing bloom_sizing,
+                                   ThreadPool* column_writer_pool)
     : rowset_metadata_(rowset_metadata),
       schema_(schema),
       bloom_sizing_(bloom_sizing),
+      column_writer_pool_(column_writer_pool),
       finished_(false),
-      written_count_(0) {
+      written_count_(0),
+      key_ranges_builder_(std::max(1, FLAGS_rowset_max_key_ranges)) {
   CHECK(schema->has_column_ids());
 }
 
@@ -120,7 +133,7 @@ Status DiskRowSetWriter::Open() {
 
   FsManager* fs = rowset_metadata_->fs_manager();
   const string& tablet_id = rowset_metadata_->tablet_metadata()->tablet_id();
-  col_writer_.reset(new MultiColumnWriter(fs, schema_, tablet_id));
+  col_writer_.reset(new MultiColumnWriter(fs, schema_, tablet_id, column_writer_pool_));
   RETURN_NOT_OK(col_writer_->Open());
 
   // Open bloom filter.
@@ -197,11 +210,21 @@ Status DiskRowSetWriter::AppendBlock(const RowBlock &block) {
     last_encoded_key_.clear();
   }
 
-  // Write the batch to each of the columns
-  RETURN_NOT_OK(col_writer_->AppendBlock(block));
+  // Write the batch to each of the columns. If they are written by the
+  // column writer pool, encode the keys meanwhile.
+  col_writer_->StartAppendBlock(block);
+  Status s = AppendKeys(block);
+  RETURN_NOT_OK(col_writer_->WaitForAppendBlock());
+  RETURN_NOT_OK(s);
 
+  written_count_ += block.nrows();
+
+  return Status::OK();
+}
+
+Status DiskRowSetWriter::AppendKeys(const RowBlock& block) {
 #ifndef NDEBUG
-    faststring prev_key;
+  faststring prev_key;
 #endif
 
   // Write the batch to the bloom and optionally the ad-hoc index
@@ -216,6 +239,9 @@ Status DiskRowSetWriter::AppendBlock(const RowBlock &block) {
     // Insert the encoded key into the bloom.
     Slice enc_key = schema_->EncodeComparableKey(row, &last_encoded_key_);
     RETURN_NOT_OK(bloom_writer_->AppendKeys(&enc_key, 1));
+    if (FLAGS_rowset_max_key_ranges > 0) {
+      key_ranges_builder_.AddKey(enc_key);
+    }
 
     // Write the batch to the ad hoc index if we're using one
     if (ad_hoc_index_writer_ != nullptr) {
@@ -229,8 +255,6 @@ Status DiskRowSetWriter::AppendBlock(const RowBlock &block) {
 #endif
   }
 
-  written_count_ += block.nrows();
-
   return Status::OK();
 }
 
@@ -264,6 +288,9 @@ Status DiskRowSetWriter::FinishAndReleaseBlocks(BlockCreationTransaction* transa
   if (FLAGS_rowset_metadata_store_keys) {
     rowset_metadata_->set_max_encoded_key(last_enc_slice.ToString());
   }
+  if (FLAGS_rowset_max_key_ranges > 0) {
+    rowset_metadata_->set_key_ranges(key_ranges_builder_.Finish());
+  }
 
   // Finish writing the columns themselves.
   RETURN_NOT_OK(col_writer_->FinishAndReleaseBlocks(transaction));
@@ -319,12 +346,14 @@ DiskRowSetWriter::~DiskRowSetWriter() {
 
 RollingDiskRowSetWriter::RollingDiskRowSetWriter(
     TabletMetadata* tablet_metadata, const Schema& schema,
-    BloomFilterSizing bloom_sizing, size_t target_rowset_size)
+    BloomFilterSizing bloom_sizing, size_t target_rowset_size,
+    ThreadPool* column_writer_pool)
     : state_(kInitialized),
       tablet_metadata_(DCHECK_NOTNULL(tablet_metadata)),
       schema_(schema),
       bloom_sizing_(bloom_sizing),
       target_rowset_size_(target_rowset_size),
+      column_writer_pool_(column_writer_pool),
       row_idx_in_cur_drs_(0),
       can_roll_(false),
       written_count_(0),
@@ -350,7 +379,8 @@ Status RollingDiskRowSetWriter::RollWriter() {
 
   RETURN_NOT_OK(tablet_metadata_->CreateRowSet(&cur_drs_metadata_));
 
-  cur_writer_.reset(new DiskRowSetWriter(cur_drs_metadata_.get(), &schema_, bloom_sizing_));
+  cur_writer_.reset(new DiskRowSetWriter(cur_drs_metadata_.get(), &schema_, bloom_sizing_,
+                                         column_writer_pool_));
   RETURN_NOT_OK(cur_writer_->Open());
 
   FsManager* fs = tablet_metadata_->fs_manager();
@@ -527,7 +557,10 @@ DiskRowSet::DiskRowSet(shared_ptr<RowSetMetadata> rowset_metadata,
       log_anchor_registry_(log_anchor_registry),
       mem_trackers_(std::move(mem_trackers)),
       num_rows_(-1),
-      has_been_compacted_(false) {}
+      has_been_compacted_(false),
+      num_scans_(0),
+      num_bloom_probes_(0),
+      num_key_lookups_(0) {}
 
 Status DiskRowSet::Open() {
   TRACE_EVENT0("tablet", "DiskRowSet::Open");
@@ -656,6 +689,7 @@ Status DiskRowSet::NewRowIterator(const RowIteratorOptions& opts,
 
   out->reset(new MaterializingIterator(
       shared_ptr<ColumnwiseIterator>(col_iter.release())));
+  num_scans_.fetch_add(1, std::memory_order_relaxed);
   return Status::OK();
 }
 
@@ -679,7 +713,9 @@ Status DiskRowSet::MutateRow(Timestamp timestamp,
   shared_lock<rw_spinlock> l(component_lock_);
 
   boost::optional<rowid_t> row_idx;
+  const ProbeStats stats_before = *stats;
   RETURN_NOT_OK(base_data_->FindRow(probe, &row_idx, stats));
+  RecordProbes(stats_before, *stats);
   if (PREDICT_FALSE(row_idx == boost::none)) {
     return Status::NotFound("row not found");
   }
@@ -711,7 +747,9 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   shared_lock<rw_spinlock> l(component_lock_);
 
   rowid_t row_idx;
+  const ProbeStats stats_before = *stats;
   RETURN_NOT_OK(base_data_->CheckRowPresent(probe, present, &row_idx, stats));
+  RecordProbes(stats_before, *stats);
   if (!*present) {
     // If it wasn't in the base data, then it's definitely not in the rowset.
     return Status::OK();
@@ -727,6 +765,58 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+Status DiskRowSet::CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                                    bool* present, ProbeStats* const* stats) const {
+  DCHECK(open_);
+#ifndef NDEBUG
+  rowid_t num_rows;
+  RETURN_NOT_OK(CountRows(&num_rows));
+#endif
+  shared_lock<rw_spinlock> l(component_lock_);
+
+  // Sum up the probes of the batch, so that they're recorded at once.
+  ProbeStats stats_before;
+  ProbeStats stats_after;
+  for (size_t i = 0; i < n; i++) {
+    stats_before.blooms_consulted += stats[i]->blooms_consulted;
+    stats_before.keys_consulted += stats[i]->keys_consulted;
+  }
+  unique_ptr<rowid_t[]> row_idxs(new rowid_t[n]);
+  RETURN_NOT_OK(base_data_->CheckRowsPresent(probes, n, present, row_idxs.get(), stats));
+  for (size_t i = 0; i < n; i++) {
+    stats_after.blooms_consulted += stats[i]->blooms_consulted;
+    stats_after.keys_consulted += stats[i]->keys_consulted;
+  }
+  RecordProbes(stats_before, stats_after);
+
+  // The rows found in the base data might have been deleted.
+  for (size_t i = 0; i < n; i++) {
+    if (!present[i]) continue;
+#ifndef NDEBUG
+    CHECK_LT(row_idxs[i], num_rows);
+#endif
+    bool deleted = false;
+    RETURN_NOT_OK(delta_tracker_->CheckRowDeleted(row_idxs[i], &deleted, stats[i]));
+    present[i] = !deleted;
+  }
+  return Status::OK();
+}
+
+void DiskRowSet::RecordProbes(const ProbeStats& stats_before, const ProbeStats& stats) const {
+  num_bloom_probes_.fetch_add(stats.blooms_consulted - stats_before.blooms_consulted,
+                              std::memory_order_relaxed);
+  num_key_lookups_.fetch_add(stats.keys_consulted - stats_before.keys_consulted,
+                             std::memory_order_relaxed);
+}
+
+RowSetReadStats DiskRowSet::GetReadStats() const {
+  RowSetReadStats stats;
+  stats.scans = num_scans_.load(std::memory_order_relaxed);
+  stats.bloom_probes = num_bloom_probes_.load(std::memory_order_relaxed);
+  stats.key_lookups = num_key_lookups_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 Status DiskRowSet::CountRows(rowid_t *count) const {
   DCHECK(open_);
   rowid_t num_rows = num_rows_.load();
@@ -740,6 +830,16 @@ Status DiskRowSet::CountRows(rowid_t *count) const {
   return Status::OK();
 }
 
+Status DiskRowSet::GetKeyRanges(vector<pair<string, string>>* ranges) const {
+  vector<EncodedKeyRange> key_ranges = rowset_metadata_->key_ranges();
+  if (key_ranges.empty()) {
+    // The rowset was written before its key ranges were tracked.
+    return RowSet::GetKeyRanges(ranges);
+  }
+  *ranges = std::move(key_ranges);
+  return Status::OK();
+}
+
 Status DiskRowSet::GetBounds(std::string* min_encoded_key,
                              std::string* max_encoded_key) const {
   DCHECK(open_);
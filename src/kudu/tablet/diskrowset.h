@@ -26,6 +26,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -41,6 +42,7 @@
 #include "kudu/tablet/delta_key.h"
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_key_ranges.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
 #include "kudu/tablet/tablet_metadata.h"
@@ -55,6 +57,7 @@ class MonoTime;
 class RowBlock;
 class RowChangeList;
 class RowwiseIterator;
+class ThreadPool;
 class Timestamp;
 
 namespace cfile {
@@ -89,8 +92,13 @@ class OperationResultPB;
 class DiskRowSetWriter {
  public:
   // TODO: document ownership of rowset_metadata
+  //
+  // If 'column_writer_pool' isn't NULL, the columns are encoded by its
+  // threads while the calling thread writes the bloom filter and the ad-hoc
+  // index. It must outlive the writer.
   DiskRowSetWriter(RowSetMetadata* rowset_metadata, const Schema* schema,
-                   BloomFilterSizing bloom_sizing);
+                   BloomFilterSizing bloom_sizing,
+                   ThreadPool* column_writer_pool = nullptr);
 
   ~DiskRowSetWriter();
 
@@ -134,6 +142,10 @@ class DiskRowSetWriter {
   // this index is written to a new file instead of embedded in the col_* files
   Status InitAdHocIndexWriter();
 
+  // Append the encoded keys of the rows of 'block' to the bloom filter and,
+  // if there is one, to the ad-hoc index.
+  Status AppendKeys(const RowBlock& block);
+
   // Return the cfile::Writer responsible for writing the key index.
   // (the ad-hoc writer for composite keys, otherwise the key column writer)
   cfile::CFileWriter *key_index_writer();
@@ -142,6 +154,7 @@ class DiskRowSetWriter {
   const Schema* const schema_;
 
   BloomFilterSizing bloom_sizing_;
+  ThreadPool* const column_writer_pool_;
 
   bool finished_;
   rowid_t written_count_;
@@ -151,6 +164,9 @@ class DiskRowSetWriter {
 
   // The last encoded key written.
   faststring last_encoded_key_;
+
+  // Summarizes the keys written as a few key ranges.
+  RowSetKeyRangesBuilder key_ranges_builder_;
 };
 
 
@@ -164,9 +180,12 @@ class RollingDiskRowSetWriter {
   // Create a new rolling writer. The given 'tablet_metadata' must stay valid
   // for the lifetime of this writer, and is used to construct the new rowsets
   // that this RollingDiskRowSetWriter creates.
+  //
+  // 'column_writer_pool' may be NULL; see DiskRowSetWriter.
   RollingDiskRowSetWriter(TabletMetadata* tablet_metadata, const Schema& schema,
                           BloomFilterSizing bloom_sizing,
-                          size_t target_rowset_size);
+                          size_t target_rowset_size,
+                          ThreadPool* column_writer_pool = nullptr);
   ~RollingDiskRowSetWriter();
 
   Status Open();
@@ -216,6 +235,9 @@ class RollingDiskRowSetWriter {
 
   uint64_t written_size() const { return written_size_; }
 
+  // Whether the columns are encoded in parallel.
+  bool has_column_writer_pool() const { return column_writer_pool_ != nullptr; }
+
  private:
   Status RollWriter();
 
@@ -242,6 +264,7 @@ class RollingDiskRowSetWriter {
   std::shared_ptr<RowSetMetadata> cur_drs_metadata_;
   const BloomFilterSizing bloom_sizing_;
   const size_t target_rowset_size_;
+  ThreadPool* const column_writer_pool_;
 
   gscoped_ptr<DiskRowSetWriter> cur_writer_;
 
@@ -348,6 +371,9 @@ class DiskRowSet : public RowSet {
                          bool *present,
                          ProbeStats* stats) const override;
 
+  Status CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                          bool* present, ProbeStats* const* stats) const override;
+
   ////////////////////
   // Read functions.
   ////////////////////
@@ -366,6 +392,9 @@ class DiskRowSet : public RowSet {
   virtual Status GetBounds(std::string* min_encoded_key,
                            std::string* max_encoded_key) const override;
 
+  // See RowSet::GetKeyRanges(...)
+  Status GetKeyRanges(std::vector<std::pair<std::string, std::string>>* ranges) const override;
+
   void GetDiskRowSetSpaceUsage(DiskRowSetSpace* drss) const;
 
   uint64_t OnDiskSize() const override;
@@ -418,6 +447,8 @@ class DiskRowSet : public RowSet {
     return rowset_metadata_;
   }
 
+  RowSetReadStats GetReadStats() const override;
+
   std::string ToString() const override {
     return rowset_metadata_->ToString();
   }
@@ -455,6 +486,10 @@ class DiskRowSet : public RowSet {
   Status MajorCompactDeltaStoresWithColumnIds(const std::vector<ColumnId>& col_ids,
                                               HistoryGcOpts history_gc_opts);
 
+  // Adds the bloom probes and key lookups counted in 'stats' since
+  // 'stats_before' to the read counters of the rowset.
+  void RecordProbes(const ProbeStats& stats_before, const ProbeStats& stats) const;
+
   std::shared_ptr<RowSetMetadata> rowset_metadata_;
 
   bool open_;
@@ -480,6 +515,11 @@ class DiskRowSet : public RowSet {
   // and thus should not be scheduled for further compactions.
   std::atomic<bool> has_been_compacted_;
 
+  // Counters of the reads served by this rowset. See GetReadStats().
+  mutable std::atomic<int64_t> num_scans_;
+  mutable std::atomic<int64_t> num_bloom_probes_;
+  mutable std::atomic<int64_t> num_key_lookups_;
+
   DISALLOW_COPY_AND_ASSIGN(DiskRowSet);
 };
 
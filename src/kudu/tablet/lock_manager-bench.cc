@@ -0,0 +1,139 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmark of the row locks taken by concurrent write batches, comparing
+// the locking of each row with its own ScopedRowLock with LockBatch().
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/lock_manager.h"
+#include "kudu/util/random.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_util.h"
+
+DEFINE_int32(num_writer_threads, 8, "The number of threads writing batches concurrently");
+DEFINE_int32(num_batches, 200, "The number of batches written by each thread");
+DEFINE_int32(batch_size, 1000, "The number of rows of each batch");
+DEFINE_double(key_overlap_ratio, 0.01,
+              "The fraction of the rows of each batch whose keys are picked from a "
+              "set shared by all the threads, and may be locked by several batches "
+              "at a time. The other keys are only written by one thread.");
+
+using std::string;
+using std::thread;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+class TransactionState;
+
+class LockManagerBench : public KuduTest {
+ protected:
+  // Runs FLAGS_num_writer_threads threads which each lock and release the
+  // rows of FLAGS_num_batches batches, and logs the throughput.
+  void RunBench(bool use_batch) {
+    LockManager manager;
+    Stopwatch sw(Stopwatch::ALL_THREADS);
+    sw.start();
+    vector<thread> threads;
+    for (int t = 0; t < FLAGS_num_writer_threads; t++) {
+      threads.emplace_back([&, t]() {
+        const TransactionState* txn = reinterpret_cast<TransactionState*>(t + 1);
+        Random rng(SeedRandom() + t);
+        vector<string> key_strings(FLAGS_batch_size);
+        vector<Slice> keys(FLAGS_batch_size);
+        int64_t next_private_key = 0;
+        for (int b = 0; b < FLAGS_num_batches; b++) {
+          for (int i = 0; i < FLAGS_batch_size; i++) {
+            if (rng.NextDoubleFraction() < FLAGS_key_overlap_ratio) {
+              key_strings[i] = StringPrintf("shared%08u", rng.Uniform(FLAGS_batch_size));
+            } else {
+              key_strings[i] = StringPrintf("t%03d-%012ld", t, next_private_key++);
+            }
+          }
+          if (!use_batch) {
+            // Without LockBatch(), the rows must be locked in a global order
+            // to avoid deadlocks.
+            std::sort(key_strings.begin(), key_strings.end());
+          }
+          for (int i = 0; i < FLAGS_batch_size; i++) {
+            keys[i] = Slice(key_strings[i]);
+          }
+
+          vector<ScopedRowLock> locks;
+          if (use_batch) {
+            manager.LockBatch(keys, txn, LockManager::LOCK_EXCLUSIVE, &locks);
+            vector<ScopedRowLock*> to_release;
+            to_release.reserve(locks.size());
+            for (auto& lock : locks) {
+              to_release.push_back(&lock);
+            }
+            ScopedRowLock::ReleaseAll(to_release);
+          } else {
+            locks.reserve(keys.size());
+            for (const auto& key : keys) {
+              locks.emplace_back(&manager, txn, key, LockManager::LOCK_EXCLUSIVE);
+            }
+            for (auto& lock : locks) {
+              lock.Release();
+            }
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    sw.stop();
+
+    double rows = static_cast<double>(FLAGS_num_writer_threads) * FLAGS_num_batches *
+        FLAGS_batch_size;
+    LOG(INFO) << Substitute("$0: $1 threads, $2% key overlap: $3 Mrows/sec, "
+                            "$4us of CPU per batch",
+                            use_batch ? "LockBatch" : "ScopedRowLock per row",
+                            FLAGS_num_writer_threads, FLAGS_key_overlap_ratio * 100,
+                            StringPrintf("%.2f", rows / sw.elapsed().wall_seconds() / 1e6),
+                            StringPrintf("%.1f", (sw.elapsed().user + sw.elapsed().system) /
+                                         1000.0 / FLAGS_num_batches /
+                                         FLAGS_num_writer_threads));
+  }
+};
+
+TEST_F(LockManagerBench, PerRow) {
+  RunBench(false);
+}
+
+TEST_F(LockManagerBench, Batch) {
+  RunBench(true);
+}
+
+} // namespace tablet
+} // namespace kudu
@@ -21,6 +21,7 @@
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -35,11 +36,13 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 #include "kudu/util/thread.h"
 
 using std::shared_ptr;
 using std::string;
+using std::thread;
 using std::vector;
 
 DEFINE_int32(num_test_threads, 10, "number of stress test client threads");
@@ -62,6 +65,13 @@ class LockManagerTest : public KuduTest {
               lock_manager_.TryLock(key, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &entry));
   }
 
+  void VerifyNotLocked(const Slice& key) {
+    LockEntry *entry;
+    ASSERT_EQ(LockManager::LOCK_ACQUIRED,
+              lock_manager_.TryLock(key, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &entry));
+    lock_manager_.Release(entry, LockManager::LOCK_ACQUIRED);
+  }
+
   LockManager lock_manager_;
 };
 
@@ -117,6 +127,63 @@ TEST_F(LockManagerTest, TestMoveLock) {
   ASSERT_FALSE(row_lock.acquired()); // NOLINT(bugprone-use-after-move)
 }
 
+TEST_F(LockManagerTest, TestLockBatch) {
+  vector<Slice> keys = { Slice("b"), Slice("a"), Slice("c"), Slice("a") };
+  vector<ScopedRowLock> locks;
+  lock_manager_.LockBatch(keys, kFakeTransaction, LockManager::LOCK_EXCLUSIVE, &locks);
+  ASSERT_EQ(keys.size(), locks.size());
+  for (const auto& lock : locks) {
+    ASSERT_TRUE(lock.acquired());
+  }
+  for (const auto& key : keys) {
+    NO_FATALS(VerifyAlreadyLocked(key));
+  }
+
+  // Releasing the duplicate lock of "a" doesn't release the row.
+  locks[3].Release();
+  NO_FATALS(VerifyAlreadyLocked(Slice("a")));
+
+  vector<ScopedRowLock*> to_release;
+  for (auto& lock : locks) {
+    to_release.push_back(&lock);
+  }
+  ScopedRowLock::ReleaseAll(to_release);
+  for (const auto& lock : locks) {
+    ASSERT_FALSE(lock.acquired());
+  }
+
+  // All the rows are free again.
+  for (const auto& key : keys) {
+    NO_FATALS(VerifyNotLocked(key));
+  }
+}
+
+// Test that batches which lock the same rows in opposite orders don't
+// deadlock, since LockBatch() always locks the rows in the same order.
+TEST_F(LockManagerTest, TestLockBatchOpposingOrders) {
+  vector<string> key_strings;
+  for (int i = 0; i < 100; i++) {
+    key_strings.push_back(StringPrintf("key%03d", i));
+  }
+  vector<thread> threads;
+  for (int t = 0; t < 2; t++) {
+    threads.emplace_back([&, t]() {
+      const TransactionState* my_txn = reinterpret_cast<TransactionState*>(t + 1);
+      vector<Slice> keys(key_strings.begin(), key_strings.end());
+      if (t == 1) {
+        std::reverse(keys.begin(), keys.end());
+      }
+      for (int i = 0; i < FLAGS_num_iterations; i++) {
+        vector<ScopedRowLock> locks;
+        lock_manager_.LockBatch(keys, my_txn, LockManager::LOCK_EXCLUSIVE, &locks);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
 class LmTestResource {
  public:
   explicit LmTestResource(const Slice* id)
@@ -171,7 +238,6 @@ class LmTestThread {
     std::sort(keys_.begin(), keys_.end());
     for (int i = 0; i < FLAGS_num_iterations; i++) {
       std::vector<shared_ptr<ScopedRowLock> > locks;
-      // TODO: We don't have an API for multi-row
       for (const Slice* key : keys_) {
         locks.push_back(std::make_shared<ScopedRowLock>(
             manager_, my_txn, *key, LockManager::LOCK_EXCLUSIVE));
@@ -17,14 +17,17 @@
 
 #include "kudu/tablet/lock_manager.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include <glog/logging.h>
 
 #include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/bits.h"
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/hash/city.h"
@@ -38,6 +41,7 @@
 #include "kudu/util/trace.h"
 
 using base::subtle::NoBarrier_Load;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -52,12 +56,13 @@ class TransactionState;
 // Callers should generally use ScopedRowLock (see below).
 class LockEntry {
  public:
-  explicit LockEntry(const Slice& key)
+  LockEntry()
   : sem(1),
     recursion_(0) {
-    key_hash_ = util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
-    key_ = key;
-    refs_ = 1;
+  }
+
+  static uint64_t HashKey(const Slice& key) {
+    return util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
   }
 
   bool Equals(const Slice& key, uint64_t hash) const {
@@ -76,12 +81,19 @@ class LockEntry {
   friend class LockTable;
   friend class LockManager;
 
-  void CopyKey() {
-    key_buf_.assign_copy(key_.data(), key_.size());
+  // Set up a new or recycled entry for 'key', which hashes to 'hash', and
+  // copy the key. The entry must not be locked.
+  void Init(const Slice& key, uint64_t hash) {
+    DCHECK_EQ(0, recursion_);
+    key_hash_ = hash;
+    key_buf_.assign_copy(key.data(), key.size());
     key_ = Slice(key_buf_);
+    refs_ = 1;
+    holder_ = nullptr;
   }
 
-  // Pointer to the next entry in the same hash table bucket
+  // Pointer to the next entry in the same hash table bucket, or in the pool
+  // of free entries.
   LockEntry *ht_next_;
 
   // Hash of the key, used to lookup the hash table bucket
@@ -93,7 +105,7 @@ class LockEntry {
   // number of users that are referencing this object
   uint64_t refs_;
 
-  // buffer of the key, allocated on insertion by CopyKey()
+  // buffer of the key, allocated on insertion by Init()
   faststring key_buf_;
 
   // The transaction currently holding the lock
@@ -110,7 +122,21 @@ class LockTable {
   };
 
  public:
-  LockTable() : mask_(0), size_(0), item_count_(0) {
+  // A key to look up in GetLockEntries().
+  struct Lookup {
+    Slice key;
+    uint64_t hash;
+    // The index of the key in the batch of the caller.
+    size_t idx;
+    // Set by GetLockEntries().
+    LockEntry* entry;
+
+    bool operator<(const Lookup& other) const {
+      return hash < other.hash || (hash == other.hash && key.compare(other.key) < 0);
+    }
+  };
+
+  LockTable() : shift_(64), size_(0), item_count_(0), pool_head_(nullptr), pool_size_(0) {
     Resize();
   }
 
@@ -122,14 +148,29 @@ class LockTable {
         DCHECK(p == nullptr) << "The entry " << p->ToString() << " was not released";
       }
     }
+    DeleteEntries(pool_head_);
   }
 
   LockEntry *GetLockEntry(const Slice &key);
   void ReleaseLockEntry(LockEntry *entry);
 
+  // Set the entry of each of the 'n' lookups, inserting new entries for the
+  // keys which aren't in the table yet. The lookups must be sorted, so that
+  // the keys of the same bucket are next to each other.
+  void GetLockEntries(Lookup* lookups, size_t n);
+
+  // Release the 'n' entries, which must be sorted by hash.
+  void ReleaseLockEntries(LockEntry* const* entries, size_t n);
+
  private:
+  // The maximum number of free entries kept in the pool. This is enough for
+  // a batch of 1000 rows, the default maximum of the clients.
+  static const size_t kMaxPooledEntries = 1024;
+
+  // The bucket of a hash is given by its top bits, so that sorting the keys
+  // by hash also groups them by bucket, whatever the size of the table.
   Bucket *FindBucket(uint64_t hash) const {
-    return &(buckets_[hash & mask_]);
+    return &(buckets_[shift_ == 64 ? 0 : hash >> shift_]);
   }
 
   // Return a pointer to slot that points to a lock entry that
@@ -157,46 +198,85 @@ class LockTable {
 
   void Resize();
 
+  // Take 'n' free entries from the pool, allocating those that the pool
+  // lacks, and return them chained by their 'ht_next_' pointer.
+  LockEntry* TakeFromPool(size_t n);
+
+  // Return the entries chained from 'head' to the pool, deleting those
+  // which don't fit in it.
+  void ReturnToPool(LockEntry* head);
+
+  static void DeleteEntries(LockEntry* head) {
+    while (head != nullptr) {
+      LockEntry* next = head->ht_next_;
+      delete head;
+      head = next;
+    }
+  }
+
  private:
   // table rwlock used as write on resize
   percpu_rwlock lock_;
-  // size - 1 used to lookup the bucket (hash & mask_)
-  uint64_t mask_;
+  // 64 - log2(size_) used to lookup the bucket (hash >> shift_)
+  int shift_;
   // number of buckets in the table
   uint64_t size_;
   // table buckets
   gscoped_array<Bucket> buckets_;
   // number of items in the table
   base::subtle::Atomic64 item_count_;
+
+  // The pool of free entries, chained by their 'ht_next_' pointer, and the
+  // lock which protects it.
+  simple_spinlock pool_lock_;
+  LockEntry* pool_head_;
+  size_t pool_size_;
 };
 
 LockEntry *LockTable::GetLockEntry(const Slice& key) {
-  auto new_entry = new LockEntry(key);
-  LockEntry *old_entry;
+  Lookup lookup = { key, LockEntry::HashKey(key), 0, nullptr };
+  GetLockEntries(&lookup, 1);
+  return lookup.entry;
+}
+
+void LockTable::ReleaseLockEntry(LockEntry *entry) {
+  ReleaseLockEntries(&entry, 1);
+}
 
+void LockTable::GetLockEntries(Lookup* lookups, size_t n) {
+  // Allocate the entries which may be inserted before taking any lock, and
+  // return those left over to the pool afterwards.
+  LockEntry* free_entries = TakeFromPool(n);
+  int64_t num_inserted = 0;
   {
     shared_lock<rw_spinlock> l(lock_.get_lock());
-    Bucket *bucket = FindBucket(new_entry->key_hash_);
-    {
+    size_t i = 0;
+    while (i < n) {
+      Bucket *bucket = FindBucket(lookups[i].hash);
       std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
-      LockEntry **node = FindSlot(bucket, new_entry->key_, new_entry->key_hash_);
-      old_entry = *node;
-      if (old_entry != nullptr) {
-        old_entry->refs_++;
-      } else {
-        new_entry->ht_next_ = nullptr;
-        new_entry->CopyKey();
-        *node = new_entry;
-      }
+      do {
+        DCHECK(i == 0 || !(lookups[i] < lookups[i - 1])) << "lookups must be sorted";
+        Lookup* lookup = &lookups[i];
+        LockEntry **node = FindSlot(bucket, lookup->key, lookup->hash);
+        if (*node != nullptr) {
+          (*node)->refs_++;
+        } else {
+          LockEntry* new_entry = free_entries;
+          free_entries = new_entry->ht_next_;
+          new_entry->Init(lookup->key, lookup->hash);
+          new_entry->ht_next_ = nullptr;
+          *node = new_entry;
+          num_inserted++;
+        }
+        lookup->entry = *node;
+        i++;
+      } while (i < n && FindBucket(lookups[i].hash) == bucket);
     }
   }
+  ReturnToPool(free_entries);
 
-  if (old_entry != nullptr) {
-    delete new_entry;
-    return old_entry;
-  }
-
-  if (base::subtle::NoBarrier_AtomicIncrement(&item_count_, 1) > size_) {
+  if (num_inserted > 0 &&
+      base::subtle::NoBarrier_AtomicIncrement(&item_count_, num_inserted) > size_) {
     std::unique_lock<percpu_rwlock> table_wrlock(lock_, std::try_to_lock);
     // if we can't take the lock, means that someone else is resizing.
     // (The percpu_rwlock try_lock waits for readers to complete)
@@ -204,33 +284,79 @@ LockEntry *LockTable::GetLockEntry(const Slice& key) {
       Resize();
     }
   }
-
-  return new_entry;
 }
 
-void LockTable::ReleaseLockEntry(LockEntry *entry) {
-  bool removed = false;
+void LockTable::ReleaseLockEntries(LockEntry* const* entries, size_t n) {
+  LockEntry* removed = nullptr;
+  int64_t num_removed = 0;
   {
-    std::lock_guard<rw_spinlock> table_rdlock(lock_.get_lock());
-    Bucket *bucket = FindBucket(entry->key_hash_);
-    {
+    shared_lock<rw_spinlock> l(lock_.get_lock());
+    size_t i = 0;
+    while (i < n) {
+      Bucket *bucket = FindBucket(entries[i]->key_hash_);
       std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
-      LockEntry **node = FindEntry(bucket, entry);
-      if (node != nullptr) {
+      do {
+        LockEntry* entry = entries[i];
+        LockEntry **node = FindEntry(bucket, entry);
+        DCHECK(node != nullptr) << "Unable to find LockEntry on release";
         // ASSUMPTION: There are few updates, so locking the same row at the same time is rare
-        // TODO: Move out this if we're going with the TryLock
-        if (--entry->refs_ > 0)
-          return;
+        if (node != nullptr && --entry->refs_ == 0) {
+          *node = entry->ht_next_;
+          entry->ht_next_ = removed;
+          removed = entry;
+          num_removed++;
+        }
+        i++;
+      } while (i < n && FindBucket(entries[i]->key_hash_) == bucket);
+    }
+  }
 
-        *node = entry->ht_next_;
-        removed = true;
-      }
+  if (num_removed > 0) {
+    base::subtle::NoBarrier_AtomicIncrement(&item_count_, -num_removed);
+    ReturnToPool(removed);
+  }
+}
+
+LockEntry* LockTable::TakeFromPool(size_t n) {
+  LockEntry* head = nullptr;
+  size_t taken = 0;
+  {
+    std::lock_guard<simple_spinlock> l(pool_lock_);
+    while (taken < n && pool_head_ != nullptr) {
+      LockEntry* entry = pool_head_;
+      pool_head_ = entry->ht_next_;
+      entry->ht_next_ = head;
+      head = entry;
+      taken++;
     }
+    pool_size_ -= taken;
+  }
+  for (; taken < n; taken++) {
+    LockEntry* entry = new LockEntry();
+    entry->ht_next_ = head;
+    head = entry;
   }
+  return head;
+}
 
-  DCHECK(removed) << "Unable to find LockEntry on release";
-  base::subtle::NoBarrier_AtomicIncrement(&item_count_, -1);
-  delete entry;
+void LockTable::ReturnToPool(LockEntry* head) {
+  LockEntry* to_delete = nullptr;
+  {
+    std::lock_guard<simple_spinlock> l(pool_lock_);
+    while (head != nullptr) {
+      LockEntry* next = head->ht_next_;
+      if (pool_size_ < kMaxPooledEntries) {
+        head->ht_next_ = pool_head_;
+        pool_head_ = head;
+        pool_size_++;
+      } else {
+        head->ht_next_ = to_delete;
+        to_delete = head;
+      }
+      head = next;
+    }
+  }
+  DeleteEntries(to_delete);
 }
 
 void LockTable::Resize() {
@@ -245,7 +371,7 @@ void LockTable::Resize() {
 
   // Allocate a new bucket list
   gscoped_array<Bucket> new_buckets(new Bucket[new_size]);
-  size_t new_mask = new_size - 1;
+  int new_shift = 64 - Bits::Log2Floor64(new_size);
 
   // Copy entries
   for (size_t i = 0; i < size_; ++i) {
@@ -254,7 +380,7 @@ void LockTable::Resize() {
       LockEntry *next = p->ht_next_;
 
       // Insert Entry
-      Bucket *bucket = &(new_buckets[p->key_hash_ & new_mask]);
+      Bucket *bucket = &(new_buckets[p->key_hash_ >> new_shift]);
       p->ht_next_ = bucket->chain_head;
       bucket->chain_head = p;
 
@@ -263,7 +389,7 @@ void LockTable::Resize() {
   }
 
   // Swap the bucket
-  mask_ = new_mask;
+  shift_ = new_shift;
   size_ = new_size;
   buckets_.swap(new_buckets);
 }
@@ -320,6 +446,15 @@ void ScopedRowLock::Release() {
   }
 }
 
+void ScopedRowLock::ReleaseAll(const vector<ScopedRowLock*>& locks) {
+  for (ScopedRowLock* lock : locks) {
+    if (lock->entry_ != nullptr) {
+      lock->manager_->ReleaseBatch(locks);
+      return;
+    }
+  }
+}
+
 // ============================================================================
 //  LockManager
 // ============================================================================
@@ -337,11 +472,15 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
                                           LockManager::LockMode mode,
                                           LockEntry** entry) {
   *entry = locks_->GetLockEntry(key);
+  AcquireEntry(key, tx, *entry);
+  return LOCK_ACQUIRED;
+}
 
+void LockManager::AcquireEntry(const Slice& key, const TransactionState* tx, LockEntry* entry) {
   // We expect low contention, so just try to try_lock first. This is faster
   // than a timed_lock, since we don't have to do a syscall to get the current
   // time.
-  if (!(*entry)->sem.TryAcquire()) {
+  if (!entry->sem.TryAcquire()) {
     // If the current holder of this lock is the same transaction just return
     // a LOCK_ALREADY_ACQUIRED status without actually acquiring the mutex.
     //
@@ -351,9 +490,9 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     // obtained and released at the same time). If at any time in the future
     // we opt to perform more fine grained locking, possibly letting transactions
     // release a portion of the locks they no longer need, this no longer is OK.
-    if (ANNOTATE_UNPROTECTED_READ((*entry)->holder_) == tx) {
-      (*entry)->recursion_++;
-      return LOCK_ACQUIRED;
+    if (ANNOTATE_UNPROTECTED_READ(entry->holder_) == tx) {
+      entry->recursion_++;
+      return;
     }
 
     // If we couldn't immediately acquire the lock, do a timed lock so we can
@@ -363,8 +502,8 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     TRACE_COUNTER_INCREMENT("row_lock_wait_count", 1);
     MicrosecondsInt64 start_wait_us = GetMonoTimeMicros();
     int waited_seconds = 0;
-    while (!(*entry)->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
-      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ((*entry)->holder_);
+    while (!entry->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
+      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ(entry->holder_);
       LOG(WARNING) << "Waited " << (++waited_seconds) << " seconds to obtain row lock on key "
                    << KUDU_REDACT(key.ToDebugString()) << " cur holder: " << cur_holder;
       // TODO(unknown): would be nice to also include some info about the blocking transaction,
@@ -378,8 +517,7 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     }
   }
 
-  (*entry)->holder_ = tx;
-  return LOCK_ACQUIRED;
+  entry->holder_ = tx;
 }
 
 LockManager::LockStatus LockManager::TryLock(const Slice& key,
@@ -397,15 +535,60 @@ LockManager::LockStatus LockManager::TryLock(const Slice& key,
 }
 
 void LockManager::Release(LockEntry *lock, LockStatus ls) {
-  DCHECK_NOTNULL(lock)->holder_ = nullptr;
+  ReleaseEntry(lock, ls);
+  locks_->ReleaseLockEntry(lock);
+}
+
+void LockManager::ReleaseEntry(LockEntry* entry, LockStatus ls) {
+  DCHECK_NOTNULL(entry)->holder_ = nullptr;
   if (ls == LOCK_ACQUIRED) {
-    if (lock->recursion_ > 0) {
-      lock->recursion_--;
+    if (entry->recursion_ > 0) {
+      entry->recursion_--;
     } else {
-      lock->sem.Release();
+      entry->sem.Release();
     }
   }
-  locks_->ReleaseLockEntry(lock);
+}
+
+void LockManager::LockBatch(const vector<Slice>& keys,
+                            const TransactionState* tx,
+                            LockManager::LockMode mode,
+                            vector<ScopedRowLock>* locks) {
+  // Sort the keys by hash so that the keys of each bucket of the lock table
+  // are next to each other, and so that all the transactions lock the rows
+  // in the same order.
+  vector<LockTable::Lookup> lookups(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    lookups[i] = { keys[i], LockEntry::HashKey(keys[i]), i, nullptr };
+  }
+  std::sort(lookups.begin(), lookups.end());
+  locks_->GetLockEntries(lookups.data(), lookups.size());
+
+  locks->clear();
+  locks->resize(keys.size());
+  for (const auto& lookup : lookups) {
+    AcquireEntry(lookup.key, tx, lookup.entry);
+    (*locks)[lookup.idx] = ScopedRowLock(this, lookup.entry);
+  }
+}
+
+void LockManager::ReleaseBatch(const vector<ScopedRowLock*>& locks) {
+  vector<LockEntry*> entries;
+  entries.reserve(locks.size());
+  for (ScopedRowLock* lock : locks) {
+    if (lock->entry_ == nullptr) {
+      continue;
+    }
+    DCHECK_EQ(this, lock->manager_);
+    ReleaseEntry(lock->entry_, lock->ls_);
+    entries.push_back(lock->entry_);
+    lock->acquired_ = false;
+    lock->entry_ = nullptr;
+  }
+  std::sort(entries.begin(), entries.end(), [](const LockEntry* a, const LockEntry* b) {
+    return a->key_hash_ < b->key_hash_;
+  });
+  locks_->ReleaseLockEntries(entries.data(), entries.size());
 }
 
 } // namespace tablet
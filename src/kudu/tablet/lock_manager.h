@@ -18,6 +18,7 @@
 #define KUDU_TABLET_LOCK_MANAGER_H
 
 #include <cstddef>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/util/slice.h"
@@ -26,11 +27,12 @@ namespace kudu { namespace tablet {
 
 class LockTable;
 class LockEntry;
+class ScopedRowLock;
 class TransactionState;
 
 // Super-simple lock manager implementation. This only supports exclusive
 // locks, and makes no attempt to prevent deadlocks if a single thread
-// takes multiple locks.
+// takes multiple locks, unless they are taken together with LockBatch().
 //
 // In the future when we want to support multi-row transactions of some kind
 // we'll have to implement a proper lock manager with all its trappings,
@@ -49,10 +51,31 @@ class LockManager {
     LOCK_EXCLUSIVE
   };
 
+  // Lock all the rows of 'keys' on behalf of 'tx', blocking until each of
+  // them is available, and set 'locks' to the lock of each key, in the same
+  // order. The keys may contain duplicates. As for ScopedRowLock, each key
+  // must remain valid and un-changed for the lifetime of its lock.
+  //
+  // This is cheaper than locking each row with its own ScopedRowLock: each
+  // lock table bucket is locked once for all of its keys, and the lock entries
+  // are taken from a pool rather than allocated one by one. Since the rows are
+  // always locked in the same order, two transactions which lock overlapping
+  // sets of rows with LockBatch() can't deadlock.
+  void LockBatch(const std::vector<Slice>& keys, const TransactionState* tx,
+                 LockMode mode, std::vector<ScopedRowLock>* locks);
+
  private:
   friend class ScopedRowLock;
   friend class LockManagerTest;
 
+  // See ScopedRowLock::ReleaseAll().
+  void ReleaseBatch(const std::vector<ScopedRowLock*>& locks);
+
+  // Acquire the semaphore of 'entry', which must have been obtained for 'key'
+  // from the lock table.
+  void AcquireEntry(const Slice& key, const TransactionState* tx, LockEntry* entry);
+  void ReleaseEntry(LockEntry* entry, LockStatus ls);
+
   LockStatus Lock(const Slice& key, const TransactionState* tx,
                   LockMode mode, LockEntry **entry);
   LockStatus TryLock(const Slice& key, const TransactionState* tx,
@@ -109,6 +132,11 @@ class ScopedRowLock {
 
   void Release();
 
+  // Release all the given locks, which must have been acquired from the same
+  // LockManager. This takes each lock table bucket lock once, rather than once
+  // per lock.
+  static void ReleaseAll(const std::vector<ScopedRowLock*>& locks);
+
   bool acquired() const { return acquired_; }
 
   LockManager::LockStatus GetLockStatusForTests() { return ls_; }
@@ -116,6 +144,16 @@ class ScopedRowLock {
   ~ScopedRowLock();
 
  private:
+  friend class LockManager;
+
+  // Wrap a lock which has already been acquired by LockManager::LockBatch().
+  ScopedRowLock(LockManager* manager, LockEntry* entry)
+    : manager_(manager),
+      acquired_(true),
+      entry_(entry),
+      ls_(LockManager::LOCK_ACQUIRED) {
+  }
+
   void TakeState(ScopedRowLock* other);
 
   LockManager *manager_;
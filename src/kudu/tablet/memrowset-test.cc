@@ -31,9 +31,11 @@
 #include "kudu/clock/clock.h"
 #include "kudu/clock/logical_clock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/encoded_key.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/consensus/log_anchor_registry.h"
@@ -42,6 +44,7 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/tablet/compaction.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet-test-util.h"
@@ -60,6 +63,8 @@ DEFINE_int32(roundtrip_num_rows, 10000,
 DEFINE_int32(num_scan_passes, 1,
              "Number of passes to run the scan portion of the round-trip test");
 
+DECLARE_bool(mrs_use_columnar_layout);
+
 namespace kudu {
 namespace tablet {
 
@@ -565,5 +570,137 @@ TEST_F(TestMemRowSet, TestUpdateMVCC) {
   }
 }
 
+// Test that a memrowset with the columnar layout returns the same rows as one
+// with the row layout, to scans and to compactions, whether the rows were
+// inserted in key order or not, and with updates, deletes and NULL cells.
+TEST_F(TestMemRowSet, TestColumnarLayout) {
+  SchemaBuilder builder;
+  ASSERT_OK(builder.AddKeyColumn("key", STRING));
+  ASSERT_OK(builder.AddColumn("val", UINT32));
+  ASSERT_OK(builder.AddNullableColumn("note", STRING));
+  const Schema schema = builder.Build();
+
+  // Rows 0 to 2999 are mostly inserted in order, with runs spanning several
+  // chunks of the column store. Every seventh row is inserted at the end.
+  const int kNumRows = 3000;
+  vector<int> order;
+  vector<int> late;
+  for (int i = 0; i < kNumRows; i++) {
+    (i % 7 == 3 ? late : order).push_back(i);
+  }
+  order.insert(order.end(), late.begin(), late.end());
+
+  shared_ptr<MemRowSet> mrs[2];
+  for (bool columnar : { false, true }) {
+    FLAGS_mrs_use_columnar_layout = columnar;
+    ASSERT_OK(MemRowSet::Create(0, schema, log_anchor_registry_.get(),
+                                MemTracker::GetRootTracker(), &mrs[columnar]));
+    ASSERT_EQ(columnar, mrs[columnar]->column_store() != nullptr);
+  }
+  FLAGS_mrs_use_columnar_layout = false;
+
+  MRSInsertHint hints[2];
+  char keybuf[32];
+  char notebuf[32];
+  for (int i : order) {
+    ScopedTransaction tx(&mvcc_, clock_->Now());
+    tx.StartApplying();
+    RowBuilder rb(schema);
+    snprintf(keybuf, sizeof(keybuf), "row %06d", i);
+    rb.AddString(Slice(keybuf));
+    rb.AddUint32(i);
+    if (i % 5 == 0) {
+      rb.AddNull();
+    } else {
+      snprintf(notebuf, sizeof(notebuf), "note %d", i);
+      rb.AddString(Slice(notebuf));
+    }
+    for (int m = 0; m < 2; m++) {
+      ASSERT_OK(mrs[m]->Insert(tx.timestamp(), rb.row(), op_id_, &hints[m]));
+    }
+    tx.Commit();
+  }
+
+  // Update and delete some of the rows.
+  int num_deleted = 0;
+  int num_deleted_before_1000 = 0;
+  for (int i = 0; i < kNumRows; i += 11) {
+    ScopedTransaction tx(&mvcc_, clock_->Now());
+    tx.StartApplying();
+    mutation_buf_.clear();
+    RowChangeListEncoder enc(&mutation_buf_);
+    if (i % 2 == 0) {
+      uint32_t new_val = i * 2;
+      enc.AddColumnUpdate(schema.column(1), schema.column_id(1), &new_val);
+    } else {
+      enc.SetToDelete();
+      num_deleted++;
+      num_deleted_before_1000 += i < 1000;
+    }
+    RowBuilder rb(schema.CreateKeyProjection());
+    snprintf(keybuf, sizeof(keybuf), "row %06d", i);
+    rb.AddString(Slice(keybuf));
+    RowSetKeyProbe probe(rb.row());
+    for (int m = 0; m < 2; m++) {
+      ProbeStats stats;
+      OperationResultPB result;
+      ASSERT_OK(mrs[m]->MutateRow(tx.timestamp(), probe, RowChangeList(mutation_buf_),
+                                  op_id_, &stats, &result));
+    }
+    tx.Commit();
+  }
+
+  // Scan with the memrowset's schema, and with a projection which drops a
+  // column and adds one with a default.
+  SchemaBuilder proj_builder(schema);
+  ASSERT_OK(proj_builder.RemoveColumn("val"));
+  uint32_t default_val = 42;
+  ASSERT_OK(proj_builder.AddColumn("extra", UINT32, false, &default_val, &default_val));
+  const Schema projection = proj_builder.Build();
+
+  MvccSnapshot snap(mvcc_);
+  for (const Schema* proj : { &schema, &projection }) {
+    vector<string> rows[2];
+    for (int m = 0; m < 2; m++) {
+      ASSERT_OK(DumpRowSet(*mrs[m], *proj, snap, &rows[m]));
+    }
+    ASSERT_EQ(kNumRows - num_deleted, rows[0].size());
+    ASSERT_EQ(rows[0], rows[1]);
+  }
+
+  // Scan with blocks smaller than the leaves of the tree, and with an upper
+  // bound.
+  for (int m = 0; m < 2; m++) {
+    RowIteratorOptions opts;
+    opts.projection = &schema;
+    opts.snap_to_include = snap;
+    gscoped_ptr<MemRowSet::Iterator> iter(mrs[m]->NewIterator(opts));
+    ScanSpec spec;
+    RowBuilder rb(schema.CreateKeyProjection());
+    rb.AddString(Slice("row 001000"));
+    gscoped_ptr<EncodedKey> upper(EncodedKey::FromContiguousRow(rb.row()));
+    spec.SetExclusiveUpperBoundKey(upper.get());
+    ASSERT_OK(iter->Init(&spec));
+    Arena arena(1024);
+    RowBlock block(schema, 7, &arena);
+    int fetched = 0;
+    while (iter->HasNext()) {
+      ASSERT_OK(iter->NextBlock(&block));
+      fetched += block.selection_vector()->CountSelected();
+    }
+    EXPECT_EQ(1000 - num_deleted_before_1000, fetched);
+  }
+
+  // Compaction inputs must yield the same rows and mutations.
+  vector<string> compaction_rows[2];
+  for (int m = 0; m < 2; m++) {
+    gscoped_ptr<CompactionInput> input;
+    ASSERT_OK(mrs[m]->NewCompactionInput(&schema, snap, &input));
+    ASSERT_OK(DebugDumpCompactionInput(input.get(), &compaction_rows[m]));
+  }
+  ASSERT_EQ(kNumRows, compaction_rows[0].size());
+  ASSERT_EQ(compaction_rows[0], compaction_rows[1]);
+}
+
 } // namespace tablet
 } // namespace kudu
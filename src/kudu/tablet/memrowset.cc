@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/memrowset.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -29,11 +30,13 @@
 #include "kudu/codegen/compilation_manager.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
+#include "kudu/common/types.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/gutil/dynamic_annotations.h"
@@ -51,6 +54,14 @@ DEFINE_bool(mrs_use_codegen, true, "whether the memrowset should use code "
             "generation for iteration");
 TAG_FLAG(mrs_use_codegen, hidden);
 
+DEFINE_bool(mrs_use_columnar_layout, false,
+            "Whether new memrowsets should store the cells of their rows in per-column "
+            "chunks rather than as contiguous rows. Scans and flushes of rows inserted "
+            "in key order, as with time series, can then copy a column at a time. "
+            "Code generation isn't used to scan memrowsets with this layout.");
+TAG_FLAG(mrs_use_columnar_layout, experimental);
+
+using std::min;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -118,6 +129,8 @@ MemRowSet::MemRowSet(int64_t id,
         CreateMemTrackerForMemRowSet(id, std::move(parent_tracker)))),
     arena_(new ThreadSafeMemoryTrackingArena(kInitialArenaSize, allocator_)),
     tree_(arena_),
+    column_store_(FLAGS_mrs_use_columnar_layout ?
+                  new MRSColumnStore(&schema_, arena_.get()) : nullptr),
     debug_insert_count_(0),
     debug_update_count_(0),
     anchorer_(log_anchor_registry, Substitute("MemRowSet-$0", id_)),
@@ -150,16 +163,28 @@ Status MemRowSet::DebugDump(vector<string> *lines) {
 Status MemRowSet::Insert(Timestamp timestamp,
                          const ConstContiguousRow& row,
                          const OpId& op_id) {
+  return Insert(timestamp, row, op_id, nullptr);
+}
+
+Status MemRowSet::Insert(Timestamp timestamp,
+                         const ConstContiguousRow& row,
+                         const OpId& op_id,
+                         MRSInsertHint* hint) {
   CHECK(row.schema()->has_column_ids());
   DCHECK_SCHEMA_EQ(schema_, *row.schema());
 
+  if (hint != nullptr && hint->memrowset_ != this) {
+    hint->memrowset_ = this;
+    hint->leaf_ = nullptr;
+  }
+
   {
     faststring enc_key_buf;
     schema_.EncodeComparableKey(row, &enc_key_buf);
     Slice enc_key(enc_key_buf);
 
     btree::PreparedMutation<MSBTreeTraits> mutation(enc_key);
-    mutation.Prepare(&tree_);
+    mutation.PrepareWithHint(&tree_, hint ? hint->leaf_ : nullptr);
 
     // TODO: for now, the key ends up stored doubly --
     // once encoded in the btree key, and again in the value
@@ -178,16 +203,36 @@ Status MemRowSet::Insert(Timestamp timestamp,
       return Reinsert(timestamp, row, &ms_row);
     }
 
-    // Copy the non-encoded key onto the stack since we need
-    // to mutate it when we relocate its Slices into our arena.
-    DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
-    mrsrow.header_->insertion_timestamp = timestamp;
-    mrsrow.header_->redo_head = nullptr;
-    RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+    if (column_store_) {
+      // The tree only stores the header and the ordinal of the row, and the
+      // cells go to the column store.
+      uint8_t mrsrow_storage[sizeof(MRSRow::Header) + sizeof(rowid_t)];
+      Slice mrsrow_slice(mrsrow_storage, sizeof(mrsrow_storage));
+      MRSRow mrsrow(this, mrsrow_slice);
+      mrsrow.header_->insertion_timestamp = timestamp;
+      mrsrow.header_->redo_head = nullptr;
+      UnalignedStore<rowid_t>(mrsrow.row_slice_.mutable_data(), column_store_->AddRow());
+      RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+
+      CHECK(mutation.Insert(mrsrow_slice))
+      << "Expected to be able to insert, since the prepared mutation "
+      << "succeeded!";
+    } else {
+      // Copy the non-encoded key onto the stack since we need
+      // to mutate it when we relocate its Slices into our arena.
+      DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
+      mrsrow.header_->insertion_timestamp = timestamp;
+      mrsrow.header_->redo_head = nullptr;
+      RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+
+      CHECK(mutation.Insert(mrsrow_slice))
+      << "Expected to be able to insert, since the prepared mutation "
+      << "succeeded!";
+    }
 
-    CHECK(mutation.Insert(mrsrow_slice))
-    << "Expected to be able to insert, since the prepared mutation "
-    << "succeeded!";
+    if (hint != nullptr) {
+      hint->leaf_ = mutation.leaf();
+    }
   }
 
   anchorer_.AnchorIfMinimum(op_id.index());
@@ -327,6 +372,7 @@ class MemRowSet::Iterator::MRSRowProjector {
                                    RowBlockRow* dst_row,
                                    Arena* arena) = 0;
   virtual const vector<ProjectionIdxMapping>& base_cols_mapping() const = 0;
+  virtual const vector<size_t>& projection_defaults() const = 0;
   virtual Status Init() = 0;
 };
 
@@ -356,16 +402,21 @@ class MRSRowProjectorImpl : public MRSRowProjector {
     return actual_->base_cols_mapping();
   }
 
+  const vector<size_t>& projection_defaults() const override {
+    return actual_->projection_defaults();
+  }
+
  private:
   gscoped_ptr<ActualProjector> actual_;
 };
 
 // If codegen is enabled, then generates a codegen::RowProjector;
-// otherwise makes a regular one.
+// otherwise makes a regular one. The generated code reads contiguous
+// rows, so it can't be used with the columnar layout.
 gscoped_ptr<MRSRowProjector> GenerateAppropriateProjector(
-  const Schema* base, const Schema* projection) {
+  const Schema* base, const Schema* projection, bool columnar) {
   // Attempt code-generated implementation
-  if (FLAGS_mrs_use_codegen) {
+  if (FLAGS_mrs_use_codegen && !columnar) {
     gscoped_ptr<codegen::RowProjector> actual;
     if (codegen::CompilationManager::GetSingleton()->RequestRowProjector(
           base, projection, &actual)) {
@@ -389,7 +440,8 @@ MemRowSet::Iterator::Iterator(const std::shared_ptr<const MemRowSet>& mrs,
       iter_(iter),
       opts_(std::move(opts)),
       projector_(
-          GenerateAppropriateProjector(&mrs->schema_nonvirtual(), opts_.projection)),
+          GenerateAppropriateProjector(&mrs->schema_nonvirtual(), opts_.projection,
+                                       mrs->column_store() != nullptr)),
       delta_projector_(&mrs->schema_nonvirtual(), opts_.projection),
       state_(kUninitialized) {
   // TODO(todd): various code assumes that a newly constructed iterator
@@ -473,7 +525,11 @@ Status MemRowSet::Iterator::NextBlock(RowBlock *dst) {
   // Fill
   dst->selection_vector()->SetAllTrue();
   size_t fetched;
-  RETURN_NOT_OK(FetchRows(dst, &fetched));
+  if (memrowset_->column_store()) {
+    RETURN_NOT_OK(FetchColumnarRows(dst, &fetched));
+  } else {
+    RETURN_NOT_OK(FetchRows(dst, &fetched));
+  }
   DCHECK_LE(0, fetched);
   DCHECK_LE(fetched, dst->nrows());
 
@@ -529,6 +585,134 @@ Status MemRowSet::Iterator::FetchRows(RowBlock* dst, size_t* fetched) {
   return Status::OK();
 }
 
+Status MemRowSet::Iterator::FetchColumnarRows(RowBlock* dst, size_t* fetched) {
+  *fetched = 0;
+  // Copy the rows a leaf at a time, so that the cells of runs of consecutive
+  // ordinals are copied a column at a time.
+  while (*fetched < dst->nrows() && iter_->IsValid()) {
+    const size_t first_in_leaf = iter_->index_in_leaf();
+    size_t n = min(remaining_in_leaf(), dst->nrows() - *fetched);
+    if (has_upper_bound()) {
+      for (size_t i = 0; i < n; i++) {
+        if (out_of_bounds(iter_->GetKeyInLeaf(first_in_leaf + i))) {
+          n = i;
+          state_ = kFinished;
+          break;
+        }
+      }
+    }
+
+    // Uncommitted rows are copied as well, and unselected below.
+    RETURN_NOT_OK(ProjectColumnarRowsInLeaf(n, dst, *fetched, dst->arena()));
+
+    for (size_t i = 0; i < n; i++) {
+      Slice k, v;
+      iter_->GetEntryInLeaf(first_in_leaf + i, &k, &v);
+      MRSRow row(memrowset_.get(), v);
+      if (opts_.snap_to_include.IsCommitted(row.insertion_timestamp())) {
+        // Roll-forward MVCC for committed updates.
+        RowBlockRow dst_row = dst->row(*fetched + i);
+        RETURN_NOT_OK(ApplyMutationsToProjectedRow(
+            row.acquire_redo_head(), &dst_row, dst->arena()));
+      } else {
+        // This row was not yet committed in the current MVCC snapshot
+        dst->selection_vector()->SetRowUnselected(*fetched + i);
+      }
+    }
+    *fetched += n;
+
+    if (state_ == kFinished) {
+      break;
+    }
+    for (size_t i = 0; i < n; i++) {
+      iter_->Next();
+    }
+  }
+  return Status::OK();
+}
+
+Status MemRowSet::Iterator::ProjectRowsInLeaf(size_t n, RowBlock* dst, size_t dst_idx,
+                                              Arena* row_arena) {
+  DCHECK_NE(state_, kUninitialized) << "not initted";
+  DCHECK_LE(n, remaining_in_leaf());
+  if (memrowset_->column_store()) {
+    return ProjectColumnarRowsInLeaf(n, dst, dst_idx, row_arena);
+  }
+  const size_t first_in_leaf = iter_->index_in_leaf();
+  for (size_t i = 0; i < n; i++) {
+    Slice k, v;
+    iter_->GetEntryInLeaf(first_in_leaf + i, &k, &v);
+    RowBlockRow dst_row = dst->row(dst_idx + i);
+    RETURN_NOT_OK(projector_->ProjectRowForRead(MRSRow(memrowset_.get(), v),
+                                                &dst_row, row_arena));
+  }
+  return Status::OK();
+}
+
+Status MemRowSet::Iterator::ProjectColumnarRowsInLeaf(size_t n, RowBlock* dst, size_t dst_idx,
+                                                      Arena* row_arena) {
+  const MRSColumnStore* store = DCHECK_NOTNULL(memrowset_->column_store());
+  if (n == 0) {
+    return Status::OK();
+  }
+  const size_t first_in_leaf = iter_->index_in_leaf();
+  ordinals_buf_.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    Slice k, v;
+    iter_->GetEntryInLeaf(first_in_leaf + i, &k, &v);
+    ordinals_buf_[i] = MRSRow(memrowset_.get(), v).ordinal();
+  }
+
+  // Copy the runs of rows with consecutive ordinals in the same chunk.
+  size_t run_start = 0;
+  while (run_start < n) {
+    size_t run_end = run_start + 1;
+    while (run_end < n &&
+           ordinals_buf_[run_end] == ordinals_buf_[run_end - 1] + 1 &&
+           ordinals_buf_[run_end] % MRSColumnStore::kRowsPerChunk != 0) {
+      run_end++;
+    }
+    for (const auto& mapping : projector_->base_cols_mapping()) {
+      ColumnBlock dst_col = dst->column_block(mapping.first);
+      store->CopyCells(mapping.second, ordinals_buf_[run_start], run_end - run_start,
+                       &dst_col, dst_idx + run_start);
+    }
+    run_start = run_end;
+  }
+
+  // The copied slices still point into the memrowset's arena.
+  if (row_arena != nullptr) {
+    for (const auto& mapping : projector_->base_cols_mapping()) {
+      ColumnBlock dst_col = dst->column_block(mapping.first);
+      if (dst_col.type_info()->physical_type() != BINARY) {
+        continue;
+      }
+      for (size_t i = dst_idx; i < dst_idx + n; i++) {
+        ColumnBlock::Cell cell = dst_col.cell(i);
+        if (cell.is_nullable() && cell.is_null()) {
+          continue;
+        }
+        Slice* slice = reinterpret_cast<Slice*>(cell.mutable_ptr());
+        if (PREDICT_FALSE(!row_arena->RelocateSlice(*slice, slice))) {
+          return Status::IOError("out of memory copying slice", slice->ToString());
+        }
+      }
+    }
+  }
+
+  // Fill the columns which aren't in the memrowset's schema with their defaults.
+  for (size_t proj_idx : projector_->projection_defaults()) {
+    const ColumnSchema& col_proj = opts_.projection->column(proj_idx);
+    SimpleConstCell src_cell(&col_proj, col_proj.read_default_value());
+    for (size_t i = dst_idx; i < dst_idx + n; i++) {
+      RowBlockRow dst_row = dst->row(i);
+      RowBlockRow::Cell dst_cell = dst_row.cell(proj_idx);
+      RETURN_NOT_OK(CopyCell(src_cell, &dst_cell, row_arena));
+    }
+  }
+  return Status::OK();
+}
+
 Status MemRowSet::Iterator::ApplyMutationsToProjectedRow(
   const Mutation *mutation_head, RowBlockRow *dst_row, Arena *dst_arena) {
   // Fast short-circuit the likely case of a row which was inserted and never
@@ -588,7 +772,15 @@ Status MemRowSet::Iterator::GetCurrentRow(RowBlockRow* dst_row,
                                           Mutation** redo_head,
                                           Arena* mutation_arena,
                                           Timestamp* insertion_timestamp) {
+  RETURN_NOT_OK(GetCurrentRowMutations(redo_head, mutation_arena, insertion_timestamp));
+
+  // Project the Row
+  return projector_->ProjectRowForRead(GetCurrentRow(), dst_row, row_arena);
+}
 
+Status MemRowSet::Iterator::GetCurrentRowMutations(Mutation** redo_head,
+                                                   Arena* mutation_arena,
+                                                   Timestamp* insertion_timestamp) {
   DCHECK(redo_head != nullptr);
 
   // Get the row from the MemRowSet. It may have a different schema from the iterator projection.
@@ -627,9 +819,7 @@ Status MemRowSet::Iterator::GetCurrentRow(RowBlockRow* dst_row,
       prev_redo = mutation;
     }
   }
-
-  // Project the Row
-  return projector_->ProjectRowForRead(src_row, dst_row, row_arena);
+  return Status::OK();
 }
 
 } // namespace tablet
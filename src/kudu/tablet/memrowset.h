@@ -37,7 +37,9 @@
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
 #include "kudu/tablet/concurrent_btree.h"
+#include "kudu/tablet/mrs_column_store.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/util/faststring.h"
@@ -77,6 +79,11 @@ namespace tablet {
 // of the row's primary key, such that the entries sort correctly using the default
 // lexicographic comparator. The value for each row is an instance of MRSRow.
 //
+// With the columnar layout (see --mrs_use_columnar_layout), the CBTree entry
+// of a row only holds the ordinal of the row in an MRSColumnStore, which keeps
+// the cells of each column contiguous, so that scans and flushes can copy
+// ranges of rows a column at a time.
+//
 // NOTE: all allocations done by the MemRowSet are done inside its associated
 // thread-safe arena, and then freed in bulk when the MemRowSet is destructed.
 
@@ -90,13 +97,7 @@ class MRSRow {
  public:
   typedef ContiguousRowCell<MRSRow> Cell;
 
-  MRSRow(const MemRowSet *memrowset, const Slice &s) {
-    DCHECK_GE(s.size(), sizeof(Header));
-    row_slice_ = s;
-    header_ = reinterpret_cast<Header *>(row_slice_.mutable_data());
-    row_slice_.remove_prefix(sizeof(Header));
-    memrowset_ = memrowset;
-  }
+  MRSRow(const MemRowSet *memrowset, const Slice &s);
 
   const Schema* schema() const;
 
@@ -113,18 +114,39 @@ class MRSRow {
 
   const Slice &row_slice() const { return row_slice_; }
 
-  const uint8_t* row_data() const { return row_slice_.data(); }
+  // Return the contiguous row data. Only valid with the row layout.
+  const uint8_t* row_data() const {
+    DCHECK(column_store_ == nullptr) << "no row data with the columnar layout";
+    return row_slice_.data();
+  }
+
+  // Return the ordinal of the row in the column store. Only valid with the
+  // columnar layout.
+  rowid_t ordinal() const {
+    DCHECK(column_store_ != nullptr) << "no ordinal with the row layout";
+    return UnalignedLoad<rowid_t>(row_slice_.data());
+  }
 
   bool is_null(size_t col_idx) const {
+    if (column_store_ != nullptr) {
+      return column_store_->is_null(ordinal(), col_idx);
+    }
     return ContiguousRowHelper::is_null(*schema(), row_slice_.data(), col_idx);
   }
 
   void set_null(size_t col_idx, bool is_null) const {
+    if (column_store_ != nullptr) {
+      column_store_->set_null(ordinal(), col_idx, is_null);
+      return;
+    }
     ContiguousRowHelper::SetCellIsNull(*schema(),
       const_cast<uint8_t*>(row_slice_.data()), col_idx, is_null);
   }
 
   const uint8_t *cell_ptr(size_t col_idx) const {
+    if (column_store_ != nullptr) {
+      return column_store_->cell_ptr(ordinal(), col_idx);
+    }
     return ContiguousRowHelper::cell_ptr(*schema(), row_slice_.data(), col_idx);
   }
 
@@ -133,6 +155,9 @@ class MRSRow {
   }
 
   const uint8_t *nullable_cell_ptr(size_t col_idx) const {
+    if (column_store_ != nullptr) {
+      return is_null(col_idx) ? nullptr : cell_ptr(col_idx);
+    }
     return ContiguousRowHelper::nullable_cell_ptr(*schema(), row_slice_.data(), col_idx);
   }
 
@@ -155,6 +180,17 @@ class MRSRow {
 
   template <class ArenaType>
   Status CopyRow(const ConstContiguousRow& row, ArenaType *arena) {
+    if (column_store_ != nullptr) {
+      // The row's ordinal must already be set: copy each cell to its column.
+      const Schema* schema = row.schema();
+      for (size_t i = 0; i < schema->num_columns(); i++) {
+        memcpy(mutable_cell_ptr(i), row.cell_ptr(i), schema->column(i).type_info()->size());
+        if (schema->column(i).is_nullable()) {
+          set_null(i, row.is_null(i));
+        }
+      }
+      return kudu::RelocateIndirectDataToArena(this, arena);
+    }
     // the representation of the MRSRow and ConstContiguousRow is the same.
     // so, instead of using CopyRow we can just do a memcpy.
     memcpy(row_slice_.mutable_data(), row.row_data(), row_slice_.size());
@@ -175,10 +211,14 @@ class MRSRow {
 
   Header *header_;
 
-  // Actual row data.
+  // Actual row data, or the row's ordinal in 'column_store_' with the
+  // columnar layout.
   Slice row_slice_;
 
   const MemRowSet *memrowset_;
+
+  // The column store of the MemRowSet, or NULL with the row layout.
+  const MRSColumnStore* column_store_;
 };
 
 struct MSBTreeTraits : public btree::BTreeTraits {
@@ -197,10 +237,29 @@ struct MSBTreeTraits : public btree::BTreeTraits {
   ContiguousRowHelper::InitNullsBitmap((memrowset)->schema_nonvirtual(), slice_name); \
   MRSRow varname(memrowset, slice_name);
 
+// Remembers the leaf of the MemRowSet's tree where the previous row inserted
+// with it went, so that inserting a run of rows in increasing key order, as
+// with appends of time series or sorted write batches, doesn't descend the
+// tree from the root for each row.
+//
+// A hint must only be used with a single MemRowSet, by one thread at a time.
+class MRSInsertHint {
+ public:
+  MRSInsertHint() : memrowset_(nullptr), leaf_(nullptr) {}
+
+ private:
+  friend class MemRowSet;
+
+  const MemRowSet* memrowset_;
+  btree::LeafNode<MSBTreeTraits>* leaf_;
+
+  DISALLOW_COPY_AND_ASSIGN(MRSInsertHint);
+};
+
 
 // In-memory storage for data currently being written to the tablet.
-// This is a holding area for inserts, currently held in row form
-// (i.e not columnar)
+// This is a holding area for inserts, held in row form, or in columnar form
+// with --mrs_use_columnar_layout.
 //
 // The data is kept sorted.
 class MemRowSet : public RowSet,
@@ -230,6 +289,12 @@ class MemRowSet : public RowSet,
                 const ConstContiguousRow& row,
                 const consensus::OpId& op_id);
 
+  // Same as above, but first tries to insert the row next to the previous row
+  // inserted with 'hint', and updates 'hint' to the new row. 'hint' may be NULL.
+  Status Insert(Timestamp timestamp,
+                const ConstContiguousRow& row,
+                const consensus::OpId& op_id,
+                MRSInsertHint* hint);
 
   // Update or delete an existing row in the memrowset.
   //
@@ -336,6 +401,12 @@ class MemRowSet : public RowSet,
     return id_;
   }
 
+  // Return the store of the cells of the rows with the columnar layout, or
+  // NULL with the row layout.
+  const MRSColumnStore* column_store() const {
+    return column_store_.get();
+  }
+
   std::shared_ptr<RowSetMetadata> metadata() override {
     return std::shared_ptr<RowSetMetadata>(
         reinterpret_cast<RowSetMetadata *>(NULL));
@@ -429,6 +500,9 @@ class MemRowSet : public RowSet,
 
   MSBTree tree_;
 
+  // Set only with the columnar layout.
+  gscoped_ptr<MRSColumnStore> column_store_;
+
   // Approximate counts of mutations. This variable is updated non-atomically,
   // so it cannot be relied upon to be in any way accurate. It's only used
   // as a sanity check during flush.
@@ -504,6 +578,20 @@ class MemRowSet::Iterator : public RowwiseIterator {
                        Arena* mutation_arena,
                        Timestamp* insertion_timestamp);
 
+  // Same as above, but only returns the insertion timestamp and the projected
+  // mutations of the current row.
+  Status GetCurrentRowMutations(Mutation** redo_head,
+                                Arena* mutation_arena,
+                                Timestamp* insertion_timestamp);
+
+  // Copy the current row and the 'n - 1' following rows in the current leaf,
+  // as by GetCurrentRow(), into the rows of 'dst' starting at 'dst_idx'. The
+  // iterator isn't moved.
+  //
+  // With the columnar layout, the runs of rows with consecutive ordinals are
+  // copied with one memcpy() per column.
+  Status ProjectRowsInLeaf(size_t n, RowBlock* dst, size_t dst_idx, Arena* row_arena);
+
   bool Next() {
     DCHECK_NE(state_, kUninitialized) << "not initted";
     return iter_->Next();
@@ -544,6 +632,8 @@ class MemRowSet::Iterator : public RowwiseIterator {
 
   // Various helper functions called while getting the next RowBlock
   Status FetchRows(RowBlock* dst, size_t* fetched);
+  Status FetchColumnarRows(RowBlock* dst, size_t* fetched);
+  Status ProjectColumnarRowsInLeaf(size_t n, RowBlock* dst, size_t dst_idx, Arena* row_arena);
   Status ApplyMutationsToProjectedRow(const Mutation *mutation_head,
                                       RowBlockRow *dst_row,
                                       Arena *dst_arena);
@@ -567,6 +657,9 @@ class MemRowSet::Iterator : public RowwiseIterator {
   // seek target.
   faststring tmp_buf;
 
+  // Temporary buffer for the ordinals of the rows copied with the columnar layout.
+  std::vector<rowid_t> ordinals_buf_;
+
   // State of the scanner: indicates whether we should keep scanning/fetching,
   // whether we've scanned the last batch, or whether we've reached the upper bounds
   // or will never reach the lower bounds (no more rows can be returned)
@@ -576,6 +669,15 @@ class MemRowSet::Iterator : public RowwiseIterator {
   boost::optional<const Slice &> exclusive_upper_bound_;
 };
 
+inline MRSRow::MRSRow(const MemRowSet *memrowset, const Slice &s) {
+  DCHECK_GE(s.size(), sizeof(Header));
+  row_slice_ = s;
+  header_ = reinterpret_cast<Header *>(row_slice_.mutable_data());
+  row_slice_.remove_prefix(sizeof(Header));
+  memrowset_ = memrowset;
+  column_store_ = memrowset->column_store();
+}
+
 inline const Schema* MRSRow::schema() const {
   return &memrowset_->schema_nonvirtual();
 }
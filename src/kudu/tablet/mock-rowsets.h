@@ -20,6 +20,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/common/timestamp.h"
@@ -192,10 +193,33 @@ class MockDiskRowSet : public MockRowSet {
                                Slice(last_key_).ToDebugString());
   }
 
+  virtual Status GetKeyRanges(
+      std::vector<std::pair<std::string, std::string>>* ranges) const OVERRIDE {
+    if (key_ranges_.empty()) {
+      return RowSet::GetKeyRanges(ranges);
+    }
+    *ranges = key_ranges_;
+    return Status::OK();
+  }
+
+  virtual RowSetReadStats GetReadStats() const OVERRIDE {
+    return read_stats_;
+  }
+
+  void set_key_ranges(std::vector<std::pair<std::string, std::string>> key_ranges) {
+    key_ranges_ = std::move(key_ranges);
+  }
+
+  void set_read_stats(const RowSetReadStats& read_stats) {
+    read_stats_ = read_stats;
+  }
+
  private:
   const std::string first_key_;
   const std::string last_key_;
   const uint64_t size_;
+  std::vector<std::pair<std::string, std::string>> key_ranges_;
+  RowSetReadStats read_stats_;
 };
 
 // Mock which acts like a MemRowSet and has no known bounds.
@@ -0,0 +1,120 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/mrs_column_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/memory/arena.h"
+
+namespace kudu {
+namespace tablet {
+
+static const size_t kInitialChunksCapacity = 16;
+
+MRSColumnStore::MRSColumnStore(const Schema* schema, ThreadSafeMemoryTrackingArena* arena)
+    : schema_(schema),
+      arena_(arena),
+      next_ordinal_(0),
+      chunks_(nullptr),
+      num_chunks_(0),
+      chunks_capacity_(0) {
+  cell_sizes_.reserve(schema_->num_columns());
+  for (size_t i = 0; i < schema_->num_columns(); i++) {
+    cell_sizes_.push_back(schema_->column(i).type_info()->size());
+  }
+}
+
+rowid_t MRSColumnStore::AddRow() {
+  rowid_t ordinal = next_ordinal_.fetch_add(1, std::memory_order_relaxed);
+  size_t chunk_idx = ordinal / kRowsPerChunk;
+  if (PREDICT_FALSE(chunk_idx >= num_chunks_.load(std::memory_order_acquire))) {
+    // Several inserters may race to allocate the same chunk.
+    std::lock_guard<simple_spinlock> l(lock_);
+    while (num_chunks_.load(std::memory_order_relaxed) <= chunk_idx) {
+      AddChunkUnlocked();
+    }
+  }
+  return ordinal;
+}
+
+void MRSColumnStore::AddChunkUnlocked() {
+  DCHECK(lock_.is_locked());
+  size_t num_chunks = num_chunks_.load(std::memory_order_relaxed);
+  ColumnData** chunks = chunks_.load(std::memory_order_relaxed);
+  if (num_chunks == chunks_capacity_) {
+    size_t new_capacity = std::max(kInitialChunksCapacity, chunks_capacity_ * 2);
+    auto* new_chunks = static_cast<ColumnData**>(
+        arena_->AllocateBytesAligned(new_capacity * sizeof(ColumnData*), alignof(ColumnData*)));
+    CHECK(new_chunks) << "failed to allocate chunk directory from arena";
+    if (num_chunks > 0) {
+      memcpy(new_chunks, chunks, num_chunks * sizeof(ColumnData*));
+    }
+    chunks = new_chunks;
+    chunks_capacity_ = new_capacity;
+    chunks_.store(chunks, std::memory_order_release);
+  }
+
+  auto* columns = static_cast<ColumnData*>(arena_->AllocateBytesAligned(
+      schema_->num_columns() * sizeof(ColumnData), alignof(ColumnData)));
+  CHECK(columns) << "failed to allocate chunk from arena";
+  for (size_t i = 0; i < schema_->num_columns(); i++) {
+    columns[i].cells = static_cast<uint8_t*>(
+        arena_->AllocateBytesAligned(kRowsPerChunk * cell_sizes_[i], 16));
+    CHECK(columns[i].cells) << "failed to allocate chunk from arena";
+    columns[i].nulls = nullptr;
+    if (schema_->column(i).is_nullable()) {
+      columns[i].nulls = static_cast<uint8_t*>(arena_->AllocateBytes(kRowsPerChunk));
+      CHECK(columns[i].nulls) << "failed to allocate chunk from arena";
+    }
+  }
+  chunks[num_chunks] = columns;
+  num_chunks_.store(num_chunks + 1, std::memory_order_release);
+}
+
+void MRSColumnStore::CopyCells(size_t col_idx, rowid_t first_ordinal, size_t n,
+                               ColumnBlock* dst, size_t dst_idx) const {
+  DCHECK_EQ(first_ordinal / kRowsPerChunk, (first_ordinal + n - 1) / kRowsPerChunk)
+      << "rows span several chunks";
+  DCHECK_EQ(dst->stride(), cell_sizes_[col_idx]);
+  const ColumnData& col = chunk(first_ordinal)[col_idx];
+  size_t offset = first_ordinal % kRowsPerChunk;
+  memcpy(dst->data() + dst_idx * dst->stride(), col.cells + offset * cell_sizes_[col_idx],
+         n * cell_sizes_[col_idx]);
+
+  if (dst->is_nullable()) {
+    if (col.nulls == nullptr) {
+      BitmapChangeBits(dst->null_bitmap(), dst_idx, n, true);
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        BitmapChange(dst->null_bitmap(), dst_idx + i, !col.nulls[offset + i]);
+      }
+    }
+  } else {
+    DCHECK(col.nulls == nullptr) << "nullable column projected as not nullable";
+  }
+}
+
+} // namespace tablet
+} // namespace kudu
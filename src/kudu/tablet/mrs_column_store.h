@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+
+namespace kudu {
+
+class ColumnBlock;
+class Schema;
+class ThreadSafeMemoryTrackingArena;
+
+namespace tablet {
+
+// Column-major storage for the cells of the rows of a MemRowSet which uses
+// the columnar layout (see --mrs_use_columnar_layout).
+//
+// Each row gets an ordinal when it is inserted, and the cells of the rows are
+// stored in chunks of kRowsPerChunk consecutive ordinals. Within a chunk, each
+// column has its own array of cells, and an array of null flags if it is
+// nullable, all allocated from the MemRowSet's arena. The CBTree then only
+// stores the row's header and ordinal along with its encoded key.
+//
+// Ordinals are assigned in insertion order, so when the rows are inserted in
+// key order, as with time series, the consecutive rows of a leaf of the tree
+// usually have consecutive ordinals, and a scan or a flush can copy the cells
+// of such a run into a ColumnBlock with one memcpy() per column.
+//
+// The cells of a row are written once, by its inserter, before the row is
+// inserted into the tree. Updates are stored as mutations, as with the row
+// layout, so the cells are immutable once readers may find the row.
+class MRSColumnStore {
+ public:
+  enum {
+    kRowsPerChunk = 1024
+  };
+
+  // 'schema' and 'arena' must outlive the store.
+  MRSColumnStore(const Schema* schema, ThreadSafeMemoryTrackingArena* arena);
+
+  // Reserve the storage of a new row, and return its ordinal.
+  rowid_t AddRow();
+
+  const uint8_t* cell_ptr(rowid_t ordinal, size_t col_idx) const {
+    return chunk(ordinal)[col_idx].cells + (ordinal % kRowsPerChunk) * cell_sizes_[col_idx];
+  }
+
+  uint8_t* mutable_cell_ptr(rowid_t ordinal, size_t col_idx) const {
+    return const_cast<uint8_t*>(cell_ptr(ordinal, col_idx));
+  }
+
+  bool is_null(rowid_t ordinal, size_t col_idx) const {
+    const uint8_t* nulls = chunk(ordinal)[col_idx].nulls;
+    DCHECK(nulls != nullptr) << "column " << col_idx << " is not nullable";
+    return nulls[ordinal % kRowsPerChunk];
+  }
+
+  void set_null(rowid_t ordinal, size_t col_idx, bool is_null) const {
+    uint8_t* nulls = chunk(ordinal)[col_idx].nulls;
+    DCHECK(nulls != nullptr) << "column " << col_idx << " is not nullable";
+    nulls[ordinal % kRowsPerChunk] = is_null;
+  }
+
+  // Copy the cells of column 'col_idx' of the 'n' rows with consecutive
+  // ordinals starting at 'first_ordinal' into 'dst', starting at its row
+  // 'dst_idx'. The rows must all be in the same chunk.
+  //
+  // BINARY cells are copied as is, and still refer to the MemRowSet's arena.
+  void CopyCells(size_t col_idx, rowid_t first_ordinal, size_t n,
+                 ColumnBlock* dst, size_t dst_idx) const;
+
+ private:
+  // The storage of one column in a chunk.
+  struct ColumnData {
+    uint8_t* cells;
+    // One byte per row, rather than a bitmap, so that concurrent inserters
+    // never write to the same byte. NULL if the column isn't nullable.
+    uint8_t* nulls;
+  };
+
+  // Return the columns of the chunk holding the row 'ordinal'.
+  const ColumnData* chunk(rowid_t ordinal) const {
+    return chunks_.load(std::memory_order_acquire)[ordinal / kRowsPerChunk];
+  }
+
+  // Allocate a new chunk and append it to 'chunks_', growing the directory
+  // if it is full. 'lock_' must be held.
+  void AddChunkUnlocked();
+
+  const Schema* const schema_;
+  ThreadSafeMemoryTrackingArena* const arena_;
+
+  // The size of the cells of each column.
+  std::vector<size_t> cell_sizes_;
+
+  // The ordinal of the next row to be added.
+  std::atomic<rowid_t> next_ordinal_;
+
+  // Protects the allocation of the chunks.
+  simple_spinlock lock_;
+
+  // The directory of the chunks, and the number of chunks it holds. When the
+  // directory is full, a copy twice as large is allocated from the arena and
+  // published with a release store. Readers which loaded the previous copy
+  // may keep using it, since it stays valid as long as the arena.
+  std::atomic<ColumnData**> chunks_;
+  std::atomic<size_t> num_chunks_;
+  size_t chunks_capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(MRSColumnStore);
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -22,6 +22,8 @@
 #include <string>
 #include <utility>
 
+#include <boost/bind.hpp> // IWYU pragma: keep
+
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/common/columnblock.h"
@@ -31,7 +33,9 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/stl_util.h"
+#include "kudu/util/threadpool.h"
 
 namespace kudu {
 namespace tablet {
@@ -44,14 +48,22 @@ using std::unique_ptr;
 
 MultiColumnWriter::MultiColumnWriter(FsManager* fs,
                                      const Schema* schema,
-                                     std::string tablet_id)
+                                     std::string tablet_id,
+                                     ThreadPool* pool)
   : fs_(fs),
     schema_(schema),
     finished_(false),
-    tablet_id_(std::move(tablet_id)) {
+    tablet_id_(std::move(tablet_id)),
+    append_statuses_(schema->num_columns()) {
+  // With a single column there is nothing to run in parallel.
+  if (pool && schema->num_columns() > 1) {
+    pool_token_ = pool->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
+  }
 }
 
 MultiColumnWriter::~MultiColumnWriter() {
+  // Make sure no task still refers to the writers.
+  pool_token_.reset();
   STLDeleteElements(&cfile_writers_);
 }
 
@@ -69,6 +81,10 @@ Status MultiColumnWriter::Open() {
     // the corresponding rows.
     opts.write_posidx = true;
 
+    // Keep the min/max values of each data block, so that scans can skip
+    // blocks which can't match their predicates.
+    opts.write_block_stats = true;
+
     /// Set the column storage attributes.
     opts.storage_attributes = col.attributes();
 
@@ -101,18 +117,51 @@ Status MultiColumnWriter::Open() {
 }
 
 Status MultiColumnWriter::AppendBlock(const RowBlock& block) {
+  StartAppendBlock(block);
+  return WaitForAppendBlock();
+}
+
+void MultiColumnWriter::StartAppendBlock(const RowBlock& block) {
+  DCHECK_EQ(block.schema().num_columns(), schema_->num_columns());
   for (int i = 0; i < schema_->num_columns(); i++) {
-    ColumnBlock column = block.column_block(i);
-    if (column.is_nullable()) {
-      RETURN_NOT_OK(cfile_writers_[i]->AppendNullableEntries(column.null_bitmap(),
-          column.data(), column.nrows()));
-    } else {
-      RETURN_NOT_OK(cfile_writers_[i]->AppendEntries(column.data(), column.nrows()));
+    if (pool_token_) {
+      Status s = pool_token_->SubmitFunc(
+          boost::bind(&MultiColumnWriter::AppendColumn, this, &block, i));
+      if (PREDICT_TRUE(s.ok())) {
+        continue;
+      }
+      // The pool is shutting down: write the column from this thread instead.
+      VLOG(1) << "Unable to submit append of column " << i << ": " << s.ToString();
+    }
+    AppendColumn(&block, i);
+  }
+}
+
+Status MultiColumnWriter::WaitForAppendBlock() {
+  if (pool_token_) {
+    pool_token_->Wait();
+  }
+  for (int i = 0; i < schema_->num_columns(); i++) {
+    Status s = append_statuses_[i];
+    if (!s.ok()) {
+      return s.CloneAndPrepend("Unable to append to column " + schema_->column(i).ToString());
     }
   }
   return Status::OK();
 }
 
+void MultiColumnWriter::AppendColumn(const RowBlock* block, int col_idx) {
+  ColumnBlock column = block->column_block(col_idx);
+  CFileWriter* writer = cfile_writers_[col_idx];
+  Status s;
+  if (column.is_nullable()) {
+    s = writer->AppendNullableEntries(column.null_bitmap(), column.data(), column.nrows());
+  } else {
+    s = writer->AppendEntries(column.data(), column.nrows());
+  }
+  append_statuses_[col_idx] = std::move(s);
+}
+
 Status MultiColumnWriter::FinishAndReleaseBlocks(
     BlockCreationTransaction* transaction) {
   CHECK(!finished_);
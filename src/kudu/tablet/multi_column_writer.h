@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,8 @@ namespace kudu {
 class FsManager;
 class RowBlock;
 class Schema;
+class ThreadPool;
+class ThreadPoolToken;
 struct ColumnId;
 
 namespace cfile {
@@ -45,13 +48,19 @@ class BlockCreationTransaction;
 
 namespace tablet {
 
-// Wrapper which writes several columns in parallel corresponding to some
-// Schema. Written blocks will fall in the tablet_id's data dir group.
+// Wrapper which writes several columns corresponding to some Schema. Written
+// blocks will fall in the tablet_id's data dir group.
+//
+// If a thread pool is provided, the columns of each appended block are
+// encoded and compressed in parallel by the threads of the pool, one task
+// per column. Otherwise they are written serially by the calling thread.
 class MultiColumnWriter {
  public:
+  // 'pool' may be NULL. If not, it must outlive the writer.
   MultiColumnWriter(FsManager* fs,
                     const Schema* schema,
-                    std::string tablet_id);
+                    std::string tablet_id,
+                    ThreadPool* pool = nullptr);
 
   virtual ~MultiColumnWriter();
 
@@ -63,11 +72,23 @@ class MultiColumnWriter {
   // Note that the selection vector here is ignored.
   Status AppendBlock(const RowBlock& block);
 
+  // Like AppendBlock(), but split in two halves so that the caller may work
+  // on the block (e.g. encode its keys) while the columns are being written
+  // by the pool. 'block' must not be modified or destroyed until
+  // WaitForAppendBlock() returns, and WaitForAppendBlock() must be called
+  // after each call to StartAppendBlock().
+  //
+  // Without a pool, the columns are written before StartAppendBlock() returns.
+  void StartAppendBlock(const RowBlock& block);
+  Status WaitForAppendBlock();
+
   // Close the in-progress CFiles, finalizing the underlying writable
   // blocks and releasing them to 'transaction'.
   Status FinishAndReleaseBlocks(fs::BlockCreationTransaction* transaction);
 
   // Return the number of bytes written so far.
+  //
+  // Must not be called while a block is being appended.
   size_t written_size() const;
 
   cfile::CFileWriter* writer_for_col_idx(int i) {
@@ -81,6 +102,10 @@ class MultiColumnWriter {
   void GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>* ret) const;
 
  private:
+  // Append the column 'col_idx' of 'block' to its CFile, storing the result
+  // in 'append_statuses_'.
+  void AppendColumn(const RowBlock* block, int col_idx);
+
   FsManager* const fs_;
   const Schema* const schema_;
 
@@ -91,6 +116,14 @@ class MultiColumnWriter {
   std::vector<cfile::CFileWriter *> cfile_writers_;
   std::vector<BlockId> block_ids_;
 
+  // The token used to submit the tasks appending the columns to the pool,
+  // or NULL if the columns are written serially.
+  std::unique_ptr<ThreadPoolToken> pool_token_;
+
+  // The result of the last append of each column. Each task only touches
+  // the entry of its own column.
+  std::vector<Status> append_statuses_;
+
   DISALLOW_COPY_AND_ASSIGN(MultiColumnWriter);
 };
 
@@ -15,6 +15,8 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <ostream>
 #include <string>
@@ -37,7 +39,9 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+using std::atomic;
 using std::thread;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -782,5 +786,106 @@ TEST_F(MvccTest, TestCorrectInitWithNoTxns) {
   EXPECT_EQ(snap2.committed_timestamps_.size(), 0);
 }
 
+// Test that snapshots with more committed timestamps than can be published
+// for lock-free readers are still taken correctly.
+TEST_F(MvccTest, TestPublishedSnapshotOverflow) {
+  MvccManager mgr;
+
+  // Keep the first transaction in flight, so that the clean time can't move
+  // past it and the later transactions are tracked as committed timestamps.
+  Timestamp first = clock_->Now();
+  mgr.StartTransaction(first);
+  const int kNumTxns = MvccManager::kMaxPublishedCommitted + 10;
+  vector<Timestamp> committed;
+  for (int i = 0; i < kNumTxns; i++) {
+    Timestamp ts = clock_->Now();
+    mgr.StartTransaction(ts);
+    mgr.StartApplyingTransaction(ts);
+    mgr.CommitTransaction(ts);
+    committed.push_back(ts);
+
+    MvccSnapshot snap;
+    mgr.TakeSnapshot(&snap);
+    ASSERT_EQ(committed.size(), snap.committed_timestamps_.size());
+    ASSERT_EQ(committed.size() > MvccManager::kMaxPublishedCommitted,
+              mgr.published_snap_.num_committed.load() < 0);
+    ASSERT_FALSE(snap.IsCommitted(first));
+    for (const auto& committed_ts : committed) {
+      ASSERT_TRUE(snap.IsCommitted(committed_ts));
+    }
+  }
+
+  // Once the first transaction commits and safe time moves, the snapshot can
+  // be published again.
+  mgr.StartApplyingTransaction(first);
+  mgr.CommitTransaction(first);
+  mgr.AdjustSafeTime(committed.back());
+  ASSERT_GE(mgr.published_snap_.num_committed.load(), 0);
+  MvccSnapshot snap;
+  mgr.TakeSnapshot(&snap);
+  ASSERT_TRUE(snap.IsCommitted(first));
+  for (const auto& committed_ts : committed) {
+    ASSERT_TRUE(snap.IsCommitted(committed_ts));
+  }
+  ASSERT_EQ(committed.back(), mgr.GetCleanTimestamp());
+}
+
+// Benchmark of concurrent writers starting and committing transactions while
+// readers take snapshots, as scans do.
+TEST_F(MvccTest, TestSnapshotContentionBenchmark) {
+  const int kNumWriters = 4;
+  const int kNumReaders = 8;
+  const MonoDelta kDuration = MonoDelta::FromSeconds(AllowSlowTests() ? 10 : 1);
+  MvccManager mgr;
+
+  // Transactions start in timestamp order, and safe time is moved up to each
+  // new transaction, as the TimeManager does on a leader.
+  std::mutex start_lock;
+  Timestamp::val_type next_ts = clock_->Now().value();
+  atomic<bool> stop(false);
+  atomic<int64_t> num_txns(0);
+  atomic<int64_t> num_snapshots(0);
+  vector<thread> threads;
+  for (int i = 0; i < kNumWriters; i++) {
+    threads.emplace_back([&]() {
+        int64_t txns = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          Timestamp ts;
+          {
+            std::lock_guard<std::mutex> l(start_lock);
+            ts = Timestamp(++next_ts);
+            mgr.StartTransaction(ts);
+            mgr.AdjustSafeTime(ts);
+          }
+          mgr.StartApplyingTransaction(ts);
+          mgr.CommitTransaction(ts);
+          txns++;
+        }
+        num_txns += txns;
+      });
+  }
+  for (int i = 0; i < kNumReaders; i++) {
+    threads.emplace_back([&]() {
+        int64_t snapshots = 0;
+        MvccSnapshot snap;
+        while (!stop.load(std::memory_order_relaxed)) {
+          mgr.TakeSnapshot(&snap);
+          snapshots++;
+        }
+        num_snapshots += snapshots;
+      });
+  }
+  SleepFor(kDuration);
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  double secs = kDuration.ToSeconds();
+  LOG(INFO) << kNumWriters << " writers: " << num_txns.load() / secs << " txns/sec";
+  LOG(INFO) << kNumReaders << " readers: " << num_snapshots.load() / secs << " snapshots/sec";
+  ASSERT_EQ(0, mgr.CountTransactionsInFlight());
+}
+
 } // namespace tablet
 } // namespace kudu
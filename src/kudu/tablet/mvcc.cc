@@ -18,6 +18,7 @@
 #include "kudu/tablet/mvcc.h"
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <ostream>
 #include <utility>
@@ -37,12 +38,25 @@ namespace tablet {
 
 using strings::Substitute;
 
+namespace {
+
+// How many times TakeSnapshot() tries to read the published snapshot while
+// it's being updated, before falling back to taking the lock.
+const int kMaxPublishedSnapshotReads = 4;
+
+} // anonymous namespace
+
+constexpr int MvccManager::kMaxPublishedCommitted;
+
 MvccManager::MvccManager()
   : safe_time_(Timestamp::kMin),
     earliest_in_flight_(Timestamp::kMax),
     open_(true) {
   cur_snap_.all_committed_before_ = Timestamp::kInitialTimestamp;
   cur_snap_.none_committed_at_or_after_ = Timestamp::kInitialTimestamp;
+  published_snap_.seq.store(0, std::memory_order_relaxed);
+  std::lock_guard<LockType> l(lock_);
+  PublishSnapshotUnlocked();
 }
 
 void MvccManager::StartTransaction(Timestamp timestamp) {
@@ -124,6 +138,7 @@ void MvccManager::CommitTransaction(Timestamp timestamp) {
     // the "clean" timestamp.
     AdjustCleanTime();
   }
+  PublishSnapshotUnlocked();
 }
 
 MvccManager::TxnState MvccManager::RemoveInFlightAndGetStateUnlocked(Timestamp ts) {
@@ -188,6 +203,7 @@ void MvccManager::AdjustSafeTime(Timestamp safe_time) {
   }
 
   AdjustCleanTime();
+  PublishSnapshotUnlocked();
 }
 
 // Remove any elements from 'v' which are < the given watermark.
@@ -336,7 +352,61 @@ bool MvccManager::AnyApplyingAtOrBeforeUnlocked(Timestamp ts) const {
   return false;
 }
 
+void MvccManager::PublishSnapshotUnlocked() {
+  DCHECK(lock_.is_locked());
+  PublishedSnapshot* pub = &published_snap_;
+  const uint64_t seq = pub->seq.load(std::memory_order_relaxed);
+  pub->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  pub->all_committed_before.store(cur_snap_.all_committed_before_.value(),
+                                  std::memory_order_relaxed);
+  pub->none_committed_at_or_after.store(cur_snap_.none_committed_at_or_after_.value(),
+                                        std::memory_order_relaxed);
+  const auto& committed = cur_snap_.committed_timestamps_;
+  if (committed.size() > kMaxPublishedCommitted) {
+    pub->num_committed.store(-1, std::memory_order_relaxed);
+  } else {
+    for (int i = 0; i < committed.size(); i++) {
+      pub->committed[i].store(committed[i], std::memory_order_relaxed);
+    }
+    pub->num_committed.store(committed.size(), std::memory_order_relaxed);
+  }
+
+  pub->seq.store(seq + 2, std::memory_order_release);
+}
+
+bool MvccManager::ReadPublishedSnapshot(MvccSnapshot* snap) const {
+  const PublishedSnapshot& pub = published_snap_;
+  const uint64_t seq = pub.seq.load(std::memory_order_acquire);
+  if (seq & 1) {
+    // A writer is updating the snapshot.
+    return false;
+  }
+  int num_committed = pub.num_committed.load(std::memory_order_relaxed);
+  if (num_committed < 0) {
+    return false;
+  }
+  snap->all_committed_before_ = Timestamp(
+      pub.all_committed_before.load(std::memory_order_relaxed));
+  snap->none_committed_at_or_after_ = Timestamp(
+      pub.none_committed_at_or_after.load(std::memory_order_relaxed));
+  snap->committed_timestamps_.resize(num_committed);
+  for (int i = 0; i < num_committed; i++) {
+    snap->committed_timestamps_[i] = pub.committed[i].load(std::memory_order_relaxed);
+  }
+
+  // Check that no writer updated the snapshot while it was being read.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return pub.seq.load(std::memory_order_relaxed) == seq;
+}
+
 void MvccManager::TakeSnapshot(MvccSnapshot *snap) const {
+  for (int i = 0; i < kMaxPublishedSnapshotReads; i++) {
+    if (ReadPublishedSnapshot(snap)) {
+      return;
+    }
+  }
   std::lock_guard<LockType> l(lock_);
   *snap = cur_snap_;
 }
@@ -378,6 +448,10 @@ Status MvccManager::WaitForApplyingTransactionsToCommit() const {
 }
 
 bool MvccManager::AreAllTransactionsCommitted(Timestamp ts) const {
+  // Avoid taking the lock if 'ts' is below the clean time.
+  if (ts < GetCleanTimestamp()) {
+    return true;
+  }
   std::lock_guard<LockType> l(lock_);
   return AreAllTransactionsCommittedUnlocked(ts);
 }
@@ -388,8 +462,7 @@ int MvccManager::CountTransactionsInFlight() const {
 }
 
 Timestamp MvccManager::GetCleanTimestamp() const {
-  std::lock_guard<LockType> l(lock_);
-  return cur_snap_.all_committed_before_;
+  return Timestamp(published_snap_.all_committed_before.load(std::memory_order_acquire));
 }
 
 void MvccManager::GetApplyingTransactionsTimestamps(std::vector<Timestamp>* timestamps) const {
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -117,6 +118,7 @@ class MvccSnapshot {
   FRIEND_TEST(MvccTest, TestMayHaveUncommittedTransactionsBefore);
   FRIEND_TEST(MvccTest, TestWaitUntilAllCommitted_SnapAtTimestampWithInFlights);
   FRIEND_TEST(MvccTest, TestCorrectInitWithNoTxns);
+  FRIEND_TEST(MvccTest, TestPublishedSnapshotOverflow);
 
   bool IsCommittedFallback(const Timestamp& timestamp) const;
 
@@ -181,6 +183,12 @@ class MvccSnapshot {
 //
 // See: docs/design_docs/repeatable-reads.md for more information on some of the concepts in
 // this class like "clean" and "safe" time.
+//
+// Transactions are started and committed under a spinlock, since they must
+// update the in-flight set, the committed set and the clean time together.
+// Readers don't take it: every change to the current snapshot is published
+// to a seqlock-protected copy, which TakeSnapshot() reads without locking
+// unless the snapshot has too many committed timestamps to be published.
 class MvccManager {
  public:
   MvccManager();
@@ -231,6 +239,9 @@ class MvccManager {
 
   // Take a snapshot of the current MVCC state, which indicates which
   // transactions have been committed at the time of this call.
+  //
+  // This doesn't take the lock of the manager, unless the snapshot has more
+  // than kMaxPublishedCommitted committed timestamps.
   void TakeSnapshot(MvccSnapshot *snapshot) const;
 
   // Take a snapshot of the MVCC state at 'timestamp' (i.e which includes
@@ -261,6 +272,8 @@ class MvccManager {
 
   // Returns the earliest possible timestamp for an uncommitted transaction.
   // All timestamps before this one are guaranteed to be committed.
+  //
+  // This doesn't take the lock of the manager.
   Timestamp GetCleanTimestamp() const;
 
   // Return the timestamps of all transactions which are currently 'APPLYING'
@@ -292,6 +305,26 @@ class MvccManager {
   FRIEND_TEST(MvccTest, TestWaitForApplyingTransactionsToCommit);
   FRIEND_TEST(MvccTest, TestWaitForCleanSnapshot_SnapAfterSafeTimeWithInFlights);
   FRIEND_TEST(MvccTest, TestDontWaitAfterClose);
+  FRIEND_TEST(MvccTest, TestPublishedSnapshotOverflow);
+
+  // The maximum number of committed timestamps of a published snapshot.
+  static constexpr int kMaxPublishedCommitted = 32;
+
+  // A copy of 'cur_snap_' which can be read without holding 'lock_'.
+  //
+  // It's written like a seqlock: with 'lock_' held, writers make 'seq' odd,
+  // update the other fields and make 'seq' even again. Readers retry if 'seq'
+  // was odd or changed while they read the fields. All the fields are atomics
+  // so that these racy reads are well-defined.
+  struct PublishedSnapshot {
+    std::atomic<uint64_t> seq;
+    std::atomic<Timestamp::val_type> all_committed_before;
+    std::atomic<Timestamp::val_type> none_committed_at_or_after;
+    // The number of committed timestamps, or -1 if there are more than
+    // kMaxPublishedCommitted of them, in which case readers must take 'lock_'.
+    std::atomic<int> num_committed;
+    std::atomic<Timestamp::val_type> committed[kMaxPublishedCommitted];
+  };
 
   enum TxnState {
     RESERVED,
@@ -354,6 +387,14 @@ class MvccManager {
   // commits or aborts.
   void AdvanceEarliestInFlightTimestamp();
 
+  // Publishes 'cur_snap_' to 'published_snap_'. Must be called with 'lock_'
+  // held after every change to 'cur_snap_'.
+  void PublishSnapshotUnlocked();
+
+  // Reads 'published_snap_' into 'snap'. Returns false if it couldn't be read
+  // consistently, or if it overflowed.
+  bool ReadPublishedSnapshot(MvccSnapshot* snap) const;
+
   int GetNumWaitersForTests() const {
     std::lock_guard<simple_spinlock> l(lock_);
     return waiters_.size();
@@ -364,6 +405,8 @@ class MvccManager {
 
   MvccSnapshot cur_snap_;
 
+  PublishedSnapshot published_snap_;
+
   // The set of timestamps corresponding to currently in-flight transactions.
   typedef std::unordered_map<Timestamp::val_type, TxnState> InFlightMap;
   InFlightMap timestamps_in_flight_;
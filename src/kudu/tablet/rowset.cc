@@ -30,6 +30,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/rowset_metadata.h"
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -43,6 +44,22 @@ RowIteratorOptions::RowIteratorOptions()
       snap_to_include(MvccSnapshot::CreateSnapshotIncludingAllTransactions()),
       order(OrderMode::UNORDERED) {}
 
+Status RowSet::GetKeyRanges(vector<pair<string, string>>* ranges) const {
+  string min_key, max_key;
+  RETURN_NOT_OK(GetBounds(&min_key, &max_key));
+  ranges->clear();
+  ranges->emplace_back(std::move(min_key), std::move(max_key));
+  return Status::OK();
+}
+
+Status RowSet::CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                                bool* present, ProbeStats* const* stats) const {
+  for (size_t i = 0; i < n; i++) {
+    RETURN_NOT_OK(CheckRowPresent(*probes[i], &present[i], stats[i]));
+  }
+  return Status::OK();
+}
+
 DuplicatingRowSet::DuplicatingRowSet(RowSetVector old_rowsets,
                                      RowSetVector new_rowsets)
     : old_rowsets_(std::move(old_rowsets)),
@@ -23,6 +23,7 @@
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -89,6 +90,20 @@ struct RowIteratorOptions {
   OrderMode order;
 };
 
+// Counts of the reads a rowset has served since it was opened. These are
+// used by compaction policies which weigh rowsets by how they're read.
+struct RowSetReadStats {
+  // Number of iterators opened on the rowset.
+  int64_t scans = 0;
+
+  // Number of bloom filter probes made against the rowset's keys.
+  int64_t bloom_probes = 0;
+
+  // Number of lookups in the rowset's key index, i.e. the bloom probes
+  // which couldn't rule out the key.
+  int64_t key_lookups = 0;
+};
+
 class RowSet {
  public:
   enum DeltaCompactionType {
@@ -106,6 +121,13 @@ class RowSet {
   virtual Status CheckRowPresent(const RowSetKeyProbe &probe, bool *present,
                                  ProbeStats* stats) const = 0;
 
+  // Batched version of CheckRowPresent(): sets present[i] for each of the 'n'
+  // probes, which must be sorted by key, and updates stats[i].
+  //
+  // The default implementation checks the probes one at a time.
+  virtual Status CheckRowsPresent(const RowSetKeyProbe* const* probes, size_t n,
+                                  bool* present, ProbeStats* const* stats) const;
+
   // Update/delete a row in this rowset.
   // The 'update_schema' is the client schema used to encode the 'update' RowChangeList.
   //
@@ -148,6 +170,12 @@ class RowSet {
   virtual Status GetBounds(std::string* min_encoded_key,
                            std::string* max_encoded_key) const = 0;
 
+  // Return the disjoint ranges, in key order, which hold all of the keys of
+  // this RowSet. Keys between the ranges can't be in the RowSet.
+  //
+  // The default implementation returns the single range of GetBounds().
+  virtual Status GetKeyRanges(std::vector<std::pair<std::string, std::string>>* ranges) const;
+
   // Return a displayable string for this rowset.
   virtual std::string ToString() const = 0;
 
@@ -174,6 +202,12 @@ class RowSet {
   // Returns the metadata associated with this rowset.
   virtual std::shared_ptr<RowSetMetadata> metadata() = 0;
 
+  // Returns the number of reads served by this rowset so far. RowSets
+  // which don't track their reads return all zeros.
+  virtual RowSetReadStats GetReadStats() const {
+    return RowSetReadStats();
+  }
+
   // Get the size of the delta's MemStore
   virtual size_t DeltaMemStoreSize() const = 0;
 
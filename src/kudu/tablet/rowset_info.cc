@@ -30,6 +30,7 @@
 
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/endian.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_tree.h"
@@ -132,8 +133,8 @@ double StringFractionInRange(const RowSetInfo* rsi,
 // Computes the "width" of an interval [prev, next] according to the amount
 // of data estimated to be inside the interval, where this is calculated by
 // multiplying the fraction that the interval takes up in the keyspace of
-// each rowset by the rowset's size (assumes distribution of rows is somewhat
-// uniform).
+// each rowset by the rowset's weighted size (assumes distribution of rows is
+// somewhat uniform).
 // Requires: [prev, next] contained in each rowset in "active"
 double WidthByDataSize(const Slice& prev, const Slice& next,
                        const unordered_map<RowSet*, RowSetInfo*>& active) {
@@ -141,7 +142,7 @@ double WidthByDataSize(const Slice& prev, const Slice& next,
 
   for (const auto& rs_rsi : active) {
     double fraction = StringFractionInRange(rs_rsi.second, prev, next);
-    weight += rs_rsi.second->size_bytes() * fraction;
+    weight += rs_rsi.second->size_bytes() * rs_rsi.second->weight() * fraction;
   }
 
   return weight;
@@ -174,7 +175,8 @@ void RowSetInfo::Collect(const RowSetTree& tree, vector<RowSetInfo>* rsvec) {
 
 void RowSetInfo::CollectOrdered(const RowSetTree& tree,
                                 vector<RowSetInfo>* min_key,
-                                vector<RowSetInfo>* max_key) {
+                                vector<RowSetInfo>* max_key,
+                                const unordered_map<RowSet*, double>* weights) {
   // Resize
   size_t len = tree.all_rowsets().size();
   min_key->reserve(min_key->size() + len);
@@ -229,7 +231,11 @@ void RowSetInfo::CollectOrdered(const RowSetTree& tree,
 
     // Add/remove current RowSetInfo
     if (rse.endpoint_ == RowSetTree::START) {
-      min_key->push_back(RowSetInfo(rs, total_width));
+      double weight = 1;
+      if (weights) {
+        weight = FindWithDefault(*weights, rs, 1);
+      }
+      min_key->push_back(RowSetInfo(rs, total_width, weight));
       // Store reference from vector. This is safe b/c of reserve() above.
       active.insert(std::make_pair(rs, &min_key->back()));
     } else if (rse.endpoint_ == RowSetTree::STOP) {
@@ -255,12 +261,13 @@ void RowSetInfo::CollectOrdered(const RowSetTree& tree,
   FinalizeCDFVector(max_key, total_width);
 }
 
-RowSetInfo::RowSetInfo(RowSet* rs, double init_cdf)
+RowSetInfo::RowSetInfo(RowSet* rs, double init_cdf, double weight)
     : cdf_min_key_(init_cdf),
       cdf_max_key_(init_cdf),
       extra_(new ExtraData()) {
   extra_->rowset = rs;
   extra_->size_bytes = rs->OnDiskBaseDataSizeWithRedos();
+  extra_->weight = weight;
   extra_->has_bounds = rs->GetBounds(&extra_->min_key, &extra_->max_key).ok();
   size_mb_ = std::max(implicit_cast<int>(extra_->size_bytes / 1024 / 1024), kMinSizeMb);
 }
@@ -285,6 +292,9 @@ string RowSetInfo::ToString() const {
   ret.append(rowset()->ToString());
   StringAppendF(&ret, "(% 3dM) [%.04f, %.04f]", size_mb_,
                 cdf_min_key_, cdf_max_key_);
+  if (extra_->weight != 1) {
+    StringAppendF(&ret, " weight %.02f", extra_->weight);
+  }
   if (extra_->has_bounds) {
     ret.append(" [").append(KUDU_REDACT(Slice(extra_->min_key).ToDebugString()));
     ret.append(",").append(KUDU_REDACT(Slice(extra_->max_key).ToDebugString()));
@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "kudu/gutil/ref_counted.h"
@@ -40,11 +41,19 @@ class RowSetInfo {
   static void Collect(const RowSetTree& tree, std::vector<RowSetInfo>* rsvec);
   // Appends the rowsets in min-key and max-key sorted order, with
   // cdf values set.
+  //
+  // If 'weights' is not NULL, the data of each rowset counts towards the
+  // cdf in proportion to the rowset's weight in the map rather than to its
+  // size alone. Rowsets missing from the map have weight 1.
   static void CollectOrdered(const RowSetTree& tree,
                              std::vector<RowSetInfo>* min_key,
-                             std::vector<RowSetInfo>* max_key);
+                             std::vector<RowSetInfo>* max_key,
+                             const std::unordered_map<RowSet*, double>* weights = nullptr);
 
   uint64_t size_bytes() const { return extra_->size_bytes; }
+
+  // The weight of the rowset's data in the cdf. See CollectOrdered().
+  double weight() const { return extra_->weight; }
   int size_mb() const { return size_mb_; }
 
   // Return the value of the CDF at the minimum key of this candidate.
@@ -79,7 +88,7 @@ class RowSetInfo {
   bool Intersects(const RowSetInfo& other) const;
 
  private:
-  explicit RowSetInfo(RowSet* rs, double init_cdf);
+  RowSetInfo(RowSet* rs, double init_cdf, double weight = 1);
 
   static void FinalizeCDFVector(std::vector<RowSetInfo>* vec,
                                 double quot);
@@ -101,6 +110,9 @@ class RowSetInfo {
     // Cached version of rowset_->OnDiskBaseDataSizeWithRedos().
     uint64_t size_bytes;
 
+    // Multiplier of 'size_bytes' when computing the cdf.
+    double weight;
+
     // True if the RowSet has known bounds.
     // MemRowSets in particular do not.
     bool has_bounds;
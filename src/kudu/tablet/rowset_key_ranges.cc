@@ -0,0 +1,107 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/rowset_key_ranges.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace kudu {
+namespace tablet {
+
+RowSetKeyRangesBuilder::RowSetKeyRangesBuilder(int max_ranges)
+    : max_ranges_(max_ranges),
+      has_keys_(false) {
+  CHECK_GE(max_ranges_, 1);
+}
+
+bool RowSetKeyRangesBuilder::SmallerGap(const Gap& a, const Gap& b) {
+  if (a.common_prefix_len != b.common_prefix_len) {
+    return a.common_prefix_len > b.common_prefix_len;
+  }
+  return a.difference < b.difference;
+}
+
+void RowSetKeyRangesBuilder::MeasureGap(const Slice& before, const Slice& after, Gap* gap) {
+  size_t min_len = std::min(before.size(), after.size());
+  size_t prefix = 0;
+  while (prefix < min_len && before[prefix] == after[prefix]) {
+    prefix++;
+  }
+  // Read the eight bytes following the common prefix as big-endian integers,
+  // padding the keys with zeros.
+  uint64_t before_bits = 0;
+  uint64_t after_bits = 0;
+  for (size_t i = prefix; i < prefix + 8; i++) {
+    before_bits = (before_bits << 8) | (i < before.size() ? before[i] : 0);
+    after_bits = (after_bits << 8) | (i < after.size() ? after[i] : 0);
+  }
+  gap->common_prefix_len = prefix;
+  gap->difference = after_bits - before_bits;
+}
+
+void RowSetKeyRangesBuilder::AddKey(const Slice& key) {
+  if (!has_keys_) {
+    first_key_.assign_copy(key.data(), key.size());
+    prev_key_.assign_copy(key.data(), key.size());
+    has_keys_ = true;
+    return;
+  }
+  DCHECK_LT(Slice(prev_key_).compare(key), 0);
+
+  if (max_ranges_ > 1) {
+    Gap gap;
+    MeasureGap(Slice(prev_key_), key, &gap);
+    // Keep the max_ranges_ - 1 largest gaps: only copy the keys of the gap if
+    // it's to be kept.
+    const size_t max_gaps = max_ranges_ - 1;
+    if (gaps_.size() < max_gaps || SmallerGap(gaps_.front(), gap)) {
+      if (gaps_.size() == max_gaps) {
+        std::pop_heap(gaps_.begin(), gaps_.end(), LargerGap);
+        gaps_.pop_back();
+      }
+      gap.before = Slice(prev_key_).ToString();
+      gap.after = key.ToString();
+      gaps_.emplace_back(std::move(gap));
+      std::push_heap(gaps_.begin(), gaps_.end(), LargerGap);
+    }
+  }
+  prev_key_.assign_copy(key.data(), key.size());
+}
+
+std::vector<EncodedKeyRange> RowSetKeyRangesBuilder::Finish() {
+  std::vector<EncodedKeyRange> ranges;
+  if (!has_keys_) {
+    return ranges;
+  }
+  // Split the [first, last] range at each of the gaps, in key order.
+  std::sort(gaps_.begin(), gaps_.end(), [](const Gap& a, const Gap& b) {
+      return Slice(a.before).compare(Slice(b.before)) < 0;
+    });
+  std::string start = Slice(first_key_).ToString();
+  for (auto& gap : gaps_) {
+    ranges.emplace_back(std::move(start), std::move(gap.before));
+    start = std::move(gap.after);
+  }
+  ranges.emplace_back(std::move(start), Slice(prev_key_).ToString());
+  gaps_.clear();
+  return ranges;
+}
+
+} // namespace tablet
+} // namespace kudu
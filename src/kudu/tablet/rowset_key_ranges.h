@@ -0,0 +1,90 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+namespace tablet {
+
+// An inclusive range [first, second] of encoded keys.
+typedef std::pair<std::string, std::string> EncodedKeyRange;
+
+// Summarizes the keys of a rowset as a few disjoint key ranges rather than
+// the single [min, max] range of RowSet::GetBounds(). The keys are split at
+// the largest gaps between consecutive keys, so that a rowset whose keys are
+// clustered in a few parts of its range (e.g. time series keys with a few
+// late arrivals, or keys prefixed with a handful of tenant IDs) isn't
+// considered to possibly contain any key between its min and max.
+//
+// The size of a gap between two keys is measured by the length of their
+// common prefix, the shorter the bigger, and then by the difference of the
+// eight bytes which follow it.
+class RowSetKeyRangesBuilder {
+ public:
+  // Creates a builder which summarizes the keys as up to 'max_ranges' ranges.
+  explicit RowSetKeyRangesBuilder(int max_ranges);
+
+  // Adds a key. Keys must be added in strictly ascending order.
+  void AddKey(const Slice& key);
+
+  // Returns the sorted, disjoint ranges which cover all of the keys added.
+  // Returns no ranges if no keys were added.
+  std::vector<EncodedKeyRange> Finish();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RowSetKeyRangesBuilder);
+
+  // A gap between two consecutive keys.
+  struct Gap {
+    // The size of the gap, as documented above.
+    size_t common_prefix_len;
+    uint64_t difference;
+
+    // The keys on either side of the gap.
+    std::string before;
+    std::string after;
+  };
+
+  // Returns true if 'a' is a smaller gap than 'b'.
+  static bool SmallerGap(const Gap& a, const Gap& b);
+  static bool LargerGap(const Gap& a, const Gap& b) { return SmallerGap(b, a); }
+
+  // Computes the size of the gap between 'before' and 'after' into 'gap'.
+  static void MeasureGap(const Slice& before, const Slice& after, Gap* gap);
+
+  const int max_ranges_;
+
+  // The largest gaps seen so far, as a heap ordered by LargerGap(), i.e.
+  // with the smallest of them on top.
+  std::vector<Gap> gaps_;
+
+  faststring first_key_;
+  faststring prev_key_;
+  bool has_keys_;
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -86,6 +86,12 @@ void RowSetMetadata::LoadFromPB(const RowSetDataPB& pb) {
     max_encoded_key_ = pb.max_encoded_key();
   }
 
+  // Load the key ranges.
+  key_ranges_.clear();
+  for (const EncodedKeyRangePB& range_pb : pb.key_ranges()) {
+    key_ranges_.emplace_back(range_pb.min_encoded_key(), range_pb.max_encoded_key());
+  }
+
   // Load Bloom File.
   bloom_block_ = BlockId();
   if (pb.has_bloom_block()) {
@@ -163,6 +169,13 @@ void RowSetMetadata::ToProtobuf(RowSetDataPB *pb) {
     pb->set_min_encoded_key(*min_encoded_key_);
     pb->set_max_encoded_key(*max_encoded_key_);
   }
+
+  // Write the key ranges.
+  for (const EncodedKeyRange& range : key_ranges_) {
+    EncodedKeyRangePB* range_pb = pb->add_key_ranges();
+    range_pb->set_min_encoded_key(range.first);
+    range_pb->set_max_encoded_key(range.second);
+  }
 }
 
 const std::string RowSetMetadata::ToString() const {
@@ -35,6 +35,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/tablet/rowset_key_ranges.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/status.h"
@@ -152,6 +153,18 @@ class RowSetMetadata {
     return *max_encoded_key_;
   }
 
+  void set_key_ranges(std::vector<EncodedKeyRange> key_ranges) {
+    std::lock_guard<LockType> l(lock_);
+    key_ranges_ = std::move(key_ranges);
+  }
+
+  // The disjoint ranges which hold all of the keys of the rowset, in key
+  // order. Empty if the rowset was written before they were tracked.
+  std::vector<EncodedKeyRange> key_ranges() const {
+    std::lock_guard<LockType> l(lock_);
+    return key_ranges_;
+  }
+
   BlockId bloom_block() const {
     std::lock_guard<LockType> l(lock_);
     return bloom_block_;
@@ -255,6 +268,7 @@ class RowSetMetadata {
   // The min and max keys of the rowset.
   boost::optional<std::string> min_encoded_key_;
   boost::optional<std::string> max_encoded_key_;
+  std::vector<EncodedKeyRange> key_ranges_;
 
   BlockId bloom_block_;
   BlockId adhoc_index_block_;
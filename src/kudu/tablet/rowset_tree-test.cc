@@ -20,6 +20,7 @@
 #include <memory>
 #include <unordered_set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -29,12 +30,14 @@
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/tablet/mock-rowsets.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_key_ranges.h"
 #include "kudu/tablet/rowset_tree.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unordered_set;
@@ -192,6 +195,87 @@ TEST_P(TestRowSetTreePerformance, TestPerformance) {
                             batch_total ? (oat_total / batch_total) : 0);
 }
 
+// Test that point lookups skip the rowsets which have no key range around the
+// key, even though their bounds cover it.
+TEST_F(TestRowSetTree, TestKeyRanges) {
+  RowSetVector vec;
+  auto* with_gaps = new MockDiskRowSet("0", "9");
+  with_gaps->set_key_ranges({ { "0", "2" }, { "5", "5" }, { "8", "9" } });
+  vec.push_back(shared_ptr<RowSet>(with_gaps));
+  vec.push_back(shared_ptr<RowSet>(new MockDiskRowSet("3", "6")));
+
+  RowSetTree tree;
+  ASSERT_OK(tree.Reset(vec));
+
+  // "4" is only covered by the bounds of the first rowset, not by its key
+  // ranges.
+  vector<RowSet *> out;
+  tree.FindRowSetsWithKeyInRange("4", &out);
+  ASSERT_EQ(1, out.size());
+  ASSERT_EQ(vec[1].get(), out[0]);
+
+  // "5" is in a key range of both.
+  out.clear();
+  tree.FindRowSetsWithKeyInRange("5", &out);
+  ASSERT_EQ(2, out.size());
+
+  // Interval queries still go by the bounds.
+  out.clear();
+  tree.FindRowSetsIntersectingInterval("3", "4", &out);
+  ASSERT_EQ(2, out.size());
+
+  // The batched lookup agrees with the single ones.
+  vector<Slice> keys = { "1", "4", "5", "7", "9" };
+  vector<pair<RowSet*, int>> results;
+  tree.ForEachRowSetContainingKeys(keys, [&](RowSet* rs, int i) {
+      results.emplace_back(rs, i);
+    });
+  std::sort(results.begin(), results.end(),
+            [](const pair<RowSet*, int>& a, const pair<RowSet*, int>& b) {
+              return a.second < b.second;
+            });
+  ASSERT_EQ(5, results.size());
+  EXPECT_EQ(vec[0].get(), results[0].first);
+  EXPECT_EQ(vec[1].get(), results[1].first);
+  EXPECT_EQ(2, results[2].second);
+  EXPECT_EQ(2, results[3].second);
+  EXPECT_EQ(vec[0].get(), results[4].first);
+  EXPECT_EQ(4, results[4].second);
+}
+
+// Test that the keys of a rowset are split at the largest gaps.
+TEST_F(TestRowSetTree, TestKeyRangesBuilder) {
+  // Three clusters of keys, the last two of which are further apart than the
+  // keys within each cluster.
+  RowSetKeyRangesBuilder builder(3);
+  for (int i = 0; i < 100; i++) {
+    builder.AddKey(StringPrintf("a%04d", i));
+  }
+  for (int i = 0; i < 100; i++) {
+    builder.AddKey(StringPrintf("b%04d", i * 2));
+  }
+  for (int i = 0; i < 100; i++) {
+    builder.AddKey(StringPrintf("b9%03d", i));
+  }
+  vector<EncodedKeyRange> ranges = builder.Finish();
+  ASSERT_EQ(3, ranges.size());
+  EXPECT_EQ(EncodedKeyRange("a0000", "a0099"), ranges[0]);
+  EXPECT_EQ(EncodedKeyRange("b0000", "b0198"), ranges[1]);
+  EXPECT_EQ(EncodedKeyRange("b9000", "b9099"), ranges[2]);
+
+  // A single range is the bounds of the keys.
+  RowSetKeyRangesBuilder single(1);
+  single.AddKey("a");
+  single.AddKey("b");
+  ranges = single.Finish();
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(EncodedKeyRange("a", "b"), ranges[0]);
+
+  // No keys, no ranges.
+  RowSetKeyRangesBuilder empty(16);
+  ASSERT_TRUE(empty.Finish().empty());
+}
+
 TEST_F(TestRowSetTree, TestEndpointsConsistency) {
   const int kNumRowSets = 1000;
   RowSetVector vec = GenerateRandomRowSets(kNumRowSets);
@@ -22,6 +22,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <ostream>
 
@@ -34,9 +35,10 @@
 #include "kudu/util/interval_tree.h"
 #include "kudu/util/slice.h"
 
-using std::vector;
+using std::pair;
 using std::shared_ptr;
 using std::string;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -110,8 +112,10 @@ RowSetTree::RowSetTree()
 Status RowSetTree::Reset(const RowSetVector &rowsets) {
   CHECK(!initted_);
   std::vector<RowSetWithBounds *> entries;
+  std::vector<RowSetWithBounds *> key_range_entries;
   RowSetVector unbounded;
   ElementDeleter deleter(&entries);
+  ElementDeleter key_range_deleter(&key_range_entries);
   entries.reserve(rowsets.size());
   std::vector<RSEndpoint> endpoints;
   endpoints.reserve(rowsets.size()*2);
@@ -148,6 +152,25 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
     endpoints.emplace_back(rsit->rowset, STOP, rsit->max_key);
 
     entries.push_back(rsit.release());
+
+    // Load the key ranges.
+    vector<pair<string, string>> key_ranges;
+    s = rs->GetKeyRanges(&key_ranges);
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to construct RowSetTree: "
+                   << rs->ToString() << " unable to determine its key ranges: "
+                   << s.ToString();
+      return s;
+    }
+    for (auto& range : key_ranges) {
+      DCHECK_LE(range.first.compare(range.second), 0)
+        << "Key range start must be <= stop: " << rs->ToString();
+      gscoped_ptr<RowSetWithBounds> range_entry(new RowSetWithBounds());
+      range_entry->rowset = rs.get();
+      range_entry->min_key = std::move(range.first);
+      range_entry->max_key = std::move(range.second);
+      key_range_entries.push_back(range_entry.release());
+    }
   }
 
   // Sort endpoints
@@ -155,8 +178,10 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
 
   // Install the vectors into the object.
   entries_.swap(entries);
+  key_range_entries_.swap(key_range_entries);
   unbounded_rowsets_.swap(unbounded);
   tree_.reset(new IntervalTree<RowSetIntervalTraits>(entries_));
+  key_range_tree_.reset(new IntervalTree<RowSetIntervalTraits>(key_range_entries_));
   key_endpoints_.swap(endpoints);
   all_rowsets_.assign(rowsets.begin(), rowsets.end());
 
@@ -208,10 +233,11 @@ void RowSetTree::FindRowSetsWithKeyInRange(const Slice &encoded_key,
   }
 
   // Query the interval tree to efficiently find rowsets with known bounds
-  // whose ranges overlap the probe key.
+  // which have a key range overlapping the probe key. The key ranges of a
+  // rowset are disjoint, so each rowset is found at most once.
   vector<RowSetWithBounds *> from_tree;
   from_tree.reserve(all_rowsets_.size());
-  tree_->FindContainingPoint(encoded_key, &from_tree);
+  key_range_tree_->FindContainingPoint(encoded_key, &from_tree);
   rowsets->reserve(rowsets->size() + from_tree.size());
   for (RowSetWithBounds *rs : from_tree) {
     rowsets->push_back(rs->rowset);
@@ -241,7 +267,7 @@ void RowSetTree::ForEachRowSetContainingKeys(
     queries[i] = {encoded_keys[i], i};
   }
 
-  tree_->ForEachIntervalContainingPoints(
+  key_range_tree_->ForEachIntervalContainingPoints(
       queries,
       [&](const QueryStruct& qs, RowSetWithBounds* rs) {
         cb(rs->rowset, qs.idx);
@@ -251,6 +277,7 @@ void RowSetTree::ForEachRowSetContainingKeys(
 
 RowSetTree::~RowSetTree() {
   STLDeleteElements(&entries_);
+  STLDeleteElements(&key_range_entries_);
 }
 
 } // namespace tablet
@@ -42,6 +42,11 @@ struct RowSetWithBounds;
 // Tablet. This provides efficient lookup by key for RowSets which may overlap
 // that key range.
 //
+// Point lookups go through a second interval tree, of the disjoint key ranges
+// which hold the keys of each rowset (see RowSet::GetKeyRanges()), so that
+// they skip the rowsets whose [min, max] range covers the key but which have
+// no keys around it.
+//
 // Additionally, the rowset tree maintains information about the implicit
 // intervals generated by the row sets (for instance, if a tablet has
 // rowsets [0, 2] and [1, 3] it has three implicit contiguous intervals:
@@ -68,7 +73,7 @@ class RowSetTree {
   Status Reset(const RowSetVector &rowsets);
   ~RowSetTree();
 
-  // Return all RowSets whose range may contain the given encoded key.
+  // Return all RowSets whose key ranges may contain the given encoded key.
   //
   // The returned pointers are guaranteed to be valid at least until this
   // RowSetTree object is Reset().
@@ -76,10 +81,13 @@ class RowSetTree {
                                  std::vector<RowSet *> *rowsets) const;
 
   // Call 'cb(rowset, index)' for each (rowset, index) pair such that
-  // 'encoded_keys[index]' may be within the bounds of 'rowset'.
+  // 'encoded_keys[index]' may be within the key ranges of 'rowset'.
   //
   // See IntervalTree::ForEachIntervalContainingPoints for additional
   // information on the particular order in which the callback will be called.
+  // Since a rowset may have several key ranges, consecutive groups of calls
+  // for the same rowset may belong to different ranges, in which case the
+  // keys of the second group may be smaller than those of the first.
   //
   // REQUIRES: 'encoded_keys' must be in sorted order.
   void ForEachRowSetContainingKeys(const std::vector<Slice>& encoded_keys,
@@ -105,6 +113,10 @@ class RowSetTree {
   // a probe row.
   gscoped_ptr<IntervalTree<RowSetIntervalTraits> > tree_;
 
+  // Interval tree of the key ranges of the rowsets. Used to find the rowsets
+  // which might contain a given key.
+  gscoped_ptr<IntervalTree<RowSetIntervalTraits> > key_range_tree_;
+
   // Ordered map of all the interval endpoints, holding the implicit contiguous
   // intervals
   // TODO map to usage statistics as well. See KUDU-???
@@ -115,6 +127,9 @@ class RowSetTree {
   // all the entry structs and free them in the destructor.
   std::vector<RowSetWithBounds *> entries_;
 
+  // Same as above, for the entries of key_range_tree_.
+  std::vector<RowSetWithBounds *> key_range_entries_;
+
   // All of the rowsets which were put in this RowSetTree.
   RowSetVector all_rowsets_;
 
@@ -88,6 +88,7 @@
 #include "kudu/util/process_memory.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status_callback.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/throttler.h"
 #include "kudu/util/trace.h"
 #include "kudu/util/url-coding.h"
@@ -96,6 +97,23 @@ DEFINE_int32(tablet_compaction_budget_mb, 128,
              "Budget for a single compaction");
 TAG_FLAG(tablet_compaction_budget_mb, experimental);
 
+DEFINE_string(tablet_compaction_policy, "budgeted",
+              "The policy used to select the rowsets of a tablet to compact. Either "
+              "'budgeted', which picks the rowsets whose compaction reduces key range "
+              "overlap the most, or 'workload_aware', which also favors the rowsets "
+              "that are read the most.");
+TAG_FLAG(tablet_compaction_policy, experimental);
+DEFINE_validator(tablet_compaction_policy, [](const char* /*n*/, const std::string& v) {
+  return v == "budgeted" || v == "workload_aware";
+});
+
+DEFINE_int32(tablet_compaction_column_writer_threads, 1,
+             "Number of threads used to encode and compress the columns of the "
+             "rowsets written by each flush or compaction of a tablet. The rows are "
+             "still merged and their mutations applied by a single thread. If 1, "
+             "the columns are written by that thread.");
+TAG_FLAG(tablet_compaction_column_writer_threads, experimental);
+
 DEFINE_int32(tablet_bloom_block_size, 4096,
              "Block size of the bloom filters used for tablet keys.");
 TAG_FLAG(tablet_bloom_block_size, advanced);
@@ -177,6 +195,7 @@ using std::ostream;
 using std::pair;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
@@ -189,6 +208,9 @@ struct IteratorStats;
 namespace tablet {
 
 static CompactionPolicy *CreateCompactionPolicy() {
+  if (FLAGS_tablet_compaction_policy == "workload_aware") {
+    return new WorkloadAwareCompactionPolicy(FLAGS_tablet_compaction_budget_mb);
+  }
   return new BudgetedCompactionPolicy(FLAGS_tablet_compaction_budget_mb);
 }
 
@@ -265,6 +287,15 @@ Status Tablet::Open() {
 
   next_mrs_id_ = metadata_->last_durable_mrs_id() + 1;
 
+  if (FLAGS_tablet_compaction_column_writer_threads > 1) {
+    // The threads are only started while rowsets are written, and exit once
+    // they have been idle for a while.
+    RETURN_NOT_OK(ThreadPoolBuilder("rowset-writer")
+                  .set_min_threads(0)
+                  .set_max_threads(FLAGS_tablet_compaction_column_writer_threads)
+                  .Build(&column_writer_pool_));
+  }
+
   RowSetVector rowsets_opened;
 
   // open the tablet row-sets
@@ -419,8 +450,20 @@ Status Tablet::AcquireRowLocks(WriteTransactionState* tx_state) {
   TRACE_EVENT1("tablet", "Tablet::AcquireRowLocks",
                "num_locks", tx_state->row_ops().size());
   TRACE("PREPARE: Acquiring locks for $0 operations", tx_state->row_ops().size());
+  vector<Slice> keys;
+  keys.reserve(tx_state->row_ops().size());
   for (RowOp* op : tx_state->row_ops()) {
-    RETURN_NOT_OK(AcquireLockForOp(tx_state, op));
+    ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
+    op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
+    RETURN_NOT_OK(CheckRowInTablet(row_key));
+    keys.push_back(op->key_probe->encoded_key_slice());
+  }
+
+  // Lock all the rows at once, rather than one by one.
+  vector<ScopedRowLock> locks;
+  lock_manager_.LockBatch(keys, tx_state, LockManager::LOCK_EXCLUSIVE, &locks);
+  for (int i = 0; i < locks.size(); i++) {
+    tx_state->row_ops()[i]->row_lock = std::move(locks[i]);
   }
   TRACE("PREPARE: locks acquired");
   return Status::OK();
@@ -442,18 +485,6 @@ Status Tablet::CheckRowInTablet(const ConstContiguousRow& row) const {
   return Status::OK();
 }
 
-Status Tablet::AcquireLockForOp(WriteTransactionState* tx_state, RowOp* op) {
-  ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
-  op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
-  RETURN_NOT_OK(CheckRowInTablet(row_key));
-
-  op->row_lock = ScopedRowLock(&lock_manager_,
-                               tx_state,
-                               op->key_probe->encoded_key_slice(),
-                               LockManager::LOCK_EXCLUSIVE);
-  return Status::OK();
-}
-
 void Tablet::AssignTimestampAndStartTransactionForTests(WriteTransactionState* tx_state) {
   CHECK(!tx_state->has_timestamp());
   // Don't support COMMIT_WAIT for tests that don't boot a tablet server.
@@ -572,7 +603,8 @@ Status Tablet::ValidateMutateUnlocked(const RowOp& op) const {
 
 Status Tablet::InsertOrUpsertUnlocked(WriteTransactionState *tx_state,
                                       RowOp* op,
-                                      ProbeStats* stats) {
+                                      ProbeStats* stats,
+                                      MRSInsertHint* insert_hint) {
   DCHECK(op->checked_present);
   DCHECK(op->validated);
 
@@ -599,7 +631,7 @@ Status Tablet::InsertOrUpsertUnlocked(WriteTransactionState *tx_state,
 
   // Now try to op into memrowset. The memrowset itself will return
   // AlreadyPresent if it has already been oped there.
-  Status s = comps->memrowset->Insert(ts, row, tx_state->op_id());
+  Status s = comps->memrowset->Insert(ts, row, tx_state->op_id(), insert_hint);
   if (s.ok()) {
     op->SetInsertSucceeded(comps->memrowset->mrs_id());
   } else {
@@ -809,6 +841,9 @@ Status Tablet::BulkCheckPresence(WriteTransactionState* tx_state) {
   // 'pending_group' and then calls 'ProcessPendingGroup' when the next group
   // begins.
   vector<pair<RowSet*, int>> pending_group;
+  vector<RowOp*> group_ops;
+  vector<const RowSetKeyProbe*> group_probes;
+  vector<ProbeStats*> group_stats;
   Status s;
   const auto& ProcessPendingGroup = [&]() {
     if (pending_group.empty() || !s.ok()) return;
@@ -822,6 +857,9 @@ Status Tablet::BulkCheckPresence(WriteTransactionState* tx_state) {
                             return s_a.compare(s_b) < 0;
                           }));
     RowSet* rs = pending_group[0].first;
+    group_ops.clear();
+    group_probes.clear();
+    group_stats.clear();
     for (auto it = pending_group.begin();
          it != pending_group.end();
          ++it) {
@@ -832,26 +870,41 @@ Status Tablet::BulkCheckPresence(WriteTransactionState* tx_state) {
         // Already found this op present somewhere.
         continue;
       }
-
-      bool present = false;
-      s = rs->CheckRowPresent(*op->key_probe, &present, tx_state->mutable_op_stats(op_idx));
-      if (PREDICT_FALSE(!s.ok())) {
-        LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for op $1: $2",
-            tablet_id(), op->ToString(key_schema_), s.ToString());
-        return;
-      }
-      if (present) {
-        op->present_in_rowset = rs;
-      }
+      group_ops.push_back(op);
+      group_probes.push_back(op->key_probe.get());
+      group_stats.push_back(tx_state->mutable_op_stats(op_idx));
     }
     pending_group.clear();
+    if (group_ops.empty()) return;
+
+    // Check the whole group at once, so that the rowset can batch its bloom
+    // filter probes.
+    unique_ptr<bool[]> present(new bool[group_ops.size()]);
+    s = rs->CheckRowsPresent(group_probes.data(), group_probes.size(), present.get(),
+                             group_stats.data());
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for $1 ops "
+                                 "starting with op $2: $3",
+          tablet_id(), group_ops.size(), group_ops[0]->ToString(key_schema_), s.ToString());
+      return;
+    }
+    for (int i = 0; i < group_ops.size(); i++) {
+      if (present[i]) {
+        group_ops[i]->present_in_rowset = rs;
+      }
+    }
   };
 
   const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
   comps->rowsets->ForEachRowSetContainingKeys(
       keys,
       [&](RowSet* rs, int i) {
-        if (!pending_group.empty() && rs != pending_group.back().first) {
+        // A new group starts with each run of calls for the same key range
+        // of a rowset, i.e. whenever the rowset changes or the keys stop
+        // ascending.
+        if (!pending_group.empty() &&
+            (rs != pending_group.back().first ||
+             keys[i].compare(keys[pending_group.back().second]) <= 0)) {
           ProcessPendingGroup();
         }
         pending_group.emplace_back(rs, i);
@@ -894,12 +947,15 @@ Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
 
   RETURN_NOT_OK(BulkCheckPresence(tx_state));
 
-  // Actually apply the ops.
+  // Actually apply the ops. The rows of batches sorted by key are appended
+  // to the memrowset without descending its tree for each row.
+  MRSInsertHint insert_hint;
   for (int op_idx = 0; op_idx < num_ops; op_idx++) {
     RowOp* row_op = tx_state->row_ops()[op_idx];
     if (row_op->has_result()) continue;
 
-    RETURN_NOT_OK(ApplyRowOperation(tx_state, row_op, tx_state->mutable_op_stats(op_idx)));
+    RETURN_NOT_OK(ApplyRowOperation(tx_state, row_op, tx_state->mutable_op_stats(op_idx),
+                                    &insert_hint));
     DCHECK(row_op->has_result());
   }
 
@@ -911,7 +967,8 @@ Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
 
 Status Tablet::ApplyRowOperation(WriteTransactionState* tx_state,
                                  RowOp* row_op,
-                                 ProbeStats* stats) {
+                                 ProbeStats* stats,
+                                 MRSInsertHint* insert_hint) {
   {
     std::lock_guard<simple_spinlock> l(state_lock_);
     RETURN_NOT_OK_PREPEND(CheckHasNotBeenStoppedUnlocked(),
@@ -947,7 +1004,7 @@ Status Tablet::ApplyRowOperation(WriteTransactionState* tx_state,
   switch (row_op->decoded_op.type) {
     case RowOperationsPB::INSERT:
     case RowOperationsPB::UPSERT:
-      s = InsertOrUpsertUnlocked(tx_state, row_op, stats);
+      s = InsertOrUpsertUnlocked(tx_state, row_op, stats, insert_hint);
       if (s.IsAlreadyPresent()) {
         return Status::OK();
       }
@@ -1452,7 +1509,8 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
   RETURN_NOT_OK(input.CreateCompactionInput(flush_snap, schema(), &merge));
 
   RollingDiskRowSetWriter drsw(metadata_.get(), merge->schema(), DefaultBloomSizing(),
-                               compaction_policy_->target_rowset_size());
+                               compaction_policy_->target_rowset_size(),
+                               column_writer_pool_.get());
   RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for flush");
 
   HistoryGcOpts history_gc_opts = GetHistoryGcOpts();
@@ -61,6 +61,7 @@ class MemTracker;
 class MonoDelta;
 class RowBlock;
 class ScanSpec;
+class ThreadPool;
 class Throttler;
 class Timestamp;
 struct IteratorStats;
@@ -75,6 +76,7 @@ class AlterSchemaTransactionState;
 class CompactionPolicy;
 class HistoryGcOpts;
 class MemRowSet;
+class MRSInsertHint;
 class RowSetTree;
 class RowSetsInCompaction;
 class WriteTransactionState;
@@ -137,7 +139,8 @@ class Tablet {
   Status DecodeWriteOperations(const Schema* client_schema,
                                WriteTransactionState* tx_state);
 
-  // Acquire locks for each of the operations in the given txn.
+  // Acquire locks for each of the operations in the given txn, and set their
+  // RowSetKeyProbes. The locks are taken in a single batch.
   //
   // Note that, if this fails, it's still possible that the transaction
   // state holds _some_ of the locks. In that case, we expect that
@@ -155,24 +158,6 @@ class Tablet {
   // don't boot a tablet server.
   void AssignTimestampAndStartTransactionForTests(WriteTransactionState* tx_state);
 
-  // Insert a new row into the tablet.
-  //
-  // The provided 'data' slice should have length equivalent to this
-  // tablet's Schema.byte_size().
-  //
-  // After insert, the row and any referred-to memory (eg for strings)
-  // have been copied into internal memory, and thus the provided memory
-  // buffer may safely be re-used or freed.
-  //
-  // Returns Status::AlreadyPresent() if an entry with the same key is already
-  // present in the tablet.
-  // Returns Status::OK unless allocation fails.
-  //
-  // Acquires the row lock for the given operation, setting it in the
-  // RowOp struct. This also sets the row op's RowSetKeyProbe.
-  Status AcquireLockForOp(WriteTransactionState* tx_state,
-                          RowOp* op);
-
   // Signal that the given transaction is about to Apply.
   void StartApplying(WriteTransactionState* tx_state);
 
@@ -181,9 +166,14 @@ class Tablet {
 
   // Apply a single row operation, which must already be prepared.
   // The result is set back into row_op->result.
+  //
+  // If not NULL, 'insert_hint' is used to insert rows into the memrowset
+  // next to the previous row inserted with it. It should be shared by the
+  // operations of a transaction, so that sorted batches are appended quickly.
   Status ApplyRowOperation(WriteTransactionState* tx_state,
                            RowOp* row_op,
-                           ProbeStats* stats) WARN_UNUSED_RESULT;
+                           ProbeStats* stats,
+                           MRSInsertHint* insert_hint) WARN_UNUSED_RESULT;
 
   // Create a new row iterator which yields the rows as of the current MVCC
   // state of this tablet.
@@ -513,7 +503,8 @@ class Tablet {
   // - the operation has been decoded
   Status InsertOrUpsertUnlocked(WriteTransactionState *tx_state,
                                 RowOp* op,
-                                ProbeStats* stats);
+                                ProbeStats* stats,
+                                MRSInsertHint* insert_hint);
 
   // Same as above, but for UPDATE.
   Status MutateRowUnlocked(WriteTransactionState *tx_state,
@@ -679,6 +670,11 @@ class Tablet {
 
   gscoped_ptr<CompactionPolicy> compaction_policy_;
 
+  // Encodes the columns of the rowsets written by flushes and compactions,
+  // or NULL if they are encoded by the flushing thread.
+  // See --tablet_compaction_column_writer_threads.
+  gscoped_ptr<ThreadPool> column_writer_pool_;
+
   // Lock protecting the selection of rowsets for compaction.
   // Only one thread may run the compaction selection algorithm at a time
   // so that they don't both try to select the same rowset.
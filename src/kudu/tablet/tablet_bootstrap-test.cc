@@ -27,6 +27,7 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -78,6 +79,8 @@
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_int32(tablet_bootstrap_read_ahead_mb);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -266,6 +269,27 @@ TEST_F(BootstrapTest, TestBootstrapHighOpIdIndex) {
   ASSERT_OPID_EQ(last_opid, boot_info.last_committed_id);
 }
 
+// Test that a log of several segments replays the same whether it's read ahead
+// of the replay on a separate thread, as by default, or on the replaying one.
+TEST_F(BootstrapTest, TestBootstrapWithoutReadAhead) {
+  FLAGS_tablet_bootstrap_read_ahead_mb = 0;
+  const int kNumSegments = 3;
+  const int kOpsPerSegment = 10;
+  ASSERT_OK(BuildLog());
+  for (int i = 0; i < kNumSegments; i++) {
+    ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kOpsPerSegment));
+    ASSERT_OK(RollLog());
+  }
+
+  shared_ptr<Tablet> tablet;
+  ConsensusBootstrapInfo boot_info;
+  ASSERT_OK(BootstrapTestTablet(-1, -1, &tablet, &boot_info));
+  ASSERT_EQ(kNumSegments * kOpsPerSegment, boot_info.last_id.index());
+  vector<string> results;
+  IterateTabletRows(tablet.get(), &results);
+  ASSERT_EQ(kNumSegments * kOpsPerSegment, results.size());
+}
+
 // Tests attempting a local bootstrap of a tablet that was in the middle of a
 // tablet copy before "crashing".
 TEST_F(BootstrapTest, TestIncompleteTabletCopy) {
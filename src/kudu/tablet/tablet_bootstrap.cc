@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/tablet_bootstrap.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <map>
@@ -63,6 +64,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/tablet/memrowset.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/row_op.h"
@@ -77,6 +79,7 @@
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
+#include "kudu/util/blocking_queue.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -89,6 +92,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/thread.h"
 
 DECLARE_int32(group_commit_queue_size_bytes);
 
@@ -98,6 +102,12 @@ DEFINE_double(fault_crash_during_log_replay, 0.0,
               "(For testing only!)");
 TAG_FLAG(fault_crash_during_log_replay, unsafe);
 
+DEFINE_int32(tablet_bootstrap_read_ahead_mb, 8,
+             "The amount of WAL which tablet bootstrap reads and decodes ahead of its "
+             "replay, on a separate thread, so that reading the log overlaps with "
+             "applying it. If 0, the log is read on the thread replaying it.");
+TAG_FLAG(tablet_bootstrap_read_ahead_mb, advanced);
+
 DECLARE_int32(max_clock_sync_error_usec);
 
 using kudu::clock::Clock;
@@ -1124,6 +1134,159 @@ void TabletBootstrap::DumpReplayStateToLog(const ReplayState& state) {
   }
 }
 
+// A run of consecutive entries read from a log segment.
+struct LogEntryChunk {
+  // The index of the segment in the sequence being read.
+  int segment_idx;
+
+  // The entries which were read successfully.
+  vector<unique_ptr<LogEntryPB>> entries;
+
+  // The error met when reading past 'entries', if any. No chunk follows a
+  // failed one.
+  Status status;
+
+  // Whether the end of the segment was reached after 'entries'.
+  bool last_in_segment;
+
+  // The offset in the segment up to which entries were read, and the offset
+  // at which reading the segment stops.
+  int64_t offset;
+  int64_t read_up_to_offset;
+
+  // The number of bytes of the segment read for 'entries'.
+  int64_t bytes;
+};
+
+// Measures the chunks of a BlockingQueue by the bytes of log they hold.
+struct LogEntryChunkSize {
+  static size_t logical_size(const LogEntryChunk* chunk) {
+    return chunk->bytes;
+  }
+};
+
+// Reads the entries of a sequence of log segments in chunks, in order.
+//
+// Unless --tablet_bootstrap_read_ahead_mb is 0, the entries are read,
+// decompressed and decoded on a separate thread, which stays up to that much
+// log ahead of the caller, so that reading the log overlaps with replaying it.
+class LogEntryReadAhead {
+ public:
+  // 'segments' must outlive this object.
+  explicit LogEntryReadAhead(const log::SegmentSequence& segments)
+      : segments_(segments),
+        segment_idx_(0),
+        failed_(false),
+        queue_(std::max(FLAGS_tablet_bootstrap_read_ahead_mb, 1) * 1024 * 1024) {
+  }
+
+  ~LogEntryReadAhead() {
+    queue_.Shutdown();
+    if (thread_) {
+      thread_->Join();
+    }
+    LogEntryChunk* chunk;
+    while (queue_.BlockingGet(&chunk)) {
+      delete chunk;
+    }
+  }
+
+  // Starts reading ahead, if enabled.
+  Status Start() {
+    if (FLAGS_tablet_bootstrap_read_ahead_mb <= 0 || segments_.empty()) {
+      return Status::OK();
+    }
+    return Thread::Create("tablet-bootstrap", "log-read-ahead",
+                          &LogEntryReadAhead::RunThread, this, &thread_);
+  }
+
+  // Sets 'chunk' to the next chunk of entries. Returns false once all the
+  // segments have been read.
+  bool GetNextChunk(unique_ptr<LogEntryChunk>* chunk) {
+    if (!thread_) {
+      *chunk = ReadChunk();
+      return *chunk != nullptr;
+    }
+    LogEntryChunk* next;
+    if (!queue_.BlockingGet(&next)) {
+      return false;
+    }
+    chunk->reset(next);
+    return true;
+  }
+
+ private:
+  // The amount of log read at once into a chunk.
+  static const int64_t kChunkBytes = 1024 * 1024;
+
+  // Reads the next chunk of entries. Returns null once all the segments have
+  // been read, or after an error.
+  unique_ptr<LogEntryChunk> ReadChunk() {
+    if (failed_) {
+      return nullptr;
+    }
+    if (!reader_) {
+      if (segment_idx_ == static_cast<int>(segments_.size())) {
+        return nullptr;
+      }
+      reader_.reset(new log::LogEntryReader(segments_[segment_idx_].get()));
+    }
+    unique_ptr<LogEntryChunk> chunk(new LogEntryChunk);
+    chunk->segment_idx = segment_idx_;
+    chunk->last_in_segment = false;
+    const int64_t start_offset = reader_->offset();
+    while (reader_->offset() - start_offset < kChunkBytes) {
+      unique_ptr<LogEntryPB> entry;
+      Status s = reader_->ReadNextEntry(&entry);
+      if (s.IsEndOfFile()) {
+        chunk->last_in_segment = true;
+        break;
+      }
+      if (PREDICT_FALSE(!s.ok())) {
+        chunk->status = s;
+        failed_ = true;
+        break;
+      }
+      chunk->entries.emplace_back(std::move(entry));
+    }
+    chunk->offset = reader_->offset();
+    chunk->read_up_to_offset = reader_->read_up_to_offset();
+    chunk->bytes = chunk->offset - start_offset;
+    if (chunk->last_in_segment) {
+      reader_.reset();
+      segment_idx_++;
+    }
+    return chunk;
+  }
+
+  void RunThread() {
+    while (true) {
+      unique_ptr<LogEntryChunk> chunk = ReadChunk();
+      // Stop once done, or once the caller has shut the queue down.
+      if (!chunk || !queue_.BlockingPut(chunk.get())) {
+        break;
+      }
+      ignore_result(chunk.release());
+    }
+    queue_.Shutdown();
+  }
+
+  const log::SegmentSequence& segments_;
+
+  // The segment read by 'reader_', or to be read next if 'reader_' is null.
+  int segment_idx_;
+  unique_ptr<log::LogEntryReader> reader_;
+
+  // Whether reading failed; nothing more is read after a failure.
+  bool failed_;
+
+  // The chunks read ahead by 'thread_'.
+  BlockingQueue<LogEntryChunk*, LogEntryChunkSize> queue_;
+  scoped_refptr<Thread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogEntryReadAhead);
+};
+
 Status TabletBootstrap::PlaySegments(ConsensusBootstrapInfo* consensus_info) {
   ReplayState state;
   log::SegmentSequence segments;
@@ -1152,50 +1315,48 @@ Status TabletBootstrap::PlaySegments(ConsensusBootstrapInfo* consensus_info) {
   const auto kStatusUpdateInterval = MonoDelta::FromSeconds(5);
   int segment_count = 0;
 
-  for (const scoped_refptr<ReadableLogSegment>& segment : segments) {
-    log::LogEntryReader reader(segment.get());
-
-    int entry_count = 0;
-    while (true) {
-      {
-        unique_ptr<LogEntryPB> entry;
-        Status s = reader.ReadNextEntry(&entry);
-        if (PREDICT_FALSE(!s.ok())) {
-          if (s.IsEndOfFile()) {
-            break;
-          }
-          return Status::Corruption(
-              Substitute("Error reading Log Segment of tablet $0: $1 "
-                         "(Read up to entry $2 of segment $3, in path $4)",
-                         tablet_->tablet_id(),
-                         s.ToString(),
-                         entry_count,
-                         segment->header().sequence_number(),
-                         segment->path()));
-        }
-        entry_count++;
-
-        string entry_debug_info;
-        s = HandleEntry(&state, std::move(entry), &entry_debug_info);
-        if (!s.ok()) {
-          DumpReplayStateToLog(state);
-          RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
-                                             segment->header().sequence_number(),
-                                             entry_count, segment->path(),
-                                             entry_debug_info));
-        }
+  LogEntryReadAhead read_ahead(segments);
+  RETURN_NOT_OK_PREPEND(read_ahead.Start(), "Failed to start reading the log ahead");
+  int entry_count = 0;
+  unique_ptr<LogEntryChunk> chunk;
+  while (read_ahead.GetNextChunk(&chunk)) {
+    const scoped_refptr<ReadableLogSegment>& segment = segments[chunk->segment_idx];
+    for (auto& entry : chunk->entries) {
+      entry_count++;
+
+      string entry_debug_info;
+      Status s = HandleEntry(&state, std::move(entry), &entry_debug_info);
+      if (!s.ok()) {
+        DumpReplayStateToLog(state);
+        RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
+                                           segment->header().sequence_number(),
+                                           entry_count, segment->path(),
+                                           entry_debug_info));
       }
+    }
+    if (PREDICT_FALSE(!chunk->status.ok())) {
+      return Status::Corruption(
+          Substitute("Error reading Log Segment of tablet $0: $1 "
+                     "(Read up to entry $2 of segment $3, in path $4)",
+                     tablet_->tablet_id(),
+                     chunk->status.ToString(),
+                     entry_count,
+                     segment->header().sequence_number(),
+                     segment->path()));
+    }
 
+    if (!chunk->last_in_segment) {
       const auto now = MonoTime::Now();
       if (now - last_status_update > kStatusUpdateInterval) {
         SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
                                     "($2/$3 this segment, stats: $4)",
                                     segment_count + 1, log_reader_->num_segments(),
-                                    HumanReadableNumBytes::ToString(reader.offset()),
-                                    HumanReadableNumBytes::ToString(reader.read_up_to_offset()),
+                                    HumanReadableNumBytes::ToString(chunk->offset),
+                                    HumanReadableNumBytes::ToString(chunk->read_up_to_offset),
                                     stats_.ToString()));
         last_status_update = now;
       }
+      continue;
     }
 
     SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
@@ -1204,6 +1365,7 @@ Status TabletBootstrap::PlaySegments(ConsensusBootstrapInfo* consensus_info) {
                                 stats_.ToString(),
                                 state.pending_replicates.size()));
     segment_count++;
+    entry_count = 0;
   }
 
   // If we have non-applied commits they all must belong to pending operations and
@@ -1488,6 +1650,7 @@ Status TabletBootstrap::ApplyOperations(WriteTransactionState* tx_state,
   DCHECK_EQ(tx_state->row_ops().size(), orig_result.ops_size());
   DCHECK_EQ(tx_state->row_ops().size(), new_result->ops_size());
   int32_t op_idx = 0;
+  MRSInsertHint insert_hint;
   for (RowOp* op : tx_state->row_ops()) {
     int32_t curr_op_idx = op_idx++;
     // Increment the seen/ignored stats.
@@ -1530,7 +1693,7 @@ Status TabletBootstrap::ApplyOperations(WriteTransactionState* tx_state,
 
     // Actually apply it.
     ProbeStats stats; // we don't use this, but tablet internals require non-NULL.
-    RETURN_NOT_OK(tablet_->ApplyRowOperation(tx_state, op, &stats));
+    RETURN_NOT_OK(tablet_->ApplyRowOperation(tx_state, op, &stats, &insert_hint));
     DCHECK(op->result != nullptr);
 
     // We expect that the above Apply() will always succeed, because we're
@@ -88,6 +88,11 @@ class TransactionTracker;
 //  5 - ApplyAsync() submits ApplyTask() to the apply_pool_.
 //      ApplyTask() calls transaction_->Apply().
 //
+//      The transactions of a tablet are applied concurrently, though ApplyAsync() is
+//      called in OpId order: transactions touching the same rows were serialized by
+//      the row locks taken in Prepare(), and the others may commit to the
+//      MvccManager in any order.
+//
 //      When Apply() is called, changes are made to the in-memory data structures. These
 //      changes are not visible to clients yet. After Apply() completes, a CommitMsg
 //      is enqueued to the WAL in order to store information about the operation result
@@ -108,7 +113,7 @@ class TransactionTracker;
 //
 // On the leader side, starting the mvcc transaction for writes
 // (calling tablet_->StartTransaction()) must always be done _after_ any relevant row locks are
-// acquired (using AcquireLockForOp). This ensures that, within each row, timestamps only move
+// acquired (using AcquireRowLocks). This ensures that, within each row, timestamps only move
 // forward. If we took a timestamp before getting the row lock, we could have the following
 // situation:
 //
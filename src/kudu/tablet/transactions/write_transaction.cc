@@ -367,9 +367,12 @@ void WriteTransactionState::UpdateMetricsForOp(const RowOp& op) {
 
 void WriteTransactionState::ReleaseRowLocks() {
   // free the row locks
+  vector<ScopedRowLock*> locks;
+  locks.reserve(row_ops_.size());
   for (RowOp* op : row_ops_) {
-    op->row_lock.Release();
+    locks.push_back(&op->row_lock);
   }
+  ScopedRowLock::ReleaseAll(locks);
 }
 
 WriteTransactionState::~WriteTransactionState() {
@@ -0,0 +1,229 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "kudu/tserver/scan_aggregator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/int128.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+
+using std::map;
+using std::string;
+
+namespace kudu {
+namespace tserver {
+
+class ScanAggregatorTest : public ::testing::Test {
+ public:
+  ScanAggregatorTest()
+      : schema_({ ColumnSchema("key", INT32),
+                  ColumnSchema("status", STRING),
+                  ColumnSchema("val", INT64, true /* nullable */),
+                  ColumnSchema("str", STRING, true /* nullable */) }, 1),
+        arena_(1024) {
+  }
+
+ protected:
+  // Fills 'block' with 'kNumRows' rows. Row 'i' has status "even" or "odd",
+  // 'val' equal to 'i' except that every fourth row is NULL, and a NULL 'str'
+  // except on row 3.
+  void FillRowBlock(RowBlock* block) {
+    block->selection_vector()->SetAllTrue();
+    for (int i = 0; i < block->nrows(); i++) {
+      RowBlockRow row = block->row(i);
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = i;
+      *reinterpret_cast<Slice*>(row.mutable_cell_ptr(1)) = i % 2 == 0 ? even_ : odd_;
+      *reinterpret_cast<int64_t*>(row.mutable_cell_ptr(2)) = i;
+      row.cell(2).set_null(i % 4 == 0);
+      *reinterpret_cast<Slice*>(row.mutable_cell_ptr(3)) = Slice("three");
+      row.cell(3).set_null(i != 3);
+    }
+  }
+
+  static void AddAggregate(AggregateSpecPB* spec, ColumnAggregatePB::Function function,
+                           const char* column_name = nullptr) {
+    ColumnAggregatePB* agg = spec->add_aggregates();
+    agg->set_function(function);
+    if (column_name) {
+      agg->set_column_name(column_name);
+    }
+  }
+
+  static int64_t DecodeInt64(const string& value) {
+    CHECK_EQ(sizeof(int64_t), value.size());
+    int64_t ret;
+    memcpy(&ret, value.data(), sizeof(ret));
+    return ret;
+  }
+
+  static int128_t DecodeInt128(const string& value) {
+    CHECK_EQ(sizeof(int128_t), value.size());
+    int128_t ret;
+    memcpy(&ret, value.data(), sizeof(ret));
+    return ret;
+  }
+
+  static const int kNumRows = 10;
+  const Slice even_ = "even";
+  const Slice odd_ = "odd";
+  Schema schema_;
+  Arena arena_;
+};
+
+TEST_F(ScanAggregatorTest, TestValidateSpec) {
+  AggregateSpecPB spec;
+  ASSERT_TRUE(ScanAggregator::ValidateSpec(spec, schema_).IsInvalidArgument());
+
+  AddAggregate(&spec, ColumnAggregatePB::COUNT);
+  ASSERT_OK(ScanAggregator::ValidateSpec(spec, schema_));
+
+  AddAggregate(&spec, ColumnAggregatePB::MAX, "str");
+  ASSERT_OK(ScanAggregator::ValidateSpec(spec, schema_));
+
+  // SUM requires a numeric column.
+  AggregateSpecPB sum_spec(spec);
+  AddAggregate(&sum_spec, ColumnAggregatePB::SUM, "str");
+  ASSERT_TRUE(ScanAggregator::ValidateSpec(sum_spec, schema_).IsInvalidArgument());
+
+  // Only COUNT may omit the column.
+  AggregateSpecPB min_spec(spec);
+  AddAggregate(&min_spec, ColumnAggregatePB::MIN);
+  ASSERT_TRUE(ScanAggregator::ValidateSpec(min_spec, schema_).IsInvalidArgument());
+
+  // Columns must be part of the projection.
+  AggregateSpecPB missing_spec(spec);
+  missing_spec.add_group_by_columns("missing");
+  ASSERT_TRUE(ScanAggregator::ValidateSpec(missing_spec, schema_).IsInvalidArgument());
+}
+
+TEST_F(ScanAggregatorTest, TestAggregatesWithoutGroupBy) {
+  AggregateSpecPB spec;
+  AddAggregate(&spec, ColumnAggregatePB::COUNT);
+  AddAggregate(&spec, ColumnAggregatePB::COUNT, "val");
+  AddAggregate(&spec, ColumnAggregatePB::SUM, "val");
+  AddAggregate(&spec, ColumnAggregatePB::MIN, "val");
+  AddAggregate(&spec, ColumnAggregatePB::MAX, "status");
+  AddAggregate(&spec, ColumnAggregatePB::MIN, "str");
+  ASSERT_OK(ScanAggregator::ValidateSpec(spec, schema_));
+
+  // Without any rows, there's a single group with zero counts.
+  {
+    ScanAggregator aggregator(spec);
+    AggregateResultPB pb;
+    aggregator.ToPB(&pb);
+    ASSERT_EQ(1, pb.groups_size());
+    ASSERT_EQ(spec.aggregates_size(), pb.groups(0).values_size());
+    for (const auto& value : pb.groups(0).values()) {
+      EXPECT_EQ(0, value.count());
+      EXPECT_FALSE(value.has_value());
+    }
+  }
+
+  RowBlock block(schema_, kNumRows, &arena_);
+  FillRowBlock(&block);
+  // Deselect row 9 to check that only selected rows are aggregated.
+  block.selection_vector()->SetRowUnselected(9);
+
+  ScanAggregator aggregator(spec);
+  aggregator.AddRowBlock(block);
+  aggregator.AddRowBlock(block);
+  AggregateResultPB pb;
+  aggregator.ToPB(&pb);
+  ASSERT_EQ(1, pb.groups_size());
+  const auto& group = pb.groups(0);
+  ASSERT_EQ(0, group.group_by_values_size());
+
+  // Rows 0..8 are selected; rows 0, 4 and 8 have a NULL 'val'.
+  EXPECT_EQ(18, group.values(0).count());
+  EXPECT_EQ(12, group.values(1).count());
+  EXPECT_EQ(2 * (1 + 2 + 3 + 5 + 6 + 7), DecodeInt128(group.values(2).value()));
+  EXPECT_EQ(1, DecodeInt64(group.values(3).value()));
+  EXPECT_EQ("odd", group.values(4).value());
+  EXPECT_EQ(2, group.values(5).count());
+  EXPECT_EQ("three", group.values(5).value());
+}
+
+TEST_F(ScanAggregatorTest, TestAggregatesWithGroupBy) {
+  AggregateSpecPB spec;
+  spec.add_group_by_columns("status");
+  AddAggregate(&spec, ColumnAggregatePB::COUNT);
+  AddAggregate(&spec, ColumnAggregatePB::MAX, "val");
+  ASSERT_OK(ScanAggregator::ValidateSpec(spec, schema_));
+
+  RowBlock block(schema_, kNumRows, &arena_);
+  FillRowBlock(&block);
+
+  ScanAggregator aggregator(spec);
+  aggregator.AddRowBlock(block);
+  ASSERT_EQ(2, aggregator.num_groups());
+  AggregateResultPB pb;
+  aggregator.ToPB(&pb);
+  ASSERT_EQ(2, pb.groups_size());
+
+  map<string, const AggregateResultPB::GroupPB*> groups;
+  for (const auto& group : pb.groups()) {
+    ASSERT_EQ(1, group.group_by_values_size());
+    ASSERT_FALSE(group.group_by_is_null(0));
+    groups[group.group_by_values(0)] = &group;
+  }
+  ASSERT_EQ(1, groups.count("even"));
+  ASSERT_EQ(1, groups.count("odd"));
+  EXPECT_EQ(5, groups["even"]->values(0).count());
+  EXPECT_EQ(6, DecodeInt64(groups["even"]->values(1).value()));
+  EXPECT_EQ(5, groups["odd"]->values(0).count());
+  EXPECT_EQ(9, DecodeInt64(groups["odd"]->values(1).value()));
+}
+
+// NULL values of GROUP BY columns form their own group.
+TEST_F(ScanAggregatorTest, TestGroupByNullableColumn) {
+  AggregateSpecPB spec;
+  spec.add_group_by_columns("str");
+  AddAggregate(&spec, ColumnAggregatePB::COUNT);
+
+  RowBlock block(schema_, kNumRows, &arena_);
+  FillRowBlock(&block);
+
+  ScanAggregator aggregator(spec);
+  aggregator.AddRowBlock(block);
+  AggregateResultPB pb;
+  aggregator.ToPB(&pb);
+  ASSERT_EQ(2, pb.groups_size());
+  for (const auto& group : pb.groups()) {
+    if (group.group_by_is_null(0)) {
+      EXPECT_EQ("", group.group_by_values(0));
+      EXPECT_EQ(kNumRows - 1, group.values(0).count());
+    } else {
+      EXPECT_EQ("three", group.group_by_values(0));
+      EXPECT_EQ(1, group.values(0).count());
+    }
+  }
+}
+
+} // namespace tserver
+} // namespace kudu
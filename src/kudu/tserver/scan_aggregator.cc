@@ -0,0 +1,348 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_aggregator.h"
+
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/slice.h"
+
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// The per-group overhead of a serialized group and of each of its
+// aggregates, used to estimate the size of the results.
+const int kGroupOverheadBytes = 8;
+const int kAggregateOverheadBytes = 24;
+
+bool SupportsSum(DataType type) {
+  switch (type) {
+    case INT8:
+    case INT16:
+    case INT32:
+    case INT64:
+    case FLOAT:
+    case DOUBLE:
+    case DECIMAL32:
+    case DECIMAL64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Appends the value of 'cell', of type 'type_info', to 'dst' in its
+// ColumnPredicatePB encoding.
+void AppendEncodedCell(const TypeInfo* type_info, const void* cell, string* dst) {
+  if (type_info->physical_type() == BINARY) {
+    const Slice* s = reinterpret_cast<const Slice*>(cell);
+    dst->append(reinterpret_cast<const char*>(s->data()), s->size());
+  } else {
+    dst->append(reinterpret_cast<const char*>(cell), type_info->size());
+  }
+}
+
+} // anonymous namespace
+
+ScanAggregator::ScanAggregator(const AggregateSpecPB& spec)
+    : spec_(spec),
+      columns_resolved_(false),
+      estimated_result_size_(0) {
+}
+
+ScanAggregator::~ScanAggregator() {}
+
+Status ScanAggregator::ValidateSpec(const AggregateSpecPB& spec, const Schema& projection) {
+  if (spec.aggregates_size() == 0 && spec.group_by_columns_size() == 0) {
+    return Status::InvalidArgument("aggregate spec has no aggregates or GROUP BY columns");
+  }
+  for (const ColumnAggregatePB& agg : spec.aggregates()) {
+    if (!agg.has_column_name()) {
+      if (agg.function() != ColumnAggregatePB::COUNT) {
+        return Status::InvalidArgument(Substitute(
+            "aggregate $0 requires a column",
+            ColumnAggregatePB::Function_Name(agg.function())));
+      }
+      continue;
+    }
+    int col_idx = projection.find_column(agg.column_name());
+    if (col_idx == Schema::kColumnNotFound) {
+      return Status::InvalidArgument(Substitute(
+          "aggregated column $0 is not part of the projection", agg.column_name()));
+    }
+    const ColumnSchema& col = projection.column(col_idx);
+    switch (agg.function()) {
+      case ColumnAggregatePB::COUNT:
+      case ColumnAggregatePB::MIN:
+      case ColumnAggregatePB::MAX:
+        break;
+      case ColumnAggregatePB::SUM:
+        if (!SupportsSum(col.type_info()->type())) {
+          return Status::InvalidArgument(Substitute(
+              "SUM is not supported for column $0 of type $1",
+              col.name(), col.type_info()->name()));
+        }
+        break;
+      default:
+        return Status::InvalidArgument(Substitute(
+            "unknown aggregate function for column $0", col.name()));
+    }
+  }
+  for (const string& col_name : spec.group_by_columns()) {
+    if (projection.find_column(col_name) == Schema::kColumnNotFound) {
+      return Status::InvalidArgument(Substitute(
+          "GROUP BY column $0 is not part of the projection", col_name));
+    }
+  }
+  return Status::OK();
+}
+
+void ScanAggregator::ResolveColumns(const Schema& schema) {
+  for (const ColumnAggregatePB& agg_pb : spec_.aggregates()) {
+    Aggregate agg;
+    agg.function = agg_pb.function();
+    if (agg_pb.has_column_name()) {
+      agg.col_idx = schema.find_column(agg_pb.column_name());
+      CHECK_NE(agg.col_idx, Schema::kColumnNotFound) << agg_pb.column_name();
+      agg.type_info = schema.column(agg.col_idx).type_info();
+    } else {
+      agg.col_idx = -1;
+      agg.type_info = nullptr;
+    }
+    aggregates_.push_back(agg);
+  }
+  for (const string& col_name : spec_.group_by_columns()) {
+    int col_idx = schema.find_column(col_name);
+    CHECK_NE(col_idx, Schema::kColumnNotFound) << col_name;
+    group_by_col_idxs_.push_back(col_idx);
+  }
+  columns_resolved_ = true;
+}
+
+ScanAggregator::Group* ScanAggregator::AddGroup(string key) {
+  Group group;
+  group.states.resize(aggregates_.size());
+  groups_.emplace_back(std::move(group));
+  estimated_result_size_ += kGroupOverheadBytes + key.size() +
+      aggregates_.size() * kAggregateOverheadBytes;
+  group_idx_by_key_.emplace(std::move(key), groups_.size() - 1);
+  return &groups_.back();
+}
+
+ScanAggregator::Group* ScanAggregator::FindOrAddGroup(const RowBlock& block,
+                                                      size_t row_idx,
+                                                      string* scratch) {
+  // Encode the GROUP BY values as a sequence of (null flag, value) pairs,
+  // prefixing variable-length values with their length so that the encoding
+  // is unambiguous.
+  scratch->clear();
+  for (int col_idx : group_by_col_idxs_) {
+    ColumnBlock column_block = block.column_block(col_idx);
+    if (column_block.is_nullable() && column_block.is_null(row_idx)) {
+      scratch->push_back('\0');
+      continue;
+    }
+    scratch->push_back('\1');
+    const void* cell = column_block.cell_ptr(row_idx);
+    if (column_block.type_info()->physical_type() == BINARY) {
+      uint32_t size = reinterpret_cast<const Slice*>(cell)->size();
+      scratch->append(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    AppendEncodedCell(column_block.type_info(), cell, scratch);
+  }
+
+  auto it = group_idx_by_key_.find(*scratch);
+  if (it != group_idx_by_key_.end()) {
+    return &groups_[it->second];
+  }
+
+  Group* group = AddGroup(*scratch);
+  for (int col_idx : group_by_col_idxs_) {
+    ColumnBlock column_block = block.column_block(col_idx);
+    bool is_null = column_block.is_nullable() && column_block.is_null(row_idx);
+    group->key_is_null.push_back(is_null);
+    group->key_values.emplace_back();
+    if (!is_null) {
+      AppendEncodedCell(column_block.type_info(), column_block.cell_ptr(row_idx),
+                        &group->key_values.back());
+    }
+  }
+  return group;
+}
+
+void ScanAggregator::Accumulate(const Aggregate& agg, const void* cell, AggregateState* state) {
+  if (agg.col_idx == -1) {
+    // COUNT(*).
+    state->count++;
+    return;
+  }
+  if (cell == nullptr) {
+    // NULL cells don't contribute to any aggregate of a column.
+    return;
+  }
+  state->count++;
+  switch (agg.function) {
+    case ColumnAggregatePB::COUNT:
+      break;
+    case ColumnAggregatePB::SUM:
+      state->has_value = true;
+      switch (agg.type_info->physical_type()) {
+        case INT8: state->int_sum += *reinterpret_cast<const int8_t*>(cell); break;
+        case INT16: state->int_sum += *reinterpret_cast<const int16_t*>(cell); break;
+        case INT32: state->int_sum += *reinterpret_cast<const int32_t*>(cell); break;
+        case INT64: state->int_sum += *reinterpret_cast<const int64_t*>(cell); break;
+        case FLOAT: state->double_sum += *reinterpret_cast<const float*>(cell); break;
+        case DOUBLE: state->double_sum += *reinterpret_cast<const double*>(cell); break;
+        default:
+          LOG(FATAL) << "SUM is not supported for type " << agg.type_info->name();
+      }
+      break;
+    case ColumnAggregatePB::MIN:
+    case ColumnAggregatePB::MAX: {
+      if (state->has_value) {
+        int cmp;
+        if (agg.type_info->physical_type() == BINARY) {
+          Slice current(state->value);
+          cmp = agg.type_info->Compare(cell, &current);
+        } else {
+          cmp = agg.type_info->Compare(cell, state->value.data());
+        }
+        bool replace = agg.function == ColumnAggregatePB::MIN ? cmp < 0 : cmp > 0;
+        if (!replace) {
+          break;
+        }
+      }
+      state->value.clear();
+      AppendEncodedCell(agg.type_info, cell, &state->value);
+      state->has_value = true;
+      break;
+    }
+    default:
+      LOG(FATAL) << "unknown aggregate function " << agg.function;
+  }
+}
+
+void ScanAggregator::AccumulateColumn(const Aggregate& agg, const RowBlock& block,
+                                      AggregateState* state) {
+  const SelectionVector* sel = block.selection_vector();
+  if (agg.col_idx == -1) {
+    state->count += sel->CountSelected();
+    return;
+  }
+  ColumnBlock column_block = block.column_block(agg.col_idx);
+  const bool nullable = column_block.is_nullable();
+  for (size_t row_idx = 0; row_idx < block.nrows(); row_idx++) {
+    if (!sel->IsRowSelected(row_idx)) continue;
+    const void* cell = (nullable && column_block.is_null(row_idx)) ?
+        nullptr : column_block.cell_ptr(row_idx);
+    Accumulate(agg, cell, state);
+  }
+}
+
+void ScanAggregator::AddRowBlock(const RowBlock& block) {
+  if (PREDICT_FALSE(!columns_resolved_)) {
+    ResolveColumns(block.schema());
+  }
+
+  if (group_by_col_idxs_.empty()) {
+    // There is always exactly one group, so each aggregate can be
+    // accumulated a whole column at a time.
+    if (groups_.empty()) {
+      AddGroup("");
+    }
+    Group* group = &groups_[0];
+    for (int i = 0; i < aggregates_.size(); i++) {
+      AccumulateColumn(aggregates_[i], block, &group->states[i]);
+    }
+    return;
+  }
+
+  const SelectionVector* sel = block.selection_vector();
+  string scratch;
+  for (size_t row_idx = 0; row_idx < block.nrows(); row_idx++) {
+    if (!sel->IsRowSelected(row_idx)) continue;
+    Group* group = FindOrAddGroup(block, row_idx, &scratch);
+    for (int i = 0; i < aggregates_.size(); i++) {
+      const Aggregate& agg = aggregates_[i];
+      const void* cell = nullptr;
+      if (agg.col_idx != -1) {
+        ColumnBlock column_block = block.column_block(agg.col_idx);
+        if (!column_block.is_nullable() || !column_block.is_null(row_idx)) {
+          cell = column_block.cell_ptr(row_idx);
+        }
+      }
+      Accumulate(agg, cell, &group->states[i]);
+    }
+  }
+}
+
+void ScanAggregator::ToPB(AggregateResultPB* pb) const {
+  // A scan without GROUP BY columns always returns its single group, even
+  // if no rows were scanned.
+  if (groups_.empty() && spec_.group_by_columns_size() == 0) {
+    AggregateResultPB::GroupPB* group_pb = pb->add_groups();
+    for (int i = 0; i < spec_.aggregates_size(); i++) {
+      group_pb->add_values()->set_count(0);
+    }
+    return;
+  }
+
+  for (const Group& group : groups_) {
+    AggregateResultPB::GroupPB* group_pb = pb->add_groups();
+    for (int i = 0; i < group.key_values.size(); i++) {
+      group_pb->add_group_by_values(group.key_values[i]);
+      group_pb->add_group_by_is_null(group.key_is_null[i]);
+    }
+    for (int i = 0; i < aggregates_.size(); i++) {
+      const Aggregate& agg = aggregates_[i];
+      const AggregateState& state = group.states[i];
+      AggregateValuePB* value_pb = group_pb->add_values();
+      value_pb->set_count(state.count);
+      if (!state.has_value) continue;
+      if (agg.function == ColumnAggregatePB::SUM) {
+        DataType type = agg.type_info->physical_type();
+        if (type == FLOAT || type == DOUBLE) {
+          value_pb->set_value(reinterpret_cast<const char*>(&state.double_sum),
+                              sizeof(state.double_sum));
+        } else {
+          value_pb->set_value(reinterpret_cast<const char*>(&state.int_sum),
+                              sizeof(state.int_sum));
+        }
+      } else {
+        value_pb->set_value(state.value);
+      }
+    }
+  }
+}
+
+} // namespace tserver
+} // namespace kudu
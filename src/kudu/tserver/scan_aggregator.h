@@ -0,0 +1,133 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_TSERVER_SCAN_AGGREGATOR_H
+#define KUDU_TSERVER_SCAN_AGGREGATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/int128.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class RowBlock;
+class Schema;
+class TypeInfo;
+
+namespace tserver {
+
+// Computes the partial aggregates described by an AggregateSpecPB over the
+// selected rows of a sequence of RowBlocks, optionally grouped by the values
+// of some columns.
+//
+// Each aggregate is accumulated a column at a time when there are no GROUP BY
+// columns. Otherwise, each selected row is first mapped to its group.
+class ScanAggregator {
+ public:
+  explicit ScanAggregator(const AggregateSpecPB& spec);
+  ~ScanAggregator();
+
+  // Checks that 'spec' only refers to columns of 'projection', and that it
+  // only applies functions which are supported for the types of those columns.
+  static Status ValidateSpec(const AggregateSpecPB& spec, const Schema& projection);
+
+  // Accumulates the selected rows of 'block'. The schema of the block must
+  // contain every column referred to by the spec, and must be the same for
+  // every call.
+  void AddRowBlock(const RowBlock& block);
+
+  // Returns an estimate of the size of the aggregates accumulated so far,
+  // once serialized.
+  int64_t EstimatedResultSize() const {
+    return estimated_result_size_;
+  }
+
+  // Returns the number of groups accumulated so far.
+  int64_t num_groups() const {
+    return groups_.size();
+  }
+
+  // Serializes the accumulated aggregates into 'pb'.
+  void ToPB(AggregateResultPB* pb) const;
+
+ private:
+  // An aggregate of the spec, resolved against the schema of the row blocks.
+  struct Aggregate {
+    ColumnAggregatePB::Function function;
+    // The index of the column in the row blocks, or -1 for COUNT(*).
+    int col_idx;
+    const TypeInfo* type_info;
+  };
+
+  // The running state of one aggregate of one group.
+  struct AggregateState {
+    int64_t count = 0;
+    bool has_value = false;
+    int128_t int_sum = 0;
+    double double_sum = 0;
+    // The current MIN or MAX value, in its ColumnPredicatePB encoding.
+    std::string value;
+  };
+
+  struct Group {
+    std::vector<std::string> key_values;
+    std::vector<bool> key_is_null;
+    std::vector<AggregateState> states;
+  };
+
+  void ResolveColumns(const Schema& schema);
+
+  // Returns the group of row 'row_idx' of 'block', adding it if it's new.
+  // 'scratch' is used to encode the group key.
+  Group* FindOrAddGroup(const RowBlock& block, size_t row_idx, std::string* scratch);
+
+  Group* AddGroup(std::string key);
+
+  // Adds the cell 'cell' of 'agg' to 'state'. 'cell' is NULL for COUNT(*) or
+  // if the cell is NULL.
+  static void Accumulate(const Aggregate& agg, const void* cell, AggregateState* state);
+
+  // Accumulates every selected cell of the column of 'agg' in 'block'.
+  static void AccumulateColumn(const Aggregate& agg, const RowBlock& block,
+                               AggregateState* state);
+
+  const AggregateSpecPB spec_;
+
+  bool columns_resolved_;
+  std::vector<Aggregate> aggregates_;
+  std::vector<int> group_by_col_idxs_;
+
+  // The groups accumulated so far, and an index from the encoded values of
+  // their GROUP BY columns to their position in 'groups_'.
+  std::vector<Group> groups_;
+  std::unordered_map<std::string, size_t> group_idx_by_key_;
+
+  int64_t estimated_result_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanAggregator);
+};
+
+} // namespace tserver
+} // namespace kudu
+
+#endif // KUDU_TSERVER_SCAN_AGGREGATOR_H
@@ -38,6 +38,7 @@
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tserver/scanner_metrics.h"
+#include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
@@ -335,6 +336,10 @@ void Scanner::Init(gscoped_ptr<RowwiseIterator> iter,
   spec_.reset(spec.release());
 }
 
+void Scanner::set_aggregate_spec(gscoped_ptr<AggregateSpecPB> aggregate_spec) {
+  aggregate_spec_.swap(aggregate_spec);
+}
+
 const ScanSpec& Scanner::spec() const {
   return *spec_;
 }
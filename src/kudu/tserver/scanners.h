@@ -54,6 +54,7 @@ class Thread;
 
 namespace tserver {
 
+class AggregateSpecPB;
 class Scanner;
 enum class ScanState;
 struct ScanDescriptor;
@@ -293,6 +294,15 @@ class Scanner {
     return row_format_flags_;
   }
 
+  // Associate an aggregate spec with the Scanner, which then returns the
+  // aggregates of the scanned rows rather than the rows themselves. Must be
+  // called before the scanner is first continued.
+  void set_aggregate_spec(gscoped_ptr<AggregateSpecPB> aggregate_spec);
+
+  // Returns the aggregate spec of the scan, or NULL if the scan doesn't
+  // aggregate its results.
+  const AggregateSpecPB* aggregate_spec() const { return aggregate_spec_.get(); }
+
   void add_num_rows_returned(int64_t num_rows_added) {
     std::lock_guard<simple_spinlock> l(lock_);
     num_rows_returned_ += num_rows_added;
@@ -356,6 +366,9 @@ class Scanner {
 
   gscoped_ptr<RowwiseIterator> iter_;
 
+  // The aggregates computed by the scan, if any.
+  gscoped_ptr<AggregateSpecPB> aggregate_spec_;
+
   AutoReleasePool autorelease_pool_;
 
   // Arena used for allocations which must last as long as the scanner
@@ -94,6 +94,7 @@
 #include "kudu/util/curl_util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/int128.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -2202,6 +2203,106 @@ TEST_F(TabletServerTest, TestRandomizedScanLimits) {
   }
 }
 
+// Runs an aggregate scan end-to-end, over several batches, merging the
+// partial aggregates of every response.
+TEST_F(TabletServerTest, TestAggregateScan) {
+  const int kNumRows = 1000;
+  FLAGS_scanner_batch_size_rows = 100;
+  InsertTestRowsDirect(0, kNumRows);
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns(),
+                              SCHEMA_PB_WITHOUT_IDS));
+  AggregateSpecPB* spec = scan->mutable_aggregate_spec();
+  spec->add_aggregates()->set_function(ColumnAggregatePB::COUNT);
+  for (auto function : { ColumnAggregatePB::SUM, ColumnAggregatePB::MIN,
+                         ColumnAggregatePB::MAX }) {
+    ColumnAggregatePB* agg = spec->add_aggregates();
+    agg->set_function(function);
+    agg->set_column_name("int_val");
+  }
+  // Return the aggregates after every block, so the scan takes several RPCs.
+  req.set_batch_size_bytes(1);
+  req.set_call_seq_id(0);
+
+  int64_t count = 0;
+  int128_t sum = 0;
+  int32_t min_val = INT32_MAX;
+  int32_t max_val = INT32_MIN;
+  int num_rpcs = 0;
+  while (true) {
+    ScanResponsePB resp;
+    RpcController rpc;
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_FALSE(resp.has_data());
+    num_rpcs++;
+
+    const AggregateResultPB& result = resp.aggregate_result();
+    ASSERT_EQ(1, result.groups_size());
+    const auto& values = result.groups(0).values();
+    ASSERT_EQ(4, values.size());
+    count += values.Get(0).count();
+    if (values.Get(1).has_value()) {
+      int128_t partial_sum;
+      ASSERT_EQ(sizeof(partial_sum), values.Get(1).value().size());
+      memcpy(&partial_sum, values.Get(1).value().data(), sizeof(partial_sum));
+      sum += partial_sum;
+    }
+    if (values.Get(2).has_value()) {
+      int32_t partial_min;
+      ASSERT_EQ(sizeof(partial_min), values.Get(2).value().size());
+      memcpy(&partial_min, values.Get(2).value().data(), sizeof(partial_min));
+      min_val = std::min(min_val, partial_min);
+    }
+    if (values.Get(3).has_value()) {
+      int32_t partial_max;
+      ASSERT_EQ(sizeof(partial_max), values.Get(3).value().size());
+      memcpy(&partial_max, values.Get(3).value().data(), sizeof(partial_max));
+      max_val = std::max(max_val, partial_max);
+    }
+
+    if (!resp.has_more_results()) break;
+    string scanner_id = resp.scanner_id();
+    req.Clear();
+    req.set_scanner_id(scanner_id);
+    req.set_batch_size_bytes(1);
+    req.set_call_seq_id(num_rpcs);
+  }
+  ASSERT_GT(num_rpcs, 1);
+  // Each row's 'int_val' is twice its key.
+  EXPECT_EQ(kNumRows, count);
+  EXPECT_TRUE(sum == static_cast<int128_t>(kNumRows) * (kNumRows - 1));
+  EXPECT_EQ(0, min_val);
+  EXPECT_EQ((kNumRows - 1) * 2, max_val);
+}
+
+// Aggregate scans fold the rows they read into aggregates, so a limit on the
+// number of rows returned has no meaning for them and is rejected.
+TEST_F(TabletServerTest, TestAggregateScanRejectsLimit) {
+  InsertTestRowsDirect(0, 10);
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  scan->set_limit(5);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns(),
+                              SCHEMA_PB_WITHOUT_IDS));
+  scan->mutable_aggregate_spec()->add_aggregates()->set_function(ColumnAggregatePB::COUNT);
+
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  SCOPED_TRACE(SecureDebugString(resp));
+  ASSERT_TRUE(resp.has_error());
+  ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  ASSERT_STR_CONTAINS(StatusFromPB(resp.error().status()).ToString(),
+                      "Cannot limit a scan which computes aggregates");
+}
+
 TEST_F(TabletServerTest, TestScanWithPredicates) {
   int num_rows = AllowSlowTests() ? 10000 : 1000;
   InsertTestRowsDirect(0, num_rows);
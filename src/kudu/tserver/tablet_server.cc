@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_prefetcher.h"
 #include "kudu/fs/error_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/bind.h"
@@ -81,6 +82,7 @@ Status TabletServer::Init() {
   CHECK(!initted_);
 
   cfile::BlockCache::GetSingleton()->StartInstrumentation(metric_entity());
+  cfile::BlockPrefetcher::GetSingleton()->StartInstrumentation(metric_entity());
 
   // Validate that the passed master address actually resolves.
   // We don't validate that we can connect at this point -- it should
@@ -74,6 +74,7 @@
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
 #include "kudu/tablet/transactions/transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
+#include "kudu/tserver/scan_aggregator.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_replica_lookup.h"
 #include "kudu/tserver/tablet_server.h"
@@ -436,6 +437,12 @@ class ScanResultCollector {
   //
   // Does nothing by default.
   virtual void set_row_format_flags(uint64_t /* row_format_flags */) {}
+
+  // Sets the projection requested by the client. This is called before any
+  // row blocks are handled, and even if the scan turns out to have no rows.
+  //
+  // Does nothing by default.
+  virtual void set_client_projection_schema(const Schema& /* projection */) {}
 };
 
 namespace {
@@ -467,16 +474,22 @@ void SetLastRow(const RowBlock& row_block, faststring* last_primary_key) {
 // (This is in contrast to some other ScanResultCollector implementation that
 // might do an aggregation or gather some other types of statistics via a
 // server-side scan and thus never need to return the actual data.)
+//
+// If the client set the COLUMNAR_LAYOUT row format flag, the results are
+// serialized into 'columnar_data' instead of the row-wise buffers.
 class ScanResultCopier : public ScanResultCollector {
  public:
   ScanResultCopier(RowwiseRowBlockPB* rowblock_pb,
                    faststring* rows_data,
-                   faststring* indirect_data)
+                   faststring* indirect_data,
+                   ColumnarSerializedBatch* columnar_data)
       : rowblock_pb_(DCHECK_NOTNULL(rowblock_pb)),
         rows_data_(DCHECK_NOTNULL(rows_data)),
         indirect_data_(DCHECK_NOTNULL(indirect_data)),
+        columnar_data_(DCHECK_NOTNULL(columnar_data)),
         num_rows_returned_(0),
-        pad_unixtime_micros_to_16_bytes_(false) {}
+        pad_unixtime_micros_to_16_bytes_(false),
+        columnar_layout_(false) {}
 
   void HandleRowBlock(Scanner* scanner, const RowBlock& row_block) override {
     int64_t num_selected = row_block.selection_vector()->CountSelected();
@@ -486,13 +499,26 @@ class ScanResultCopier : public ScanResultCollector {
 
     num_rows_returned_ += num_selected;
     scanner->add_num_rows_returned(num_selected);
-    SerializeRowBlock(row_block, rowblock_pb_, scanner->client_projection_schema(),
-                      rows_data_, indirect_data_, pad_unixtime_micros_to_16_bytes_);
+    if (columnar_layout_) {
+      SerializeRowBlockColumnar(row_block, scanner->client_projection_schema(), columnar_data_);
+    } else {
+      SerializeRowBlock(row_block, rowblock_pb_, scanner->client_projection_schema(),
+                        rows_data_, indirect_data_, pad_unixtime_micros_to_16_bytes_);
+    }
     SetLastRow(row_block, &last_primary_key_);
   }
 
   // Returns number of bytes buffered to return.
   int64_t ResponseSize() const override {
+    if (columnar_layout_) {
+      int64_t size = 0;
+      for (const auto& col : columnar_data_->columns) {
+        size += col.data->size();
+        if (col.varlen_data) size += col.varlen_data->size();
+        if (col.non_null_bitmap) size += col.non_null_bitmap->size();
+      }
+      return size;
+    }
     return rows_data_->size() + indirect_data_->size();
   }
 
@@ -508,15 +534,32 @@ class ScanResultCopier : public ScanResultCollector {
     if (row_format_flags & RowFormatFlags::PAD_UNIX_TIME_MICROS_TO_16_BYTES) {
       pad_unixtime_micros_to_16_bytes_ = true;
     }
+    if (row_format_flags & RowFormatFlags::COLUMNAR_LAYOUT) {
+      columnar_layout_ = true;
+    }
+  }
+
+  void set_client_projection_schema(const Schema& projection) override {
+    // Respond with the projection's (empty) columns even if no rows match.
+    if (columnar_layout_) {
+      InitColumnarSerializedBatch(projection, columnar_data_);
+    }
+  }
+
+  // Whether the results are being serialized in columnar layout.
+  bool columnar_layout() const {
+    return columnar_layout_;
   }
 
  private:
   RowwiseRowBlockPB* const rowblock_pb_;
   faststring* const rows_data_;
   faststring* const indirect_data_;
+  ColumnarSerializedBatch* const columnar_data_;
   int64_t num_rows_returned_;
   faststring last_primary_key_;
   bool pad_unixtime_micros_to_16_bytes_;
+  bool columnar_layout_;
 
   DISALLOW_COPY_AND_ASSIGN(ScanResultCopier);
 };
@@ -603,6 +646,50 @@ class ScanResultChecksummer : public ScanResultCollector {
   DISALLOW_COPY_AND_ASSIGN(ScanResultChecksummer);
 };
 
+// Computes aggregates over the scan result, as requested by an aggregate spec
+// in the scan request, so that only the (partial) aggregates rather than the
+// rows need to be returned to the client.
+class ScanResultAggregator : public ScanResultCollector {
+ public:
+  explicit ScanResultAggregator(const AggregateSpecPB& spec)
+      : aggregator_(spec) {
+  }
+
+  void HandleRowBlock(Scanner* scanner, const RowBlock& row_block) override {
+    // The rows are folded into aggregates rather than returned, so the
+    // scanner's count of returned rows is not advanced. That count only
+    // matters for LIMIT, which aggregate scans reject up front.
+    DCHECK(!scanner->spec().has_limit());
+    aggregator_.AddRowBlock(row_block);
+    SetLastRow(row_block, &last_primary_key_);
+  }
+
+  // Returns the estimated size of the aggregates, so that scans with many
+  // groups return them in several batches.
+  int64_t ResponseSize() const override {
+    return aggregator_.EstimatedResultSize();
+  }
+
+  const faststring& last_primary_key() const override {
+    return last_primary_key_;
+  }
+
+  // Returns the number of groups, which are the "rows" sent to the client.
+  int64_t NumRowsReturned() const override {
+    return aggregator_.num_groups();
+  }
+
+  void ToPB(AggregateResultPB* pb) const {
+    aggregator_.ToPB(pb);
+  }
+
+ private:
+  ScanAggregator aggregator_;
+  faststring last_primary_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultAggregator);
+};
+
 // Return the batch size to use for a given request, after clamping
 // the user-requested request within the server-side allowable range.
 // This is only a hint, really more of a threshold since returned bytes
@@ -1280,6 +1367,31 @@ void SetResourceMetrics(ResourceMetricsPB* metrics, rpc::RpcContext* context) {
   metrics->set_cfile_cache_hit_bytes(
     context->trace()->metrics()->GetMetric(cfile::CFILE_CACHE_HIT_BYTES_METRIC_NAME));
 }
+
+// Moves the buffers of 'batch' into sidecars of the RPC response and records
+// their indices in 'pb'.
+void SetColumnarResponseData(ColumnarSerializedBatch* batch,
+                             ColumnarRowBlockPB* pb,
+                             rpc::RpcContext* context) {
+  pb->set_num_rows(batch->num_rows);
+  for (auto& col : batch->columns) {
+    ColumnarRowBlockPB::Column* col_pb = pb->add_columns();
+    int idx;
+    CHECK_OK(context->AddOutboundSidecar(
+        RpcSidecar::FromFaststring(std::move(col.data)), &idx));
+    col_pb->set_data_sidecar(idx);
+    if (col.varlen_data) {
+      CHECK_OK(context->AddOutboundSidecar(
+          RpcSidecar::FromFaststring(std::move(col.varlen_data)), &idx));
+      col_pb->set_varlen_data_sidecar(idx);
+    }
+    if (col.non_null_bitmap) {
+      CHECK_OK(context->AddOutboundSidecar(
+          RpcSidecar::FromFaststring(std::move(col.non_null_bitmap)), &idx));
+      col_pb->set_non_null_bitmap_sidecar(idx);
+    }
+  }
+}
 } // anonymous namespace
 
 void TabletServiceImpl::Scan(const ScanRequestPB* req,
@@ -1299,12 +1411,35 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   unique_ptr<faststring> rows_data(new faststring(batch_size_bytes * 11 / 10));
   unique_ptr<faststring> indirect_data(new faststring(batch_size_bytes * 11 / 10));
   RowwiseRowBlockPB data;
-  ScanResultCopier collector(&data, rows_data.get(), indirect_data.get());
+  ColumnarSerializedBatch columnar_data;
+  ScanResultCopier copier(&data, rows_data.get(), indirect_data.get(), &columnar_data);
+
+  // Scans with an aggregate spec return aggregates rather than rows. The spec
+  // is part of the request for new scans, and kept by the scanner otherwise.
+  SharedScanner existing_scanner;
+  const AggregateSpecPB* aggregate_spec = nullptr;
+  if (req->has_new_scan_request()) {
+    if (req->new_scan_request().has_aggregate_spec()) {
+      aggregate_spec = &req->new_scan_request().aggregate_spec();
+    }
+  } else if (req->has_scanner_id() &&
+             server_->scanner_manager()->LookupScanner(req->scanner_id(), &existing_scanner)) {
+    aggregate_spec = existing_scanner->aggregate_spec();
+  }
+  unique_ptr<ScanResultAggregator> aggregator;
+  if (aggregate_spec) {
+    aggregator.reset(new ScanResultAggregator(*aggregate_spec));
+  }
+  ScanResultCollector* collector = aggregator ?
+      static_cast<ScanResultCollector*>(aggregator.get()) : &copier;
 
   bool has_more_results = false;
   TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
   if (req->has_new_scan_request()) {
     const NewScanRequestPB& scan_pb = req->new_scan_request();
+    // Set the flags up front so that the response has the requested layout
+    // even if the scan short-circuits before any rows are collected.
+    copier.set_row_format_flags(scan_pb.row_format_flags());
     scoped_refptr<TabletReplica> replica;
     if (!LookupRunningTabletReplicaOrRespond(server_->tablet_manager(), scan_pb.tablet_id(), resp,
                                              context, &replica)) {
@@ -1313,7 +1448,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
     string scanner_id;
     Timestamp scan_timestamp;
     Status s = HandleNewScanRequest(replica.get(), req, context,
-                                    &collector, &scanner_id, &scan_timestamp, &has_more_results,
+                                    collector, &scanner_id, &scan_timestamp, &has_more_results,
                                     &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
@@ -1328,7 +1463,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
       resp->set_snap_timestamp(scan_timestamp.ToUint64());
     }
   } else if (req->has_scanner_id()) {
-    Status s = HandleContinueScanRequest(req, &collector, &has_more_results, &error_code);
+    Status s = HandleContinueScanRequest(req, collector, &has_more_results, &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
@@ -1340,27 +1475,33 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   }
   resp->set_has_more_results(has_more_results);
 
-  resp->mutable_data()->CopyFrom(data);
-
-  // Add sidecar data to context and record the returned indices.
-  int rows_idx;
-  CHECK_OK(context->AddOutboundSidecar(
-      RpcSidecar::FromFaststring((std::move(rows_data))), &rows_idx));
-  resp->mutable_data()->set_rows_sidecar(rows_idx);
+  if (aggregator) {
+    aggregator->ToPB(resp->mutable_aggregate_result());
+  } else if (copier.columnar_layout()) {
+    SetColumnarResponseData(&columnar_data, resp->mutable_columnar_data(), context);
+  } else {
+    resp->mutable_data()->CopyFrom(data);
 
-  // Add indirect data as a sidecar, if applicable.
-  if (indirect_data->size() > 0) {
-    int indirect_idx;
+    // Add sidecar data to context and record the returned indices.
+    int rows_idx;
     CHECK_OK(context->AddOutboundSidecar(
-        RpcSidecar::FromFaststring(std::move(indirect_data)), &indirect_idx));
-    resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
+        RpcSidecar::FromFaststring((std::move(rows_data))), &rows_idx));
+    resp->mutable_data()->set_rows_sidecar(rows_idx);
+
+    // Add indirect data as a sidecar, if applicable.
+    if (indirect_data->size() > 0) {
+      int indirect_idx;
+      CHECK_OK(context->AddOutboundSidecar(
+          RpcSidecar::FromFaststring(std::move(indirect_data)), &indirect_idx));
+      resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
+    }
   }
 
   // Set the last row found by the collector.
   //
   // We could have an empty batch if all the remaining rows are filtered by the
   // predicate, in which case do not set the last row.
-  const faststring& last = collector.last_primary_key();
+  const faststring& last = collector->last_primary_key();
   if (last.length() > 0) {
     resp->set_last_primary_key(last.ToString());
   }
@@ -1459,6 +1600,8 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
   switch (feature) {
     case TabletServerFeatures::COLUMN_PREDICATES:
     case TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES:
+    case TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE:
+    case TabletServerFeatures::AGGREGATE_PUSHDOWN:
       return true;
     default:
       return false;
@@ -1701,6 +1844,22 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     return Status::InvalidArgument("User requests should not have Column IDs");
   }
 
+  result_collector->set_client_projection_schema(projection);
+
+  if (scan_pb.has_aggregate_spec()) {
+    if (scan_pb.has_limit()) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return Status::InvalidArgument("Cannot limit a scan which computes aggregates");
+    }
+    s = ScanAggregator::ValidateSpec(scan_pb.aggregate_spec(), projection);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return s;
+    }
+    scanner->set_aggregate_spec(
+        gscoped_ptr<AggregateSpecPB>(new AggregateSpecPB(scan_pb.aggregate_spec())));
+  }
+
   if (scan_pb.order_mode() == ORDERED) {
     // Ordered scans must be at a snapshot so that we perform a serializable read (which can be
     // resumed). Otherwise, this would be read committed isolation, which is not resumable.
@@ -1907,6 +2066,9 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
 
   // Set the row format flags on the ScanResultCollector.
   result_collector->set_row_format_flags(scanner->row_format_flags());
+  if (scanner->client_projection_schema()) {
+    result_collector->set_client_projection_schema(*scanner->client_projection_schema());
+  }
 
   // If we early-exit out of this function, automatically unregister the scanner.
   ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner->id());
@@ -17,6 +17,7 @@
 
 #include "kudu/tserver/ts_tablet_manager.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -62,6 +63,7 @@
 #include "kudu/tserver/heartbeater.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/env.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
@@ -85,6 +87,13 @@ DEFINE_int32(num_tablets_to_open_simultaneously, 0,
              "may make sense to manually tune this.");
 TAG_FLAG(num_tablets_to_open_simultaneously, advanced);
 
+DEFINE_bool(prioritize_tablets_to_open, true,
+            "Whether to open the tablets found on startup in order of priority, rather "
+            "than in the order of their ids: first the tablets this server was leading "
+            "before it restarted, then those with the least WAL to replay, so that as "
+            "many tablets as possible are back up early.");
+TAG_FLAG(prioritize_tablets_to_open, advanced);
+
 DEFINE_int32(num_tablets_to_delete_simultaneously, 0,
              "Number of threads available to delete tablets. If this is set to 0 (the "
              "default), then the number of delete threads will be set based on the number "
@@ -354,6 +363,9 @@ Status TSTabletManager::Init() {
     metas.push_back(meta);
   }
   LOG(INFO) << Substitute("Loaded tablet metadata ($0 live tablets)", metas.size());
+  if (FLAGS_prioritize_tablets_to_open) {
+    SortTabletsToOpen(&metas);
+  }
 
   // Now submit the "Open" task for each.
   for (const scoped_refptr<TabletMetadata>& meta : metas) {
@@ -377,6 +389,43 @@ Status TSTabletManager::Init() {
   return Status::OK();
 }
 
+void TSTabletManager::SortTabletsToOpen(vector<scoped_refptr<TabletMetadata>>* metas) {
+  struct TabletToOpen {
+    scoped_refptr<TabletMetadata> meta;
+    bool was_leader;
+    uint64_t wal_bytes;
+  };
+  vector<TabletToOpen> tablets;
+  tablets.reserve(metas->size());
+  for (auto& meta : *metas) {
+    const string& tablet_id = meta->tablet_id();
+    // A replica votes for itself when it becomes leader, so having voted for
+    // ourselves in the last term is a good hint that we were leading the
+    // tablet. Failures to read are left to OpenTablet() to report.
+    bool was_leader = false;
+    scoped_refptr<ConsensusMetadata> cmeta;
+    if (cmeta_manager_->Load(tablet_id, &cmeta).ok()) {
+      was_leader = cmeta->has_voted_for() && cmeta->voted_for() == fs_manager_->uuid();
+    }
+    uint64_t wal_bytes = 0;
+    WARN_NOT_OK(fs_manager_->env()->GetFileSizeOnDiskRecursively(
+                    fs_manager_->GetTabletWalDir(tablet_id), &wal_bytes),
+                Substitute("Could not get the WAL size of tablet $0", tablet_id));
+    tablets.push_back({ std::move(meta), was_leader, wal_bytes });
+  }
+  std::stable_sort(tablets.begin(), tablets.end(),
+                   [](const TabletToOpen& a, const TabletToOpen& b) {
+                     if (a.was_leader != b.was_leader) {
+                       return a.was_leader;
+                     }
+                     return a.wal_bytes < b.wal_bytes;
+                   });
+  metas->clear();
+  for (auto& t : tablets) {
+    metas->push_back(std::move(t.meta));
+  }
+}
+
 Status TSTabletManager::WaitForAllBootstrapsToFinish() {
   CHECK_EQ(state(), MANAGER_RUNNING);
 
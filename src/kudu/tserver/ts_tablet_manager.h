@@ -266,6 +266,11 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   Status OpenTabletMeta(const std::string& tablet_id,
                         scoped_refptr<tablet::TabletMetadata>* metadata);
 
+  // Sorts the metadata of the tablets found on startup in the order in which
+  // they should be opened: first the tablets this server was leading, then
+  // those with the least WAL to replay.
+  void SortTabletsToOpen(std::vector<scoped_refptr<tablet::TabletMetadata>>* metas);
+
   // Open a tablet whose metadata has already been loaded/created.
   // This method does not return anything as it can be run asynchronously.
   // Upon completion of this method the tablet should be initialized and running.
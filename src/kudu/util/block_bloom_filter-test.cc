@@ -0,0 +1,132 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/bloom_filter.h"
+#include "kudu/util/slice.h"
+
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+
+static const int kRandomSeed = 0xdeadbeef;
+
+// Fills 'keys' with 'n_keys' random keys, and 'probes' with probes of them.
+static void MakeRandomProbes(int random_seed, int n_keys, vector<uint64_t>* keys,
+                             vector<unique_ptr<BloomKeyProbe>>* probes) {
+  srandom(random_seed);
+  keys->resize(n_keys);
+  probes->clear();
+  for (int i = 0; i < n_keys; i++) {
+    (*keys)[i] = random();
+    probes->emplace_back(new BloomKeyProbe(
+        Slice(reinterpret_cast<const uint8_t*>(&(*keys)[i]), sizeof(uint64_t))));
+  }
+}
+
+static vector<const BloomKeyProbe*> Pointers(const vector<unique_ptr<BloomKeyProbe>>& probes) {
+  vector<const BloomKeyProbe*> ret;
+  for (const auto& p : probes) {
+    ret.push_back(p.get());
+  }
+  return ret;
+}
+
+TEST(TestBlockBloomFilter, TestInsertAndProbe) {
+  BlockBloomFilterBuilder bfb(BloomFilterSizing::BySizeAndFPRate(4096, 0.01));
+  ASSERT_EQ(4096, bfb.n_bytes());
+  ASSERT_TRUE(BlockBloomFilter::IsValidSize(bfb.n_bytes()));
+
+  // The filter is sized for the requested false positive rate, which takes
+  // a few more bits per key than a classic bloom filter.
+  double expected_fp_rate = bfb.false_positive_rate();
+  ASSERT_LE(expected_fp_rate, 0.01);
+  ASSERT_NEAR(expected_fp_rate, 0.01, 0.001);
+  BloomFilterBuilder classic(BloomFilterSizing::BySizeAndFPRate(4096, 0.01));
+  ASSERT_LT(bfb.expected_count(), classic.expected_count());
+  ASSERT_GT(bfb.expected_count(), classic.expected_count() * 3 / 4);
+
+  // Enter expected_count() random keys into the filter.
+  vector<uint64_t> keys;
+  vector<unique_ptr<BloomKeyProbe>> probes;
+  MakeRandomProbes(kRandomSeed, bfb.expected_count(), &keys, &probes);
+  for (const auto& p : probes) {
+    bfb.AddKey(*p);
+  }
+  ASSERT_EQ(bfb.expected_count(), bfb.count());
+
+  // Verify that the keys we inserted all return true when queried, one by
+  // one or in a batch.
+  BlockBloomFilter bf(bfb.slice());
+  for (const auto& p : probes) {
+    ASSERT_TRUE(bf.MayContainKey(*p));
+  }
+  vector<const BloomKeyProbe*> probe_ptrs = Pointers(probes);
+  unique_ptr<bool[]> maybe_present(new bool[probe_ptrs.size()]);
+  bf.MayContainKeys(probe_ptrs.data(), probe_ptrs.size(), maybe_present.get());
+  for (int i = 0; i < probe_ptrs.size(); i++) {
+    ASSERT_TRUE(maybe_present[i]) << "key " << i;
+  }
+
+  // Query a bunch of other keys, and verify that the batched probe agrees
+  // with the single-key one and that the false positive rate is within
+  // reasonable bounds.
+  const int kNumQueries = 100000;
+  MakeRandomProbes(kRandomSeed + 1, kNumQueries, &keys, &probes);
+  probe_ptrs = Pointers(probes);
+  maybe_present.reset(new bool[kNumQueries]);
+  bf.MayContainKeys(probe_ptrs.data(), kNumQueries, maybe_present.get());
+  int num_positives = 0;
+  for (int i = 0; i < kNumQueries; i++) {
+    ASSERT_EQ(bf.MayContainKey(*probes[i]), maybe_present[i]) << "key " << i;
+    if (maybe_present[i]) {
+      num_positives++;
+    }
+  }
+
+  double fp_rate = static_cast<double>(num_positives) / kNumQueries;
+  LOG(INFO) << "FP rate: " << fp_rate << " (" << num_positives << "/" << kNumQueries << ")";
+  LOG(INFO) << "Expected FP rate: " << expected_fp_rate;
+  LOG(INFO) << "Instruction set: " << BlockBloomFilter::InstructionSet();
+
+  // Actual FP rate should be within 20% of the estimated FP rate
+  ASSERT_NEAR(fp_rate, expected_fp_rate, 0.20 * expected_fp_rate);
+}
+
+// A filter can't be smaller than a bucket.
+TEST(TestBlockBloomFilter, TestTinyFilter) {
+  BlockBloomFilterBuilder bfb(BloomFilterSizing::ByCountAndFPRate(1, 0.01));
+  ASSERT_EQ(32, bfb.n_bytes());
+  ASSERT_GE(bfb.expected_count(), 1);
+  uint64_t key = 12345;
+  BloomKeyProbe probe(Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)));
+  bfb.AddKey(probe);
+  BlockBloomFilter bf(bfb.slice());
+  ASSERT_TRUE(bf.MayContainKey(probe));
+}
+
+} // namespace kudu
@@ -0,0 +1,133 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/block_bloom_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/cpu.h"
+
+using base::CPU;
+
+namespace kudu {
+
+namespace block_bloom {
+// Defined in block_bloom_filter_avx2.cc, which is compiled with -mavx2.
+void MayContainKeysAvx2(const uint8_t* data, size_t n_buckets,
+                        const BloomKeyProbe* const* probes, size_t n,
+                        bool* maybe_present);
+} // namespace block_bloom
+
+namespace {
+
+// How many probes ahead of the current one MayContainKeys() prefetches.
+const int kPrefetchDistance = 8;
+
+// Set once the CPU has been checked for AVX2 support.
+bool g_use_avx2 = false;
+
+// When this translation unit is initialized, figure out whether the CPU
+// supports AVX2, rather than calling 'cpuid' in the hot path.
+__attribute__((constructor))
+void SelectBlockBloomProbe() {
+  g_use_avx2 = CPU().has_avx2();
+}
+
+// Returns the false positive rate of a filter holding 'keys_per_bucket' keys
+// per bucket on average.
+//
+// The number of keys of a bucket follows a Poisson distribution, and each of
+// the eight bits probed in a bucket with j keys is set with probability
+// 1 - (31/32)^j.
+double FalsePositiveRate(double keys_per_bucket) {
+  const int max_keys = static_cast<int>(keys_per_bucket * 4) + 64;
+  double p_keys = std::exp(-keys_per_bucket);
+  double fp_rate = 0;
+  for (int j = 0; j <= max_keys; j++) {
+    double p_bit_set = 1 - std::pow(31.0 / 32, j);
+    fp_rate += p_keys * std::pow(p_bit_set, block_bloom::kBucketWords);
+    p_keys *= keys_per_bucket / (j + 1);
+  }
+  return fp_rate;
+}
+
+} // anonymous namespace
+
+BlockBloomFilterBuilder::BlockBloomFilterBuilder(const BloomFilterSizing& sizing)
+  : n_buckets_(std::max<size_t>(sizing.n_bytes() / block_bloom::kBucketBytes, 1)),
+    buckets_(new uint32_t[n_buckets_ * block_bloom::kBucketWords]),
+    n_inserted_(0) {
+  CHECK_GT(sizing.fp_rate(), 0);
+  CHECK_LT(sizing.fp_rate(), 1);
+
+  // Search for the largest load which still achieves the false positive rate.
+  // A bucket can't usefully hold more keys than it has bits.
+  double low = 0;
+  double high = block_bloom::kBucketBytes * 8;
+  for (int i = 0; i < 64; i++) {
+    double mid = (low + high) / 2;
+    if (FalsePositiveRate(mid) <= sizing.fp_rate()) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  expected_count_ = std::max<size_t>(static_cast<size_t>(low * n_buckets_), 1);
+  Clear();
+}
+
+void BlockBloomFilterBuilder::Clear() {
+  memset(&buckets_[0], 0, n_bytes());
+  n_inserted_ = 0;
+}
+
+double BlockBloomFilterBuilder::false_positive_rate() const {
+  return FalsePositiveRate(static_cast<double>(expected_count_) / n_buckets_);
+}
+
+BlockBloomFilter::BlockBloomFilter(const Slice& data)
+  : data_(data.data()),
+    n_buckets_(data.size() / block_bloom::kBucketBytes) {
+  DCHECK(IsValidSize(data.size())) << data.size();
+}
+
+void BlockBloomFilter::MayContainKeys(const BloomKeyProbe* const* probes, size_t n,
+                                      bool* maybe_present) const {
+  if (g_use_avx2) {
+    block_bloom::MayContainKeysAvx2(data_, n_buckets_, probes, n, maybe_present);
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (i + kPrefetchDistance < n) {
+      __builtin_prefetch(data_ + block_bloom::BucketIndex(*probes[i + kPrefetchDistance],
+                                                          n_buckets_) *
+                         block_bloom::kBucketBytes);
+    }
+    maybe_present[i] = MayContainKey(*probes[i]);
+  }
+}
+
+const char* BlockBloomFilter::InstructionSet() {
+  return g_use_avx2 ? "avx2" : "scalar";
+}
+
+} // namespace kudu
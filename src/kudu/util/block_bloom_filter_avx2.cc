@@ -0,0 +1,59 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// The AVX2 probe of BlockBloomFilter::MayContainKeys(). This file is compiled
+// with -mavx2, and its function is only called after checking that the CPU
+// supports AVX2: see block_bloom_filter.cc.
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kudu/util/block_bloom_filter.h"
+
+namespace kudu {
+namespace block_bloom {
+
+namespace {
+const int kPrefetchDistance = 8;
+} // anonymous namespace
+
+void MayContainKeysAvx2(const uint8_t* data, size_t n_buckets,
+                        const BloomKeyProbe* const* probes, size_t n,
+                        bool* maybe_present) {
+  const __m256i salts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kSalts));
+  const __m256i ones = _mm256_set1_epi32(1);
+  for (size_t i = 0; i < n; i++) {
+    if (i + kPrefetchDistance < n) {
+      __builtin_prefetch(data + BucketIndex(*probes[i + kPrefetchDistance], n_buckets) *
+                         kBucketBytes);
+    }
+    const BloomKeyProbe& probe = *probes[i];
+    // Compute the bit of each of the eight words at once, as in WordMask().
+    __m256i hash = _mm256_set1_epi32(static_cast<int>(probe.initial_hash()));
+    __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(hash, salts), 27);
+    __m256i mask = _mm256_sllv_epi32(ones, shifts);
+    __m256i bucket = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+        data + BucketIndex(probe, n_buckets) * kBucketBytes));
+    // The key may be present if all the bits of 'mask' are set in 'bucket'.
+    maybe_present[i] = _mm256_testc_si256(bucket, mask);
+  }
+}
+
+} // namespace block_bloom
+} // namespace kudu
@@ -78,6 +78,12 @@ class BloomKeyProbe {
     return h + h_2_;
   }
 
+  // The second of the two hash values. Filters which don't need a sequence
+  // of hashes, like BlockBloomFilter, use the two hash values directly.
+  uint32_t second_hash() const {
+    return h_2_;
+  }
+
  private:
   Slice key_;
 
@@ -103,15 +109,18 @@ class BloomFilterSizing {
 
   size_t n_bytes() const { return n_bytes_; }
   size_t expected_count() const { return expected_count_; }
+  double fp_rate() const { return fp_rate_; }
 
  private:
-  BloomFilterSizing(size_t n_bytes, size_t expected_count) :
+  BloomFilterSizing(size_t n_bytes, size_t expected_count, double fp_rate) :
     n_bytes_(n_bytes),
-    expected_count_(expected_count)
+    expected_count_(expected_count),
+    fp_rate_(fp_rate)
   {}
 
   size_t n_bytes_;
   size_t expected_count_;
+  double fp_rate_;
 };
 
 
@@ -180,6 +189,14 @@ class BloomFilter {
   // Return true if the filter may contain the given key.
   bool MayContainKey(const BloomKeyProbe &probe) const;
 
+  // Return a slice view into the underlying bitmap.
+  const Slice slice() const {
+    return Slice(bitmap_, n_bits_ / 8);
+  }
+
+  // Return the number of hashes that are calculated for each key.
+  size_t n_hashes() const { return n_hashes_; }
+
  private:
   friend class BloomFilterBuilder;
   static uint32_t PickBit(uint32_t hash, size_t n_bits);
@@ -18,20 +18,28 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
 namespace kudu {
 
+using std::string;
+using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 class TestCompression : public KuduTest {};
 
@@ -87,4 +95,57 @@ TEST_F(TestCompression, TestZlibCompressionCodec) {
   TestCompressionCodec(ZLIB);
 }
 
+TEST_F(TestCompression, TestZstdCompressionCodec) {
+  TestCompressionCodec(ZSTD);
+}
+
+// Test that a dictionary trained on similar data lets a small buffer compress
+// better, and that it must be used again to uncompress.
+TEST_F(TestCompression, TestZstdCompressionDictionary) {
+  vector<string> samples;
+  for (int i = 0; i < 1000; i++) {
+    samples.push_back(Substitute("{\"user\": \"user-$0\", \"status\": \"$1\", "
+                                 "\"region\": \"region-$2\"}",
+                                 i, i % 3 == 0 ? "active" : "inactive", i % 7));
+  }
+  vector<Slice> sample_slices(samples.begin(), samples.end());
+  faststring dict;
+  ASSERT_OK(TrainCompressionDictionary(ZSTD, sample_slices, 4096, &dict));
+  ASSERT_GT(dict.size(), 0);
+  ASSERT_LE(dict.size(), 4096);
+
+  faststring unused;
+  Status s = TrainCompressionDictionary(LZ4, sample_slices, 4096, &unused);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+  unique_ptr<CompressionCodec> unused_codec;
+  s = NewCompressionCodecWithDictionary(LZ4, Slice(dict), &unused_codec);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+
+  const CompressionCodec* codec;
+  ASSERT_OK(GetCompressionCodec(ZSTD, &codec));
+  unique_ptr<CompressionCodec> dict_codec;
+  ASSERT_OK(NewCompressionCodecWithDictionary(ZSTD, Slice(dict), &dict_codec));
+  ASSERT_EQ(ZSTD, dict_codec->type());
+
+  Slice input("{\"user\": \"user-12345\", \"status\": \"active\", \"region\": \"region-3\"}");
+  size_t max_compressed = dict_codec->MaxCompressedLength(input.size());
+  unique_ptr<uint8_t[]> cbuffer(new uint8_t[max_compressed]);
+  unique_ptr<uint8_t[]> dict_cbuffer(new uint8_t[max_compressed]);
+  unique_ptr<uint8_t[]> ubuffer(new uint8_t[input.size()]);
+  size_t compressed;
+  size_t dict_compressed;
+  ASSERT_OK(codec->Compress(input, cbuffer.get(), &compressed));
+  ASSERT_OK(dict_codec->Compress(input, dict_cbuffer.get(), &dict_compressed));
+  ASSERT_LT(dict_compressed, compressed);
+
+  ASSERT_OK(dict_codec->Uncompress(Slice(dict_cbuffer.get(), dict_compressed),
+                                   ubuffer.get(), input.size()));
+  ASSERT_EQ(0, memcmp(input.data(), ubuffer.get(), input.size()));
+
+  // The data can't be uncompressed without the dictionary.
+  s = codec->Uncompress(Slice(dict_cbuffer.get(), dict_compressed),
+                        ubuffer.get(), input.size());
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+}
+
 } // namespace kudu
@@ -18,25 +18,50 @@
 #include "kudu/util/compression/compression_codec.h"
 
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <lz4.h>
 #include <snappy-sinksource.h>
 #include <snappy.h>
+#include <zdict.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/string_case.h"
+#include "kudu/util/threadlocal.h"
+
+DEFINE_int32(zstd_compression_level, 3,
+             "The compression level of the ZSTD codec, from 1 (fastest) to 19 "
+             "(smallest output). The speed of decompression barely depends on "
+             "the level.");
+TAG_FLAG(zstd_compression_level, advanced);
+TAG_FLAG(zstd_compression_level, runtime);
+
+static bool ValidateZstdCompressionLevel(const char* flagname, int32_t value) {
+  if (value < 1 || value > ZSTD_maxCLevel()) {
+    LOG(ERROR) << strings::Substitute("$0 must be between 1 and $1, value $2 is invalid",
+                                      flagname, ZSTD_maxCLevel(), value);
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(zstd_compression_level, &ValidateZstdCompressionLevel);
 
 namespace kudu {
 
+using std::unique_ptr;
 using std::vector;
 
 CompressionCodec::CompressionCodec() {
@@ -244,6 +269,140 @@ class ZlibCodec : public CompressionCodec {
   }
 };
 
+namespace {
+
+// The contexts used by ZSTD to compress and uncompress. They are expensive to
+// create, so each thread reuses its own.
+struct ZstdContexts {
+  ZstdContexts()
+      : cctx(CHECK_NOTNULL(ZSTD_createCCtx())),
+        dctx(CHECK_NOTNULL(ZSTD_createDCtx())) {
+  }
+  ~ZstdContexts() {
+    ZSTD_freeCCtx(cctx);
+    ZSTD_freeDCtx(dctx);
+  }
+  ZSTD_CCtx* const cctx;
+  ZSTD_DCtx* const dctx;
+};
+
+ZstdContexts* GetZstdContexts() {
+  BLOCK_STATIC_THREAD_LOCAL(ZstdContexts, contexts);
+  return contexts;
+}
+
+} // anonymous namespace
+
+class ZstdCodec : public CompressionCodec {
+ public:
+  static ZstdCodec *GetSingleton() {
+    return Singleton<ZstdCodec>::get();
+  }
+
+  ZstdCodec()
+      : cdict_(nullptr),
+        ddict_(nullptr) {
+  }
+
+  ~ZstdCodec() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+  }
+
+  // Makes the codec compress and uncompress with the dictionary 'dict'. The
+  // dictionary is copied.
+  Status InitDictionary(const Slice& dict) {
+    dict_.assign_copy(dict.data(), dict.size());
+    ddict_ = ZSTD_createDDict(dict_.data(), dict_.size());
+    if (ddict_ == nullptr) {
+      return Status::Corruption("unable to load the compression dictionary");
+    }
+    return Status::OK();
+  }
+
+  Status Compress(const Slice& input,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    ZSTD_CCtx* cctx = GetZstdContexts()->cctx;
+    size_t n;
+    if (ddict_ != nullptr) {
+      RETURN_NOT_OK(InitCompressionDictionary());
+      n = ZSTD_compress_usingCDict(cctx, compressed, MaxCompressedLength(input.size()),
+                                   input.data(), input.size(), cdict_);
+    } else {
+      n = ZSTD_compressCCtx(cctx, compressed, MaxCompressedLength(input.size()),
+                            input.data(), input.size(), FLAGS_zstd_compression_level);
+    }
+    if (ZSTD_isError(n)) {
+      return Status::IOError("unable to compress the buffer", ZSTD_getErrorName(n));
+    }
+    *compressed_length = n;
+    return Status::OK();
+  }
+
+  Status Compress(const vector<Slice>& input_slices,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    if (input_slices.size() == 1) {
+      return Compress(input_slices[0], compressed, compressed_length);
+    }
+
+    SlicesSource source(input_slices);
+    faststring buffer;
+    source.Dump(&buffer);
+    return Compress(Slice(buffer.data(), buffer.size()), compressed, compressed_length);
+  }
+
+  Status Uncompress(const Slice& compressed,
+                    uint8_t *uncompressed,
+                    size_t uncompressed_length) const OVERRIDE {
+    ZSTD_DCtx* dctx = GetZstdContexts()->dctx;
+    size_t n;
+    if (ddict_ != nullptr) {
+      n = ZSTD_decompress_usingDDict(dctx, uncompressed, uncompressed_length,
+                                     compressed.data(), compressed.size(), ddict_);
+    } else {
+      n = ZSTD_decompressDCtx(dctx, uncompressed, uncompressed_length,
+                              compressed.data(), compressed.size());
+    }
+    if (ZSTD_isError(n)) {
+      return Status::Corruption(
+          StringPrintf("unable to uncompress the buffer: %s", ZSTD_getErrorName(n)),
+          KUDU_REDACT(compressed.ToDebugString(100)));
+    }
+    if (n != uncompressed_length) {
+      return Status::Corruption(
+          StringPrintf("uncompressed %zu bytes, expected %zu", n, uncompressed_length),
+          KUDU_REDACT(compressed.ToDebugString(100)));
+    }
+    return Status::OK();
+  }
+
+  size_t MaxCompressedLength(size_t source_bytes) const OVERRIDE {
+    return ZSTD_compressBound(source_bytes);
+  }
+
+  CompressionType type() const override {
+    return ZSTD;
+  }
+
+ private:
+  // Digests the dictionary for compression, on first use: readers only ever
+  // uncompress, and shouldn't pay for it.
+  Status InitCompressionDictionary() const {
+    std::call_once(cdict_once_, [this]() {
+      cdict_ = ZSTD_createCDict(dict_.data(), dict_.size(), FLAGS_zstd_compression_level);
+    });
+    if (cdict_ == nullptr) {
+      return Status::Corruption("unable to load the compression dictionary");
+    }
+    return Status::OK();
+  }
+
+  faststring dict_;
+  mutable std::once_flag cdict_once_;
+  mutable ZSTD_CDict* cdict_;
+  ZSTD_DDict* ddict_;
+};
+
 Status GetCompressionCodec(CompressionType compression,
                            const CompressionCodec** codec) {
   switch (compression) {
@@ -259,12 +418,56 @@ Status GetCompressionCodec(CompressionType compression,
     case ZLIB:
       *codec = ZlibCodec::GetSingleton();
       break;
+    case ZSTD:
+      *codec = ZstdCodec::GetSingleton();
+      break;
     default:
       return Status::NotFound("bad compression type");
   }
   return Status::OK();
 }
 
+Status NewCompressionCodecWithDictionary(CompressionType compression,
+                                         const Slice& dict,
+                                         unique_ptr<CompressionCodec>* codec) {
+  if (compression != ZSTD) {
+    return Status::NotSupported("compression codec doesn't support dictionaries",
+                                CompressionType_Name(compression));
+  }
+  unique_ptr<ZstdCodec> zstd(new ZstdCodec());
+  RETURN_NOT_OK(zstd->InitDictionary(dict));
+  *codec = std::move(zstd);
+  return Status::OK();
+}
+
+Status TrainCompressionDictionary(CompressionType compression,
+                                  const vector<Slice>& samples,
+                                  size_t max_dict_size,
+                                  faststring* dict) {
+  if (compression != ZSTD) {
+    return Status::NotSupported("compression codec doesn't support dictionaries",
+                                CompressionType_Name(compression));
+  }
+  // The trainer takes the samples back to back in a single buffer.
+  faststring buffer;
+  vector<size_t> sample_sizes;
+  sample_sizes.reserve(samples.size());
+  for (const Slice& sample : samples) {
+    buffer.append(sample.data(), sample.size());
+    sample_sizes.push_back(sample.size());
+  }
+  dict->resize(max_dict_size);
+  size_t n = ZDICT_trainFromBuffer(dict->data(), max_dict_size,
+                                   buffer.data(), sample_sizes.data(), sample_sizes.size());
+  if (ZDICT_isError(n)) {
+    dict->clear();
+    return Status::InvalidArgument("unable to train a compression dictionary",
+                                   ZDICT_getErrorName(n));
+  }
+  dict->resize(n);
+  return Status::OK();
+}
+
 CompressionType GetCompressionCodecType(const std::string& name) {
   std::string uname;
   ToUpperCase(name, &uname);
@@ -275,6 +478,8 @@ CompressionType GetCompressionCodecType(const std::string& name) {
     return LZ4;
   if (uname == "ZLIB")
     return ZLIB;
+  if (uname == "ZSTD")
+    return ZSTD;
   if (uname == "NONE")
     return NO_COMPRESSION;
 
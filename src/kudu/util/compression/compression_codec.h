@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,6 +31,8 @@
 
 namespace kudu {
 
+class faststring;
+
 class CompressionCodec {
  public:
   CompressionCodec();
@@ -71,6 +74,26 @@ class CompressionCodec {
 Status GetCompressionCodec(CompressionType compression,
                            const CompressionCodec** codec);
 
+// Creates a new compression codec for the specified type, which compresses
+// and uncompresses with the dictionary 'dict', as trained by
+// TrainCompressionDictionary(). Data compressed with a dictionary can only be
+// uncompressed with the same dictionary.
+//
+// Only ZSTD supports dictionaries: returns NotSupported for other types.
+Status NewCompressionCodecWithDictionary(CompressionType compression,
+                                         const Slice& dict,
+                                         std::unique_ptr<CompressionCodec>* codec);
+
+// Trains a dictionary of at most 'max_dict_size' bytes for the specified type
+// from 'samples', which should be typical of the data to be compressed.
+//
+// Returns NotSupported if the type doesn't support dictionaries, or
+// InvalidArgument if the samples aren't enough to train a dictionary.
+Status TrainCompressionDictionary(CompressionType compression,
+                                  const std::vector<Slice>& samples,
+                                  size_t max_dict_size,
+                                  faststring* dict);
+
 // Returns the compression codec type given the name
 CompressionType GetCompressionCodecType(const std::string& name);
 
@@ -59,6 +59,7 @@
 #include "kudu/util/array_view.h" // IWYU pragma: keep
 #include "kudu/util/env_util.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/io_uring.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/random.h"
@@ -72,6 +73,7 @@
 
 DECLARE_bool(never_fsync);
 DECLARE_bool(crash_on_eio);
+DECLARE_bool(env_use_io_uring);
 DECLARE_double(env_inject_eio);
 DECLARE_int32(env_inject_short_read_bytes);
 DECLARE_int32(env_inject_short_write_bytes);
@@ -568,6 +570,115 @@ TEST_F(TestEnv, TestIOVMax) {
   VerifyTestData(Slice(scratch, data_size), 0);
 }
 
+// Test that all the reads of a batch are performed, whether or not they are
+// issued through io_uring.
+TEST_F(TestEnv, TestReadBatch) {
+  Env* env = Env::Default();
+  const string kTestPath = GetTestPath("test");
+  const int kFileSize = 1024 * 1024;
+  const int kNumReads = 200;
+  NO_FATALS(WriteTestFile(env, kTestPath, kFileSize));
+  LOG(INFO) << "io_uring supported: " << IoUring::IsSupported();
+  Random r(SeedRandom());
+
+  for (bool use_io_uring : { false, true }) {
+    SCOPED_TRACE(use_io_uring);
+    FLAGS_env_use_io_uring = use_io_uring;
+
+    shared_ptr<RandomAccessFile> file;
+    ASSERT_OK(env_util::OpenFileForRandom(env, kTestPath, &file));
+
+    // Read random ranges of the file, some of them into two buffers. There
+    // are more of them than an io_uring has room for.
+    unique_ptr<uint8_t[]> scratch(new uint8_t[kNumReads * 2 * 4096]);
+    vector<Slice> results;
+    vector<uint64_t> offsets;
+    vector<size_t> num_results;
+    results.reserve(kNumReads * 2);
+    for (int i = 0; i < kNumReads; i++) {
+      offsets.push_back(r.Uniform(kFileSize - 2 * 4096));
+      num_results.push_back(1 + r.Uniform(2));
+      for (int j = 0; j < num_results.back(); j++) {
+        results.emplace_back(&scratch[(i * 2 + j) * 4096], 1 + r.Uniform(4096));
+      }
+    }
+    vector<ReadRequest> requests;
+    size_t result_idx = 0;
+    for (int i = 0; i < kNumReads; i++) {
+      requests.push_back({ offsets[i], ArrayView<Slice>(&results[result_idx], num_results[i]) });
+      result_idx += num_results[i];
+    }
+    ASSERT_OK(file->ReadBatch(requests));
+    for (const auto& request : requests) {
+      size_t offset = request.offset;
+      for (const auto& result : request.results) {
+        NO_FATALS(VerifyTestData(result, offset));
+        offset += result.size();
+      }
+    }
+
+    // A read past the end of the file fails the batch.
+    uint8_t eof_scratch[10];
+    Slice eof_result(eof_scratch, sizeof(eof_scratch));
+    requests.push_back({ kFileSize - 5, ArrayView<Slice>(&eof_result, 1) });
+    Status s = file->ReadBatch(requests);
+    ASSERT_TRUE(s.IsEndOfFile()) << s.ToString();
+  }
+}
+
+// Compares the time it takes to read random pages of a file one at a time
+// and in batches, with and without io_uring.
+//
+// The file is likely to be in the page cache, in which case this measures
+// the overhead of the system calls rather than the benefit of having I/Os in
+// flight on the device. Run it on a file which doesn't fit in memory for the
+// latter.
+TEST_F(TestEnv, TestReadBatchBenchmark) {
+  Env* env = Env::Default();
+  const string kTestPath = GetTestPath("test");
+  const int kFileSize = (AllowSlowTests() ? 512 : 64) * 1024 * 1024;
+  const int kPageSize = 4096;
+  const int kNumReads = 64 * 1024;
+  const int kBatchSize = 32;
+  NO_FATALS(WriteTestFile(env, kTestPath, kFileSize));
+
+  shared_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_util::OpenFileForRandom(env, kTestPath, &file));
+  Random r(SeedRandom());
+  vector<uint64_t> offsets;
+  for (int i = 0; i < kNumReads; i++) {
+    offsets.push_back(r.Uniform(kFileSize / kPageSize) * kPageSize);
+  }
+  unique_ptr<uint8_t[]> scratch(new uint8_t[kBatchSize * kPageSize]);
+  vector<Slice> results;
+  for (int i = 0; i < kBatchSize; i++) {
+    results.emplace_back(&scratch[i * kPageSize], kPageSize);
+  }
+
+  LOG_TIMING(INFO, Substitute("reading $0 pages one at a time", kNumReads)) {
+    for (int i = 0; i < kNumReads; i++) {
+      ASSERT_OK(file->Read(offsets[i], results[0]));
+    }
+  }
+  for (bool use_io_uring : { false, true }) {
+    if (use_io_uring && !IoUring::IsSupported()) {
+      LOG(INFO) << "io_uring not supported, skipping";
+      break;
+    }
+    FLAGS_env_use_io_uring = use_io_uring;
+    LOG_TIMING(INFO, Substitute("reading $0 pages in batches of $1 $2 io_uring",
+                                kNumReads, kBatchSize, use_io_uring ? "with" : "without")) {
+      vector<ReadRequest> requests(kBatchSize);
+      for (int i = 0; i < kNumReads; i += kBatchSize) {
+        for (int j = 0; j < kBatchSize; j++) {
+          requests[j] = { offsets[i + j], ArrayView<Slice>(&results[j], 1) };
+        }
+        ASSERT_OK(file->ReadBatch(requests));
+      }
+    }
+  }
+}
+
 TEST_F(TestEnv, TestAppendV) {
   WritableFileOptions opts;
   LOG(INFO) << "Testing AppendV() only, NO pre-allocation";
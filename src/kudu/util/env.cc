@@ -33,6 +33,9 @@ RWFile::~RWFile() {
 FileLock::~FileLock() {
 }
 
+FileSystemHandle::~FileSystemHandle() {
+}
+
 static Status DoWriteStringToFile(Env* env, const Slice& data,
                                   const std::string& fname,
                                   bool should_sync) {
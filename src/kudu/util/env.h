@@ -23,25 +23,24 @@
 
 #include "kudu/gutil/callback_forward.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
 class faststring;
 class FileLock;
+class FileSystemHandle;
 class RandomAccessFile;
 class RWFile;
 class SequentialFile;
-class Slice;
 class WritableFile;
 
 struct RandomAccessFileOptions;
 struct RWFileOptions;
 struct WritableFileOptions;
 
-template <typename T>
-class ArrayView;
-
 // Returned by Env::GetSpaceInfo().
 struct SpaceInfo {
   int64_t capacity_bytes; // Capacity of a filesystem, in bytes.
@@ -173,6 +172,14 @@ class Env {
   // Synchronize the entry for a specific directory.
   virtual Status SyncDir(const std::string& dirname) = 0;
 
+  // Opens a handle on the filesystem containing 'path', through which all of
+  // its data and metadata can be synchronized, e.g. to make the writes to
+  // many files durable with a single call.
+  //
+  // Returns NotSupported if the platform has no means to do so.
+  virtual Status OpenFileSystem(const std::string& path,
+                                std::unique_ptr<FileSystemHandle>* handle) = 0;
+
   // Recursively delete the specified directory.
   // This should operate safely, not following any symlinks, etc.
   virtual Status DeleteRecursively(const std::string &dirname) = 0;
@@ -399,6 +406,13 @@ class SequentialFile {
   virtual const std::string& filename() const = 0;
 };
 
+// One of the reads of a ReadBatch() call: reads the "results" aggregate size,
+// based on each Slice's "size", starting at 'offset'.
+struct ReadRequest {
+  uint64_t offset;
+  ArrayView<Slice> results;
+};
+
 // A file abstraction for randomly reading the contents of a file.
 class RandomAccessFile {
  public:
@@ -430,6 +444,13 @@ class RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs all the reads of 'requests', as ReadV() does, returning the
+  // first error encountered if any. The reads may be issued concurrently and
+  // complete in any order.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const = 0;
+
   // Returns the size of the file
   virtual Status Size(uint64_t *size) const = 0;
 
@@ -571,6 +592,13 @@ class RWFile {
   // Safe for concurrent use by multiple threads.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs all the reads of 'requests', as ReadV() does, returning the
+  // first error encountered if any. The reads may be issued concurrently and
+  // complete in any order.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const = 0;
+
   // Writes 'data' to the file position given by 'offset'.
   virtual Status Write(uint64_t offset, const Slice& data) = 0;
 
@@ -654,6 +682,26 @@ class RWFile {
   DISALLOW_COPY_AND_ASSIGN(RWFile);
 };
 
+// A handle on a filesystem, returned by Env::OpenFileSystem().
+class FileSystemHandle {
+ public:
+  FileSystemHandle() { }
+  virtual ~FileSystemHandle();
+
+  // Synchronizes all of the data and metadata of the filesystem.
+  //
+  // Only the failures to write back data which happened after the handle was
+  // opened are reported, so a handle must stay open for as long as its syncs
+  // are relied upon.
+  virtual Status Sync() = 0;
+
+  // Returns the path provided when the handle was opened.
+  virtual const std::string& path() const = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(FileSystemHandle);
+};
+
 // Identifies a locked file.
 class FileLock {
  public:
@@ -54,6 +54,7 @@
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flags.h"
+#include "kudu/util/io_uring.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/malloc.h"
 #include "kudu/util/monotime.h"
@@ -63,6 +64,7 @@
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/thread_restrictions.h"
+#include "kudu/util/threadlocal.h"
 #include "kudu/util/trace.h"
 
 #if defined(__APPLE__)
@@ -161,6 +163,12 @@ DEFINE_bool(env_use_ioctl_hole_punch_on_xfs, true,
 TAG_FLAG(env_use_ioctl_hole_punch_on_xfs, advanced);
 TAG_FLAG(env_use_ioctl_hole_punch_on_xfs, experimental);
 
+DEFINE_bool(env_use_io_uring, false,
+            "Whether to issue the reads of a batch concurrently through io_uring, "
+            "if the kernel supports it. Otherwise, they're issued one after the other.");
+TAG_FLAG(env_use_io_uring, advanced);
+TAG_FLAG(env_use_io_uring, experimental);
+
 DEFINE_bool(crash_on_eio, false,
             "Kill the process if an I/O operation results in EIO. If false, "
             "I/O resulting in EIOs will return the status IOError and leave "
@@ -432,6 +440,140 @@ Status DoReadV(int fd, const string& filename, uint64_t offset,
   return Status::OK();
 }
 
+// The io_uring of a thread, used for the reads of its batches. Its queues
+// are sized for the batches of CFile blocks which are read at once.
+struct ThreadIoUring {
+  ThreadIoUring() {
+    if (IoUring::IsSupported()) {
+      WARN_NOT_OK(IoUring::Create(kEntries, &ring), "Unable to create io_uring");
+    }
+  }
+
+  static const uint32_t kEntries = 64;
+  unique_ptr<IoUring> ring;
+};
+
+// Returns the io_uring of the calling thread, or null if io_uring can't be
+// used.
+IoUring* GetThreadIoUring() {
+  BLOCK_STATIC_THREAD_LOCAL(ThreadIoUring, thread_ring);
+  return thread_ring->ring.get();
+}
+
+// Completes 'request' after its first 'bytes_read' bytes were read.
+Status FinishShortRead(int fd, const string& filename, const ReadRequest& request,
+                       size_t bytes_read) {
+  if (bytes_read == 0) {
+    // EOF.
+    return Status::EndOfFile(Substitute("EOF trying to read at offset $0", request.offset));
+  }
+  vector<Slice> rest;
+  size_t skip = bytes_read;
+  for (const Slice& result : request.results) {
+    if (skip >= result.size()) {
+      skip -= result.size();
+      continue;
+    }
+    rest.emplace_back(result.data() + skip, result.size() - skip);
+    skip = 0;
+  }
+  return DoReadV(fd, filename, request.offset + bytes_read, ArrayView<Slice>(rest));
+}
+
+Status DoReadBatch(int fd, const string& filename, ArrayView<const ReadRequest> requests) {
+  IoUring* ring = nullptr;
+  if (FLAGS_env_use_io_uring && requests.size() > 1) {
+    ring = GetThreadIoUring();
+  }
+  if (!ring) {
+    for (const auto& request : requests) {
+      RETURN_NOT_OK(DoReadV(fd, filename, request.offset, request.results));
+    }
+    return Status::OK();
+  }
+
+  MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
+  ThreadRestrictions::AssertIOAllowed();
+
+  // Convert the results of all the requests into a single iovec vector,
+  // each request using a range of it.
+  const size_t n = requests.size();
+  vector<struct iovec> iov;
+  vector<size_t> iov_start(n + 1);
+  vector<size_t> bytes_req(n);
+  for (size_t i = 0; i < n; i++) {
+    iov_start[i] = iov.size();
+    for (Slice& result : requests[i].results) {
+      iov.push_back({ result.mutable_data(), result.size() });
+      bytes_req[i] += result.size();
+    }
+  }
+  iov_start[n] = iov.size();
+
+  // Issue as many requests at once as the ring has room for, and wait for
+  // them all before issuing the next ones.
+  Status first_error;
+  auto read_without_ring = [&](size_t index) {
+    Status s = DoReadV(fd, filename, requests[index].offset, requests[index].results);
+    if (!s.ok() && first_error.ok()) {
+      first_error = s;
+    }
+  };
+  vector<size_t> queued;
+  size_t next = 0;
+  while (next < n) {
+    queued.clear();
+    for (; next < n && queued.size() < ring->capacity(); next++) {
+      size_t iov_count = iov_start[next + 1] - iov_start[next];
+      if (PREDICT_FALSE(iov_count > IOV_MAX)) {
+        read_without_ring(next);
+        continue;
+      }
+      CHECK(ring->PrepareReadV(fd, &iov[iov_start[next]], iov_count,
+                               requests[next].offset, next));
+      queued.push_back(next);
+    }
+    if (queued.empty()) {
+      continue;
+    }
+    uint32_t in_flight = queued.size();
+    Status submitted = ring->SubmitAndWait(in_flight);
+    if (PREDICT_FALSE(!submitted.ok())) {
+      // The requests which were submitted write into the caller's buffers, so
+      // there's no returning until they have completed. Waiting for them
+      // submits nothing, which only fails on a bug. The others, and the rest
+      // of the batch, are read without the ring.
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute("Unable to submit the reads of $0, "
+                                                  "reading without io_uring: $1",
+                                                  filename, submitted.ToString());
+      in_flight -= ring->DiscardUnsubmitted();
+      CHECK_OK_PREPEND(ring->SubmitAndWait(in_flight),
+                       Substitute("Unable to wait for the reads of $0", filename));
+      for (size_t i = in_flight; i < queued.size(); i++) {
+        read_without_ring(queued[i]);
+      }
+      for (; next < n; next++) {
+        read_without_ring(next);
+      }
+    }
+    for (uint32_t i = 0; i < in_flight; i++) {
+      uint64_t index;
+      int32_t res;
+      CHECK(ring->PopCompletion(&index, &res));
+      Status s;
+      if (PREDICT_FALSE(res < 0)) {
+        s = IOError(filename, -res);
+      } else if (PREDICT_FALSE(static_cast<size_t>(res) < bytes_req[index])) {
+        s = FinishShortRead(fd, filename, requests[index], res);
+      }
+      if (!s.ok() && first_error.ok()) {
+        first_error = s;
+      }
+    }
+  }
+  return first_error;
+}
+
 Status DoWriteV(int fd, const string& filename, uint64_t offset, ArrayView<const Slice> data) {
   MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
   ThreadRestrictions::AssertIOAllowed();
@@ -615,6 +757,10 @@ class PosixRandomAccessFile: public RandomAccessFile {
     return DoReadV(fd_, filename_, offset, results);
   }
 
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const OVERRIDE {
+    return DoReadBatch(fd_, filename_, requests);
+  }
+
   virtual Status Size(uint64_t *size) const OVERRIDE {
     MAYBE_RETURN_EIO(filename_, IOError(Env::kInjectedFailureStatusMsg, EIO));
     TRACE_EVENT1("io", "PosixRandomAccessFile::Size", "path", filename_);
@@ -802,6 +948,10 @@ class PosixRWFile : public RWFile {
     return DoReadV(fd_, filename_, offset, results);
   }
 
+  virtual Status ReadBatch(ArrayView<const ReadRequest> requests) const OVERRIDE {
+    return DoReadBatch(fd_, filename_, requests);
+  }
+
   virtual Status Write(uint64_t offset, const Slice& data) OVERRIDE {
     return WriteV(offset, ArrayView<const Slice>(&data, 1));
   }
@@ -1061,6 +1211,46 @@ class PosixFileLock : public FileLock {
   int fd_;
 };
 
+#ifndef __APPLE__
+class PosixFileSystemHandle : public FileSystemHandle {
+ public:
+  PosixFileSystemHandle(string path, int fd)
+      : path_(std::move(path)),
+        fd_(fd) {}
+
+  virtual ~PosixFileSystemHandle() {
+    int err;
+    RETRY_ON_EINTR(err, close(fd_));
+    if (PREDICT_FALSE(err != 0)) {
+      PLOG(WARNING) << "Failed to close " << path_;
+    }
+  }
+
+  virtual Status Sync() OVERRIDE {
+    TRACE_EVENT1("io", "PosixFileSystemHandle::Sync", "path", path_);
+    MAYBE_RETURN_EIO(path_, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+    if (FLAGS_never_fsync) return Status::OK();
+    TRACE_COUNTER_INCREMENT("syncfs", 1);
+    TRACE_COUNTER_SCOPE_LATENCY_US("syncfs_us");
+    // syncfs() reports the write-back errors of the filesystem which were
+    // recorded since 'fd_' was opened, so the same fd is used every time.
+    if (syncfs(fd_) != 0) {
+      return IOError(path_, errno);
+    }
+    return Status::OK();
+  }
+
+  virtual const string& path() const OVERRIDE {
+    return path_;
+  }
+
+ private:
+  const string path_;
+  const int fd_;
+};
+#endif
+
 class PosixEnv : public Env {
  public:
   PosixEnv();
@@ -1254,6 +1444,24 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  virtual Status OpenFileSystem(const std::string& path,
+                                unique_ptr<FileSystemHandle>* handle) OVERRIDE {
+    TRACE_EVENT1("io", "PosixEnv::OpenFileSystem", "path", path);
+    MAYBE_RETURN_EIO(path, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+#ifdef __APPLE__
+    return Status::NotSupported("syncfs() is not supported on macOS");
+#else
+    int fd;
+    RETRY_ON_EINTR(fd, open(path.c_str(), O_RDONLY));
+    if (fd < 0) {
+      return IOError(path, errno);
+    }
+    handle->reset(new PosixFileSystemHandle(path, fd));
+    return Status::OK();
+#endif
+  }
+
   virtual Status DeleteRecursively(const std::string &name) OVERRIDE {
     return Walk(name, POST_ORDER, Bind(&PosixEnv::DeleteRecursivelyCb,
                                        Unretained(this)));
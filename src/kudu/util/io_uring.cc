@@ -0,0 +1,292 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/io_uring.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/once.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/monotime.h"
+
+// io_uring appeared in Linux 5.1. Older kernel headers, as found on some of
+// the platforms Kudu is built on, don't define it at all.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define KUDU_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+using std::unique_ptr;
+
+namespace kudu {
+
+#if defined(KUDU_HAVE_IO_URING)
+
+namespace {
+
+// The ring indexes are only ever written by one side: either the kernel or
+// us. The other side reads them with acquire semantics and publishes its own
+// with release semantics, so that the entries they cover are visible.
+uint32_t LoadAcquire(const uint32_t* p) {
+  return static_cast<uint32_t>(base::subtle::Acquire_Load(
+      reinterpret_cast<volatile const base::subtle::Atomic32*>(p)));
+}
+
+void StoreRelease(uint32_t* p, uint32_t v) {
+  base::subtle::Release_Store(reinterpret_cast<volatile base::subtle::Atomic32*>(p),
+                              static_cast<base::subtle::Atomic32>(v));
+}
+
+void* MapRing(int ring_fd, size_t size, off_t offset) {
+  void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 ring_fd, offset);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+template <typename T>
+T* RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+// The number of times io_uring_enter() is retried when the kernel is short
+// of resources, waiting a bit longer each time.
+const int kMaxBusyRetries = 5;
+
+} // anonymous namespace
+
+IoUring::IoUring()
+    : ring_fd_(-1),
+      capacity_(0),
+      to_submit_(0),
+      sq_ring_(nullptr),
+      sq_ring_size_(0),
+      cq_ring_(nullptr),
+      cq_ring_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_mask_(0),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_mask_(0),
+      cqes_(nullptr) {
+}
+
+IoUring::~IoUring() {
+  // The requests in flight keep referencing their buffers: their owners must
+  // have waited for them.
+  DCHECK_EQ(0, to_submit_);
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+Status IoUring::Create(uint32_t entries, unique_ptr<IoUring>* ring) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  int fd = syscall(__NR_io_uring_setup, entries, &p);
+  if (fd < 0) {
+    int err = errno;
+    if (err == ENOSYS || err == EPERM) {
+      return Status::NotSupported("io_uring is not available", ErrnoToString(err), err);
+    }
+    return Status::IOError("io_uring_setup() failed", ErrnoToString(err), err);
+  }
+
+  unique_ptr<IoUring> r(new IoUring());
+  r->ring_fd_ = fd;
+  r->capacity_ = p.sq_entries;
+
+  // The submission queue ring, the completion queue ring and the submission
+  // queue entries are mapped separately, which all kernels support.
+  r->sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  r->cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  r->sqes_size_ = p.sq_entries * sizeof(struct io_uring_sqe);
+  r->sq_ring_ = MapRing(fd, r->sq_ring_size_, IORING_OFF_SQ_RING);
+  if (r->sq_ring_) {
+    r->cq_ring_ = MapRing(fd, r->cq_ring_size_, IORING_OFF_CQ_RING);
+  }
+  if (r->cq_ring_) {
+    r->sqes_ = MapRing(fd, r->sqes_size_, IORING_OFF_SQES);
+  }
+  if (!r->sqes_) {
+    int err = errno;
+    return Status::IOError("unable to map io_uring", ErrnoToString(err), err);
+  }
+
+  r->sq_head_ = RingField<uint32_t>(r->sq_ring_, p.sq_off.head);
+  r->sq_tail_ = RingField<uint32_t>(r->sq_ring_, p.sq_off.tail);
+  r->sq_mask_ = *RingField<uint32_t>(r->sq_ring_, p.sq_off.ring_mask);
+  r->sq_array_ = RingField<uint32_t>(r->sq_ring_, p.sq_off.array);
+  r->cq_head_ = RingField<uint32_t>(r->cq_ring_, p.cq_off.head);
+  r->cq_tail_ = RingField<uint32_t>(r->cq_ring_, p.cq_off.tail);
+  r->cq_mask_ = *RingField<uint32_t>(r->cq_ring_, p.cq_off.ring_mask);
+  r->cqes_ = RingField<void>(r->cq_ring_, p.cq_off.cqes);
+  *ring = std::move(r);
+  return Status::OK();
+}
+
+bool IoUring::PrepareReadV(int fd, const struct iovec* iov, int iovcnt, uint64_t offset,
+                           uint64_t user_data) {
+  uint32_t tail = *sq_tail_;
+  if (tail - LoadAcquire(sq_head_) >= capacity_) {
+    return false;
+  }
+  uint32_t index = tail & sq_mask_;
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<uint64_t>(iov);
+  sqe->len = iovcnt;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  StoreRelease(sq_tail_, tail + 1);
+  to_submit_++;
+  return true;
+}
+
+Status IoUring::SubmitAndWait(uint32_t wait_nr) {
+  int busy_retries = 0;
+  while (true) {
+    int ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit_, wait_nr,
+                      IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret < 0) {
+      int err = errno;
+      if (err == EINTR) {
+        continue;
+      }
+      if ((err == EAGAIN || err == EBUSY) && busy_retries < kMaxBusyRetries) {
+        SleepFor(MonoDelta::FromMilliseconds(1 << busy_retries++));
+        continue;
+      }
+      return Status::IOError("io_uring_enter() failed", ErrnoToString(err), err);
+    }
+    DCHECK_LE(ret, to_submit_);
+    to_submit_ -= ret;
+    if (to_submit_ == 0 && LoadAcquire(cq_tail_) - *cq_head_ >= wait_nr) {
+      return Status::OK();
+    }
+  }
+}
+
+uint32_t IoUring::DiscardUnsubmitted() {
+  // Without a kernel polling thread, the kernel only consumes the submission
+  // queue within io_uring_enter(), so the entries past the ones it consumed
+  // can be taken back.
+  uint32_t discarded = to_submit_;
+  StoreRelease(sq_tail_, *sq_tail_ - discarded);
+  to_submit_ = 0;
+  return discarded;
+}
+
+bool IoUring::PopCompletion(uint64_t* user_data, int32_t* res) {
+  uint32_t head = *cq_head_;
+  if (head == LoadAcquire(cq_tail_)) {
+    return false;
+  }
+  const struct io_uring_cqe* cqe =
+      static_cast<const struct io_uring_cqe*>(cqes_) + (head & cq_mask_);
+  *user_data = cqe->user_data;
+  *res = cqe->res;
+  StoreRelease(cq_head_, head + 1);
+  return true;
+}
+
+#else
+
+IoUring::IoUring() {
+}
+
+IoUring::~IoUring() {
+}
+
+Status IoUring::Create(uint32_t /* entries */, unique_ptr<IoUring>* /* ring */) {
+  return Status::NotSupported("io_uring is not supported by this build");
+}
+
+bool IoUring::PrepareReadV(int /* fd */, const struct iovec* /* iov */, int /* iovcnt */,
+                           uint64_t /* offset */, uint64_t /* user_data */) {
+  LOG(FATAL) << "io_uring is not supported by this build";
+  return false;
+}
+
+Status IoUring::SubmitAndWait(uint32_t /* wait_nr */) {
+  LOG(FATAL) << "io_uring is not supported by this build";
+  return Status::OK();
+}
+
+uint32_t IoUring::DiscardUnsubmitted() {
+  LOG(FATAL) << "io_uring is not supported by this build";
+  return 0;
+}
+
+bool IoUring::PopCompletion(uint64_t* /* user_data */, int32_t* /* res */) {
+  LOG(FATAL) << "io_uring is not supported by this build";
+  return false;
+}
+
+#endif // defined(KUDU_HAVE_IO_URING)
+
+namespace {
+
+bool g_io_uring_supported = false;
+GoogleOnceType g_io_uring_supported_once = GOOGLE_ONCE_INIT;
+
+void CheckIoUringSupported() {
+  unique_ptr<IoUring> ring;
+  Status s = IoUring::Create(1, &ring);
+  if (!s.ok()) {
+    LOG(INFO) << "io_uring will not be used: " << s.ToString();
+  }
+  g_io_uring_supported = s.ok();
+}
+
+} // anonymous namespace
+
+bool IoUring::IsSupported() {
+  GoogleOnceInit(&g_io_uring_supported_once, &CheckIoUringSupported);
+  return g_io_uring_supported;
+}
+
+} // namespace kudu
@@ -0,0 +1,112 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+// A minimal wrapper around a Linux io_uring instance: a submission queue and
+// a completion queue shared with the kernel, which let a thread have many I/Os
+// in flight at once with a single system call.
+//
+// Only what Env needs is implemented, using the raw system calls rather than
+// liburing. On kernels or builds without io_uring support, Create() returns
+// NotSupported and callers are expected to fall back to blocking I/O.
+//
+// This class is not thread-safe.
+class IoUring {
+ public:
+  // Returns whether io_uring can be used by this process. The kernel may
+  // predate it, or it may be blocked (e.g. by a seccomp filter). The result
+  // is computed once.
+  static bool IsSupported();
+
+  // Creates a ring with room for at least 'entries' requests in flight.
+  static Status Create(uint32_t entries, std::unique_ptr<IoUring>* ring);
+
+  ~IoUring();
+
+  // The maximum number of requests which may be in flight at once.
+  uint32_t capacity() const { return capacity_; }
+
+  // Queues a read of the 'iovcnt' buffers of 'iov' from 'fd', starting at
+  // 'offset'. 'user_data' is returned with the completion of the read. 'iov'
+  // and its buffers must stay valid until the read has completed.
+  //
+  // Returns false if the submission queue is full.
+  bool PrepareReadV(int fd, const struct iovec* iov, int iovcnt, uint64_t offset,
+                    uint64_t user_data);
+
+  // Submits the queued requests to the kernel, and waits until at least
+  // 'wait_nr' completions are ready to be popped. If the kernel is short of
+  // resources, retries a few times before giving up.
+  //
+  // On failure, some of the queued requests may have been submitted: the
+  // others stay queued until DiscardUnsubmitted() or the next call.
+  Status SubmitAndWait(uint32_t wait_nr);
+
+  // Drops the queued requests which weren't submitted yet, returning their
+  // number. They are the last ones queued.
+  uint32_t DiscardUnsubmitted();
+
+  // Pops a completion, setting 'user_data' to that of its request and 'res'
+  // to its result: the number of bytes transferred, or a negated errno.
+  //
+  // Returns false if no completion is ready.
+  bool PopCompletion(uint64_t* user_data, int32_t* res);
+
+ private:
+  IoUring();
+
+  int ring_fd_;
+  uint32_t capacity_;
+
+  // The number of queued requests which haven't been submitted yet.
+  uint32_t to_submit_;
+
+  // The mappings of the rings shared with the kernel.
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  void* sqes_;
+  size_t sqes_size_;
+
+  // Pointers into the submission queue ring.
+  uint32_t* sq_head_;
+  uint32_t* sq_tail_;
+  uint32_t sq_mask_;
+  uint32_t* sq_array_;
+
+  // Pointers into the completion queue ring.
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t cq_mask_;
+  void* cqes_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+} // namespace kudu
@@ -533,6 +533,24 @@ build_lz4() {
   popd
 }
 
+build_zstd() {
+  ZSTD_BDIR=$TP_BUILD_DIR/$ZSTD_NAME$MODE_SUFFIX
+  mkdir -p $ZSTD_BDIR
+  pushd $ZSTD_BDIR
+  rm -Rf CMakeCache.txt CMakeFiles/
+  CFLAGS="$EXTRA_CFLAGS" \
+    cmake \
+    -DCMAKE_BUILD_TYPE=release \
+    -DZSTD_BUILD_PROGRAMS=OFF \
+    -DZSTD_BUILD_SHARED=OFF \
+    -DZSTD_MULTITHREAD_SUPPORT=OFF \
+    -DCMAKE_INSTALL_PREFIX:PATH=$PREFIX \
+    $EXTRA_CMAKE_FLAGS \
+    $ZSTD_SOURCE/build/cmake
+  ${NINJA:-make} -j$PARALLEL $EXTRA_MAKEFLAGS install
+  popd
+}
+
 build_bitshuffle() {
   BITSHUFFLE_BDIR=$TP_BUILD_DIR/$BITSHUFFLE_NAME$MODE_SUFFIX
   mkdir -p $BITSHUFFLE_BDIR
@@ -68,6 +68,10 @@ LZ4_VERSION=r130
 LZ4_NAME=lz4-lz4-$LZ4_VERSION
 LZ4_SOURCE=$TP_SOURCE_DIR/$LZ4_NAME
 
+ZSTD_VERSION=1.3.4
+ZSTD_NAME=zstd-$ZSTD_VERSION
+ZSTD_SOURCE=$TP_SOURCE_DIR/$ZSTD_NAME
+
 # from https://github.com/kiyo-masui/bitshuffle
 # Hash of git: 55f9b4caec73fa21d13947cacea1295926781440
 BITSHUFFLE_VERSION=55f9b4c